@@ -0,0 +1,224 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""
+Benchmark specifications, one per sketch family bound in the module.
+
+Each Family holds a factory for an empty sketch and callables for each
+operation. Operations a family does not support are None and are skipped.
+The update callables take a sketch and the input of the family, as prepared
+by its `data` callable, and must process every item; the others take a
+sketch already updated with that input.
+"""
+
+from dataclasses import dataclass
+from typing import Any, Callable, Optional
+
+import numpy as np
+import datasketches as ds
+
+
+@dataclass
+class Family:
+  name: str
+  make: Callable[[], Any]
+  data: Callable[[np.random.Generator, int], Any]
+  update_scalar: Optional[Callable[[Any, Any], None]] = None
+  update_vector: Optional[Callable[[Any, Any], None]] = None
+  merge: Optional[Callable[[Any, Any], Any]] = None
+  serialize: Optional[Callable[[Any], bytes]] = None
+  deserialize: Optional[Callable[[bytes], Any]] = None
+  query: Optional[Callable[[Any], Any]] = None
+
+
+def _ints(rng, n):
+  return rng.integers(0, 1 << 62, size=n, dtype=np.int64)
+
+def _floats(rng, n):
+  return rng.random(n)
+
+def _floats32(rng, n):
+  return rng.random(n, dtype=np.float32)
+
+def _strings(rng, n):
+  return rng.integers(0, 1 << 20, size=n).astype('U')
+
+def _weighted(rng, n):
+  return rng.random(n), rng.random(n) + 0.5
+
+def _for_each(update):
+  def run(sk, items):
+    for item in items.tolist():
+      update(sk, item)
+  return run
+
+def _merge_into_copy(a, b):
+  result = a.__copy__()
+  result.merge(b)
+  return result
+
+def _union(make_union, get_result=lambda u: u.get_result()):
+  def run(a, b):
+    u = make_union()
+    u.update(a)
+    u.update(b)
+    return get_result(u)
+  return run
+
+_RANKS = np.linspace(0.01, 0.99, 99)
+_DENSITY_DIM = 3
+_VECTOR_D = 16
+_MAP_KEYS = 1024
+
+
+def _quantile_family(name, make, data, deserialize):
+  return Family(name, make, data,
+    update_scalar=_for_each(lambda sk, x: sk.update(x)),
+    update_vector=lambda sk, items: sk.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda sk: sk.serialize(),
+    deserialize=deserialize,
+    query=lambda sk: sk.get_quantiles(_RANKS))
+
+
+def _hash_family(name, make, make_union, serialize, deserialize):
+  return Family(name, make, _ints,
+    update_scalar=_for_each(lambda sk, x: sk.update(x)),
+    update_vector=lambda sk, items: sk.update(items),
+    merge=_union(make_union),
+    serialize=serialize,
+    deserialize=deserialize,
+    query=lambda sk: sk.get_estimate())
+
+
+def _tuple_summaries(rng, n):
+  return _ints(rng, n), np.ones(n)
+
+
+FAMILIES = [
+  _hash_family('hll', lambda: ds.hll_sketch(12), lambda: ds.hll_union(12),
+    lambda sk: sk.serialize_compact(), ds.hll_sketch.deserialize),
+  _hash_family('cpc', lambda: ds.cpc_sketch(11), lambda: ds.cpc_union(11),
+    lambda sk: sk.serialize(), ds.cpc_sketch.deserialize),
+  _hash_family('theta', lambda: ds.update_theta_sketch(12), lambda: ds.theta_union(12),
+    lambda sk: sk.compact().serialize(), ds.compact_theta_sketch.deserialize),
+  Family('tuple_py_policy', lambda: ds.update_tuple_sketch(ds.AccumulatorPolicy(), 12), _ints,
+    update_scalar=_for_each(lambda sk, x: sk.update(x, 1)),
+    merge=_union(lambda: ds.tuple_union(ds.AccumulatorPolicy(), 12)),
+    serialize=lambda sk: sk.compact().serialize(ds.PyIntsSerDe()),
+    deserialize=lambda image: ds.compact_tuple_sketch.deserialize(image, ds.PyIntsSerDe()),
+    query=lambda sk: sk.get_estimate()),
+  Family('tuple_double_sum', lambda: ds.update_tuple_sketch_double_sum(12), _tuple_summaries,
+    update_scalar=lambda sk, data: [sk.update(k, v) for k, v in zip(data[0].tolist(), data[1].tolist())],
+    update_vector=lambda sk, data: sk.update(data[0], data[1]),
+    merge=_union(lambda: ds.tuple_union_double_sum(12)),
+    serialize=lambda sk: sk.compact().serialize(),
+    deserialize=ds.compact_tuple_sketch_double_sum.deserialize,
+    query=lambda sk: sk.get_estimate()),
+  _quantile_family('kll_floats', lambda: ds.kll_floats_sketch(200), _floats32, ds.kll_floats_sketch.deserialize),
+  _quantile_family('kll_doubles', lambda: ds.kll_doubles_sketch(200), _floats, ds.kll_doubles_sketch.deserialize),
+  _quantile_family('req_floats', lambda: ds.req_floats_sketch(12), _floats32, ds.req_floats_sketch.deserialize),
+  _quantile_family('quantiles_doubles', lambda: ds.quantiles_doubles_sketch(128), _floats,
+    ds.quantiles_doubles_sketch.deserialize),
+  Family('tdigest_double', lambda: ds.tdigest_double(200), _floats,
+    update_scalar=_for_each(lambda sk, x: sk.update(x)),
+    update_vector=lambda sk, items: sk.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda sk: sk.serialize(),
+    deserialize=ds.tdigest_double.deserialize,
+    query=lambda sk: sk.get_quantile(0.5)),
+  Family('frequent_ints', lambda: ds.frequent_ints_sketch(10), lambda rng, n: rng.zipf(1.5, n).astype(np.int64),
+    update_scalar=_for_each(lambda sk, x: sk.update(x)),
+    update_vector=lambda sk, items: sk.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda sk: sk.serialize(),
+    deserialize=ds.frequent_ints_sketch.deserialize,
+    query=lambda sk: sk.get_frequent_items(ds.frequent_items_error_type.NO_FALSE_POSITIVES)),
+  Family('frequent_strings', lambda: ds.frequent_strings_sketch(10), _strings,
+    update_scalar=_for_each(lambda sk, x: sk.update(x)),
+    update_vector=lambda sk, items: sk.update_strings(items),
+    merge=_merge_into_copy,
+    serialize=lambda sk: sk.serialize(),
+    deserialize=ds.frequent_strings_sketch.deserialize,
+    query=lambda sk: sk.get_frequent_items(ds.frequent_items_error_type.NO_FALSE_POSITIVES)),
+  Family('count_min', lambda: ds.count_min_sketch(3, 1024), _ints,
+    update_scalar=_for_each(lambda sk, x: sk.update(x)),
+    update_vector=lambda sk, items: sk.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda sk: sk.serialize(),
+    deserialize=ds.count_min_sketch.deserialize,
+    query=lambda sk: sk.get_estimate(12345)),
+  Family('var_opt_doubles', lambda: ds.var_opt_doubles_sketch(1024), _weighted,
+    update_scalar=lambda sk, data: [sk.update(x, w) for x, w in zip(data[0].tolist(), data[1].tolist())],
+    update_vector=lambda sk, data: sk.update(data[0], data[1]),
+    merge=_union(lambda: ds.var_opt_doubles_union(1024)),
+    serialize=lambda sk: sk.serialize(),
+    deserialize=ds.var_opt_doubles_sketch.deserialize,
+    query=lambda sk: sk.estimate_subset_sum_range(0.25, 0.75)),
+  Family('ebpps_doubles', lambda: ds.ebpps_doubles_sketch(1024), _weighted,
+    update_scalar=lambda sk, data: [sk.update(x, w) for x, w in zip(data[0].tolist(), data[1].tolist())],
+    update_vector=lambda sk, data: sk.update(data[0], data[1]),
+    merge=_merge_into_copy,
+    serialize=lambda sk: sk.serialize(),
+    deserialize=ds.ebpps_doubles_sketch.deserialize,
+    query=lambda sk: sk.get_samples()),
+  Family('density', lambda: ds.density_sketch(50, _DENSITY_DIM, ds.GaussianKernel()),
+    lambda rng, n: rng.random((n, _DENSITY_DIM)),
+    update_scalar=lambda sk, points: [sk.update(p) for p in points],
+    update_vector=lambda sk, points: sk.update(points),
+    merge=_merge_into_copy,
+    serialize=lambda sk: sk.serialize(),
+    deserialize=lambda image: ds.density_sketch.deserialize(image, ds.GaussianKernel()),
+    query=lambda sk: sk.get_estimate([0.5] * _DENSITY_DIM)),
+  Family('vector_of_kll_floats', lambda: ds.vector_of_kll_floats_sketches(200, _VECTOR_D),
+    lambda rng, n: rng.random((n // _VECTOR_D, _VECTOR_D), dtype=np.float32),
+    update_vector=lambda vs, items: vs.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda vs: vs.serialize_batch(),
+    query=lambda vs: vs.get_quantiles(_RANKS)),
+  Family('vector_of_hll', lambda: ds.vector_of_hll_sketches(12, d=_VECTOR_D),
+    lambda rng, n: _ints(rng, n).reshape(-1, _VECTOR_D),
+    update_vector=lambda vs, items: vs.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda vs: vs.serialize_batch(),
+    query=lambda vs: vs.get_estimate()),
+  Family('vector_of_theta', lambda: ds.vector_of_theta_sketches(12, d=_VECTOR_D),
+    lambda rng, n: _ints(rng, n).reshape(-1, _VECTOR_D),
+    update_vector=lambda vs, items: vs.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda vs: vs.serialize_batch(),
+    query=lambda vs: vs.get_estimate()),
+  Family('vector_of_tdigests', lambda: ds.vector_of_tdigests(200, d=_VECTOR_D),
+    lambda rng, n: rng.random((n // _VECTOR_D, _VECTOR_D)),
+    update_vector=lambda vs, items: vs.update(items),
+    merge=_merge_into_copy,
+    serialize=lambda vs: vs.serialize_batch(),
+    query=lambda vs: vs.get_quantiles(_RANKS)),
+  Family('hll_sketch_map', lambda: ds.hll_sketch_map(10),
+    lambda rng, n: (rng.integers(0, _MAP_KEYS, size=n, dtype=np.int64), _ints(rng, n)),
+    update_vector=lambda sm, data: sm.update(data[0], data[1]),
+    merge=_merge_into_copy,
+    serialize=lambda sm: sm.serialize_batch(),
+    query=lambda sm: sm.estimates()),
+  Family('kll_sketch_map', lambda: ds.kll_sketch_map(200),
+    lambda rng, n: (rng.integers(0, _MAP_KEYS, size=n, dtype=np.int64), _floats(rng, n)),
+    update_vector=lambda sm, data: sm.update(data[0], data[1]),
+    merge=_merge_into_copy,
+    serialize=lambda sm: sm.serialize_batch(),
+    query=lambda sm: sm.quantiles(_RANKS)),
+]
@@ -0,0 +1,110 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""
+Measures the import time of the module and the first-access cost of each
+family.
+
+Every measurement runs in a new interpreter, so nothing is cached. The
+`import` record times `import datasketches`, which registers only the
+supporting functions, and each `register` record times the registration
+of one family and the families it depends on, which is what the first
+access to one of its classes adds. The `register` record of `all` times
+registering every family, close to the cost of an eager import. The best
+of several repeats is reported as one JSON record of {family, operation,
+impl, n, seconds, items_per_second}, as in run_benchmarks.py.
+
+  python benchmarks/import_time.py --repeat 10 --output import_time.json
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+
+TIMER = '''
+import json, time
+start = time.perf_counter_ns()
+import datasketches
+imported = time.perf_counter_ns()
+datasketches.register_families({families})
+registered = time.perf_counter_ns()
+print(json.dumps([(imported - start) / 1e9, (registered - imported) / 1e9]))
+'''
+
+
+def time_fresh(families):
+  code = TIMER.format(families=repr(families))
+  out = subprocess.run([sys.executable, '-c', code], check=True, capture_output=True, text=True).stdout
+  return json.loads(out)
+
+
+def record(family, operation, seconds):
+  return {
+    'family': family,
+    'operation': operation,
+    'impl': 'python',
+    'n': 1,
+    'seconds': seconds,
+    'items_per_second': 1 / seconds if seconds > 0 else None,
+  }
+
+
+def list_families():
+  code = 'import datasketches; print("\\n".join(datasketches.get_families()))'
+  return subprocess.run([sys.executable, '-c', code], check=True, capture_output=True, text=True).stdout.split()
+
+
+def main(argv=None):
+  parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--families', help='comma-separated family names (default: all)')
+  parser.add_argument('--repeat', type=int, default=5, help='number of repeats, of which the best is reported')
+  parser.add_argument('--output', help='file to write the JSON results to (default: stdout)')
+  parser.add_argument('--list', action='store_true', help='list the family names and exit')
+  args = parser.parse_args(argv)
+
+  families = list_families()
+  if args.list:
+    print('\n'.join(families))
+    return 0
+
+  selected = args.families.split(',') if args.families else families
+  unknown = set(selected) - set(families)
+  if unknown:
+    parser.error('unknown families: ' + ', '.join(sorted(unknown)))
+
+  import_times = []
+  results = []
+  for family in selected:
+    times = [time_fresh([family]) for _ in range(args.repeat)]
+    import_times += [t[0] for t in times]
+    results.append(record(family, 'register', min(t[1] for t in times)))
+  times = [time_fresh(None) for _ in range(args.repeat)]
+  import_times += [t[0] for t in times]
+  results.append(record('all', 'register', min(t[1] for t in times)))
+  results.insert(0, record('datasketches', 'import', min(import_times)))
+
+  text = json.dumps(results, indent=2)
+  if args.output:
+    with open(args.output, 'w') as out:
+      out.write(text + '\n')
+  else:
+    print(text)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
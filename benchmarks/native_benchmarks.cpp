@@ -0,0 +1,337 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+  Native baseline of the Python benchmarks in run_benchmarks.py: the same
+  families and operations on the same kinds of input, calling the C++
+  sketches directly. The best of several repeats of each operation is
+  printed to stdout as a JSON array of records in the schema of
+  run_benchmarks.py, with impl "native" and the operation "update" standing
+  for both update_scalar and update_vector.
+
+  native_benchmarks [--n N] [--repeat R] [--families a,b,...]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hll.hpp"
+#include "cpc_sketch.hpp"
+#include "cpc_union.hpp"
+#include "theta_sketch.hpp"
+#include "theta_union.hpp"
+#include "tuple_sketch.hpp"
+#include "tuple_union.hpp"
+#include "kll_sketch.hpp"
+#include "req_sketch.hpp"
+#include "quantiles_sketch.hpp"
+#include "tdigest.hpp"
+#include "frequent_items_sketch.hpp"
+#include "count_min.hpp"
+#include "var_opt_sketch.hpp"
+#include "var_opt_union.hpp"
+#include "ebpps_sketch.hpp"
+
+using namespace datasketches;
+
+namespace {
+
+struct record {
+  std::string family;
+  std::string operation;
+  size_t n;
+  double seconds;
+};
+
+// results of queries and merges accumulate here so the work cannot be optimized away
+volatile double sink = 0;
+
+template<typename F>
+double best_time(unsigned repeat, F&& f) {
+  double best = INFINITY;
+  for (unsigned i = 0; i < repeat; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed.count() < best) best = elapsed.count();
+  }
+  return best;
+}
+
+struct dataset {
+  std::vector<uint64_t> ints;
+  std::vector<int64_t> zipf;
+  std::vector<double> doubles;
+  std::vector<float> floats;
+  std::vector<double> weights;
+
+  dataset(size_t n, uint64_t seed): ints(n), zipf(n), doubles(n), floats(n), weights(n) {
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t i = 0; i < n; ++i) {
+      ints[i] = gen() >> 2;
+      // Pareto with shape 1/2, the tail of the Zipf(1.5) input of the Python benchmark
+      zipf[i] = static_cast<int64_t>(std::pow(1.0 - uniform(gen), -2.0));
+      doubles[i] = uniform(gen);
+      floats[i] = static_cast<float>(uniform(gen));
+      weights[i] = uniform(gen) + 0.5;
+    }
+  }
+};
+
+/*
+  Times one family. update(sk, data) feeds a whole dataset into a sketch,
+  merge(a, b) returns the merged sketch without changing its arguments,
+  and query(sk) returns a number added to the sink.
+*/
+template<typename Make, typename Update, typename Merge, typename Serialize, typename Deserialize, typename Query>
+void bench_family(std::vector<record>& out, const std::string& name, const dataset& a, const dataset& b,
+    unsigned repeat, Make make, Update update, Merge merge, Serialize serialize, Deserialize deserialize, Query query) {
+  const size_t n = a.ints.size();
+  using sketch_type = decltype(make());
+
+  out.push_back({name, "update", n, best_time(repeat, [&] {
+    auto sk = make();
+    update(sk, a);
+    sink = sink + query(sk);
+  })});
+
+  sketch_type sk_a = make();
+  update(sk_a, a);
+  sketch_type sk_b = make();
+  update(sk_b, b);
+  out.push_back({name, "merge", 1, best_time(repeat, [&] { sink = sink + query(merge(sk_a, sk_b)); })});
+  out.push_back({name, "serialize", 1, best_time(repeat, [&] { sink = sink + serialize(sk_a).size(); })});
+  const auto image = serialize(sk_a);
+  out.push_back({name, "deserialize", 1, best_time(repeat, [&] { sink = sink + query(deserialize(image)); })});
+  out.push_back({name, "query", 1, best_time(repeat, [&] { sink = sink + query(sk_a); })});
+}
+
+template<typename SK>
+SK merged_copy(const SK& a, const SK& b) {
+  SK result(a);
+  result.merge(b);
+  return result;
+}
+
+const int NUM_RANKS = 99;
+
+template<typename SK>
+double quantiles_query(const SK& sk) {
+  double sum = 0;
+  for (int i = 1; i <= NUM_RANKS; ++i) sum += sk.get_quantile(i / (NUM_RANKS + 1.0));
+  return sum;
+}
+
+template<typename SK, typename T>
+void bench_quantiles(std::vector<record>& out, const std::string& name, const dataset& a, const dataset& b,
+    unsigned repeat, uint16_t k, const std::vector<T> dataset::* items) {
+  bench_family(out, name, a, b, repeat,
+    [k] { return SK(k); },
+    [items](SK& sk, const dataset& d) { for (T x: d.*items) sk.update(x); },
+    merged_copy<SK>,
+    [](const SK& sk) { return sk.serialize(); },
+    [](const auto& image) { return SK::deserialize(image.data(), image.size()); },
+    quantiles_query<SK>);
+}
+
+struct double_sum_policy {
+  double create() const { return 0; }
+  void update(double& summary, double update) const { summary += update; }
+  void operator()(double& summary, double other) const { summary += other; }
+};
+
+void run_families(std::vector<record>& out, const std::set<std::string>& selected, size_t n, unsigned repeat) {
+  const dataset a(n, 42);
+  const dataset b(n, 43);
+  auto wanted = [&selected](const char* name) { return selected.empty() || selected.count(name) > 0; };
+
+  if (wanted("hll")) {
+    bench_family(out, "hll", a, b, repeat,
+      [] { return hll_sketch(12, HLL_8); },
+      [](hll_sketch& sk, const dataset& d) { for (uint64_t x: d.ints) sk.update(x); },
+      [](const hll_sketch& x, const hll_sketch& y) {
+        hll_union u(12);
+        u.update(x);
+        u.update(y);
+        return u.get_result(HLL_8);
+      },
+      [](const hll_sketch& sk) { return sk.serialize_compact(); },
+      [](const auto& image) { return hll_sketch::deserialize(image.data(), image.size()); },
+      [](const hll_sketch& sk) { return sk.get_estimate(); });
+  }
+  if (wanted("cpc")) {
+    bench_family(out, "cpc", a, b, repeat,
+      [] { return cpc_sketch(11); },
+      [](cpc_sketch& sk, const dataset& d) { for (uint64_t x: d.ints) sk.update(x); },
+      [](const cpc_sketch& x, const cpc_sketch& y) {
+        cpc_union u(11);
+        u.update(x);
+        u.update(y);
+        return u.get_result();
+      },
+      [](const cpc_sketch& sk) { return sk.serialize(); },
+      [](const auto& image) { return cpc_sketch::deserialize(image.data(), image.size()); },
+      [](const cpc_sketch& sk) { return sk.get_estimate(); });
+  }
+  if (wanted("theta")) {
+    bench_family(out, "theta", a, b, repeat,
+      [] { return update_theta_sketch::builder().set_lg_k(12).build(); },
+      [](update_theta_sketch& sk, const dataset& d) { for (uint64_t x: d.ints) sk.update(x); },
+      [](const update_theta_sketch& x, const update_theta_sketch& y) {
+        auto u = theta_union::builder().set_lg_k(12).build();
+        u.update(x);
+        u.update(y);
+        return u.get_result();
+      },
+      [](const update_theta_sketch& sk) { return sk.compact().serialize(); },
+      [](const auto& image) { return compact_theta_sketch::deserialize(image.data(), image.size()); },
+      [](const theta_sketch& sk) { return sk.get_estimate(); });
+  }
+  if (wanted("tuple_double_sum")) {
+    using update_type = update_tuple_sketch<double, double, double_sum_policy>;
+    using union_type = tuple_union<double, double_sum_policy>;
+    bench_family(out, "tuple_double_sum", a, b, repeat,
+      [] { return update_type::builder(double_sum_policy()).set_lg_k(12).build(); },
+      [](update_type& sk, const dataset& d) { for (uint64_t x: d.ints) sk.update(x, 1.0); },
+      [](const update_type& x, const update_type& y) {
+        auto u = union_type::builder(double_sum_policy()).set_lg_k(12).build();
+        u.update(x);
+        u.update(y);
+        return u.get_result();
+      },
+      [](const update_type& sk) { return sk.compact().serialize(); },
+      [](const auto& image) { return compact_tuple_sketch<double>::deserialize(image.data(), image.size()); },
+      [](const tuple_sketch<double>& sk) { return sk.get_estimate(); });
+  }
+  if (wanted("kll_floats")) bench_quantiles<kll_sketch<float>>(out, "kll_floats", a, b, repeat, 200, &dataset::floats);
+  if (wanted("kll_doubles")) bench_quantiles<kll_sketch<double>>(out, "kll_doubles", a, b, repeat, 200, &dataset::doubles);
+  if (wanted("req_floats")) bench_quantiles<req_sketch<float>>(out, "req_floats", a, b, repeat, 12, &dataset::floats);
+  if (wanted("quantiles_doubles")) {
+    bench_quantiles<quantiles_sketch<double>>(out, "quantiles_doubles", a, b, repeat, 128, &dataset::doubles);
+  }
+  if (wanted("tdigest_double")) {
+    bench_family(out, "tdigest_double", a, b, repeat,
+      [] { return tdigest<double>(200); },
+      [](tdigest<double>& td, const dataset& d) { for (double x: d.doubles) td.update(x); },
+      merged_copy<tdigest<double>>,
+      [](const tdigest<double>& td) { return td.serialize(); },
+      [](const auto& image) { return tdigest<double>::deserialize(image.data(), image.size()); },
+      [](const tdigest<double>& td) { return td.get_quantile(0.5); });
+  }
+  if (wanted("frequent_ints")) {
+    using fi_type = frequent_items_sketch<int64_t>;
+    bench_family(out, "frequent_ints", a, b, repeat,
+      [] { return fi_type(10); },
+      [](fi_type& sk, const dataset& d) { for (int64_t x: d.zipf) sk.update(x); },
+      merged_copy<fi_type>,
+      [](const fi_type& sk) { return sk.serialize(); },
+      [](const auto& image) { return fi_type::deserialize(image.data(), image.size()); },
+      [](const fi_type& sk) { return static_cast<double>(sk.get_frequent_items(NO_FALSE_POSITIVES).size()); });
+  }
+  if (wanted("count_min")) {
+    using cm_type = count_min_sketch<double>;
+    bench_family(out, "count_min", a, b, repeat,
+      [] { return cm_type(3, 1024); },
+      [](cm_type& sk, const dataset& d) { for (uint64_t x: d.ints) sk.update(x); },
+      merged_copy<cm_type>,
+      [](const cm_type& sk) { return sk.serialize(); },
+      [](const auto& image) { return cm_type::deserialize(image.data(), image.size()); },
+      [](const cm_type& sk) { return sk.get_estimate(static_cast<uint64_t>(12345)); });
+  }
+  if (wanted("var_opt_doubles")) {
+    using vo_type = var_opt_sketch<double>;
+    bench_family(out, "var_opt_doubles", a, b, repeat,
+      [] { return vo_type(1024); },
+      [](vo_type& sk, const dataset& d) { for (size_t i = 0; i < d.doubles.size(); ++i) sk.update(d.doubles[i], d.weights[i]); },
+      [](const vo_type& x, const vo_type& y) {
+        var_opt_union<double> u(1024);
+        u.update(x);
+        u.update(y);
+        return u.get_result();
+      },
+      [](const vo_type& sk) { return sk.serialize(); },
+      [](const auto& image) { return vo_type::deserialize(image.data(), image.size()); },
+      [](const vo_type& sk) { return sk.estimate_subset_sum([](double x) { return x >= 0.25 && x <= 0.75; }).estimate; });
+  }
+  if (wanted("ebpps_doubles")) {
+    using eb_type = ebpps_sketch<double>;
+    bench_family(out, "ebpps_doubles", a, b, repeat,
+      [] { return eb_type(1024); },
+      [](eb_type& sk, const dataset& d) { for (size_t i = 0; i < d.doubles.size(); ++i) sk.update(d.doubles[i], d.weights[i]); },
+      merged_copy<eb_type>,
+      [](const eb_type& sk) { return sk.serialize(); },
+      [](const auto& image) { return eb_type::deserialize(image.data(), image.size()); },
+      [](const eb_type& sk) { return static_cast<double>(sk.get_result().size()); });
+  }
+}
+
+void print_json(const std::vector<record>& records) {
+  std::cout << "[";
+  for (size_t i = 0; i < records.size(); ++i) {
+    const record& r = records[i];
+    std::ostringstream seconds;
+    seconds.precision(9);
+    seconds << r.seconds;
+    std::cout << (i == 0 ? "\n" : ",\n")
+      << "  {\"family\": \"" << r.family << "\", \"operation\": \"" << r.operation << "\", \"impl\": \"native\", "
+      << "\"n\": " << r.n << ", \"seconds\": " << seconds.str() << ", \"items_per_second\": ";
+    if (r.seconds > 0) std::cout << r.n / r.seconds;
+    else std::cout << "null";
+    std::cout << "}";
+  }
+  std::cout << "\n]\n";
+}
+
+[[noreturn]] void usage(const char* program) {
+  std::cerr << "usage: " << program << " [--n N] [--repeat R] [--families a,b,...]\n";
+  std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  size_t n = 100000;
+  unsigned repeat = 5;
+  std::set<std::string> families;
+  for (int i = 1; i < argc; ++i) {
+    if (i + 1 >= argc) usage(argv[0]);
+    if (std::strcmp(argv[i], "--n") == 0) n = std::strtoull(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--repeat") == 0) repeat = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+    else if (std::strcmp(argv[i], "--families") == 0) {
+      std::istringstream names(argv[++i]);
+      for (std::string name; std::getline(names, name, ',');) families.insert(name);
+    } else usage(argv[0]);
+  }
+  if (n == 0 || repeat == 0) usage(argv[0]);
+
+  std::vector<record> records;
+  run_families(records, families, n, repeat);
+  print_json(records);
+  return 0;
+}
@@ -0,0 +1,154 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""
+Measures the throughput of the bindings for every sketch family.
+
+For each family and operation, the best of several repeats is reported as
+one JSON record of {family, operation, impl, n, seconds, items_per_second}.
+With --native, the records of the native C++ baseline are appended and each
+Python record with a native counterpart gets an `overhead` ratio of its
+time to the native time, which isolates the cost of the wrapper. Both
+update_scalar and update_vector compare to the native update loop.
+
+  python benchmarks/run_benchmarks.py --n 100000 --output results.json
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+from families import FAMILIES
+
+
+def best_time(run, repeat, setup=None):
+  best = float('inf')
+  for _ in range(repeat):
+    arg = setup() if setup is not None else None
+    start = time.perf_counter_ns()
+    run(arg)
+    best = min(best, time.perf_counter_ns() - start)
+  return best / 1e9
+
+
+def record(family, operation, n, seconds):
+  return {
+    'family': family,
+    'operation': operation,
+    'impl': 'python',
+    'n': n,
+    'seconds': seconds,
+    'items_per_second': n / seconds if seconds > 0 else None,
+  }
+
+
+def bench_family(f, n, repeat, seed):
+  rng = np.random.default_rng(seed)
+  data = f.data(rng, n)
+  data_b = f.data(rng, n)
+  results = []
+
+  def updated(items):
+    sk = f.make()
+    (f.update_vector or f.update_scalar)(sk, items)
+    return sk
+
+  if f.update_scalar is not None:
+    results.append(record(f.name, 'update_scalar', n,
+      best_time(lambda sk: f.update_scalar(sk, data), repeat, f.make)))
+  if f.update_vector is not None:
+    results.append(record(f.name, 'update_vector', n,
+      best_time(lambda sk: f.update_vector(sk, data), repeat, f.make)))
+
+  sk = updated(data)
+  if f.merge is not None:
+    other = updated(data_b)
+    results.append(record(f.name, 'merge', 1, best_time(lambda _: f.merge(sk, other), repeat)))
+  if f.serialize is not None:
+    results.append(record(f.name, 'serialize', 1, best_time(lambda _: f.serialize(sk), repeat)))
+    if f.deserialize is not None:
+      image = f.serialize(sk)
+      results.append(record(f.name, 'deserialize', 1, best_time(lambda _: f.deserialize(image), repeat)))
+  if f.query is not None:
+    results.append(record(f.name, 'query', 1, best_time(lambda _: f.query(sk), repeat)))
+  return results
+
+
+def run_native(path, n, repeat, families):
+  args = [path, '--n', str(n), '--repeat', str(repeat)]
+  if families:
+    args += ['--families', ','.join(families)]
+  out = subprocess.run(args, check=True, capture_output=True, text=True).stdout
+  return json.loads(out)
+
+
+def add_overheads(results):
+  # the native baseline has a single update loop for both update benchmarks
+  def key(r):
+    return r['family'], 'update' if r['operation'].startswith('update') else r['operation']
+  native = {key(r): r['seconds'] for r in results if r['impl'] == 'native'}
+  for r in results:
+    if r['impl'] == 'python' and key(r) in native:
+      base = native[key(r)]
+      r['overhead'] = r['seconds'] / base if base > 0 else None
+
+
+def main(argv=None):
+  parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--families', help='comma-separated family names (default: all)')
+  parser.add_argument('--n', type=int, default=100000, help='number of items per update benchmark')
+  parser.add_argument('--repeat', type=int, default=5, help='number of repeats, of which the best is reported')
+  parser.add_argument('--seed', type=int, default=42, help='seed of the input generator')
+  parser.add_argument('--native', help='path to the native_benchmarks executable to run as a baseline')
+  parser.add_argument('--output', help='file to write the JSON results to (default: stdout)')
+  parser.add_argument('--list', action='store_true', help='list the family names and exit')
+  args = parser.parse_args(argv)
+
+  if args.list:
+    print('\n'.join(f.name for f in FAMILIES))
+    return 0
+
+  selected = args.families.split(',') if args.families else None
+  if selected:
+    unknown = set(selected) - {f.name for f in FAMILIES}
+    if unknown:
+      parser.error('unknown families: ' + ', '.join(sorted(unknown)))
+
+  results = []
+  for f in FAMILIES:
+    if selected is None or f.name in selected:
+      results += bench_family(f, args.n, args.repeat, args.seed)
+  if args.native:
+    results += run_native(args.native, args.n, args.repeat, selected)
+    add_overheads(results)
+
+  text = json.dumps(results, indent=2)
+  if args.output:
+    with open(args.output, 'w') as out:
+      out.write(text + '\n')
+  else:
+    print(text)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
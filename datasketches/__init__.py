@@ -23,8 +23,44 @@ Provided under the Apache License, Version 2.0
 
 name = 'datasketches'
 
-from _datasketches import *
+import importlib
 
-from .PySerDe import *
-from .TuplePolicy import *
-from .KernelFunction import *
+import _datasketches
+
+# The native classes and functions are registered by family on first
+# access (see get_families()), which keeps the import fast. The Python
+# implementations below extend native base classes, so their modules are
+# also imported on first access. __getattr__ is only called for names not
+# yet in this namespace and caches what it finds.
+_PYTHON_CLASSES = {
+  'PyStringsSerDe': 'PySerDe',
+  'PyIntsSerDe': 'PySerDe',
+  'PyLongsSerDe': 'PySerDe',
+  'PyFloatsSerDe': 'PySerDe',
+  'PyDoublesSerDe': 'PySerDe',
+  'AccumulatorPolicy': 'TuplePolicy',
+  'MaxIntPolicy': 'TuplePolicy',
+  'MinIntPolicy': 'TuplePolicy',
+  'GaussianKernel': 'KernelFunction',
+}
+
+__all__ = [attr for attr in dir(_datasketches) if not attr.startswith('_')] + list(_PYTHON_CLASSES)
+
+def __getattr__(attr):
+  module_name = _PYTHON_CLASSES.get(attr)
+  if module_name is not None:
+    value = getattr(importlib.import_module('.' + module_name, __name__), attr)
+    # importing the submodule binds its name here, hiding the native
+    # TuplePolicy and KernelFunction base classes
+    if module_name in __all__:
+      globals()[module_name] = getattr(_datasketches, module_name)
+  else:
+    try:
+      value = getattr(_datasketches, attr)
+    except AttributeError:
+      raise AttributeError(f"module {__name__!r} has no attribute {attr!r}") from None
+  globals()[attr] = value
+  return value
+
+def __dir__():
+  return sorted(set(globals()) | set(__all__))
@@ -0,0 +1,241 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _ARROW_ARRAY_HPP_
+#define _ARROW_ARRAY_HPP_
+
+/*
+  This header reads Arrow arrays in place through the Arrow C Data
+  Interface, as exported by the Arrow PyCapsule protocol of pyarrow,
+  polars and other libraries: __arrow_c_array__() for an array or a
+  record batch, and __arrow_c_stream__() for a chunked array or a table.
+  Values are visited straight from the Arrow buffers, chunk by chunk,
+  skipping the nulls marked in the validity bitmap. Nothing is copied
+  and no NumPy conversion is involved.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <nanobind/nanobind.h>
+
+// the ABI-stable structures of the Arrow C Data and C Stream Interfaces
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream {
+  int (*get_schema)(struct ArrowArrayStream*, struct ArrowSchema* out);
+  int (*get_next)(struct ArrowArrayStream*, struct ArrowArray* out);
+  const char* (*get_last_error)(struct ArrowArrayStream*);
+  void (*release)(struct ArrowArrayStream*);
+  void* private_data;
+};
+
+#endif // ARROW_C_STREAM_INTERFACE
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+// the element types that can be visited, with narrower integers and floats widened
+enum class arrow_kind { SIGNED, UNSIGNED, FLOATING, BINARY };
+
+struct arrow_type {
+  arrow_kind kind;
+  char format; // the Arrow format character
+};
+
+// a variable-width binary or utf8 element, pointing into the Arrow data buffer
+struct arrow_binary {
+  const char* data;
+  size_t size;
+};
+
+inline arrow_type get_arrow_type(const ArrowSchema& schema) {
+  const char* format = schema.format;
+  if (schema.dictionary != nullptr) {
+    throw std::invalid_argument("dictionary-encoded Arrow arrays are not supported; decode them first");
+  }
+  if (format != nullptr && format[0] != '\0' && format[1] == '\0') {
+    switch (format[0]) {
+      case 'c': case 's': case 'i': case 'l': return {arrow_kind::SIGNED, format[0]};
+      case 'C': case 'S': case 'I': case 'L': return {arrow_kind::UNSIGNED, format[0]};
+      case 'f': case 'g': return {arrow_kind::FLOATING, format[0]};
+      case 'u': case 'z': case 'U': case 'Z': return {arrow_kind::BINARY, format[0]};
+    }
+  }
+  throw std::invalid_argument("unsupported Arrow type format: '" + std::string(format == nullptr ? "" : format)
+    + "'. Expected an integer, float32, float64, utf8 or binary array");
+}
+
+namespace arrow_internal {
+
+inline bool is_valid(const uint8_t* validity, int64_t i) {
+  return validity == nullptr || ((validity[i >> 3] >> (i & 7)) & 1) != 0;
+}
+
+template<typename V, typename W, typename F>
+void visit_fixed(const ArrowArray& array, int64_t offset, const uint8_t* validity, F& f) {
+  const V* values = static_cast<const V*>(array.buffers[1]);
+  for (int64_t i = offset; i < offset + array.length; ++i) {
+    if (is_valid(validity, i)) f(static_cast<W>(values[i]));
+  }
+}
+
+template<typename O, typename F>
+void visit_binary(const ArrowArray& array, int64_t offset, const uint8_t* validity, F& f) {
+  const O* offsets = static_cast<const O*>(array.buffers[1]);
+  const char* data = static_cast<const char*>(array.buffers[2]);
+  for (int64_t i = offset; i < offset + array.length; ++i) {
+    if (is_valid(validity, i)) f(arrow_binary{data + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i])});
+  }
+}
+
+// releases an exported structure when leaving scope, unless already released
+template<typename T>
+struct release_guard {
+  T& value;
+  ~release_guard() { if (value.release != nullptr) value.release(&value); }
+};
+
+} // namespace arrow_internal
+
+/**
+ * @brief Invokes f(value) for every non-null element of an Arrow array of
+ * the given type, with value an int64_t, uint64_t, double or arrow_binary
+ * according to its kind. parent_offset is the offset of the enclosing struct
+ * array when visiting a column of a record batch, and 0 otherwise.
+ * Does not touch any Python objects, so may be called without the GIL.
+ */
+template<typename F>
+void for_each_arrow_value(const arrow_type& type, const ArrowArray& array, int64_t parent_offset, F&& f) {
+  using namespace arrow_internal;
+  if (array.length == 0) return;
+  const int64_t min_buffers = type.kind == arrow_kind::BINARY ? 3 : 2;
+  if (array.n_buffers < min_buffers) {
+    throw std::invalid_argument("Arrow array has " + std::to_string(array.n_buffers) + " buffers, expected "
+      + std::to_string(min_buffers));
+  }
+  const int64_t offset = array.offset + parent_offset;
+  const uint8_t* validity = array.null_count != 0 ? static_cast<const uint8_t*>(array.buffers[0]) : nullptr;
+  switch (type.format) {
+    case 'c': visit_fixed<int8_t, int64_t>(array, offset, validity, f); break;
+    case 's': visit_fixed<int16_t, int64_t>(array, offset, validity, f); break;
+    case 'i': visit_fixed<int32_t, int64_t>(array, offset, validity, f); break;
+    case 'l': visit_fixed<int64_t, int64_t>(array, offset, validity, f); break;
+    case 'C': visit_fixed<uint8_t, uint64_t>(array, offset, validity, f); break;
+    case 'S': visit_fixed<uint16_t, uint64_t>(array, offset, validity, f); break;
+    case 'I': visit_fixed<uint32_t, uint64_t>(array, offset, validity, f); break;
+    case 'L': visit_fixed<uint64_t, uint64_t>(array, offset, validity, f); break;
+    case 'f': visit_fixed<float, double>(array, offset, validity, f); break;
+    case 'g': visit_fixed<double, double>(array, offset, validity, f); break;
+    case 'u': case 'z': visit_binary<int32_t>(array, offset, validity, f); break;
+    case 'U': case 'Z': visit_binary<int64_t>(array, offset, validity, f); break;
+  }
+}
+
+/**
+ * @brief Invokes f(const ArrowSchema&, const ArrowArray&) for every chunk of
+ * an object implementing the Arrow PyCapsule protocol: once for an array or
+ * record batch, and once per chunk for a chunked array, table or stream.
+ * Called with the GIL held; f may release it while visiting the chunk.
+ */
+template<typename F>
+void for_each_arrow_chunk(nb::handle obj, F&& f) {
+  using namespace arrow_internal;
+  if (nb::hasattr(obj, "__arrow_c_stream__")) {
+    nb::object capsule = obj.attr("__arrow_c_stream__")();
+    auto* stream = static_cast<ArrowArrayStream*>(PyCapsule_GetPointer(capsule.ptr(), "arrow_array_stream"));
+    if (stream == nullptr) throw nb::python_error();
+    auto stream_error = [stream]() {
+      const char* message = stream->get_last_error(stream);
+      return std::runtime_error(std::string("error reading Arrow stream: ") + (message != nullptr ? message : "unknown error"));
+    };
+    ArrowSchema schema;
+    if (stream->get_schema(stream, &schema) != 0) throw stream_error();
+    release_guard<ArrowSchema> schema_guard{schema};
+    while (true) {
+      ArrowArray chunk;
+      if (stream->get_next(stream, &chunk) != 0) throw stream_error();
+      if (chunk.release == nullptr) break; // end of stream
+      release_guard<ArrowArray> chunk_guard{chunk};
+      f(schema, chunk);
+    }
+    // the capsule releases the stream itself
+  } else if (nb::hasattr(obj, "__arrow_c_array__")) {
+    nb::tuple capsules = nb::cast<nb::tuple>(obj.attr("__arrow_c_array__")());
+    auto* schema = static_cast<ArrowSchema*>(PyCapsule_GetPointer(capsules[0].ptr(), "arrow_schema"));
+    if (schema == nullptr) throw nb::python_error();
+    auto* array = static_cast<ArrowArray*>(PyCapsule_GetPointer(capsules[1].ptr(), "arrow_array"));
+    if (array == nullptr) throw nb::python_error();
+    f(*schema, *array);
+    // the capsules release the schema and the array
+  } else {
+    throw std::invalid_argument("expected an Arrow array, chunked array, record batch or table implementing "
+      "__arrow_c_array__ or __arrow_c_stream__, such as from pyarrow");
+  }
+}
+
+} // namespace datasketches
+
+#endif // _ARROW_ARRAY_HPP_
@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _ATOMIC_HLL_SKETCH_HPP_
+#define _ATOMIC_HLL_SKETCH_HPP_
+
+/*
+  This header defines atomic_hll_sketch, a dense HLL_8 sketch that many
+  threads may update at once without locks. Its 2^lg_k one-byte registers
+  are atomics, and an update raises its register with a compare-and-swap
+  loop, so concurrent updates commute exactly: the registers end up as
+  those of an HLL_8 sketch given the same items in any order. Items are
+  hashed as by hll_sketch. get_result() exports the registers through an
+  HLL_8 image marked out of order, whose estimate comes from the
+  registers alone, as with a union.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MurmurHash3.h"
+#include "common_defs.hpp"
+#include "hll.hpp"
+#include "hll8_registers.hpp"
+
+namespace datasketches {
+
+class atomic_hll_sketch {
+  public:
+    explicit atomic_hll_sketch(uint8_t lg_k):
+    lg_k_(checked_lg_k(lg_k)),
+    registers_(new std::atomic<uint8_t>[size_t(1) << lg_k])
+    {
+      reset();
+    }
+
+    uint8_t get_lg_config_k() const { return lg_k_; }
+
+    void update(int64_t value) { update(&value, sizeof(value)); }
+    void update(uint64_t value) { update(&value, sizeof(value)); }
+    void update(double value) {
+      // -0.0 and 0.0, and all NaNs, hash alike, as with hll_sketch
+      if (value == 0.0) value = 0.0;
+      int64_t bits;
+      if (value != value) bits = 0x7ff8000000000000LL;
+      else std::memcpy(&bits, &value, sizeof(bits));
+      update(bits);
+    }
+    void update(const std::string& value) {
+      if (!value.empty()) update(value.data(), value.size());
+    }
+
+    void update(const void* data, size_t length) {
+      if (data == nullptr || length == 0) return;
+      HashState hashes;
+      MurmurHash3_x64_128(data, length, DEFAULT_SEED, hashes);
+      const uint8_t lz = leading_zeros(hashes.h2);
+      raise(hashes.h1 & ((uint64_t(1) << lg_k_) - 1), (lz > 62 ? 62 : lz) + 1);
+    }
+
+    // raises every register to that of the other sketch, which may be updated concurrently
+    void merge(const atomic_hll_sketch& other) {
+      if (other.lg_k_ != lg_k_) {
+        throw std::invalid_argument("lg_k mismatch: " + std::to_string(lg_k_) + " vs " + std::to_string(other.lg_k_));
+      }
+      for (size_t i = 0; i < num_registers(); ++i) raise(i, other.registers_[i].load(std::memory_order_relaxed));
+    }
+
+    void reset() {
+      for (size_t i = 0; i < num_registers(); ++i) registers_[i].store(0, std::memory_order_relaxed);
+    }
+
+    // a snapshot of the registers, each as of some moment during the call
+    std::vector<uint8_t> get_registers() const {
+      std::vector<uint8_t> values(num_registers());
+      for (size_t i = 0; i < values.size(); ++i) values[i] = registers_[i].load(std::memory_order_relaxed);
+      return values;
+    }
+
+    bool is_empty() const {
+      for (size_t i = 0; i < num_registers(); ++i) {
+        if (registers_[i].load(std::memory_order_relaxed) != 0) return false;
+      }
+      return true;
+    }
+
+    hll_sketch get_result() const {
+      const std::vector<uint8_t> values = get_registers();
+      const hll8_register_stats stats = hll8_accumulate(values.data(), values.size());
+      if (stats.num_zeros == values.size()) return hll_sketch(lg_k_, HLL_8);
+      const std::vector<uint8_t> image = hll8_image::make(lg_k_, values.data(), stats);
+      return hll_sketch::deserialize(image.data(), image.size());
+    }
+
+    size_t get_memory_usage() const { return sizeof(*this) + num_registers(); }
+
+  private:
+    uint8_t lg_k_;
+    std::unique_ptr<std::atomic<uint8_t>[]> registers_;
+
+    size_t num_registers() const { return size_t(1) << lg_k_; }
+
+    void raise(size_t slot, uint8_t value) {
+      std::atomic<uint8_t>& reg = registers_[slot];
+      uint8_t current = reg.load(std::memory_order_relaxed);
+      while (value > current && !reg.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+
+    static uint8_t leading_zeros(uint64_t x) {
+      if (x == 0) return 64;
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<uint8_t>(__builtin_clzll(x));
+#else
+      uint8_t n = 0;
+      while ((x & (uint64_t(1) << 63)) == 0) { x <<= 1; ++n; }
+      return n;
+#endif
+    }
+
+    static uint8_t checked_lg_k(uint8_t lg_k) {
+      if (lg_k < 4 || lg_k > 21) {
+        throw std::invalid_argument("lg_k must be between 4 and 21, inclusive: " + std::to_string(lg_k));
+      }
+      return lg_k;
+    }
+};
+
+} // namespace datasketches
+
+#endif // _ATOMIC_HLL_SKETCH_HPP_
@@ -0,0 +1,216 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _BATCH_SERDE_HPP_
+#define _BATCH_SERDE_HPP_
+
+/*
+  This header defines a container format for storing many serialized
+  sketches in one contiguous blob, and the bindings that read and write it.
+
+  All integers are little-endian, matching the sketch images themselves.
+    bytes 0-3    magic "DSBT"
+    byte  4      format version (1)
+    bytes 5-7    reserved, zero
+    bytes 8-15   uint64 number of images N
+    bytes 16-    N+1 uint64 offsets from the start of the blob, where image i
+                 spans [offset[i], offset[i+1]) and offset[N] is the blob size
+    followed by the concatenated images.
+  The offset table allows random access to any image, e.g. from an mmap.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+
+#include "py_buffer.hpp"
+#include "gil_guard.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+namespace batch_constants {
+  static const char MAGIC[4] = {'D', 'S', 'B', 'T'};
+  static const uint8_t FORMAT_VERSION = 1;
+  static const size_t HEADER_SIZE = 16;
+}
+
+// Validates a batch blob and provides access to each image in place.
+class batch_reader {
+  public:
+    batch_reader(const char* data, size_t size): data_(data), num_images_(0) {
+      using namespace batch_constants;
+      if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::invalid_argument("not a serialized sketch batch");
+      }
+      if (static_cast<uint8_t>(data[4]) != FORMAT_VERSION) {
+        throw std::invalid_argument("unsupported sketch batch version: " + std::to_string(static_cast<uint8_t>(data[4])));
+      }
+      const uint64_t num_images = load_le<uint64_t>(data + 8);
+      if (num_images >= (size - HEADER_SIZE) / sizeof(uint64_t)) {
+        throw std::invalid_argument("sketch batch of " + std::to_string(size) + " bytes is too small for "
+          + std::to_string(num_images) + " images");
+      }
+      num_images_ = static_cast<size_t>(num_images);
+      uint64_t prev = offset(0);
+      if (prev != HEADER_SIZE + (num_images_ + 1) * sizeof(uint64_t)) {
+        throw std::invalid_argument("invalid first image offset in sketch batch: " + std::to_string(prev));
+      }
+      for (size_t i = 1; i <= num_images_; ++i) {
+        const uint64_t next = offset(i);
+        if (next < prev || next > size) {
+          throw std::invalid_argument("invalid offset for image " + std::to_string(i - 1) + " in sketch batch: "
+            + std::to_string(next));
+        }
+        prev = next;
+      }
+    }
+
+    size_t num_images() const { return num_images_; }
+    const char* image(size_t i) const { return data_ + offset(i); }
+    size_t image_size(size_t i) const { return static_cast<size_t>(offset(i + 1) - offset(i)); }
+
+    uint64_t offset(size_t i) const {
+      return load_le<uint64_t>(data_ + batch_constants::HEADER_SIZE + i * sizeof(uint64_t));
+    }
+
+  private:
+    const char* data_;
+    size_t num_images_;
+};
+
+// the size of the batch holding the given serialized images
+template<typename Images>
+size_t batch_size(const Images& images) {
+  size_t total = batch_constants::HEADER_SIZE + (images.size() + 1) * sizeof(uint64_t);
+  for (const auto& image: images) total += image.size();
+  return total;
+}
+
+// writes the batch holding the given images into batch_size(images) bytes at out,
+// which needs no GIL
+template<typename Images>
+void write_batch(const Images& images, char* out) {
+  using namespace batch_constants;
+  const size_t num_images = images.size();
+  std::memset(out, 0, HEADER_SIZE);
+  std::memcpy(out, MAGIC, sizeof(MAGIC));
+  out[4] = static_cast<char>(FORMAT_VERSION);
+  store_le(out + 8, static_cast<uint64_t>(num_images));
+  uint64_t offset = HEADER_SIZE + (num_images + 1) * sizeof(uint64_t);
+  char* table = out + HEADER_SIZE;
+  for (size_t i = 0; i < num_images; ++i) {
+    store_le(table + i * sizeof(uint64_t), offset);
+    if (images[i].size() > 0) std::memcpy(out + offset, images[i].data(), images[i].size());
+    offset += images[i].size();
+  }
+  store_le(table + num_images * sizeof(uint64_t), offset);
+}
+
+/**
+ * @brief Packs the given serialized images, each a contiguous container of
+ * bytes, into a new batch bytes object. Must be called with the GIL held;
+ * the copy itself runs without it.
+ */
+template<typename Images>
+nb::bytes make_batch(const Images& images) {
+  const size_t total = batch_size(images);
+  PyObject* obj = PyBytes_FromStringAndSize(nullptr, static_cast<Py_ssize_t>(total));
+  if (obj == nullptr) throw nb::python_error();
+  nb::bytes result = nb::steal<nb::bytes>(obj);
+  char* out = PyBytes_AsString(obj);
+
+  nb::gil_scoped_release release;
+  write_batch(images, out);
+  return result;
+}
+
+// resolves an optional [start, stop) range of images within a batch
+inline void check_batch_range(const batch_reader& reader, size_t start, std::optional<size_t>& stop) {
+  if (!stop) stop = reader.num_images();
+  if (start > *stop || *stop > reader.num_images()) {
+    throw std::invalid_argument("invalid range [" + std::to_string(start) + ", " + std::to_string(*stop)
+      + ") for a sketch batch of " + std::to_string(reader.num_images()) + " images");
+  }
+}
+
+/**
+ * @brief Adds static serialize_batch() and deserialize_batch() methods to a
+ * sketch class, given functions that serialize one sketch to a byte vector
+ * and deserialize one sketch from (const char*, size_t). Both functions run
+ * without the GIL.
+ */
+template<typename SK, typename... Ts, typename S, typename D>
+void add_batch_serialization(nb::class_<SK, Ts...>& clazz, S serialize, D deserialize) {
+  clazz.def_static(
+    "serialize_batch",
+    [serialize](nb::iterable sketches) {
+      // hold references so the sketches stay alive without the GIL
+      std::vector<nb::object> holders;
+      std::vector<const SK*> ptrs;
+      for (nb::handle h: sketches) {
+        holders.push_back(nb::borrow(h));
+        ptrs.push_back(&nb::cast<const SK&>(h));
+      }
+      using image_type = decltype(serialize(std::declval<const SK&>()));
+      std::vector<image_type> images;
+      images.reserve(ptrs.size());
+      {
+        nb::gil_scoped_release release;
+        for (const SK* sk: ptrs) images.push_back(serialize(*sk));
+      }
+      return make_batch(images);
+    },
+    nb::arg("sketches"),
+    "Serializes a list of sketches into a single bytes object holding a header, an offset table "
+    "and the concatenated images, which can be read back with deserialize_batch()."
+  )
+  .def_static(
+    "deserialize_batch",
+    [deserialize](nb::handle bytes, size_t start, std::optional<size_t> stop) {
+      py_byte_range range(bytes);
+      batch_reader reader(range.data(), range.size());
+      check_batch_range(reader, start, stop);
+      using sketch_type = decltype(deserialize(nullptr, size_t(0)));
+      std::vector<sketch_type> result;
+      result.reserve(*stop - start);
+      {
+        nb::gil_scoped_release release;
+        for (size_t i = start; i < *stop; ++i) result.push_back(deserialize(reader.image(i), reader.image_size(i)));
+      }
+      nb::list list;
+      for (auto& sk: result) list.append(nb::cast(std::move(sk)));
+      return list;
+    },
+    nb::arg("bytes"), nb::arg("start")=0, nb::arg("stop")=nb::none(),
+    "Reads a sketch batch from a bytes object or any other contiguous buffer and returns a list of the "
+    "sketches with indices in [start, stop), by default all of them. Only the requested images are read."
+  );
+}
+
+} // namespace datasketches
+
+#endif // _BATCH_SERDE_HPP_
@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _BUFFER_OSTREAM_HPP_
+#define _BUFFER_OSTREAM_HPP_
+
+/*
+  This header defines helpers for serializing sketches directly into a
+  caller-provided writable buffer, such as a bytearray, NumPy uint8 array
+  or mmap, without an intermediate std::vector or bytes object.
+*/
+
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <utility>
+
+#include <nanobind/nanobind.h>
+
+#include "py_buffer.hpp"
+#include "gil_guard.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+// A fixed-size output stream buffer over caller-owned memory. Writes past
+// the end fail, setting the stream's badbit, rather than reallocating.
+class buffer_streambuf: public std::streambuf {
+  public:
+    buffer_streambuf(char* data, size_t size) { setp(data, data + size); }
+    size_t bytes_written() const { return static_cast<size_t>(pptr() - pbase()); }
+};
+
+/**
+ * @brief Invokes serialize(std::ostream&) on a stream writing to a writable
+ * buffer-protocol object starting at offset, and returns the number of bytes
+ * written. Throws std::invalid_argument if the image does not fit, in which
+ * case the buffer past offset may have been partially overwritten.
+ * The GIL is released while serializing unless items are Python objects.
+ */
+template<typename T, typename F>
+size_t serialize_into_buffer_for(nb::handle buffer, size_t offset, F&& serialize) {
+  py_buffer buf(buffer, PyBUF_WRITABLE);
+  if (offset > buf.size()) {
+    throw std::invalid_argument("offset " + std::to_string(offset) + " is beyond the end of a buffer of "
+      + std::to_string(buf.size()) + " bytes");
+  }
+  buffer_streambuf sb(reinterpret_cast<char*>(buf.writable_data()) + offset, buf.size() - offset);
+  bool ok;
+  {
+    gil_release_for<T> release;
+    std::ostream os(&sb);
+    serialize(os);
+    ok = os.good();
+  }
+  if (!ok) {
+    throw std::invalid_argument("the serialized image does not fit in the " + std::to_string(buf.size() - offset)
+      + " bytes available in the buffer after offset " + std::to_string(offset));
+  }
+  return sb.bytes_written();
+}
+
+// as serialize_into_buffer_for(), always releasing the GIL
+template<typename F>
+size_t serialize_into_buffer(nb::handle buffer, size_t offset, F&& serialize) {
+  return serialize_into_buffer_for<void>(buffer, offset, std::forward<F>(serialize));
+}
+
+} // namespace datasketches
+
+#endif // _BUFFER_OSTREAM_HPP_
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _BYTE_STRING_HPP_
+#define _BYTE_STRING_HPP_
+
+/*
+  This header defines byte_string, a std::string holding arbitrary
+  binary data that converts to and from Python bytes rather than str.
+  It lets sketches keep bytes items natively in C++, with a serde using
+  the same format as std::string so images are interchangeable.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include <nanobind/nanobind.h>
+
+#include "memory_operations.hpp"
+#include "serde.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+struct byte_string: public std::string {
+  using std::string::string;
+  byte_string() = default;
+  explicit byte_string(std::string&& str): std::string(std::move(str)) {}
+};
+
+struct byte_string_hash {
+  size_t operator()(const byte_string& item) const { return std::hash<std::string>()(item); }
+};
+
+// 4-byte length followed by the contents, as in serde<std::string>
+template<>
+struct serde<byte_string> {
+  void serialize(std::ostream& os, const byte_string* items, unsigned num) const {
+    for (unsigned i = 0; i < num && os.good(); ++i) {
+      const uint32_t length = static_cast<uint32_t>(items[i].size());
+      os.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      os.write(items[i].data(), length);
+    }
+    if (!os.good()) throw std::runtime_error("error writing to std::ostream");
+  }
+
+  void deserialize(std::istream& is, byte_string* items, unsigned num) const {
+    unsigned i = 0;
+    bool failure = false;
+    for (; i < num; ++i) {
+      uint32_t length;
+      is.read(reinterpret_cast<char*>(&length), sizeof(length));
+      if (!is.good()) { failure = true; break; }
+      std::string str(length, '\0');
+      if (length > 0) is.read(&str[0], length);
+      if (!is.good()) { failure = true; break; }
+      new (&items[i]) byte_string(std::move(str));
+    }
+    if (failure) {
+      // clean up what we've allocated
+      for (unsigned j = 0; j < i; ++j) items[j].~byte_string();
+      throw std::runtime_error("error reading from std::istream");
+    }
+  }
+
+  size_t serialize(void* ptr, size_t capacity, const byte_string* items, unsigned num) const {
+    char* out = static_cast<char*>(ptr);
+    size_t bytes_written = 0;
+    for (unsigned i = 0; i < num; ++i) {
+      const uint32_t length = static_cast<uint32_t>(items[i].size());
+      check_memory_size(bytes_written + sizeof(length) + length, capacity);
+      std::memcpy(out + bytes_written, &length, sizeof(length));
+      std::memcpy(out + bytes_written + sizeof(length), items[i].data(), length);
+      bytes_written += sizeof(length) + length;
+    }
+    return bytes_written;
+  }
+
+  size_t deserialize(const void* ptr, size_t capacity, byte_string* items, unsigned num) const {
+    const char* in = static_cast<const char*>(ptr);
+    size_t bytes_read = 0;
+    unsigned i = 0;
+    try {
+      for (; i < num; ++i) {
+        uint32_t length;
+        check_memory_size(bytes_read + sizeof(length), capacity);
+        std::memcpy(&length, in + bytes_read, sizeof(length));
+        bytes_read += sizeof(length);
+        check_memory_size(bytes_read + length, capacity);
+        new (&items[i]) byte_string(in + bytes_read, length);
+        bytes_read += length;
+      }
+    } catch (...) {
+      for (unsigned j = 0; j < i; ++j) items[j].~byte_string();
+      throw;
+    }
+    return bytes_read;
+  }
+
+  size_t size_of_item(const byte_string& item) const {
+    return sizeof(uint32_t) + item.size();
+  }
+};
+
+} // namespace datasketches
+
+namespace nanobind {
+namespace detail {
+
+template<>
+struct type_caster<datasketches::byte_string> {
+  NB_TYPE_CASTER(datasketches::byte_string, const_name("bytes"))
+
+  bool from_python(handle src, uint8_t, cleanup_list*) noexcept {
+    if (!PyBytes_Check(src.ptr())) return false;
+    char* data;
+    Py_ssize_t size;
+    if (PyBytes_AsStringAndSize(src.ptr(), &data, &size) != 0) {
+      PyErr_Clear();
+      return false;
+    }
+    value.assign(data, static_cast<size_t>(size));
+    return true;
+  }
+
+  static handle from_cpp(const datasketches::byte_string& value, rv_policy, cleanup_list*) noexcept {
+    return PyBytes_FromStringAndSize(value.data(), static_cast<Py_ssize_t>(value.size()));
+  }
+};
+
+} // namespace detail
+} // namespace nanobind
+
+#endif // _BYTE_STRING_HPP_
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _CONCURRENT_THETA_SKETCH_HPP_
+#define _CONCURRENT_THETA_SKETCH_HPP_
+
+/*
+  This header defines concurrent_theta_sketch, a theta sketch that many
+  threads may update at once. Each thread hashes its items and screens
+  them against the theta of a shared update_theta_sketch, published as an
+  atomic, then appends the survivors to one of several small buffers
+  chosen by thread. A full buffer is propagated into the shared sketch
+  under its lock. Queries read the shared sketch, which lags the updates
+  by at most num_buffers * buffer_size items that passed the screen;
+  flush() propagates them all.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MurmurHash3.h"
+#include "theta_sketch.hpp"
+
+namespace datasketches {
+
+class concurrent_theta_sketch {
+  public:
+    static const uint32_t DEFAULT_BUFFER_SIZE = 16;
+
+    // num_buffers of 0 means one per hardware thread
+    concurrent_theta_sketch(uint8_t lg_k, float p, uint64_t seed, uint32_t buffer_size, unsigned num_buffers):
+    shared_(update_theta_sketch::builder().set_lg_k(lg_k).set_p(p).set_seed(seed).build()),
+    seed_(seed),
+    theta_(shared_.get_theta64()),
+    buffer_size_(buffer_size),
+    num_buffers_(num_buffers > 0 ? num_buffers : std::max(1u, std::thread::hardware_concurrency())),
+    buffers_(new buffer[num_buffers_])
+    {
+      if (buffer_size == 0) throw std::invalid_argument("buffer_size must be at least 1");
+      for (unsigned i = 0; i < num_buffers_; ++i) buffers_[i].items.reserve(buffer_size);
+    }
+
+    void update(int64_t value) { update(&value, sizeof(value)); }
+    void update(uint64_t value) { update(&value, sizeof(value)); }
+    void update(double value) { update(canonical_bits(value)); }
+    void update(const std::string& value) {
+      if (!value.empty()) update(value.data(), value.size());
+    }
+
+    void update(const void* data, size_t length) {
+      HashState hashes;
+      MurmurHash3_x64_128(data, length, seed_, hashes);
+      const uint64_t hash = hashes.h1 >> 1;
+      // a stale theta is only larger, so this never drops an item the shared sketch would keep
+      if (hash == 0 || hash >= theta_.load(std::memory_order_relaxed)) return;
+      buffer& buf = buffers_[thread_slot() % num_buffers_];
+      std::lock_guard<std::mutex> lock(buf.mutex);
+      buf.items.emplace_back(static_cast<const char*>(data), length);
+      if (buf.items.size() >= buffer_size_) propagate(buf);
+    }
+
+    // propagates every buffered item into the shared sketch
+    void flush() {
+      for (unsigned i = 0; i < num_buffers_; ++i) {
+        std::lock_guard<std::mutex> lock(buffers_[i].mutex);
+        propagate(buffers_[i]);
+      }
+    }
+
+    // evaluates f(shared sketch) under its lock, without flushing
+    template<typename F>
+    auto query(F&& f) const -> decltype(f(std::declval<const update_theta_sketch&>())) {
+      std::lock_guard<std::mutex> lock(shared_mutex_);
+      return f(shared_);
+    }
+
+    compact_theta_sketch compact(bool ordered) {
+      flush();
+      return query([ordered](const update_theta_sketch& sk) { return sk.compact(ordered); });
+    }
+
+    void reset() {
+      for (unsigned i = 0; i < num_buffers_; ++i) {
+        std::lock_guard<std::mutex> lock(buffers_[i].mutex);
+        buffers_[i].items.clear();
+      }
+      std::lock_guard<std::mutex> lock(shared_mutex_);
+      shared_.reset();
+      theta_.store(shared_.get_theta64(), std::memory_order_relaxed);
+    }
+
+    uint32_t get_buffer_size() const { return buffer_size_; }
+    unsigned get_num_buffers() const { return num_buffers_; }
+    uint64_t get_max_pending() const { return static_cast<uint64_t>(buffer_size_) * num_buffers_; }
+
+  private:
+    // padded to a cache line, so threads on different buffers do not share one
+    struct alignas(64) buffer {
+      std::mutex mutex;
+      std::vector<std::string> items; // raw bytes of each item, as hashed by the shared sketch
+    };
+
+    mutable std::mutex shared_mutex_;
+    update_theta_sketch shared_;
+    uint64_t seed_;
+    std::atomic<uint64_t> theta_;
+    uint32_t buffer_size_;
+    unsigned num_buffers_;
+    std::unique_ptr<buffer[]> buffers_;
+
+    // called with the buffer lock held; takes the shared lock after it
+    void propagate(buffer& buf) {
+      if (buf.items.empty()) return;
+      std::lock_guard<std::mutex> lock(shared_mutex_);
+      for (const std::string& item: buf.items) shared_.update(item.data(), item.size());
+      theta_.store(shared_.get_theta64(), std::memory_order_relaxed);
+      buf.items.clear();
+    }
+
+    // threads take buffers round-robin in the order they first update any sketch
+    static unsigned thread_slot() {
+      static std::atomic<unsigned> next_slot{0};
+      thread_local const unsigned slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+      return slot;
+    }
+
+    // the canonical form of a double hashed by the theta sketches, treating -0.0 as 0.0 and all NaNs alike
+    static int64_t canonical_bits(double value) {
+      if (value == 0.0) value = 0.0;
+      int64_t bits;
+      if (value != value) bits = 0x7ff8000000000000LL;
+      else std::memcpy(&bits, &value, sizeof(bits));
+      return bits;
+    }
+};
+
+} // namespace datasketches
+
+#endif // _CONCURRENT_THETA_SKETCH_HPP_
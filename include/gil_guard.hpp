@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _GIL_GUARD_HPP_
+#define _GIL_GUARD_HPP_
+
+/*
+  This header defines helpers for releasing the GIL around pure C++
+  work. Sketches over nb::object items call back into Python to compare,
+  hash or serialize items, so they must keep holding the GIL. The choice
+  is made at compile time from the item type.
+  Const queries that fill a cache inside the sketch, such as the sorted
+  view of the quantile sketches or the buffer merge of a tdigest, also
+  keep holding it, or two threads querying one sketch would race.
+*/
+
+#include <type_traits>
+
+#include <nanobind/nanobind.h>
+
+namespace nb = nanobind;
+
+// stand-in for nb::gil_scoped_release when the GIL must be kept
+struct gil_scoped_noop {
+  gil_scoped_noop() = default;
+  gil_scoped_noop(const gil_scoped_noop&) = delete;
+  gil_scoped_noop& operator=(const gil_scoped_noop&) = delete;
+};
+
+// a scoped guard releasing the GIL unless items are Python objects
+template<typename T>
+using gil_release_for = typename std::conditional<std::is_same<T, nb::object>::value,
+                                                  gil_scoped_noop, nb::gil_scoped_release>::type;
+
+// binding annotation: nb::call_guard<nb::gil_scoped_release> unless items are Python objects
+template<typename T>
+using release_gil_guard = nb::call_guard<gil_release_for<T>>;
+
+// binding annotation for methods that never touch Python objects
+using release_gil = nb::call_guard<nb::gil_scoped_release>;
+
+// invokes f() with the GIL released and returns its result, for use inside
+// bindings that must still create Python objects (e.g. bytes) afterwards
+template<typename F>
+auto call_without_gil(F&& f) -> decltype(f()) {
+  nb::gil_scoped_release release;
+  return f();
+}
+
+// as call_without_gil(), but keeps the GIL when items are Python objects
+template<typename T, typename F>
+auto call_without_gil_for(F&& f) -> decltype(f()) {
+  gil_release_for<T> release;
+  return f();
+}
+
+#endif // _GIL_GUARD_HPP_
@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _HASH_UPDATE_HPP_
+#define _HASH_UPDATE_HPP_
+
+/*
+  This header defines vectorized update methods shared across
+  the sketches that hash their input items (HLL, CPC, Theta).
+  Each method runs the full loop in C++ with the GIL released.
+*/
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+
+#include "py_buffer.hpp"
+#include "arrow_array.hpp"
+#include "sketch_stats.hpp"
+
+namespace nb = nanobind;
+
+// host memory only, since the loop reads the data pointer directly
+template<typename T, typename SK>
+void update_from_ndarray(SK& sk, nb::ndarray<T, nb::device::cpu>& items) {
+  if (items.ndim() != 1) {
+    throw std::invalid_argument("input data must have only one dimension. Found: "
+      + std::to_string(items.ndim()));
+  }
+  auto v = items.template view<T, nb::ndim<1>>();
+  datasketches::stats_probe<SK> probe(sk);
+  nb::gil_scoped_release release;
+  for (size_t i = 0; i < v.shape(0); ++i) probe.update(sk, [&] { sk.update(v(i)); });
+}
+
+template<typename SK>
+void update_from_string_array(SK& sk, nb::handle array) {
+  datasketches::py_buffer buf(array);
+  datasketches::stats_probe<SK> probe(sk);
+  nb::gil_scoped_release release;
+  datasketches::for_each_fixed_width_string(buf, [&sk, &probe](const char* data, size_t length) {
+    // empty strings are ignored, as with the scalar update
+    if (length > 0) probe.update(sk, [&] { sk.update(data, length); });
+  });
+}
+
+template<typename SK>
+void update_from_offset_array(SK& sk, nb::handle offsets, nb::handle data) {
+  datasketches::py_buffer offsets_buf(offsets);
+  datasketches::py_buffer data_buf(data, PyBUF_SIMPLE);
+  datasketches::stats_probe<SK> probe(sk);
+  nb::gil_scoped_release release;
+  datasketches::for_each_offset_string(offsets_buf, data_buf, [&sk, &probe](const char* item, size_t length) {
+    if (length > 0) probe.update(sk, [&] { sk.update(item, length); });
+  });
+}
+
+// integers, floats and binary items hash as the int, float and bytes or str updates do
+template<typename SK>
+void update_from_arrow(SK& sk, nb::handle array) {
+  datasketches::for_each_arrow_chunk(array, [&sk](const ArrowSchema& schema, const ArrowArray& chunk) {
+    const datasketches::arrow_type type = datasketches::get_arrow_type(schema);
+    datasketches::stats_probe<SK> probe(sk);
+    nb::gil_scoped_release release;
+    datasketches::for_each_arrow_value(type, chunk, 0, [&sk, &probe](auto value) {
+      if constexpr (std::is_same<decltype(value), datasketches::arrow_binary>::value) {
+        if (value.size > 0) probe.update(sk, [&] { sk.update(value.data, value.size); });
+      } else {
+        probe.update(sk, [&] { sk.update(value); });
+      }
+    });
+  });
+}
+
+template<typename SK, typename... Ts>
+void add_hash_vector_update(nb::class_<SK, Ts...>& clazz) {
+  clazz.def(
+    "update",
+    [](SK& sk, nb::ndarray<int64_t, nb::device::cpu> items) { update_from_ndarray(sk, items); },
+    nb::arg("array"),
+    "Updates the sketch with the values in the given array of 64-bit integers"
+  )
+  .def(
+    "update",
+    [](SK& sk, nb::ndarray<uint64_t, nb::device::cpu> items) { update_from_ndarray(sk, items); },
+    nb::arg("array"),
+    "Updates the sketch with the values in the given array of unsigned 64-bit integers"
+  )
+  .def(
+    "update",
+    [](SK& sk, nb::ndarray<double, nb::device::cpu> items) { update_from_ndarray(sk, items); },
+    nb::arg("array"),
+    "Updates the sketch with the values in the given array of 64-bit floating point values"
+  )
+  .def(
+    "update_strings",
+    [](SK& sk, nb::handle array) { update_from_string_array(sk, array); },
+    nb::arg("array"),
+    "Updates the sketch with every item of a NumPy fixed-width bytes ('S') or unicode ('U') array. "
+    "Unicode items are hashed as UTF-8, giving the same result as updating with each str individually. "
+    "Empty items are ignored."
+  )
+  .def(
+    "update_binary",
+    [](SK& sk, nb::handle offsets, nb::handle data) { update_from_offset_array(sk, offsets, data); },
+    nb::arg("offsets"), nb::arg("data"),
+    "Updates the sketch with every item of an Arrow-style variable-width binary or string array, "
+    "where item i is data[offsets[i]:offsets[i+1]].\n\n"
+    ":param offsets: An array of n+1 32- or 64-bit integer offsets into data\n:type offsets: buffer\n"
+    ":param data: A contiguous buffer holding the concatenated items\n:type data: buffer"
+  )
+  .def(
+    "update_arrow",
+    [](SK& sk, nb::handle array) { update_from_arrow(sk, array); },
+    nb::arg("array"),
+    "Updates the sketch with every non-null item of an Arrow integer, floating point, utf8 or binary array, "
+    "read in place through the Arrow C Data Interface. Chunked arrays are read chunk by chunk. "
+    "Items hash as with the scalar updates, integers of any width as int and floats as float. Empty items are ignored.\n\n"
+    ":param array: Any object implementing __arrow_c_array__ or __arrow_c_stream__, such as a pyarrow Array "
+    "or ChunkedArray\n:type array: Arrow array"
+  );
+}
+
+#endif // _HASH_UPDATE_HPP_
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _HLL8_REGISTERS_HPP_
+#define _HLL8_REGISTERS_HPP_
+
+/*
+  This header defines kernels over the register arrays of dense HLL_8
+  sketches, one byte per register, and helpers reading and writing their
+  serialized images in place. merge_hll() uses them to take the union of
+  HLL_8 images without deserializing them: a register-wise max and one
+  pass accumulating the sums of the HLL estimators. atomic_hll_sketch
+  exports its registers through the same image.
+
+  The kernels are defined in src/hll8_registers.cpp with an AVX2 version
+  on x86, chosen at run time when the CPU supports it, an SSE2 version
+  otherwise, a NEON version on AArch64, and a scalar fallback.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace datasketches {
+
+// the sums the HLL estimators are computed from
+struct hll8_register_stats {
+  double kxq0; // sum of 2^-v over the registers v < 32
+  double kxq1; // sum of 2^-v over the registers v >= 32
+  uint32_t num_zeros; // the number of registers at the minimum value of HLL_8
+};
+
+// dst[i] = max(dst[i], src[i]) for i in [0, n)
+void hll8_max_registers(uint8_t* dst, const uint8_t* src, size_t n);
+
+hll8_register_stats hll8_accumulate(const uint8_t* registers, size_t n);
+
+// the name of the kernels selected for this CPU: "avx2", "sse2", "neon" or "scalar"
+const char* hll8_kernel_name();
+
+/*
+  Serialized HLL sketches in HLL mode start with a 40-byte preamble of
+  the format shared with the Java library, followed by the registers,
+  which for HLL_8 are 2^lg_k bytes with no auxiliary table.
+*/
+namespace hll8_image {
+  static const size_t PREAMBLE_INTS_BYTE = 0;
+  static const size_t SER_VER_BYTE = 1;
+  static const size_t FAMILY_BYTE = 2;
+  static const size_t LG_K_BYTE = 3;
+  static const size_t FLAGS_BYTE = 5;
+  static const size_t CUR_MIN_BYTE = 6;
+  static const size_t MODE_BYTE = 7;
+  static const size_t HIP_ACCUM_DOUBLE = 8;
+  static const size_t KXQ0_DOUBLE = 16;
+  static const size_t KXQ1_DOUBLE = 24;
+  static const size_t CUR_MIN_COUNT_INT = 32;
+  static const size_t AUX_COUNT_INT = 36;
+  static const size_t REGISTERS_START = 40;
+
+  static const uint8_t HLL_PREAMBLE_INTS = 10;
+  static const uint8_t SER_VER = 1;
+  static const uint8_t FAMILY_ID = 7;
+  static const uint8_t OUT_OF_ORDER_FLAG_MASK = 16;
+  static const uint8_t HLL_MODE = 2;
+  static const uint8_t HLL_8_TYPE = 2;
+
+  // the registers of an image of a dense HLL_8 sketch of the given lg_k, or nullptr for any other image
+  inline const uint8_t* dense_registers(const uint8_t* data, size_t size, uint8_t lg_k) {
+    if (size != REGISTERS_START + (size_t(1) << lg_k)) return nullptr;
+    if (data[PREAMBLE_INTS_BYTE] != HLL_PREAMBLE_INTS || data[SER_VER_BYTE] != SER_VER
+        || data[FAMILY_BYTE] != FAMILY_ID || data[LG_K_BYTE] != lg_k) return nullptr;
+    const uint8_t mode = data[MODE_BYTE];
+    if ((mode & 3) != HLL_MODE || ((mode >> 2) & 3) != HLL_8_TYPE) return nullptr;
+    return data + REGISTERS_START;
+  }
+
+  /**
+   * @brief Writes the image of a dense HLL_8 sketch of the given registers,
+   * marked out of order as a union result is, so that its estimate is the
+   * composite estimate computed from the stats.
+   */
+  inline std::vector<uint8_t> make(uint8_t lg_k, const uint8_t* registers, const hll8_register_stats& stats) {
+    const size_t k = size_t(1) << lg_k;
+    std::vector<uint8_t> image(REGISTERS_START + k, 0);
+    image[PREAMBLE_INTS_BYTE] = HLL_PREAMBLE_INTS;
+    image[SER_VER_BYTE] = SER_VER;
+    image[FAMILY_BYTE] = FAMILY_ID;
+    image[LG_K_BYTE] = lg_k;
+    image[FLAGS_BYTE] = OUT_OF_ORDER_FLAG_MASK;
+    image[CUR_MIN_BYTE] = 0;
+    image[MODE_BYTE] = HLL_MODE | (HLL_8_TYPE << 2);
+    const double hip_accum = 0;
+    const int32_t num_at_cur_min = static_cast<int32_t>(stats.num_zeros);
+    const int32_t aux_count = 0;
+    std::memcpy(image.data() + HIP_ACCUM_DOUBLE, &hip_accum, sizeof(hip_accum));
+    std::memcpy(image.data() + KXQ0_DOUBLE, &stats.kxq0, sizeof(stats.kxq0));
+    std::memcpy(image.data() + KXQ1_DOUBLE, &stats.kxq1, sizeof(stats.kxq1));
+    std::memcpy(image.data() + CUR_MIN_COUNT_INT, &num_at_cur_min, sizeof(num_at_cur_min));
+    std::memcpy(image.data() + AUX_COUNT_INT, &aux_count, sizeof(aux_count));
+    std::memcpy(image.data() + REGISTERS_START, registers, k);
+    return image;
+  }
+}
+
+} // namespace datasketches
+
+#endif // _HLL8_REGISTERS_HPP_
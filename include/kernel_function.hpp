@@ -17,6 +17,12 @@
  * under the License.
  */
 
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <nanobind/nanobind.h>
 #include <nanobind/trampoline.h>
 #include <nanobind/ndarray.h>
@@ -66,19 +72,145 @@ struct KernelFunction : public kernel_function {
   }
 };
 
+/**
+ * @brief native_kernel is the base class of the built-in kernels, which the
+ *        sketch evaluates directly on its vectors without calling into Python.
+ *        Calling one from Python evaluates the same function on two arrays.
+ */
+struct native_kernel : public kernel_function {
+  virtual double evaluate(const double* a, const double* b, size_t dim) const = 0;
+
+  double operator()(nb::handle& a, nb::handle& b) const override {
+    const std::vector<double> va = to_vector(a);
+    const std::vector<double> vb = to_vector(b);
+    if (va.size() != vb.size()) {
+      throw std::invalid_argument("vectors must have the same dimension: " + std::to_string(va.size())
+        + " vs " + std::to_string(vb.size()));
+    }
+    return evaluate(va.data(), vb.data(), va.size());
+  }
+
+  private:
+    static std::vector<double> to_vector(nb::handle& h) {
+      auto array = nb::cast<nb::ndarray<double, nb::ndim<1>>>(h);
+      auto v = array.template view<double, nb::ndim<1>>();
+      std::vector<double> result(v.shape(0));
+      for (size_t i = 0; i < result.size(); ++i) result[i] = v(i);
+      return result;
+    }
+};
+
+// The distance loops keep four independent partial sums, which lets the
+// compiler vectorize the reductions without reassociating (no -ffast-math).
+
+inline double squared_distance(const double* a, const double* b, size_t dim) {
+  double acc[4] = {0, 0, 0, 0};
+  size_t i = 0;
+  for (; i + 4 <= dim; i += 4) {
+    for (size_t j = 0; j < 4; ++j) {
+      const double d = a[i + j] - b[i + j];
+      acc[j] += d * d;
+    }
+  }
+  for (; i < dim; ++i) acc[0] += (a[i] - b[i]) * (a[i] - b[i]);
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+inline double manhattan_distance(const double* a, const double* b, size_t dim) {
+  double acc[4] = {0, 0, 0, 0};
+  size_t i = 0;
+  for (; i + 4 <= dim; i += 4) {
+    for (size_t j = 0; j < 4; ++j) acc[j] += std::abs(a[i + j] - b[i + j]);
+  }
+  for (; i < dim; ++i) acc[0] += std::abs(a[i] - b[i]);
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+inline double dot_product(const double* a, const double* b, size_t dim) {
+  double acc[4] = {0, 0, 0, 0};
+  size_t i = 0;
+  for (; i + 4 <= dim; i += 4) {
+    for (size_t j = 0; j < 4; ++j) acc[j] += a[i + j] * b[i + j];
+  }
+  for (; i < dim; ++i) acc[0] += a[i] * b[i];
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+inline double checked_bandwidth(double bandwidth) {
+  if (!(bandwidth > 0)) throw std::invalid_argument("bandwidth must be positive, found " + std::to_string(bandwidth));
+  return bandwidth;
+}
+
+// K(a, b) = exp(-||a - b||^2 / (2 h^2))
+struct native_gaussian_kernel : public native_kernel {
+  explicit native_gaussian_kernel(double bandwidth = 1.0) :
+    _bandwidth(checked_bandwidth(bandwidth)), _scale(-0.5 / (_bandwidth * _bandwidth)) {}
+
+  double evaluate(const double* a, const double* b, size_t dim) const override {
+    return std::exp(_scale * squared_distance(a, b, dim));
+  }
+
+  double get_bandwidth() const { return _bandwidth; }
+
+  private:
+    double _bandwidth;
+    double _scale;
+};
+
+// K(a, b) = exp(-||a - b||_1 / h)
+struct native_laplacian_kernel : public native_kernel {
+  explicit native_laplacian_kernel(double bandwidth = 1.0) :
+    _bandwidth(checked_bandwidth(bandwidth)) {}
+
+  double evaluate(const double* a, const double* b, size_t dim) const override {
+    return std::exp(-manhattan_distance(a, b, dim) / _bandwidth);
+  }
+
+  double get_bandwidth() const { return _bandwidth; }
+
+  private:
+    double _bandwidth;
+};
+
+// K(a, b) = (gamma <a, b> + coef0)^degree
+struct native_polynomial_kernel : public native_kernel {
+  explicit native_polynomial_kernel(unsigned degree = 2, double gamma = 1.0, double coef0 = 1.0) :
+    _degree(degree), _gamma(gamma), _coef0(coef0) {
+    if (degree == 0) throw std::invalid_argument("degree must be at least 1");
+  }
+
+  double evaluate(const double* a, const double* b, size_t dim) const override {
+    const double base = _gamma * dot_product(a, b, dim) + _coef0;
+    double result = base;
+    for (unsigned i = 1; i < _degree; ++i) result *= base;
+    return result;
+  }
+
+  unsigned get_degree() const { return _degree; }
+  double get_gamma() const { return _gamma; }
+  double get_coef0() const { return _coef0; }
+
+  private:
+    unsigned _degree;
+    double _gamma;
+    double _coef0;
+};
+
 /* The kernel_function_holder provides a concrete class that dispatches calls
  * from the sketch to the kernel_function. This class is needed to provide a
  * concrete object to produce a compiled library, but library users should
- * never need to use this directly.
+ * never need to use this directly. Native kernels are evaluated directly;
+ * Python kernels acquire the GIL, so the sketch can be used without it.
  */
 struct kernel_function_holder {
-  explicit kernel_function_holder(kernel_function* kernel) : _kernel(kernel) {}
-  kernel_function_holder(const kernel_function_holder& other) : _kernel(other._kernel) {}
-  kernel_function_holder(kernel_function_holder&& other) : _kernel(std::move(other._kernel)) {}
-  kernel_function_holder& operator=(const kernel_function_holder& other) { _kernel = other._kernel; return *this; }
-  kernel_function_holder& operator=(kernel_function_holder&& other) { std::swap(_kernel, other._kernel); return *this; }
+  explicit kernel_function_holder(kernel_function* kernel) : _kernel(kernel), _native(dynamic_cast<native_kernel*>(kernel)) {}
+  kernel_function_holder(const kernel_function_holder& other) : _kernel(other._kernel), _native(other._native) {}
+  kernel_function_holder(kernel_function_holder&& other) : _kernel(std::move(other._kernel)), _native(other._native) {}
+  kernel_function_holder& operator=(const kernel_function_holder& other) { _kernel = other._kernel; _native = other._native; return *this; }
+  kernel_function_holder& operator=(kernel_function_holder&& other) { std::swap(_kernel, other._kernel); std::swap(_native, other._native); return *this; }
 
   double operator()(const std::vector<double>& a, nb::object& b) const {
+    nb::gil_scoped_acquire acquire;
     const npy_intp size_a[1] { static_cast<npy_int>(a.size()) };
     nb::handle a_obj(PyArray_SimpleNewFromData(1, size_a, NPY_DOUBLE, const_cast<double*>(a.data())));
     return _kernel->operator()(
@@ -88,6 +220,8 @@ struct kernel_function_holder {
   }
 
   double operator()(const std::vector<double>& a, const std::vector<double>& b) const {
+    if (_native != nullptr) return _native->evaluate(a.data(), b.data(), a.size());
+    nb::gil_scoped_acquire acquire;
     const npy_intp size_a[1] { static_cast<npy_int>(a.size()) };
     const npy_intp size_b[1] { static_cast<npy_int>(b.size()) };
     nb::handle a_obj(PyArray_SimpleNewFromData(1, size_a, NPY_DOUBLE, const_cast<double*>(a.data())));
@@ -101,6 +235,7 @@ struct kernel_function_holder {
 
   private:
     nb::ref<kernel_function> _kernel;
+    const native_kernel* _native; // _kernel itself when built in, otherwise nullptr
 };
 
 }
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MEMORY_USAGE_HPP_
+#define _MEMORY_USAGE_HPP_
+
+/*
+  This header defines get_memory_usage() for the sketch types, returning
+  the approximate number of bytes held by a sketch: the object itself
+  plus its heap storage, derived from its public state since the sketch
+  templates do not report their allocations. Python objects held as items
+  or summaries are counted as references only.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "hll.hpp"
+#include "kll_sketch.hpp"
+#include "theta_sketch.hpp"
+#include "tuple_sketch.hpp"
+#include "tdigest.hpp"
+
+namespace datasketches {
+
+namespace memory_usage_internal {
+
+template<typename T>
+size_t item_heap_bytes(const T&) { return 0; }
+
+inline size_t item_heap_bytes(const std::string& item) {
+  static const size_t inline_capacity = std::string().capacity();
+  return item.capacity() > inline_capacity ? item.capacity() + 1 : 0;
+}
+
+// the size of the hash table of an update theta or tuple sketch, which starts at
+// 2^5 entries and doubles while more than half full, up to 2^(lg_k + 1)
+inline size_t hash_table_entries(uint8_t lg_k, uint32_t num_retained) {
+  uint8_t lg_size = 5;
+  while (lg_size <= lg_k && num_retained > (1u << lg_size) / 2) ++lg_size;
+  return size_t(1) << lg_size;
+}
+
+} // namespace memory_usage_internal
+
+template<typename A>
+size_t get_memory_usage(const hll_sketch_alloc<A>& sk) {
+  // the updatable image mirrors the in-memory arrays and auxiliary tables
+  return sizeof(sk) + sk.get_updatable_serialization_bytes();
+}
+
+template<typename T, typename C, typename A>
+size_t get_memory_usage(const kll_sketch<T, C, A>& sk) {
+  size_t bytes = sizeof(sk) + sk.get_num_retained() * sizeof(T);
+  if constexpr (!std::is_arithmetic<T>::value) {
+    for (auto it = sk.begin(); it != sk.end(); ++it) bytes += memory_usage_internal::item_heap_bytes((*it).first);
+  }
+  return bytes;
+}
+
+template<typename A>
+size_t get_memory_usage(const update_theta_sketch_alloc<A>& sk) {
+  return sizeof(sk) + memory_usage_internal::hash_table_entries(sk.get_lg_k(), sk.get_num_retained()) * sizeof(uint64_t);
+}
+
+template<typename A>
+size_t get_memory_usage(const compact_theta_sketch_alloc<A>& sk) {
+  return sizeof(sk) + sk.get_num_retained() * sizeof(uint64_t);
+}
+
+template<typename S, typename U, typename P, typename A>
+size_t get_memory_usage(const update_tuple_sketch<S, U, P, A>& sk) {
+  using entry = std::pair<uint64_t, S>;
+  return sizeof(sk) + memory_usage_internal::hash_table_entries(sk.get_lg_k(), sk.get_num_retained()) * sizeof(entry);
+}
+
+template<typename S, typename A>
+size_t get_memory_usage(const compact_tuple_sketch<S, A>& sk) {
+  using entry = std::pair<uint64_t, S>;
+  return sizeof(sk) + sk.get_num_retained() * sizeof(entry);
+}
+
+template<typename T, typename A>
+size_t get_memory_usage(const tdigest<T, A>& td) {
+  // centroids of (mean, weight) and a buffer five times as large, reserved up front
+  const size_t num_centroids = 2 * td.get_k() + (td.get_k() < 30 ? 30 : 10);
+  return sizeof(td) + num_centroids * (sizeof(T) + sizeof(uint64_t)) + 5 * num_centroids * sizeof(T);
+}
+
+// for containers, whose member get_memory_usage() hides the overloads above;
+// argument-dependent lookup also finds overloads declared after this header
+template<typename SK>
+size_t sketch_memory_usage(const SK& sk) { return get_memory_usage(sk); }
+
+} // namespace datasketches
+
+#endif // _MEMORY_USAGE_HPP_
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MERGE_TREE_HPP_
+#define _MERGE_TREE_HPP_
+
+/*
+  This header defines merge_tree, a binary tree of partial merges over a
+  sequence of leaf sketches held elsewhere. Since merging cannot be undone,
+  a changed leaf is invalidated instead, which marks the nodes on its path
+  to the root, and refresh() recomputes only those: O(log n) merges per
+  changed leaf rather than n for merging every leaf again, and the merge
+  of any range of leaves takes O(log n) merges of nodes. Nodes of one
+  level are recomputed in parallel, so leaves must be safe to read from
+  several threads. Merge is a policy merging its second argument into its
+  first, by default through the merge() member of the sketch.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "memory_usage.hpp"
+
+namespace datasketches {
+
+struct member_merge {
+  template<typename SK>
+  void operator()(SK& sk, const SK& other) const { sk.merge(other); }
+};
+
+template<typename SK, typename Merge = member_merge>
+class merge_tree {
+  public:
+    // a tree over num_leaves leaves, with every node dirty, where empty is the sketch nodes start from
+    merge_tree(size_t num_leaves, SK empty, Merge merge = Merge()):
+    num_leaves_(num_leaves),
+    capacity_(1),
+    empty_(std::move(empty)),
+    merge_(std::move(merge)),
+    nodes_(),
+    dirty_()
+    {
+      while (capacity_ < num_leaves_) capacity_ *= 2;
+      // node n >= 1 is stored at n - 1, with children 2n and 2n + 1, and leaf i is node capacity_ + i
+      nodes_.assign(capacity_ - 1, empty_);
+      dirty_.assign(capacity_ - 1, 1);
+    }
+
+    size_t num_leaves() const { return num_leaves_; }
+
+    void invalidate(size_t leaf) {
+      for (size_t node = (capacity_ + leaf) / 2; node >= 1 && !dirty_[node - 1]; node /= 2) dirty_[node - 1] = 1;
+    }
+
+    /**
+     * @brief Recomputes the dirty nodes and returns the merge of all leaves,
+     * where leaf(i) returns a const reference to the sketch of leaf i.
+     */
+    template<typename Leaf>
+    const SK& refresh(Leaf&& leaf, unsigned num_threads) {
+      if (capacity_ == 1) return leaf(0);
+      std::vector<size_t> dirty_nodes;
+      for (size_t level_begin = capacity_ / 2; level_begin >= 1; level_begin /= 2) {
+        dirty_nodes.clear();
+        for (size_t node = level_begin; node < 2 * level_begin; ++node) {
+          if (dirty_[node - 1]) dirty_nodes.push_back(node);
+        }
+        parallel_for(dirty_nodes.size(), num_threads, [&](size_t i) {
+          const size_t node = dirty_nodes[i];
+          SK& result = nodes_[node - 1];
+          result = empty_;
+          merge_child(result, 2 * node, leaf);
+          merge_child(result, 2 * node + 1, leaf);
+          dirty_[node - 1] = 0;
+        });
+      }
+      return nodes_[0];
+    }
+
+    /**
+     * @brief Merges leaves [begin, end) into result, from at most 2 log n nodes.
+     * Requires a refresh() since the last invalidation.
+     */
+    template<typename Leaf>
+    void merge_range(size_t begin, size_t end, Leaf&& leaf, SK& result) const {
+      for (size_t lo = capacity_ + begin, hi = capacity_ + end; lo < hi; lo /= 2, hi /= 2) {
+        if (lo & 1) merge_child(result, lo++, leaf);
+        if (hi & 1) merge_child(result, --hi, leaf);
+      }
+    }
+
+    const Merge& get_merge() const { return merge_; }
+
+    size_t get_memory_usage() const {
+      size_t bytes = sizeof(*this) + sketch_memory_usage(empty_) + dirty_.capacity();
+      for (const SK& node: nodes_) bytes += sketch_memory_usage(node);
+      return bytes;
+    }
+
+  private:
+    size_t num_leaves_;
+    size_t capacity_; // num_leaves_ rounded up to a power of 2
+    SK empty_;
+    Merge merge_;
+    std::vector<SK> nodes_;
+    std::vector<uint8_t> dirty_; // one byte per node, written concurrently within a level
+
+    template<typename Leaf>
+    void merge_child(SK& result, size_t child, Leaf& leaf) const {
+      if (child < capacity_) {
+        merge_(result, nodes_[child - 1]);
+      } else if (child - capacity_ < num_leaves_) {
+        merge_(result, leaf(child - capacity_));
+      }
+    }
+};
+
+} // namespace datasketches
+
+#endif // _MERGE_TREE_HPP_
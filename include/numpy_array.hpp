@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _NUMPY_ARRAY_HPP_
+#define _NUMPY_ARRAY_HPP_
+
+/*
+  This header defines helpers for NumPy array input and output.
+  Output arrays are allocated while holding the GIL, since that creates
+  the owning capsule, but their storage may be filled without it.
+*/
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+template<typename T>
+using numpy_array = nb::ndarray<T, nb::numpy, nb::ndim<1>>;
+
+template<typename T>
+using numpy_array_2d = nb::ndarray<T, nb::numpy, nb::ndim<2>>;
+
+template<typename T>
+using numpy_array_3d = nb::ndarray<T, nb::numpy, nb::ndim<3>>;
+
+// an uninitialized array of the given size, owning its storage
+template<typename T>
+numpy_array<T> make_numpy_array(size_t size) {
+  T* data = new T[size];
+  nb::capsule owner(data, [](void *p) noexcept {
+    delete[] static_cast<T*>(p);
+  });
+  return numpy_array<T>(data, {size}, owner);
+}
+
+// an uninitialized row-major array of the given shape, owning its storage
+template<typename T>
+numpy_array_2d<T> make_numpy_array(size_t rows, size_t cols) {
+  T* data = new T[rows * cols];
+  nb::capsule owner(data, [](void *p) noexcept {
+    delete[] static_cast<T*>(p);
+  });
+  return numpy_array_2d<T>(data, {rows, cols}, owner);
+}
+
+// an uninitialized row-major array of the given 3D shape, owning its storage
+template<typename T>
+numpy_array_3d<T> make_numpy_array(size_t rows, size_t cols, size_t depth) {
+  T* data = new T[rows * cols * depth];
+  nb::capsule owner(data, [](void *p) noexcept {
+    delete[] static_cast<T*>(p);
+  });
+  return numpy_array_3d<T>(data, {rows, cols, depth}, owner);
+}
+
+// a 1-dimensional view of an input array, which may be strided
+template<typename T>
+auto view_1d(nb::ndarray<T>& array) -> decltype(array.template view<T, nb::ndim<1>>()) {
+  if (array.ndim() != 1) {
+    throw std::invalid_argument("input data must have only one dimension. Found: "
+      + std::to_string(array.ndim()));
+  }
+  return array.template view<T, nb::ndim<1>>();
+}
+
+} // namespace datasketches
+
+#endif // _NUMPY_ARRAY_HPP_
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _PARALLEL_HPP_
+#define _PARALLEL_HPP_
+
+/*
+  This header defines small helpers for running native work on a pool
+  of std::threads. None of them touch Python objects, so they are meant
+  to be called with the GIL released. The first exception thrown by any
+  worker is rethrown on the calling thread once all workers have joined.
+  A slice whose thread cannot be started runs on the calling thread.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace datasketches {
+
+// maps a user-provided thread count to the number of threads to use,
+// where 0 means one per hardware thread, and never more than num_tasks
+inline unsigned resolve_num_threads(unsigned num_threads, size_t num_tasks) {
+  if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+  if (num_tasks < num_threads) num_threads = static_cast<unsigned>(std::max<size_t>(num_tasks, 1));
+  return num_threads;
+}
+
+/**
+ * @brief Invokes f(begin, end) over num_threads contiguous slices
+ * covering [0, n). The calling thread processes the first slice.
+ */
+template<typename F>
+void parallel_for_chunks(size_t n, unsigned num_threads, F&& f) {
+  num_threads = resolve_num_threads(num_threads, n);
+  if (num_threads == 1) {
+    f(size_t(0), n);
+    return;
+  }
+
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto run = [&](size_t begin, size_t end) {
+    try {
+      f(begin, end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) error = std::current_exception();
+    }
+  };
+
+  const size_t chunk = n / num_threads;
+  const size_t extra = n % num_threads;
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads - 1);
+  size_t first_end = chunk + (extra > 0 ? 1 : 0);
+  size_t begin = first_end;
+  for (unsigned t = 1; t < num_threads; ++t) {
+    const size_t end = begin + chunk + (t < extra ? 1 : 0);
+    try {
+      workers.emplace_back(run, begin, end);
+    } catch (...) {
+      // the thread could not be started, so the workers already running
+      // must still be joined: the calling thread takes this slice instead
+      run(begin, end);
+    }
+    begin = end;
+  }
+  run(0, first_end);
+  for (auto& worker: workers) worker.join();
+  if (error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief Invokes f(i) for every i in [0, n) using up to num_threads threads.
+ */
+template<typename F>
+void parallel_for(size_t n, unsigned num_threads, F&& f) {
+  parallel_for_chunks(n, num_threads, [&f](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) f(i);
+  });
+}
+
+/**
+ * @brief Reduces items [0, n) into a single accumulator.
+ * Each thread folds a contiguous slice into its own accumulator created by
+ * make(), via fold(acc, i), and the partial results are then combined
+ * pairwise as a tree via combine(acc, other), also in parallel.
+ * Requires n > 0.
+ */
+template<typename Make, typename Fold, typename Combine>
+auto parallel_reduce(size_t n, unsigned num_threads, Make&& make, Fold&& fold, Combine&& combine) -> decltype(make()) {
+  using Acc = decltype(make());
+  num_threads = resolve_num_threads(num_threads, n);
+
+  std::vector<std::optional<Acc>> partials(num_threads);
+  const size_t chunk = n / num_threads;
+  const size_t extra = n % num_threads;
+  parallel_for(num_threads, num_threads, [&](size_t t) {
+    const size_t begin = t * chunk + std::min<size_t>(t, extra);
+    const size_t end = begin + chunk + (t < extra ? 1 : 0);
+    partials[t].emplace(make());
+    for (size_t i = begin; i < end; ++i) fold(*partials[t], i);
+  });
+
+  for (size_t step = 1; step < partials.size(); step *= 2) {
+    const size_t num_pairs = (partials.size() - step + 2 * step - 1) / (2 * step);
+    parallel_for(num_pairs, num_threads, [&](size_t p) {
+      const size_t i = p * 2 * step;
+      combine(*partials[i], *partials[i + step]);
+      partials[i + step].reset();
+    });
+  }
+  return std::move(*partials[0]);
+}
+
+} // namespace datasketches
+
+#endif // _PARALLEL_HPP_
@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _PICKLE_SUPPORT_HPP_
+#define _PICKLE_SUPPORT_HPP_
+
+/*
+  This header defines the pickle and buffer protocol bindings of the
+  sketches with a self-contained serialized image. A pickled sketch is
+  its image. With protocol 5 the image is handed to pickle as a
+  PickleBuffer, so a buffer_callback, as used by multiprocessing, Dask
+  or Ray, can send it out of band without copying it into the pickle
+  stream, and unpickling reads it in place from whatever buffer the
+  receiver provides.
+*/
+
+#include <cstring>
+#include <utility>
+
+#include <nanobind/nanobind.h>
+
+#include "py_buffer.hpp"
+#include "gil_guard.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+// copies a serialized image into a new bytes object, without the GIL for the copy itself
+template<typename Image>
+nb::bytes image_to_bytes(const Image& image) {
+  PyObject* obj = PyBytes_FromStringAndSize(nullptr, static_cast<Py_ssize_t>(image.size()));
+  if (obj == nullptr) throw nb::python_error();
+  nb::bytes result = nb::steal<nb::bytes>(obj);
+  char* out = PyBytes_AsString(obj);
+  {
+    nb::gil_scoped_release release;
+    if (image.size() > 0) std::memcpy(out, image.data(), image.size());
+  }
+  return result;
+}
+
+/**
+ * @brief Adds __reduce_ex__ and __setstate__ for pickling and copying, and
+ * __buffer__, a read-only memoryview of the serialized image, which Python
+ * 3.12 and later use for memoryview(sketch) and other buffer consumers.
+ * Takes the functions of add_batch_serialization(): one serializing a sketch
+ * to a byte container and one deserializing it from (const char*, size_t),
+ * both run without the GIL.
+ */
+template<typename SK, typename... Ts, typename S, typename D>
+void add_pickle_support(nb::class_<SK, Ts...>& clazz, S serialize, D deserialize) {
+  clazz.def(
+    "__reduce_ex__",
+    [serialize](nb::handle self, int protocol) {
+      const SK& sk = nb::cast<const SK&>(self);
+      nb::object state = image_to_bytes(call_without_gil([&sk, &serialize] { return serialize(sk); }));
+      if (protocol >= 5) state = nb::module_::import_("pickle").attr("PickleBuffer")(state);
+      // as object.__reduce_ex__: the instance is created by cls.__new__(cls), then restored by __setstate__
+      return nb::make_tuple(nb::module_::import_("copyreg").attr("__newobj__"), nb::make_tuple(self.type()), state);
+    },
+    nb::arg("protocol"),
+    "Supports pickling through the serialized image, which protocol 5 passes as an out-of-band PickleBuffer"
+  )
+  .def(
+    "__setstate__",
+    [deserialize](SK& sk, nb::handle state) {
+      py_byte_range range(state);
+      new (&sk) SK(call_without_gil([&range, &deserialize] { return deserialize(range.data(), range.size()); }));
+    },
+    nb::arg("state"),
+    "Restores an unpickled sketch from its serialized image, held in any contiguous buffer"
+  )
+  .def(
+    "__buffer__",
+    [serialize](const SK& sk, int) {
+      nb::bytes image = image_to_bytes(call_without_gil([&sk, &serialize] { return serialize(sk); }));
+      PyObject* view = PyMemoryView_FromObject(image.ptr());
+      if (view == nullptr) throw nb::python_error();
+      return nb::steal(view);
+    },
+    nb::arg("flags"),
+    "Returns a read-only memoryview of the serialized image, which deserialize() accepts directly"
+  );
+}
+
+} // namespace datasketches
+
+#endif // _PICKLE_SUPPORT_HPP_
@@ -0,0 +1,288 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _PY_BUFFER_HPP_
+#define _PY_BUFFER_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <nanobind/nanobind.h>
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+/**
+ * @brief RAII wrapper around a Python buffer protocol view.
+ * The view must be acquired and released while holding the GIL, but
+ * the exported memory may be read without it for as long as this object
+ * is alive.
+ */
+class py_buffer {
+  public:
+    explicit py_buffer(nb::handle obj, int flags = PyBUF_RECORDS_RO) {
+      if (PyObject_GetBuffer(obj.ptr(), &view_, flags) != 0) {
+        throw nb::python_error();
+      }
+    }
+
+    ~py_buffer() { PyBuffer_Release(&view_); }
+
+    py_buffer(const py_buffer&) = delete;
+    py_buffer& operator=(const py_buffer&) = delete;
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(view_.buf); }
+    uint8_t* writable_data() const { return static_cast<uint8_t*>(view_.buf); }
+    size_t size() const { return static_cast<size_t>(view_.len); }
+    size_t itemsize() const { return static_cast<size_t>(view_.itemsize); }
+    int ndim() const { return view_.ndim; }
+    bool is_readonly() const { return view_.readonly != 0; }
+
+    // number of items along the first (only) dimension
+    size_t length() const {
+      if (view_.ndim == 0 || view_.shape == nullptr) return size() / itemsize();
+      return static_cast<size_t>(view_.shape[0]);
+    }
+
+    // distance in bytes between consecutive items along the first dimension
+    ptrdiff_t stride() const {
+      if (view_.strides == nullptr) return static_cast<ptrdiff_t>(itemsize());
+      return static_cast<ptrdiff_t>(view_.strides[0]);
+    }
+
+    // struct-module style format string, "B" if none was requested
+    const char* format() const { return view_.format == nullptr ? "B" : view_.format; }
+
+  private:
+    Py_buffer view_;
+};
+
+/**
+ * @brief A contiguous range of bytes exported by a buffer-protocol object,
+ * such as bytes, bytearray, memoryview, mmap or a NumPy array, optionally
+ * restricted to [offset, offset + length). Nothing is copied.
+ */
+class py_byte_range {
+  public:
+    explicit py_byte_range(nb::handle obj, size_t offset = 0, std::optional<size_t> length = std::nullopt):
+    buf_(obj, PyBUF_SIMPLE),
+    offset_(offset),
+    size_(0)
+    {
+      if (offset > buf_.size()) {
+        throw std::invalid_argument("offset " + std::to_string(offset) + " is beyond the end of a buffer of "
+          + std::to_string(buf_.size()) + " bytes");
+      }
+      size_ = buf_.size() - offset;
+      if (length) {
+        if (*length > size_) {
+          throw std::invalid_argument("range of " + std::to_string(*length) + " bytes at offset " + std::to_string(offset)
+            + " is beyond the end of a buffer of " + std::to_string(buf_.size()) + " bytes");
+        }
+        size_ = *length;
+      }
+    }
+
+    const char* data() const { return reinterpret_cast<const char*>(buf_.data()) + offset_; }
+    size_t size() const { return size_; }
+
+  private:
+    py_buffer buf_;
+    size_t offset_;
+    size_t size_;
+};
+
+namespace py_buffer_internal {
+
+inline bool is_little_endian() {
+  const uint16_t probe = 1;
+  uint8_t first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+// Skips an optional struct-module byte order prefix, reporting whether the
+// data uses the opposite byte order to the host.
+inline const char* skip_byte_order(const char* fmt, bool& swap) {
+  swap = false;
+  switch (*fmt) {
+    case '@': case '=': return fmt + 1;
+    case '<': swap = !is_little_endian(); return fmt + 1;
+    case '>': case '!': swap = is_little_endian(); return fmt + 1;
+    default: return fmt;
+  }
+}
+
+inline void append_utf8(std::string& out, uint32_t cp) {
+  if (cp < 0x80) {
+    out.push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+}
+
+inline uint32_t read_ucs4(const uint8_t* ptr, bool swap) {
+  uint32_t cp;
+  std::memcpy(&cp, ptr, sizeof(cp));
+  if (swap) {
+    cp = ((cp & 0x000000FFu) << 24) | ((cp & 0x0000FF00u) << 8)
+       | ((cp & 0x00FF0000u) >> 8) | ((cp & 0xFF000000u) >> 24);
+  }
+  return cp;
+}
+
+} // namespace py_buffer_internal
+
+// Stores and loads values little-endian whatever the byte order of the host,
+// as in the sketch images and the formats built around them.
+template<typename V>
+void store_le(char* out, V value) {
+  std::memcpy(out, &value, sizeof(V));
+  if (!py_buffer_internal::is_little_endian()) std::reverse(out, out + sizeof(V));
+}
+
+template<typename V>
+V load_le(const char* in) {
+  char bytes[sizeof(V)];
+  std::memcpy(bytes, in, sizeof(V));
+  if (!py_buffer_internal::is_little_endian()) std::reverse(bytes, bytes + sizeof(V));
+  V value;
+  std::memcpy(&value, bytes, sizeof(V));
+  return value;
+}
+
+/**
+ * @brief Invokes f(const char* data, size_t length) for every element of a
+ * 1-dimensional NumPy fixed-width bytes ('S') or unicode ('U') array.
+ * Trailing NUL padding is stripped, matching NumPy semantics, and unicode
+ * values are passed as UTF-8 so that results match updating with the
+ * equivalent Python str one at a time.
+ * Does not touch any Python objects, so may be called without the GIL.
+ */
+template<typename F>
+void for_each_fixed_width_string(const py_buffer& buf, F&& f) {
+  using namespace py_buffer_internal;
+  if (buf.ndim() != 1) {
+    throw std::invalid_argument("input data must have only one dimension. Found: "
+      + std::to_string(buf.ndim()));
+  }
+
+  bool swap;
+  const char* fmt = skip_byte_order(buf.format(), swap);
+  while (*fmt >= '0' && *fmt <= '9') ++fmt;
+  const size_t itemsize = buf.itemsize();
+  const size_t n = buf.length();
+  const ptrdiff_t stride = buf.stride();
+  const uint8_t* base = buf.data();
+
+  if (*fmt == 's' && fmt[1] == '\0') {
+    for (size_t i = 0; i < n; ++i) {
+      const char* item = reinterpret_cast<const char*>(base + i * stride);
+      size_t len = itemsize;
+      while (len > 0 && item[len - 1] == '\0') --len;
+      f(item, len);
+    }
+  } else if (*fmt == 'w' && fmt[1] == '\0') {
+    const size_t num_chars = itemsize / 4;
+    std::string utf8;
+    utf8.reserve(num_chars * 4);
+    for (size_t i = 0; i < n; ++i) {
+      const uint8_t* item = base + i * stride;
+      size_t len = num_chars;
+      while (len > 0 && read_ucs4(item + 4 * (len - 1), swap) == 0) --len;
+      utf8.clear();
+      for (size_t c = 0; c < len; ++c) append_utf8(utf8, read_ucs4(item + 4 * c, swap));
+      f(utf8.data(), utf8.size());
+    }
+  } else {
+    throw std::invalid_argument("input array must have a fixed-width bytes ('S') or unicode ('U') dtype. Found format: "
+      + std::string(buf.format()));
+  }
+}
+
+/**
+ * @brief Invokes f(const char* data, size_t length) for every element of an
+ * Arrow-style variable-width binary array, given as a buffer of n+1 int32 or
+ * int64 offsets and a contiguous data buffer. Element i is
+ * data[offsets[i]:offsets[i+1]].
+ * Does not touch any Python objects, so may be called without the GIL.
+ */
+template<typename F>
+void for_each_offset_string(const py_buffer& offsets, const py_buffer& data, F&& f) {
+  using namespace py_buffer_internal;
+  if (offsets.ndim() != 1) {
+    throw std::invalid_argument("offsets must have only one dimension. Found: "
+      + std::to_string(offsets.ndim()));
+  }
+  bool swap;
+  const char* fmt = skip_byte_order(offsets.format(), swap);
+  if (swap || std::strchr("ilqILQ", *fmt) == nullptr || fmt[1] != '\0'
+      || (offsets.itemsize() != 4 && offsets.itemsize() != 8)) {
+    throw std::invalid_argument("offsets must be a native-endian array of 32- or 64-bit integers. Found format: "
+      + std::string(offsets.format()));
+  }
+
+  const size_t num_offsets = offsets.length();
+  if (num_offsets == 0) return;
+  const uint8_t* base = offsets.data();
+  const ptrdiff_t stride = offsets.stride();
+  const bool wide = offsets.itemsize() == 8;
+  auto offset_at = [&](size_t i) -> int64_t {
+    if (wide) {
+      int64_t v;
+      std::memcpy(&v, base + i * stride, sizeof(v));
+      return v;
+    }
+    int32_t v;
+    std::memcpy(&v, base + i * stride, sizeof(v));
+    return v;
+  };
+
+  const char* chars = reinterpret_cast<const char*>(data.data());
+  const int64_t data_size = static_cast<int64_t>(data.size());
+  int64_t start = offset_at(0);
+  for (size_t i = 1; i < num_offsets; ++i) {
+    const int64_t end = offset_at(i);
+    if (start < 0 || end < start || end > data_size) {
+      throw std::invalid_argument("invalid offsets at index " + std::to_string(i - 1) + ": ["
+        + std::to_string(start) + ", " + std::to_string(end) + ") with data size " + std::to_string(data_size));
+    }
+    f(chars + start, static_cast<size_t>(end - start));
+    start = end;
+  }
+}
+
+} // namespace datasketches
+
+#endif // _PY_BUFFER_HPP_
@@ -65,9 +65,12 @@ struct py_object_serde {
 
   // these methods are required by the serde interface; see common/include/serde.hpp for
   // default implementations for C++ std::string and numeric types.
-  size_t size_of_item(const nb::object& item) const;
-  size_t serialize(void* ptr, size_t capacity, const nb::object* items, unsigned num) const;
-  size_t deserialize(const void* ptr, size_t capacity, nb::object* items, unsigned num) const;
+  // They are virtual so that native serdes can process whole arrays of items
+  // without calling back into the Python methods above for each item.
+  virtual size_t size_of_item(const nb::object& item) const;
+  virtual size_t serialize(void* ptr, size_t capacity, const nb::object* items, unsigned num) const;
+  virtual size_t deserialize(const void* ptr, size_t capacity, nb::object* items, unsigned num) const;
+  virtual void serialize(std::ostream& os, const nb::object* items, unsigned num) const;
 };
 
 /**
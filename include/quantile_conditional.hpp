@@ -27,12 +27,29 @@
 
 #include "common_defs.hpp"
 #include "py_serde.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "batch_serde.hpp"
+#include "pickle_support.hpp"
+#include "numpy_array.hpp"
+#include "arrow_array.hpp"
+#include "sketch_stats.hpp"
 
 #include <nanobind/nanobind.h>
 #include <nanobind/operators.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/vector.h>
 #include <nanobind/ndarray.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
 namespace nb = nanobind;
 
 // Serialization
@@ -42,17 +59,39 @@ void add_serialization(nb::class_<SK>& clazz) {
   clazz.def(
         "serialize",
         [](const SK& sk) {
-          auto bytes = sk.serialize();
+          auto bytes = call_without_gil([&sk] { return sk.serialize(); });
+          datasketches::count_serialized(sk, bytes.size());
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         },
         "Serializes the sketch into a bytes object."
     )
+    .def(
+        "serialize_into",
+        [](const SK& sk, nb::handle buffer, size_t offset) {
+          const size_t written = datasketches::serialize_into_buffer(buffer, offset, [&](std::ostream& os) { sk.serialize(os); });
+          datasketches::count_serialized(sk, written);
+          return written;
+        },
+        nb::arg("buffer"), nb::arg("offset")=0,
+        "Serializes the sketch into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes) { return SK::deserialize(bytes.c_str(), bytes.size()); },
-        nb::arg("bytes"),
-        "Deserializes the sketch from a bytes object."
+        [](nb::handle bytes, size_t offset, std::optional<size_t> length) {
+          datasketches::py_byte_range range(bytes, offset, length);
+          return call_without_gil([&range] { return SK::deserialize(range.data(), range.size()); });
+        },
+        nb::arg("bytes"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Deserializes the sketch from a bytes object, or from length bytes starting at offset of any contiguous buffer."
     );
+
+  datasketches::add_batch_serialization(clazz,
+    [](const SK& sk) { return sk.serialize(); },
+    [](const char* data, size_t size) { return SK::deserialize(data, size); });
+  datasketches::add_pickle_support(clazz,
+    [](const SK& sk) { return sk.serialize(); },
+    [](const char* data, size_t size) { return SK::deserialize(data, size); });
 }
 
 // nb::object and other types where the caller must provide a serde
@@ -62,38 +101,144 @@ void add_serialization(nb::class_<SK>& clazz) {
         "serialize",
         [](const SK& sk, datasketches::py_object_serde& serde) {
           auto bytes = sk.serialize(0, serde);
+          datasketches::count_serialized(sk, bytes.size());
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         }, nb::arg("serde"),
         "Serializes the sketch into a bytes object using the provided serde."
     )
+    .def(
+        "serialize_into",
+        [](const SK& sk, nb::handle buffer, datasketches::py_object_serde& serde, size_t offset) {
+          const size_t written = datasketches::serialize_into_buffer_for<T>(buffer, offset, [&](std::ostream& os) { sk.serialize(os, serde); });
+          datasketches::count_serialized(sk, written);
+          return written;
+        },
+        nb::arg("buffer"), nb::arg("serde"), nb::arg("offset")=0,
+        "Serializes the sketch using the provided serde into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes, datasketches::py_object_serde& serde) {
-            return SK::deserialize(bytes.c_str(), bytes.size(), serde);
-        }, nb::arg("bytes"), nb::arg("serde"),
-        "Deserializes the sketch from a bytes object using the provided serde."
+        [](nb::handle bytes, datasketches::py_object_serde& serde, size_t offset, std::optional<size_t> length) {
+            datasketches::py_byte_range range(bytes, offset, length);
+            return SK::deserialize(range.data(), range.size(), serde);
+        }, nb::arg("bytes"), nb::arg("serde"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Deserializes the sketch from a bytes object, or from length bytes starting at offset of any contiguous buffer, "
+        "using the provided serde."
     );
 }
 
+// Serialized size, used to pre-size buffers for serialize_into()
+template<typename T, typename SK, typename std::enable_if<std::is_arithmetic<T>::value || std::is_same<std::string, T>::value, bool>::type = 0>
+void add_serialized_size(nb::class_<SK>& clazz) {
+  clazz.def(
+    "get_serialized_size_bytes",
+    [](const SK& sk) { return sk.get_serialized_size_bytes(); },
+    "Returns the size of the serialized sketch, in bytes"
+  );
+}
+
+template<typename T, typename SK, typename std::enable_if<!std::is_arithmetic<T>::value && !std::is_same<std::string, T>::value, bool>::type = 0>
+void add_serialized_size(nb::class_<SK>& clazz) {
+  clazz.def(
+    "get_serialized_size_bytes",
+    [](const SK& sk, datasketches::py_object_serde& serde) { return sk.get_serialized_size_bytes(serde); },
+    nb::arg("serde"),
+    "Returns the size of the sketch when serialized using the provided serde, in bytes"
+  );
+}
+
 // Vector Updates
 // * Only allowed for POD types based on numpy restriction, which
 //   is equivalent to both std::is_trivial and std::is_standard_layout.
 // * Nothing is added to types that are not PODs.
+// * The update loop is specialized at compile time for contiguous input, for
+//   a mask, and for NaN skipping with floating point items, so a single pass
+//   filters and updates without per-element stride or dtype dispatch.
+namespace quantile_conditional_internal {
+
+template<bool Contiguous, bool Masked, typename T, typename SK>
+void update_values(SK& sk, datasketches::stats_probe<SK>& probe, const T* data, int64_t stride,
+                   const bool* mask, int64_t mask_stride, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    if constexpr (Masked) {
+      if (!(Contiguous ? mask[i] : mask[i * mask_stride])) continue;
+    }
+    const T& value = Contiguous ? data[i] : data[i * stride];
+    if constexpr (std::is_floating_point<T>::value) {
+      // the sketches ignore NaN too, but only after the call
+      if (std::isnan(value)) continue;
+    }
+    probe.update(sk, [&] { sk.update(value); });
+  }
+}
+
+template<typename T, typename SK>
+void update_from_array(SK& sk, nb::ndarray<T>& items, std::optional<nb::ndarray<bool>>& mask) {
+  if (items.ndim() != 1) {
+    throw std::invalid_argument("input data must have only one dimension. Found: "
+      + std::to_string(items.ndim()));
+  }
+  if (mask && (mask->ndim() != 1 || mask->shape(0) != items.shape(0))) {
+    throw std::invalid_argument("mask must be a 1D array of the same length as the input data");
+  }
+  const T* data = items.data();
+  const int64_t stride = items.stride(0);
+  const size_t n = items.shape(0);
+  datasketches::stats_probe<SK> probe(sk);
+  nb::gil_scoped_release release;
+  if (mask) {
+    const bool* m = mask->data();
+    const int64_t mask_stride = mask->stride(0);
+    if (stride == 1 && mask_stride == 1) update_values<true, true>(sk, probe, data, stride, m, mask_stride, n);
+    else update_values<false, true>(sk, probe, data, stride, m, mask_stride, n);
+  } else {
+    if (stride == 1) update_values<true, false>(sk, probe, data, stride, nullptr, 0, n);
+    else update_values<false, false>(sk, probe, data, stride, nullptr, 0, n);
+  }
+}
+
+} // namespace quantile_conditional_internal
+
 // POD type
 template<typename T, typename SK, typename std::enable_if<std::is_trivial<T>::value && std::is_standard_layout<T>::value, bool>::type = 0>
 void add_vector_update(nb::class_<SK>& clazz) {
   clazz.def(
     "update",
-    [](SK& sk, nb::ndarray<T> items) {
-      if (items.ndim() != 1) {
-        throw std::invalid_argument("input data must have only one dimension. Found: "
-          + std::to_string(items.ndim()));
-      }
-      auto v = items.template view<T, nb::ndim<1>>();
-      for (uint32_t i = 0; i < v.shape(0); ++i) sk.update(v(i));
+    [](SK& sk, nb::ndarray<T> items, std::optional<nb::ndarray<bool>> mask) {
+      quantile_conditional_internal::update_from_array(sk, items, mask);
+    },
+    nb::arg("array"), nb::arg("mask")=nb::none(),
+    "Updates the sketch with the values in the given array, skipping NaN values, "
+    "or only with the values where the given boolean mask of the same length is True"
+  )
+  .def(
+    "update_arrow",
+    [](SK& sk, nb::handle array) {
+      datasketches::for_each_arrow_chunk(array, [&sk](const ArrowSchema& schema, const ArrowArray& chunk) {
+        const datasketches::arrow_type type = datasketches::get_arrow_type(schema);
+        if (type.kind == datasketches::arrow_kind::BINARY) {
+          throw std::invalid_argument("a numeric sketch cannot be updated from an Arrow utf8 or binary array");
+        }
+        datasketches::stats_probe<SK> probe(sk);
+        nb::gil_scoped_release release;
+        datasketches::for_each_arrow_value(type, chunk, 0, [&sk, &probe](auto value) {
+          if constexpr (std::is_arithmetic<decltype(value)>::value) {
+            // NaN has no integral value, and the floating point sketches ignore it anyway
+            if constexpr (std::is_floating_point<decltype(value)>::value) {
+              if (std::isnan(value)) return;
+            }
+            probe.update(sk, [&] { sk.update(static_cast<T>(value)); });
+          }
+        });
+      });
     },
     nb::arg("array"),
-    "Updates the sketch with the values in the given array"
+    "Updates the sketch with every non-null value of an Arrow integer or floating point array, read in place "
+    "through the Arrow C Data Interface and converted to the item type of the sketch. Chunked arrays are read "
+    "chunk by chunk. NaN values are skipped.\n\n"
+    ":param array: Any object implementing __arrow_c_array__ or __arrow_c_stream__, such as a pyarrow Array "
+    "or ChunkedArray\n:type array: Arrow array"
   );
 }
 
@@ -103,4 +248,135 @@ void add_vector_update(nb::class_<SK>& clazz) {
   unused(clazz);
 }
 
+// Vector Queries
+// * NumPy array overloads of the batch queries, which use a single sorted
+//   view per call and return NumPy arrays. The view is built with the GIL
+//   held, since building it sorts and caches state inside the sketch, and
+//   only the queries of the finished view run without the GIL.
+// * These must be registered before the std::vector overloads, otherwise
+//   NumPy arrays needing a dtype conversion would be converted to lists.
+// * Nothing is added to types that are not PODs.
+// POD type
+template<typename T, typename SK, typename std::enable_if<std::is_trivial<T>::value && std::is_standard_layout<T>::value, bool>::type = 0>
+void add_vector_queries(nb::class_<SK>& clazz) {
+  using datasketches::numpy_array;
+  using datasketches::make_numpy_array;
+  using datasketches::view_1d;
+
+  clazz.def(
+    "get_quantiles",
+    [](const SK& sk, nb::ndarray<double> ranks, bool inclusive) {
+      auto r = view_1d(ranks);
+      auto quantiles = make_numpy_array<T>(sk.is_empty() ? 0 : r.shape(0));
+      if (!sk.is_empty()) {
+        T* out = quantiles.data();
+        auto view = sk.get_sorted_view();
+        nb::gil_scoped_release release;
+        for (size_t i = 0; i < r.shape(0); ++i) {
+          if (!(r(i) >= 0.0 && r(i) <= 1.0)) {
+            throw std::invalid_argument("normalized rank cannot be less than zero or greater than 1.0");
+          }
+          out[i] = view.get_quantile(r(i), inclusive);
+        }
+      }
+      return quantiles;
+    },
+    nb::arg("ranks"), nb::arg("inclusive")=false,
+    "Returns a NumPy array of the quantiles at each normalized rank of the given array.\n"
+    "If the sketch is empty this returns an empty array."
+  )
+  .def(
+    "get_ranks",
+    [](const SK& sk, nb::ndarray<T> values, bool inclusive) {
+      auto v = view_1d(values);
+      auto ranks = make_numpy_array<double>(sk.is_empty() ? 0 : v.shape(0));
+      if (!sk.is_empty()) {
+        double* out = ranks.data();
+        auto view = sk.get_sorted_view();
+        nb::gil_scoped_release release;
+        for (size_t i = 0; i < v.shape(0); ++i) out[i] = view.get_rank(v(i), inclusive);
+      }
+      return ranks;
+    },
+    nb::arg("values"), nb::arg("inclusive")=false,
+    "Returns a NumPy array of the approximate normalized rank of each value of the given array, "
+    "as computed by get_rank().\n"
+    "If the sketch is empty this returns an empty array."
+  )
+  .def(
+    "get_ranks",
+    [](const SK& sk, const std::vector<T>& values, bool inclusive) {
+      std::vector<double> ranks;
+      if (!sk.is_empty()) {
+        auto view = sk.get_sorted_view();
+        nb::gil_scoped_release release;
+        ranks.reserve(values.size());
+        for (const T& value: values) ranks.push_back(view.get_rank(value, inclusive));
+      }
+      return ranks;
+    },
+    nb::arg("values"), nb::arg("inclusive")=false,
+    "Returns a list of the approximate normalized rank of each of the given values, "
+    "as computed by get_rank().\n"
+    "If the sketch is empty this returns an empty list."
+  )
+  .def(
+    "get_pmf",
+    [](const SK& sk, nb::ndarray<T> split_points, bool inclusive) {
+      auto v = view_1d(split_points);
+      if (sk.is_empty()) return make_numpy_array<double>(0);
+      std::vector<T> points(v.shape(0));
+      for (size_t i = 0; i < points.size(); ++i) points[i] = v(i);
+      auto view = sk.get_sorted_view();
+      auto pmf = call_without_gil([&] { return view.get_PMF(points.data(), static_cast<uint32_t>(points.size()), inclusive); });
+      auto result = make_numpy_array<double>(pmf.size());
+      std::copy(pmf.begin(), pmf.end(), result.data());
+      return result;
+    },
+    nb::arg("split_points"), nb::arg("inclusive")=false,
+    "Returns the approximate Probability Mass Function (PMF) given a NumPy array of m unique, "
+    "monotonically increasing split points, as a NumPy array of m+1 values. See the list version for details.\n"
+    "If the sketch is empty this returns an empty array."
+  )
+  .def(
+    "get_cdf",
+    [](const SK& sk, nb::ndarray<T> split_points, bool inclusive) {
+      auto v = view_1d(split_points);
+      if (sk.is_empty()) return make_numpy_array<double>(0);
+      std::vector<T> points(v.shape(0));
+      for (size_t i = 0; i < points.size(); ++i) points[i] = v(i);
+      auto view = sk.get_sorted_view();
+      auto cdf = call_without_gil([&] { return view.get_CDF(points.data(), static_cast<uint32_t>(points.size()), inclusive); });
+      auto result = make_numpy_array<double>(cdf.size());
+      std::copy(cdf.begin(), cdf.end(), result.data());
+      return result;
+    },
+    nb::arg("split_points"), nb::arg("inclusive")=false,
+    "Returns the approximate Cumulative Distribution Function (CDF) given a NumPy array of m unique, "
+    "monotonically increasing split points, as a NumPy array of m+1 values. See the list version for details.\n"
+    "If the sketch is empty this returns an empty array."
+  );
+}
+
+// non-POD type, which only has the list version of get_ranks
+template<typename T, typename SK, typename std::enable_if<!std::is_trivial<T>::value || !std::is_standard_layout<T>::value, bool>::type = 0>
+void add_vector_queries(nb::class_<SK>& clazz) {
+  clazz.def(
+    "get_ranks",
+    [](const SK& sk, const std::vector<T>& values, bool inclusive) {
+      std::vector<double> ranks;
+      if (!sk.is_empty()) {
+        auto view = sk.get_sorted_view();
+        ranks.reserve(values.size());
+        for (const T& value: values) ranks.push_back(view.get_rank(value, inclusive));
+      }
+      return ranks;
+    },
+    nb::arg("values"), nb::arg("inclusive")=false,
+    "Returns a list of the approximate normalized rank of each of the given values, "
+    "as computed by get_rank().\n"
+    "If the sketch is empty this returns an empty list."
+  );
+}
+
 #endif // _QUANTILE_CONDITIONAL_HPP_
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _SAMPLING_CONDITIONAL_HPP_
+#define _SAMPLING_CONDITIONAL_HPP_
+
+/*
+  This header defines functions shared by the numeric instantiations
+  of the sampling sketches, which take their items and weights from
+  NumPy arrays. The samplers draw from random number generators shared
+  by every sketch in the process, so they keep holding the GIL, which
+  serializes those draws across threads.
+*/
+
+#include "numpy_array.hpp"
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace nb = nanobind;
+
+// update(items, weights=None), where weights default to 1
+template<typename T, typename SK>
+void add_weighted_vector_update(nb::class_<SK>& clazz) {
+  clazz.def(
+    "update",
+    [](SK& sk, nb::ndarray<T> items, std::optional<nb::ndarray<double>> weights) {
+      auto v = datasketches::view_1d(items);
+      if (!weights) {
+        for (size_t i = 0; i < v.shape(0); ++i) sk.update(v(i), 1.0);
+        return;
+      }
+      auto w = datasketches::view_1d(*weights);
+      if (w.shape(0) != v.shape(0)) {
+        throw std::invalid_argument("items and weights must have the same length: " + std::to_string(v.shape(0))
+          + " vs " + std::to_string(w.shape(0)));
+      }
+      // check every weight first, so invalid input leaves the sketch unchanged
+      for (size_t i = 0; i < w.shape(0); ++i) {
+        if (!(w(i) >= 0.0) || std::isinf(w(i))) {
+          throw std::invalid_argument("weights must be nonnegative and finite, found " + std::to_string(w(i)));
+        }
+      }
+      for (size_t i = 0; i < v.shape(0); ++i) sk.update(v(i), w(i));
+    },
+    nb::arg("items"), nb::arg("weights")=nb::none(),
+    "Updates the sketch with a NumPy array of items and an array of the same length of their weights, "
+    "or a weight of 1 for every item if weights is omitted"
+  );
+}
+
+#endif // _SAMPLING_CONDITIONAL_HPP_
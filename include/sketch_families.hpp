@@ -0,0 +1,253 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _SKETCH_FAMILIES_HPP_
+#define _SKETCH_FAMILIES_HPP_
+
+/*
+  This header defines the family policies shared by the native containers
+  of many sketches (vector_of_sketches, sketch_map). A family names its
+  sketch type and construction parameters, and provides make, update,
+  merge, collapse, serialize, deserialize and to_string as static
+  functions. None of them touch Python objects, so containers may call
+  them without the GIL, on several threads for distinct sketches.
+
+  Container sketches allocate through tracked_allocator, so they are
+  counted by the module-level allocator hook. export_sketch() converts
+  one to the std::allocator type bound in Python, through its image.
+*/
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "hll.hpp"
+#include "kll_sketch.hpp"
+#include "theta_sketch.hpp"
+#include "theta_union.hpp"
+#include "tdigest.hpp"
+#include "memory_usage.hpp"
+#include "tracked_allocator.hpp"
+
+namespace datasketches {
+
+template<typename S>
+std::string to_std_string(const S& str) { return std::string(str.data(), str.size()); }
+
+struct hll_family {
+  struct params_type {
+    uint8_t lg_k;
+    target_hll_type tgt_type;
+  };
+  using allocator_type = tracked_allocator<uint8_t>;
+  using sketch_type = hll_sketch_alloc<allocator_type>;
+  using union_type = hll_union_alloc<allocator_type>;
+  using result_type = hll_sketch;
+
+  static sketch_type make(const params_type& params) { return sketch_type(params.lg_k, params.tgt_type); }
+
+  template<typename V>
+  static void update(sketch_type& sk, V value) { sk.update(value); }
+
+  static void merge(sketch_type& sk, const sketch_type& other, const params_type& params) {
+    union_type u(params.lg_k);
+    u.update(sk);
+    u.update(other);
+    sk = u.get_result(params.tgt_type);
+  }
+
+  static result_type collapse(const params_type& params, const std::vector<const sketch_type*>& sketches) {
+    union_type u(params.lg_k);
+    for (const sketch_type* sk: sketches) u.update(*sk);
+    return export_sketch(u.get_result(params.tgt_type), params);
+  }
+
+  static sketch_type::vector_bytes serialize(const sketch_type& sk, const params_type&) { return sk.serialize_compact(); }
+
+  static sketch_type deserialize(const char* data, size_t size, const params_type&) {
+    return sketch_type::deserialize(data, size);
+  }
+
+  static result_type export_sketch(const sketch_type& sk, const params_type&) {
+    const auto bytes = sk.serialize_updatable();
+    return result_type::deserialize(bytes.data(), bytes.size());
+  }
+
+  static std::string to_string(const sketch_type& sk, const params_type&) { return to_std_string(sk.to_string()); }
+};
+
+// Theta sketches cannot be merged into an update sketch, so each column keeps
+// its own updates apart from the compact result of everything merged into it.
+struct theta_column {
+  using allocator_type = tracked_allocator<uint64_t>;
+  update_theta_sketch_alloc<allocator_type> sketch;
+  std::optional<compact_theta_sketch_alloc<allocator_type>> merged;
+};
+
+inline size_t get_memory_usage(const theta_column& column) {
+  return get_memory_usage(column.sketch) + (column.merged ? get_memory_usage(*column.merged) : 0);
+}
+
+struct theta_family {
+  struct params_type {
+    uint8_t lg_k;
+    float p;
+    uint64_t seed;
+  };
+  using allocator_type = theta_column::allocator_type;
+  using sketch_type = theta_column;
+  using update_type = update_theta_sketch_alloc<allocator_type>;
+  using compact_type = compact_theta_sketch_alloc<allocator_type>;
+  using union_type = theta_union_alloc<allocator_type>;
+  using result_type = compact_theta_sketch;
+
+  static theta_column make(const params_type& params) {
+    return theta_column{update_type::builder().set_lg_k(params.lg_k).set_p(params.p).set_seed(params.seed).build(),
+                        std::nullopt};
+  }
+
+  template<typename V>
+  static void update(theta_column& column, V value) { column.sketch.update(value); }
+
+  static union_type make_union(const params_type& params) {
+    return union_type::builder().set_lg_k(params.lg_k).set_p(params.p).set_seed(params.seed).build();
+  }
+
+  static void merge(theta_column& column, const theta_column& other, const params_type& params) {
+    union_type u = make_union(params);
+    if (column.merged) u.update(*column.merged);
+    u.update(other.sketch);
+    if (other.merged) u.update(*other.merged);
+    column.merged.emplace(u.get_result());
+  }
+
+  static compact_type compact(const theta_column& column, const params_type& params) {
+    if (!column.merged) return column.sketch.compact();
+    union_type u = make_union(params);
+    u.update(column.sketch);
+    u.update(*column.merged);
+    return u.get_result();
+  }
+
+  static result_type collapse(const params_type& params, const std::vector<const theta_column*>& columns) {
+    union_type u = make_union(params);
+    for (const theta_column* column: columns) {
+      u.update(column->sketch);
+      if (column->merged) u.update(*column->merged);
+    }
+    const auto bytes = u.get_result().serialize();
+    return result_type::deserialize(bytes.data(), bytes.size(), params.seed);
+  }
+
+  static compact_type::vector_bytes serialize(const theta_column& column, const params_type& params) {
+    return compact(column, params).serialize();
+  }
+
+  // a deserialized image becomes the merged part of a column with an empty update sketch
+  static theta_column deserialize(const char* data, size_t size, const params_type& params) {
+    theta_column column = make(params);
+    column.merged.emplace(compact_type::deserialize(data, size, params.seed));
+    return column;
+  }
+
+  static result_type export_sketch(const theta_column& column, const params_type& params) {
+    const auto bytes = serialize(column, params);
+    return result_type::deserialize(bytes.data(), bytes.size(), params.seed);
+  }
+
+  static std::string to_string(const theta_column& column, const params_type& params) {
+    return to_std_string(compact(column, params).to_string());
+  }
+};
+
+struct tdigest_family {
+  struct params_type {
+    uint16_t k;
+  };
+  using sketch_type = tdigest<double, tracked_allocator<double>>;
+  using result_type = tdigest<double>;
+
+  static sketch_type make(const params_type& params) { return sketch_type(params.k); }
+
+  template<typename V>
+  static void update(sketch_type& td, V value) { td.update(static_cast<double>(value)); }
+
+  // merging compresses the buffer of the other digest, so this merges a copy
+  static void merge(sketch_type& td, const sketch_type& other, const params_type&) {
+    sketch_type copy(other);
+    td.merge(copy);
+  }
+
+  static result_type collapse(const params_type& params, const std::vector<const sketch_type*>& digests) {
+    sketch_type result(params.k);
+    for (const sketch_type* td: digests) merge(result, *td, params);
+    return export_sketch(result, params);
+  }
+
+  static sketch_type::vector_bytes serialize(const sketch_type& td, const params_type&) { return td.serialize(); }
+
+  static sketch_type deserialize(const char* data, size_t size, const params_type&) {
+    return sketch_type::deserialize(data, size);
+  }
+
+  static result_type export_sketch(const sketch_type& td, const params_type&) {
+    const auto bytes = td.serialize();
+    return result_type::deserialize(bytes.data(), bytes.size());
+  }
+
+  static std::string to_string(const sketch_type& td, const params_type&) { return to_std_string(td.to_string()); }
+};
+
+struct kll_doubles_family {
+  struct params_type {
+    uint16_t k;
+  };
+  using sketch_type = kll_sketch<double, std::less<double>, tracked_allocator<double>>;
+  using result_type = kll_sketch<double>;
+
+  static sketch_type make(const params_type& params) { return sketch_type(params.k); }
+
+  template<typename V>
+  static void update(sketch_type& sk, V value) { sk.update(static_cast<double>(value)); }
+
+  static void merge(sketch_type& sk, const sketch_type& other, const params_type&) { sk.merge(other); }
+
+  static result_type collapse(const params_type& params, const std::vector<const sketch_type*>& sketches) {
+    sketch_type result(params.k);
+    for (const sketch_type* sk: sketches) result.merge(*sk);
+    return export_sketch(result, params);
+  }
+
+  static sketch_type::vector_bytes serialize(const sketch_type& sk, const params_type&) { return sk.serialize(); }
+
+  static sketch_type deserialize(const char* data, size_t size, const params_type&) {
+    return sketch_type::deserialize(data, size);
+  }
+
+  static result_type export_sketch(const sketch_type& sk, const params_type&) {
+    const auto bytes = sk.serialize();
+    return result_type::deserialize(bytes.data(), bytes.size());
+  }
+
+  static std::string to_string(const sketch_type& sk, const params_type&) { return to_std_string(sk.to_string()); }
+};
+
+} // namespace datasketches
+
+#endif // _SKETCH_FAMILIES_HPP_
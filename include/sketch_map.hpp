@@ -0,0 +1,279 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _SKETCH_MAP_HPP_
+#define _SKETCH_MAP_HPP_
+
+/*
+  This header defines sketch_map, a native map from int64 keys to the
+  sketches of one family (see sketch_families.hpp) for group-by
+  aggregation over many keys. Sketches live in one pool in insertion
+  order, parallel to an array of their keys, and an open-addressing
+  table with linear probing maps each key to its position in the pool.
+  Positions never change, so keys() is the order of every batch result.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "batch_serde.hpp"
+#include "numpy_array.hpp"
+#include "memory_usage.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+template<typename Family>
+class sketch_map {
+  public:
+    using sketch_type = typename Family::sketch_type;
+    using params_type = typename Family::params_type;
+
+    explicit sketch_map(const params_type& params):
+    params_(params),
+    keys_(),
+    sketches_(),
+    slots_(MIN_CAPACITY, EMPTY),
+    mask_(MIN_CAPACITY - 1)
+    {}
+
+    const params_type& get_params() const { return params_; }
+    size_t size() const { return keys_.size(); }
+    const std::vector<int64_t>& get_keys() const { return keys_; }
+    const std::vector<sketch_type>& get_sketches() const { return sketches_; }
+
+    // the position of the key in the pool, if present
+    std::optional<size_t> find(int64_t key) const {
+      for (size_t slot = hash(key) & mask_; slots_[slot] != EMPTY; slot = (slot + 1) & mask_) {
+        if (keys_[slots_[slot]] == key) return slots_[slot];
+      }
+      return std::nullopt;
+    }
+
+    // the position of the key in the pool, inserting an empty sketch if absent
+    size_t find_or_insert(int64_t key) {
+      size_t slot = hash(key) & mask_;
+      for (; slots_[slot] != EMPTY; slot = (slot + 1) & mask_) {
+        if (keys_[slots_[slot]] == key) return slots_[slot];
+      }
+      const size_t pos = keys_.size();
+      keys_.push_back(key);
+      sketches_.push_back(Family::make(params_));
+      slots_[slot] = static_cast<uint32_t>(pos);
+      if (keys_.size() * 4 > slots_.size() * 3) rehash(slots_.size() * 2);
+      return pos;
+    }
+
+    // prepares the table and the pool for the given number of keys
+    void reserve(size_t num_keys) {
+      keys_.reserve(num_keys);
+      sketches_.reserve(num_keys);
+      size_t capacity = slots_.size();
+      while (num_keys * 4 > capacity * 3) capacity *= 2;
+      if (capacity > slots_.size()) rehash(capacity);
+    }
+
+    // Updates the sketch of keys[i] with values[i] for each i, creating sketches for new keys.
+    // NaN values are skipped without creating a sketch.
+    template<typename V>
+    void update(nb::ndarray<int64_t>& keys, nb::ndarray<V>& values) {
+      auto k = view_1d(keys);
+      auto v = view_1d(values);
+      if (k.shape(0) != v.shape(0)) {
+        throw std::invalid_argument("keys and values must have the same length: " + std::to_string(k.shape(0))
+          + " vs " + std::to_string(v.shape(0)));
+      }
+      nb::gil_scoped_release release;
+      for (size_t i = 0; i < k.shape(0); ++i) {
+        const V value = v(i);
+        if constexpr (std::is_floating_point<V>::value) {
+          if (std::isnan(value)) continue;
+        }
+        Family::update(sketches_[find_or_insert(k(i))], value);
+      }
+    }
+
+    void merge(const sketch_map& other) {
+      reserve(size() + other.size());
+      for (size_t i = 0; i < other.size(); ++i) {
+        Family::merge(sketches_[find_or_insert(other.keys_[i])], other.sketches_[i], params_);
+      }
+    }
+
+    // evaluates f(sketch) for every sketch into a NumPy array in the order of keys(), without the GIL
+    template<typename R, typename F>
+    numpy_array<R> query(F&& f) const {
+      auto result = make_numpy_array<R>(size());
+      R* out = result.data();
+      nb::gil_scoped_release release;
+      for (size_t i = 0; i < size(); ++i) out[i] = f(sketches_[i]);
+      return result;
+    }
+
+    // evaluates f(sketch, out) for every sketch, where out is a row of num_cols values
+    template<typename R, typename F>
+    numpy_array_2d<R> query_rows(size_t num_cols, F&& f) const {
+      auto result = make_numpy_array<R>(size(), num_cols);
+      R* out = result.data();
+      nb::gil_scoped_release release;
+      for (size_t i = 0; i < size(); ++i) f(sketches_[i], out + i * num_cols);
+      return result;
+    }
+
+    size_t get_memory_usage() const {
+      size_t bytes = sizeof(*this) + keys_.capacity() * sizeof(int64_t) + slots_.capacity() * sizeof(uint32_t)
+        + (sketches_.capacity() - sketches_.size()) * sizeof(sketch_type);
+      for (const sketch_type& sk: sketches_) bytes += sketch_memory_usage(sk);
+      return bytes;
+    }
+
+    numpy_array<int64_t> keys_array() const {
+      auto result = make_numpy_array<int64_t>(size());
+      std::copy(keys_.begin(), keys_.end(), result.data());
+      return result;
+    }
+
+    nb::bytes serialize_batch() const {
+      using image_type = decltype(Family::serialize(std::declval<const sketch_type&>(), params_));
+      std::vector<image_type> images(size());
+      {
+        nb::gil_scoped_release release;
+        for (size_t i = 0; i < size(); ++i) images[i] = Family::serialize(sketches_[i], params_);
+      }
+      return make_batch(images);
+    }
+
+    // Stores the sketches of a batch under the given keys, replacing the sketches of existing keys.
+    void deserialize_batch(nb::ndarray<int64_t>& keys, nb::handle bytes) {
+      auto k = view_1d(keys);
+      py_byte_range range(bytes);
+      batch_reader reader(range.data(), range.size());
+      if (reader.num_images() != k.shape(0)) {
+        throw std::invalid_argument("batch holds " + std::to_string(reader.num_images()) + " sketches but "
+          + std::to_string(k.shape(0)) + " keys were given");
+      }
+
+      nb::gil_scoped_release release;
+      // deserialize everything before replacing anything, so a bad image leaves the map unchanged
+      std::vector<sketch_type> sketches;
+      sketches.reserve(reader.num_images());
+      for (size_t i = 0; i < reader.num_images(); ++i) {
+        sketches.push_back(Family::deserialize(reader.image(i), reader.image_size(i), params_));
+      }
+      reserve(size() + sketches.size());
+      for (size_t i = 0; i < sketches.size(); ++i) sketches_[find_or_insert(k(i))] = std::move(sketches[i]);
+    }
+
+  private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    params_type params_;
+    std::vector<int64_t> keys_;
+    std::vector<sketch_type> sketches_;
+    std::vector<uint32_t> slots_;
+    size_t mask_;
+
+    static size_t hash(int64_t key) {
+      uint64_t x = static_cast<uint64_t>(key);
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdULL;
+      x ^= x >> 33;
+      x *= 0xc4ceb9fe1a85ec53ULL;
+      x ^= x >> 33;
+      return static_cast<size_t>(x);
+    }
+
+    void rehash(size_t capacity) {
+      if (capacity > EMPTY) throw std::length_error("sketch_map cannot hold more than 2^32 - 1 keys");
+      slots_.assign(capacity, EMPTY);
+      mask_ = capacity - 1;
+      for (size_t pos = 0; pos < keys_.size(); ++pos) {
+        size_t slot = hash(keys_[pos]) & mask_;
+        while (slots_[slot] != EMPTY) slot = (slot + 1) & mask_;
+        slots_[slot] = static_cast<uint32_t>(pos);
+      }
+    }
+};
+
+/**
+ * @brief Binds the members shared by every sketch_map family.
+ * The caller adds the constructor, update overloads and queries.
+ */
+template<typename Family>
+nb::class_<sketch_map<Family>> bind_sketch_map(nb::module_& m, const char* name, const char* doc) {
+  using SM = sketch_map<Family>;
+  auto clazz = nb::class_<SM>(m, name, doc);
+  clazz
+    .def("__copy__", [](const SM& sm) { return SM(sm); })
+    .def("__len__", &SM::size,
+         "The number of keys in the map")
+    .def("__contains__", [](const SM& sm, int64_t key) { return sm.find(key).has_value(); }, nb::arg("key"))
+    .def("get",
+         [](const SM& sm, int64_t key) -> std::optional<typename Family::result_type> {
+           auto pos = sm.find(key);
+           if (!pos) return std::nullopt;
+           return Family::export_sketch(sm.get_sketches()[*pos], sm.get_params());
+         }, nb::arg("key"),
+         "Returns a copy of the sketch of the given key, or None if the key is absent")
+    .def("get_memory_usage", &SM::get_memory_usage, release_gil(),
+         "Returns the approximate number of bytes held by the map, including its hash table and every sketch")
+    .def("keys", &SM::keys_array,
+         "Returns a NumPy array of the keys in insertion order, which is the order of every batch result")
+    .def("reserve", &SM::reserve, nb::arg("num_keys"),
+         "Allocates room for the given number of keys, avoiding rehashing while they are inserted")
+    .def("merge", &SM::merge, nb::arg("other"), release_gil(),
+         "Merges the sketch of each key of the given map into the sketch of the same key in this one, "
+         "adding keys missing from this map")
+    .def("serialize_batch", &SM::serialize_batch,
+         "Serializes all sketches, in the order of keys(), into a single sketch batch")
+    .def("deserialize_batch", &SM::deserialize_batch, nb::arg("keys"), nb::arg("bytes"),
+         "Stores the sketches of a batch written by serialize_batch() under the given NumPy array of keys, "
+         "replacing the sketches of keys already present");
+  return clazz;
+}
+
+/**
+ * @brief Adds an update method taking NumPy arrays of int64 keys and of values of type V.
+ */
+template<typename V, typename Family>
+void add_sketch_map_update(nb::class_<sketch_map<Family>>& clazz, const char* doc) {
+  using SM = sketch_map<Family>;
+  clazz.def("update",
+    [](SM& sm, nb::ndarray<int64_t> keys, nb::ndarray<V> values) { sm.update(keys, values); },
+    nb::arg("keys"), nb::arg("values"), doc);
+}
+
+} // namespace datasketches
+
+#endif // _SKETCH_MAP_HPP_
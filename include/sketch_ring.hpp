@@ -0,0 +1,189 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _SKETCH_RING_HPP_
+#define _SKETCH_RING_HPP_
+
+/*
+  This header defines sketch_ring, a ring of num_buckets sketches of one
+  family (see sketch_families.hpp) for sliding windows over time buckets.
+  Updates go into the current bucket, and advance() moves on to the next
+  one, clearing the oldest. A merge_tree over the buckets keeps their
+  partial merges, so a window over the latest buckets takes O(log W)
+  merges: one path is merged again per changed bucket, and the window is
+  covered by at most two ranges of the ring.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+
+#include "numpy_array.hpp"
+#include "memory_usage.hpp"
+#include "merge_tree.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+template<typename Family>
+class sketch_ring {
+  public:
+    using sketch_type = typename Family::sketch_type;
+    using params_type = typename Family::params_type;
+
+    sketch_ring(const params_type& params, uint32_t num_buckets):
+    params_(params),
+    buckets_(),
+    tree_(num_buckets, Family::make(params), family_merge{params}),
+    head_(0),
+    num_advances_(0)
+    {
+      if (num_buckets == 0) throw std::invalid_argument("num_buckets must be at least 1");
+      buckets_.reserve(num_buckets);
+      for (uint32_t i = 0; i < num_buckets; ++i) buckets_.push_back(Family::make(params));
+    }
+
+    const params_type& get_params() const { return params_; }
+    uint32_t get_num_buckets() const { return static_cast<uint32_t>(buckets_.size()); }
+    uint64_t get_num_advances() const { return num_advances_; }
+    const sketch_type& current() const { return buckets_[head_]; }
+
+    // moves the current bucket forward by the given number of steps, clearing the buckets passed over
+    void advance(uint64_t steps) {
+      const uint32_t n = get_num_buckets();
+      const uint64_t cleared = steps < n ? steps : n;
+      for (uint64_t i = 1; i <= cleared; ++i) {
+        const uint32_t bucket = static_cast<uint32_t>((head_ + i) % n);
+        buckets_[bucket] = Family::make(params_);
+        tree_.invalidate(bucket);
+      }
+      head_ = static_cast<uint32_t>((head_ + steps) % n);
+      num_advances_ += steps;
+    }
+
+    // Updates the current bucket with every value. NaN values are skipped.
+    template<typename V>
+    void update(nb::ndarray<V>& values) {
+      auto v = view_1d(values);
+      nb::gil_scoped_release release;
+      sketch_type& sk = buckets_[head_];
+      for (size_t i = 0; i < v.shape(0); ++i) {
+        const V value = v(i);
+        if constexpr (std::is_floating_point<V>::value) {
+          if (std::isnan(value)) continue;
+        }
+        Family::update(sk, value);
+      }
+      tree_.invalidate(head_);
+    }
+
+    // the merge of the latest window buckets, the current one included, or of all buckets by default
+    sketch_type window(std::optional<uint32_t> window) {
+      const uint32_t n = get_num_buckets();
+      const uint32_t w = window.value_or(n);
+      if (w < 1 || w > n) {
+        throw std::invalid_argument("window must be between 1 and " + std::to_string(n) + " buckets: " + std::to_string(w));
+      }
+      auto leaf = [this](size_t i) -> const sketch_type& { return buckets_[i]; };
+      if (w == n) return tree_.refresh(leaf, 1);
+
+      tree_.refresh(leaf, 1);
+      sketch_type result = Family::make(params_);
+      const uint32_t first = (head_ + n + 1 - w) % n;
+      if (first <= head_) {
+        tree_.merge_range(first, head_ + 1, leaf, result);
+      } else {
+        tree_.merge_range(first, n, leaf, result);
+        tree_.merge_range(0, head_ + 1, leaf, result);
+      }
+      return result;
+    }
+
+    size_t get_memory_usage() const {
+      size_t bytes = sizeof(*this) + tree_.get_memory_usage();
+      for (const sketch_type& sk: buckets_) bytes += sketch_memory_usage(sk);
+      return bytes;
+    }
+
+  private:
+    struct family_merge {
+      params_type params;
+      void operator()(sketch_type& sk, const sketch_type& other) const { Family::merge(sk, other, params); }
+    };
+
+    params_type params_;
+    std::vector<sketch_type> buckets_;
+    merge_tree<sketch_type, family_merge> tree_;
+    uint32_t head_; // the current bucket
+    uint64_t num_advances_;
+};
+
+/**
+ * @brief Binds the members shared by every sketch_ring family.
+ * The caller adds the constructor, update overloads and queries.
+ */
+template<typename Family>
+nb::class_<sketch_ring<Family>> bind_sketch_ring(nb::module_& m, const char* name, const char* doc) {
+  using SR = sketch_ring<Family>;
+  auto clazz = nb::class_<SR>(m, name, doc);
+  clazz
+    .def("__copy__", [](const SR& sr) { return SR(sr); })
+    .def("__len__", &SR::get_num_buckets,
+         "The number of buckets in the ring")
+    .def_prop_ro("num_buckets", &SR::get_num_buckets,
+         "The number of buckets in the ring, which is the longest window")
+    .def_prop_ro("num_advances", &SR::get_num_advances,
+         "The total number of steps the ring has advanced")
+    .def("advance", &SR::advance, nb::arg("steps")=1,
+         "Moves to the next bucket, which becomes the current one after being cleared, or by the given number of "
+         "buckets, clearing all of them. The oldest bucket is dropped from the ring at each step.")
+    .def("current",
+         [](const SR& sr) { return Family::export_sketch(sr.current(), sr.get_params()); },
+         "Returns a copy of the sketch of the current bucket")
+    .def("window",
+         [](SR& sr, std::optional<uint32_t> window) { return Family::export_sketch(sr.window(window), sr.get_params()); },
+         nb::arg("window")=nb::none(),
+         "Returns the merge of the latest `window` buckets, the current one included, in O(log num_buckets) merges "
+         "of cached partial merges (default: all buckets)")
+    .def("get_memory_usage", &SR::get_memory_usage,
+         "Returns the approximate number of bytes held by the ring, including its buckets and partial merges");
+  return clazz;
+}
+
+/**
+ * @brief Adds an update method taking a NumPy array of values of type V.
+ */
+template<typename V, typename Family>
+void add_sketch_ring_update(nb::class_<sketch_ring<Family>>& clazz, const char* doc) {
+  using SR = sketch_ring<Family>;
+  clazz.def("update", [](SR& sr, nb::ndarray<V> values) { sr.update(values); }, nb::arg("values"), doc);
+}
+
+} // namespace datasketches
+
+#endif // _SKETCH_RING_HPP_
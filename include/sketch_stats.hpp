@@ -0,0 +1,308 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _SKETCH_STATS_HPP_
+#define _SKETCH_STATS_HPP_
+
+/*
+  This header defines the hot-path counters reported by get_stats() and
+  datasketches.stats(). They are compiled in only when DATASKETCHES_STATS
+  is defined (cmake -DDATASKETCHES_STATS=ON). Otherwise every probe below
+  is an empty inline function, update bindings are the plain member
+  functions, and the counters read as zero.
+  Structural events are detected from the public state of a sketch before
+  and after each update: a KLL, REQ or quantiles compaction retains fewer
+  items than were added, a theta rebuild lowers theta, and an HLL
+  promotion switches a coupon list to a set, or either to HLL mode.
+  Per-object counters live in a table keyed by the Python object and are
+  freed with it. The table and the module-wide totals live in
+  src/stats_wrapper.cpp.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include <nanobind/nanobind.h>
+
+#include "kll_sketch.hpp"
+#include "req_sketch.hpp"
+#include "quantiles_sketch.hpp"
+#include "theta_sketch.hpp"
+#include "hll.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+enum stats_counter: unsigned {
+  STATS_UPDATES,
+  STATS_COMPACTIONS,
+  STATS_REBUILDS,
+  STATS_PROMOTIONS,
+  STATS_SERDE_CALLS,
+  STATS_SERDE_NANOS,
+  STATS_BYTES_SERIALIZED,
+  NUM_STATS_COUNTERS
+};
+
+struct sketch_stats {
+  uint64_t counters[NUM_STATS_COUNTERS] = {};
+};
+
+// a dict from the name of each counter to its value
+nb::dict stats_to_dict(const sketch_stats& stats);
+
+#ifdef DATASKETCHES_STATS
+
+constexpr bool STATS_ENABLED = true;
+
+// the counters of a Python object, created on first use if requested; both require the GIL
+sketch_stats* object_stats(PyObject* obj, bool create);
+void add_module_stats(const sketch_stats& delta) noexcept;
+
+template<typename T>
+sketch_stats* object_stats_of(const T& obj, bool create) {
+  nb::object self = nb::find(&obj);
+  return self.is_valid() ? object_stats(self.ptr(), create) : nullptr;
+}
+
+// adds a delta to the counters of an object, if it is a Python object, and to the module totals
+inline void commit_stats(sketch_stats* object, const sketch_stats& delta) noexcept {
+  if (object != nullptr) {
+    for (unsigned i = 0; i < NUM_STATS_COUNTERS; ++i) object->counters[i] += delta.counters[i];
+  }
+  add_module_stats(delta);
+}
+
+#else
+
+constexpr bool STATS_ENABLED = false;
+
+#endif // DATASKETCHES_STATS
+
+namespace stats_internal {
+
+// the state compared before and after an update, and the events it reveals
+template<typename SK>
+struct shape_traits {
+  using shape_type = bool;
+  static shape_type shape(const SK&) { return false; }
+  static void record(const shape_type&, const SK&, sketch_stats&) {}
+};
+
+// a compaction keeps fewer items than the stream grew by
+template<typename SK>
+struct quantiles_shape_traits {
+  using shape_type = std::pair<uint64_t, uint64_t>;
+  static shape_type shape(const SK& sk) { return {sk.get_n(), sk.get_num_retained()}; }
+  static void record(const shape_type& before, const SK& sk, sketch_stats& stats) {
+    if (sk.get_num_retained() < before.second + (sk.get_n() - before.first)) ++stats.counters[STATS_COMPACTIONS];
+  }
+};
+
+template<typename T, typename C, typename A>
+struct shape_traits<kll_sketch<T, C, A>>: quantiles_shape_traits<kll_sketch<T, C, A>> {};
+
+template<typename T, typename C, typename A>
+struct shape_traits<req_sketch<T, C, A>>: quantiles_shape_traits<req_sketch<T, C, A>> {};
+
+template<typename T, typename C, typename A>
+struct shape_traits<quantiles_sketch<T, C, A>>: quantiles_shape_traits<quantiles_sketch<T, C, A>> {};
+
+// a rebuild lowers theta to keep the nominal number of entries
+template<typename SK>
+struct theta_shape_traits {
+  using shape_type = uint64_t;
+  static shape_type shape(const SK& sk) { return sk.get_theta64(); }
+  static void record(const shape_type& before, const SK& sk, sketch_stats& stats) {
+    if (sk.get_theta64() < before) ++stats.counters[STATS_REBUILDS];
+  }
+};
+
+template<typename A>
+struct shape_traits<update_theta_sketch_alloc<A>>: theta_shape_traits<update_theta_sketch_alloc<A>> {};
+
+// The updatable size tells the modes apart: the coupon list takes no more
+// than the header of HLL mode, and the coupon set, however often it resized,
+// less than the header and register array. Only changes of mode are counted,
+// not resizes of the coupon set or of the HLL_4 exception table.
+template<typename A>
+struct shape_traits<hll_sketch_alloc<A>> {
+  static constexpr uint32_t HLL_HEADER_BYTES = 40;
+  enum mode: uint8_t { LIST, SET, HLL };
+  using shape_type = mode;
+  static shape_type shape(const hll_sketch_alloc<A>& sk) {
+    const uint32_t bytes = sk.get_updatable_serialization_bytes();
+    if (bytes <= HLL_HEADER_BYTES) return LIST;
+    return bytes < hll_mode_bytes(sk) ? SET : HLL;
+  }
+  static void record(const shape_type& before, const hll_sketch_alloc<A>& sk, sketch_stats& stats) {
+    if (shape(sk) != before) ++stats.counters[STATS_PROMOTIONS];
+  }
+  static uint32_t hll_mode_bytes(const hll_sketch_alloc<A>& sk) {
+    const uint32_t k = 1u << sk.get_lg_config_k();
+    switch (sk.get_target_type()) {
+      case HLL_4: return HLL_HEADER_BYTES + k / 2;
+      case HLL_6: return HLL_HEADER_BYTES + k * 3 / 4;
+      default: return HLL_HEADER_BYTES + k;
+    }
+  }
+};
+
+} // namespace stats_internal
+
+/**
+ * @brief Counts the updates of one sketch and the structural events they
+ * cause, adding them to the sketch's counters and the module totals when
+ * destroyed. Construct and destroy it with the GIL held; update() may run
+ * without it.
+ */
+template<typename SK>
+class stats_probe {
+  public:
+#ifdef DATASKETCHES_STATS
+    explicit stats_probe(const SK& sk): object_(object_stats_of(sk, true)), delta_() {}
+    ~stats_probe() { commit_stats(object_, delta_); }
+
+    template<typename F>
+    void update(const SK& sk, F&& f) {
+      using traits = stats_internal::shape_traits<SK>;
+      const auto before = traits::shape(sk);
+      f();
+      ++delta_.counters[STATS_UPDATES];
+      traits::record(before, sk, delta_);
+    }
+
+  private:
+    sketch_stats* object_;
+    sketch_stats delta_;
+#else
+    explicit stats_probe(const SK&) {}
+
+    template<typename F>
+    void update(const SK&, F&& f) { f(); }
+#endif
+};
+
+/**
+ * @brief Wraps an update member function so that each call is counted.
+ * Without DATASKETCHES_STATS this returns the member function itself.
+ */
+template<typename SK, typename... Args>
+auto counted_update(void (SK::*update)(Args...)) {
+#ifdef DATASKETCHES_STATS
+  return [update](SK& sk, Args... args) {
+    stats_probe<SK> probe(sk);
+    probe.update(sk, [&] { (sk.*update)(std::forward<Args>(args)...); });
+  };
+#else
+  return update;
+#endif
+}
+
+/**
+ * @brief Adds the size of a serialized image to the counters of the sketch
+ * and the module totals. Requires the GIL.
+ */
+template<typename SK>
+void count_serialized(const SK& sk, size_t bytes) {
+#ifdef DATASKETCHES_STATS
+  sketch_stats delta;
+  delta.counters[STATS_BYTES_SERIALIZED] = bytes;
+  commit_stats(object_stats_of(sk, true), delta);
+#else
+  (void) sk;
+  (void) bytes;
+#endif
+}
+
+/**
+ * @brief Counts and times the Python callbacks of a serde during one
+ * serialization or deserialization. Construct and destroy it with the GIL held.
+ */
+template<typename Serde>
+class serde_stats_probe {
+  public:
+#ifdef DATASKETCHES_STATS
+    explicit serde_stats_probe(const Serde& serde): object_(object_stats_of(serde, true)), delta_() {}
+    ~serde_stats_probe() { commit_stats(object_, delta_); }
+
+    template<typename F>
+    auto call(F&& f) -> decltype(f()) {
+      const auto start = std::chrono::steady_clock::now();
+      struct timer {
+        sketch_stats& delta;
+        std::chrono::steady_clock::time_point start;
+        ~timer() {
+          ++delta.counters[STATS_SERDE_CALLS];
+          delta.counters[STATS_SERDE_NANOS] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        }
+      } t{delta_, start};
+      return f();
+    }
+
+  private:
+    sketch_stats* object_;
+    sketch_stats delta_;
+#else
+    explicit serde_stats_probe(const Serde&) {}
+
+    template<typename F>
+    auto call(F&& f) -> decltype(f()) { return f(); }
+#endif
+};
+
+/**
+ * @brief Adds get_stats() and reset_stats() to a class.
+ */
+template<typename SK, typename... Ts>
+void add_stats(nb::class_<SK, Ts...>& clazz) {
+  clazz.def(
+    "get_stats",
+    [](const SK& obj) {
+#ifdef DATASKETCHES_STATS
+      const sketch_stats* stats = object_stats_of(obj, false);
+      return stats_to_dict(stats != nullptr ? *stats : sketch_stats());
+#else
+      (void) obj;
+      return stats_to_dict(sketch_stats());
+#endif
+    },
+    "Returns a dict of the hot-path counters of this object: updates, compactions (KLL, REQ and quantiles), "
+    "rebuilds (theta), promotions (HLL), serde_calls and serde_nanos (Python serde callbacks), and "
+    "bytes_serialized. The counters are zero unless the module was built with DATASKETCHES_STATS."
+  )
+  .def(
+    "reset_stats",
+    [](const SK& obj) {
+#ifdef DATASKETCHES_STATS
+      if (sketch_stats* stats = object_stats_of(obj, false)) *stats = sketch_stats();
+#else
+      (void) obj;
+#endif
+    },
+    "Resets the counters of get_stats() for this object, leaving the module-wide totals unchanged"
+  );
+}
+
+} // namespace datasketches
+
+#endif // _SKETCH_STATS_HPP_
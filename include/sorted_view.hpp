@@ -0,0 +1,271 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _SORTED_VIEW_HPP_
+#define _SORTED_VIEW_HPP_
+
+/*
+  This header defines a Python-facing sorted view of a quantile sketch
+  (KLL, REQ, classic quantiles). The view holds the sorted retained items
+  with their cumulative weights, so repeated rank and quantile queries are
+  binary searches rather than rebuilding the view from the sketch.
+  A view is a snapshot: it records a version of its sketch and refuses
+  queries once the sketch has changed. Containers pass the counter they
+  bump on every change to the sketch, since replacing it in place can keep
+  its stream length. For a standalone sketch the stream length serves, as
+  each of its in-place changes, an update or a merge, adds to it.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/vector.h>
+
+#include "gil_guard.hpp"
+#include "numpy_array.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+template<typename T, typename SK>
+class py_sorted_view {
+  public:
+    using view_type = decltype(std::declval<const SK&>().get_sorted_view());
+
+    // version, if given, must outlive the view and change with every change to the sketch
+    explicit py_sorted_view(const SK& sk, const uint64_t* version = nullptr):
+    sketch_(&sk),
+    version_(version),
+    snapshot_version_(version != nullptr ? *version : sk.get_n()),
+    n_(sk.get_n()),
+    view_(sk.get_sorted_view())
+    {}
+
+    bool is_valid() const {
+      return (version_ != nullptr ? *version_ : sketch_->get_n()) == snapshot_version_;
+    }
+
+    // the underlying view, checking that the sketch has not changed since
+    const view_type& get() const {
+      if (!is_valid()) {
+        throw std::runtime_error("sorted view is no longer valid: the sketch has been updated since it was created");
+      }
+      return view_;
+    }
+
+    bool is_empty() const { return view_.size() == 0; }
+    uint64_t get_n() const { return n_; }
+
+    T get_quantile(double rank, bool inclusive) const {
+      check_rank(rank);
+      return get().get_quantile(rank, inclusive);
+    }
+
+    double get_rank(const T& item, bool inclusive) const {
+      return get().get_rank(item, inclusive);
+    }
+
+    static void check_rank(double rank) {
+      if (!(rank >= 0.0 && rank <= 1.0)) {
+        throw std::invalid_argument("normalized rank cannot be less than zero or greater than 1.0");
+      }
+    }
+
+  private:
+    const SK* sketch_;
+    const uint64_t* version_;
+    uint64_t snapshot_version_;
+    uint64_t n_;
+    view_type view_;
+};
+
+// POD types: scalar and NumPy array queries without the GIL
+template<typename T, typename SK, typename std::enable_if<std::is_trivial<T>::value && std::is_standard_layout<T>::value, bool>::type = 0>
+void add_sorted_view_queries(nb::class_<py_sorted_view<T, SK>>& clazz) {
+  using VW = py_sorted_view<T, SK>;
+  clazz.def("get_quantile", &VW::get_quantile, nb::arg("rank"), nb::arg("inclusive")=false, release_gil(),
+      "Returns the quantile at the given normalized rank")
+    .def("get_rank", &VW::get_rank, nb::arg("value"), nb::arg("inclusive")=false, release_gil(),
+      "Returns the normalized rank of the given value")
+    .def(
+      "get_quantiles",
+      [](const VW& vw, nb::ndarray<double> ranks, bool inclusive) {
+        auto r = view_1d(ranks);
+        auto quantiles = make_numpy_array<T>(vw.is_empty() ? 0 : r.shape(0));
+        if (!vw.is_empty()) {
+          T* out = quantiles.data();
+          nb::gil_scoped_release release;
+          const auto& view = vw.get();
+          for (size_t i = 0; i < r.shape(0); ++i) {
+            VW::check_rank(r(i));
+            out[i] = view.get_quantile(r(i), inclusive);
+          }
+        }
+        return quantiles;
+      },
+      nb::arg("ranks"), nb::arg("inclusive")=false,
+      "Returns a NumPy array of the quantiles at each normalized rank of the given array. "
+      "If the view is empty this returns an empty array."
+    )
+    .def(
+      "get_ranks",
+      [](const VW& vw, nb::ndarray<T> values, bool inclusive) {
+        auto v = view_1d(values);
+        auto ranks = make_numpy_array<double>(vw.is_empty() ? 0 : v.shape(0));
+        if (!vw.is_empty()) {
+          double* out = ranks.data();
+          nb::gil_scoped_release release;
+          const auto& view = vw.get();
+          for (size_t i = 0; i < v.shape(0); ++i) out[i] = view.get_rank(v(i), inclusive);
+        }
+        return ranks;
+      },
+      nb::arg("values"), nb::arg("inclusive")=false,
+      "Returns a NumPy array of the normalized rank of each value of the given array. "
+      "If the view is empty this returns an empty array."
+    )
+    .def(
+      "get_pmf",
+      [](const VW& vw, nb::ndarray<T> split_points, bool inclusive) {
+        auto v = view_1d(split_points);
+        if (vw.is_empty()) return make_numpy_array<double>(0);
+        std::vector<T> points(v.shape(0));
+        for (size_t i = 0; i < points.size(); ++i) points[i] = v(i);
+        auto pmf = call_without_gil([&] {
+          return vw.get().get_PMF(points.data(), static_cast<uint32_t>(points.size()), inclusive);
+        });
+        auto result = make_numpy_array<double>(pmf.size());
+        std::copy(pmf.begin(), pmf.end(), result.data());
+        return result;
+      },
+      nb::arg("split_points"), nb::arg("inclusive")=false,
+      "Returns the Probability Mass Function (PMF) given a NumPy array of m unique, monotonically "
+      "increasing split points, as a NumPy array of m+1 values, as with the sketch's get_pmf()"
+    )
+    .def(
+      "get_cdf",
+      [](const VW& vw, nb::ndarray<T> split_points, bool inclusive) {
+        auto v = view_1d(split_points);
+        if (vw.is_empty()) return make_numpy_array<double>(0);
+        std::vector<T> points(v.shape(0));
+        for (size_t i = 0; i < points.size(); ++i) points[i] = v(i);
+        auto cdf = call_without_gil([&] {
+          return vw.get().get_CDF(points.data(), static_cast<uint32_t>(points.size()), inclusive);
+        });
+        auto result = make_numpy_array<double>(cdf.size());
+        std::copy(cdf.begin(), cdf.end(), result.data());
+        return result;
+      },
+      nb::arg("split_points"), nb::arg("inclusive")=false,
+      "Returns the Cumulative Distribution Function (CDF) given a NumPy array of m unique, monotonically "
+      "increasing split points, as a NumPy array of m+1 values, as with the sketch's get_cdf()"
+    )
+    .def_prop_ro(
+      "items",
+      [](const VW& vw) {
+        const auto& view = vw.get();
+        auto items = make_numpy_array<T>(view.size());
+        T* out = items.data();
+        size_t i = 0;
+        for (auto it = view.begin(); it != view.end(); ++it) out[i++] = (*it).first;
+        return items;
+      },
+      "The retained items in sorted order, as a NumPy array"
+    );
+}
+
+// other types: scalar and list queries, holding the GIL
+template<typename T, typename SK, typename std::enable_if<!std::is_trivial<T>::value || !std::is_standard_layout<T>::value, bool>::type = 0>
+void add_sorted_view_queries(nb::class_<py_sorted_view<T, SK>>& clazz) {
+  using VW = py_sorted_view<T, SK>;
+  clazz.def("get_quantile", &VW::get_quantile, nb::arg("rank"), nb::arg("inclusive")=false,
+      "Returns the quantile at the given normalized rank")
+    .def("get_rank", &VW::get_rank, nb::arg("value"), nb::arg("inclusive")=false,
+      "Returns the normalized rank of the given value")
+    .def(
+      "get_quantiles",
+      [](const VW& vw, const std::vector<double>& ranks, bool inclusive) {
+        std::vector<T> quantiles;
+        quantiles.reserve(ranks.size());
+        for (double rank: ranks) quantiles.push_back(vw.get_quantile(rank, inclusive));
+        return quantiles;
+      },
+      nb::arg("ranks"), nb::arg("inclusive")=false,
+      "Returns a list of the quantiles at each of the given normalized ranks"
+    )
+    .def(
+      "get_ranks",
+      [](const VW& vw, const std::vector<T>& values, bool inclusive) {
+        std::vector<double> ranks;
+        ranks.reserve(values.size());
+        for (const T& value: values) ranks.push_back(vw.get_rank(value, inclusive));
+        return ranks;
+      },
+      nb::arg("values"), nb::arg("inclusive")=false,
+      "Returns a list of the normalized rank of each of the given values"
+    );
+}
+
+/**
+ * @brief Binds the sorted view class of sketch type SK under the given name
+ * and adds a sorted_view() method to the sketch class.
+ */
+template<typename T, typename SK>
+void add_sorted_view(nb::module_& m, nb::class_<SK>& sketch_class, const char* name) {
+  using VW = py_sorted_view<T, SK>;
+  auto clazz = nb::class_<VW>(m, name,
+      "A sorted view of the retained items of a sketch and their cumulative weights, for fast repeated queries. "
+      "The view is a snapshot and raises a RuntimeError on queries once its sketch has been updated.")
+    .def_prop_ro("is_valid", &VW::is_valid,
+      "True if the sketch is unchanged since the view was created, otherwise False")
+    .def_prop_ro("n", &VW::get_n,
+      "The length of the input stream when the view was created")
+    .def("__len__", [](const VW& vw) { return vw.get().size(); },
+      "The number of retained items in the view")
+    .def_prop_ro(
+      "cumulative_weights",
+      [](const VW& vw) {
+        const auto& view = vw.get();
+        auto weights = make_numpy_array<uint64_t>(view.size());
+        uint64_t* out = weights.data();
+        size_t i = 0;
+        for (auto it = view.begin(); it != view.end(); ++it) out[i++] = it.get_cumulative_weight(true);
+        return weights;
+      },
+      "The inclusive cumulative weight of each retained item in sorted order, as a NumPy array"
+    );
+  add_sorted_view_queries<T, SK>(clazz);
+
+  sketch_class.def("sorted_view",
+      // building the view sorts and caches state inside the sketch, so the GIL is kept
+      [](const SK& sk) { return VW(sk); },
+      nb::keep_alive<0, 1>(),
+      "Returns a sorted view of the sketch for fast repeated rank and quantile queries. "
+      "The view remains usable until the sketch is next updated.");
+}
+
+} // namespace datasketches
+
+#endif // _SORTED_VIEW_HPP_
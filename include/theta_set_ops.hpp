@@ -0,0 +1,229 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THETA_SET_OPS_HPP_
+#define _THETA_SET_OPS_HPP_
+
+/*
+  This header defines set operations over many theta sketches at once,
+  computed natively on sorted arrays of their retained hashes and in
+  parallel. Each pair or fold restricts both operands to the hashes below
+  the smaller theta with a binary search, then merge-joins the prefixes.
+  Results match those of theta_union, theta_intersection and
+  theta_jaccard_similarity::jaccard() for the same inputs.
+*/
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "theta_sketch.hpp"
+#include "bounds_on_ratios_in_sampled_sets.hpp"
+#include "parallel.hpp"
+
+namespace datasketches {
+
+// the state of a theta sketch needed by the set operations
+struct sorted_theta_hashes {
+  bool is_empty;
+  uint64_t theta;
+  std::vector<uint64_t> hashes; // ascending, all below theta
+
+  explicit sorted_theta_hashes(const theta_sketch& sk):
+  is_empty(sk.is_empty()),
+  theta(sk.get_theta64()),
+  hashes(sk.begin(), sk.end())
+  {
+    if (!sk.is_ordered()) std::sort(hashes.begin(), hashes.end());
+  }
+
+  sorted_theta_hashes(bool empty, uint64_t theta64, std::vector<uint64_t>&& sorted_hashes):
+  is_empty(empty), theta(theta64), hashes(std::move(sorted_hashes)) {}
+
+  // the number of hashes below the given theta
+  size_t count_below(uint64_t limit) const {
+    return std::lower_bound(hashes.begin(), hashes.end(), limit) - hashes.begin();
+  }
+};
+
+namespace theta_set_ops_internal {
+
+// sizes of the union and the intersection of two ascending ranges
+inline std::pair<size_t, size_t> count_union_intersection(const uint64_t* a, size_t size_a, const uint64_t* b, size_t size_b) {
+  size_t i = 0, j = 0, common = 0;
+  while (i < size_a && j < size_b) {
+    if (a[i] < b[j]) ++i;
+    else if (b[j] < a[i]) ++j;
+    else { ++common; ++i; ++j; }
+  }
+  return {size_a + size_b - common, common};
+}
+
+inline void check_seed_hashes(const std::vector<const theta_sketch*>& sketches, uint64_t seed) {
+  const uint16_t seed_hash = compute_seed_hash(seed);
+  for (size_t i = 0; i < sketches.size(); ++i) {
+    if (!sketches[i]->is_empty() && sketches[i]->get_seed_hash() != seed_hash) {
+      throw std::invalid_argument("seed hash mismatch for sketch " + std::to_string(i) + ": expected "
+        + std::to_string(seed_hash) + ", actual " + std::to_string(sketches[i]->get_seed_hash()));
+    }
+  }
+}
+
+} // namespace theta_set_ops_internal
+
+inline std::vector<sorted_theta_hashes> collect_sorted_hashes(const std::vector<const theta_sketch*>& sketches,
+                                                               uint64_t seed, unsigned num_threads) {
+  theta_set_ops_internal::check_seed_hashes(sketches, seed);
+  std::vector<std::optional<sorted_theta_hashes>> collected(sketches.size());
+  parallel_for(sketches.size(), num_threads, [&](size_t i) { collected[i].emplace(*sketches[i]); });
+  std::vector<sorted_theta_hashes> result;
+  result.reserve(collected.size());
+  for (auto& c: collected) result.push_back(std::move(*c));
+  return result;
+}
+
+/**
+ * @brief The {lower bound, estimate, upper bound} of the Jaccard similarity
+ * of two sketches, as computed by theta_jaccard_similarity::jaccard().
+ */
+inline std::array<double, 3> jaccard(const sorted_theta_hashes& a, const sorted_theta_hashes& b) {
+  if (a.is_empty && b.is_empty) return {1, 1, 1};
+  if (a.is_empty || b.is_empty) return {0, 0, 0};
+  const uint64_t theta = std::min(a.theta, b.theta);
+  const auto counts = theta_set_ops_internal::count_union_intersection(
+    a.hashes.data(), a.count_below(theta), b.hashes.data(), b.count_below(theta));
+  const uint64_t count_union = counts.first;
+  const uint64_t count_inter = counts.second;
+  if (count_union == a.hashes.size() && count_union == b.hashes.size() && a.theta == b.theta) return {1, 1, 1};
+  const double f = static_cast<double>(theta) / static_cast<double>(theta_constants::MAX_THETA);
+  return {
+    bounds_on_ratios_in_sampled_sets::lower_bound_for_b_over_a(count_union, count_inter, f),
+    bounds_on_ratios_in_sampled_sets::get_estimate_of_b_over_a(count_union, count_inter),
+    bounds_on_ratios_in_sampled_sets::upper_bound_for_b_over_a(count_union, count_inter, f)
+  };
+}
+
+/**
+ * @brief Computes jaccard() for every pair of sketches into a row-major
+ * n x n x 3 array, in parallel. Thread t computes the upper triangles of
+ * rows t and n-1-t so the threads get equal work, and mirrors them.
+ */
+inline void pairwise_jaccard(const std::vector<sorted_theta_hashes>& sketches, unsigned num_threads, double* out) {
+  const size_t n = sketches.size();
+  auto store = [out, n](size_t i, size_t j, const std::array<double, 3>& value) {
+    std::copy(value.begin(), value.end(), out + (i * n + j) * 3);
+    std::copy(value.begin(), value.end(), out + (j * n + i) * 3);
+  };
+  auto row = [&](size_t i) {
+    store(i, i, {1, 1, 1});
+    for (size_t j = i + 1; j < n; ++j) store(i, j, jaccard(sketches[i], sketches[j]));
+  };
+  parallel_for((n + 1) / 2, num_threads, [&](size_t t) {
+    row(t);
+    if (n - 1 - t != t) row(n - 1 - t);
+  });
+}
+
+/**
+ * @brief The intersection of all sketches, as computed by theta_intersection.
+ * Partial intersections are folded per thread and then intersected.
+ */
+inline sorted_theta_hashes intersect_all(std::vector<sorted_theta_hashes>& sketches, unsigned num_threads) {
+  if (sketches.empty()) throw std::invalid_argument("intersection of no sketches is undefined");
+  auto intersect = [](sorted_theta_hashes& acc, const sorted_theta_hashes& other) {
+    if (acc.is_empty) return;
+    if (other.is_empty) {
+      acc = sorted_theta_hashes(true, theta_constants::MAX_THETA, {});
+      return;
+    }
+    acc.theta = std::min(acc.theta, other.theta);
+    const size_t size_a = acc.count_below(acc.theta);
+    const size_t size_b = other.count_below(acc.theta);
+    const uint64_t* b = other.hashes.data();
+    size_t kept = 0;
+    for (size_t i = 0, j = 0; i < size_a && j < size_b;) {
+      if (acc.hashes[i] < b[j]) ++i;
+      else if (b[j] < acc.hashes[i]) ++j;
+      else { acc.hashes[kept++] = acc.hashes[i]; ++i; ++j; }
+    }
+    acc.hashes.resize(kept);
+    // as in theta_intersection, no common hashes at full theta means an empty result
+    if (kept == 0 && acc.theta == theta_constants::MAX_THETA) acc.is_empty = true;
+  };
+  return parallel_reduce(sketches.size(), num_threads,
+    [] { return std::optional<sorted_theta_hashes>(); },
+    [&](std::optional<sorted_theta_hashes>& acc, size_t i) {
+      if (!acc) acc.emplace(std::move(sketches[i]));
+      else intersect(*acc, sketches[i]);
+    },
+    [&](std::optional<sorted_theta_hashes>& acc, std::optional<sorted_theta_hashes>& other) {
+      if (!acc) acc = std::move(other);
+      else if (other) intersect(*acc, *other);
+    }
+  ).value();
+}
+
+/**
+ * @brief The union of all sketches keeping at most 2^lg_k hashes, as
+ * computed by a theta_union of that lg_k: every hash below the smallest
+ * theta of the non-empty inputs, trimmed to the 2^lg_k smallest.
+ * Partial unions are trimmed as they are folded, which keeps every hash of
+ * the final result.
+ */
+inline sorted_theta_hashes union_all(std::vector<sorted_theta_hashes>& sketches, uint8_t lg_k, unsigned num_threads) {
+  const size_t k = size_t(1) << lg_k;
+  auto merge = [k](sorted_theta_hashes& acc, const sorted_theta_hashes& other) {
+    if (other.is_empty) return;
+    acc.is_empty = false;
+    acc.theta = std::min(acc.theta, other.theta);
+    const size_t size_a = acc.count_below(acc.theta);
+    const size_t size_b = other.count_below(acc.theta);
+    std::vector<uint64_t> merged;
+    merged.reserve(std::min(size_a + size_b, k + 1));
+    const uint64_t* a = acc.hashes.data();
+    const uint64_t* b = other.hashes.data();
+    size_t i = 0, j = 0;
+    // stops at the (k+1)th smallest hash, which becomes theta
+    while ((i < size_a || j < size_b) && merged.size() <= k) {
+      if (j == size_b || (i < size_a && a[i] < b[j])) merged.push_back(a[i++]);
+      else if (i == size_a || b[j] < a[i]) merged.push_back(b[j++]);
+      else { merged.push_back(b[j]); ++i; ++j; }
+    }
+    if (merged.size() > k) {
+      acc.theta = merged[k];
+      merged.resize(k);
+    }
+    acc.hashes = std::move(merged);
+  };
+  auto make = [] { return sorted_theta_hashes(true, theta_constants::MAX_THETA, {}); };
+  if (sketches.empty()) return make();
+  return parallel_reduce(sketches.size(), num_threads, make,
+    [&](sorted_theta_hashes& acc, size_t i) { merge(acc, sketches[i]); },
+    [&](sorted_theta_hashes& acc, sorted_theta_hashes& other) { if (!other.is_empty) merge(acc, other); }
+  );
+}
+
+} // namespace datasketches
+
+#endif // _THETA_SET_OPS_HPP_
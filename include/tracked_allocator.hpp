@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _TRACKED_ALLOCATOR_HPP_
+#define _TRACKED_ALLOCATOR_HPP_
+
+/*
+  This header defines tracked_allocator, a stateless allocator for the
+  Allocator parameter of the sketch templates. Every allocation goes
+  through the module-level allocator hook (malloc by default, a built-in
+  size-class pool, or an external allocator installed from a capsule),
+  and is counted in global statistics. Being stateless, sketches using
+  it copy, move and merge exactly as with std::allocator.
+  The hook and the counters live in src/memory_wrapper.cpp.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace datasketches {
+
+// an external allocator, installed through a capsule named "datasketches.allocator"
+struct allocator_hook {
+  void* (*allocate)(size_t size, void* context);
+  void (*deallocate)(void* ptr, size_t size, void* context);
+  void* context;
+};
+
+struct allocation_stats {
+  uint64_t bytes_in_use;
+  uint64_t peak_bytes;
+  uint64_t num_allocations;
+  uint64_t num_deallocations;
+  uint64_t pool_bytes;
+};
+
+// both return nullptr or ignore nullptr respectively, never throw
+void* tracked_allocate(size_t size) noexcept;
+void tracked_deallocate(void* ptr, size_t size) noexcept;
+allocation_stats get_allocation_stats() noexcept;
+
+template<typename T>
+class tracked_allocator {
+  public:
+    using value_type = T;
+
+    tracked_allocator() noexcept = default;
+    template<typename U>
+    tracked_allocator(const tracked_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+      if (n > SIZE_MAX / sizeof(T)) throw std::bad_array_new_length();
+      void* ptr = tracked_allocate(n * sizeof(T));
+      if (ptr == nullptr) throw std::bad_alloc();
+      return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+      tracked_deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const tracked_allocator<T>&, const tracked_allocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const tracked_allocator<T>&, const tracked_allocator<U>&) noexcept { return false; }
+
+} // namespace datasketches
+
+#endif // _TRACKED_ALLOCATOR_HPP_
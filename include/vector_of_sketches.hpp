@@ -0,0 +1,344 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _VECTOR_OF_SKETCHES_HPP_
+#define _VECTOR_OF_SKETCHES_HPP_
+
+/*
+  This header defines vector_of_sketches, a columnar container of d
+  sketches of one family updated from 2D NumPy arrays, generalizing
+  vector_of_kll_sketches. The family is a policy class providing:
+
+    sketch_type, params_type, result_type
+    static sketch_type make(const params_type&)
+    static void update(sketch_type&, V value)        for each value type V
+    static void merge(sketch_type&, const sketch_type&, const params_type&)
+    static result_type collapse(const params_type&, const std::vector<const sketch_type*>&)
+    static <byte vector> serialize(const sketch_type&, const params_type&)
+    static sketch_type deserialize(const char*, size_t, const params_type&)
+    static std::string to_string(const sketch_type&, const params_type&)
+
+  None of these may touch Python objects, since all of them run with
+  the GIL released, possibly on several threads for distinct sketches.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/variant.h>
+#include <nanobind/stl/vector.h>
+
+#include "common_defs.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "batch_serde.hpp"
+#include "numpy_array.hpp"
+#include "memory_usage.hpp"
+#include "parallel.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+namespace vector_of_sketches_constants {
+  static const uint32_t DEFAULT_D = 1;
+  static const unsigned DEFAULT_NUM_THREADS = 1;
+  // target size of the block of a row-major input updated at once by each thread
+  static const size_t UPDATE_BLOCK_BYTES = 1 << 17;
+}
+
+// a single sketch index, -1 for all sketches, or a list of indices
+using sketch_indices = std::variant<int, std::vector<int>>;
+
+template<typename Family>
+class vector_of_sketches {
+  public:
+    using sketch_type = typename Family::sketch_type;
+    using params_type = typename Family::params_type;
+    using result_type = typename Family::result_type;
+
+    vector_of_sketches(const params_type& params, uint32_t d, unsigned num_threads):
+    params_(params),
+    num_threads_(num_threads),
+    sketches_()
+    {
+      if (d < 1) {
+        throw std::invalid_argument("D must be >= 1: " + std::to_string(d));
+      }
+      sketches_.reserve(d);
+      for (uint32_t i = 0; i < d; ++i) sketches_.push_back(Family::make(params));
+    }
+
+    uint32_t get_d() const { return static_cast<uint32_t>(sketches_.size()); }
+    const params_type& get_params() const { return params_; }
+    unsigned get_num_threads() const { return num_threads_; }
+    void set_num_threads(unsigned num_threads) { num_threads_ = num_threads; }
+
+    const sketch_type& get_sketch(uint32_t idx) const {
+      check_index(idx);
+      return sketches_[idx];
+    }
+
+    std::vector<uint32_t> get_indices(const sketch_indices& isk) const {
+      std::vector<uint32_t> indices;
+      if (std::holds_alternative<int>(isk)) {
+        const int idx = std::get<int>(isk);
+        if (idx == -1) {
+          indices.resize(get_d());
+          for (uint32_t i = 0; i < get_d(); ++i) indices[i] = i;
+          return indices;
+        }
+        indices.push_back(checked_index(idx));
+      } else {
+        for (int idx: std::get<std::vector<int>>(isk)) indices.push_back(checked_index(idx));
+      }
+      return indices;
+    }
+
+    // Updates every sketch from a 1D array of d values or a 2D array of shape (n, d).
+    // NaN values are skipped, so missing values may be marked with np.nan.
+    // Each sketch receives its values in row order, whatever the memory layout.
+    template<typename V>
+    void update(nb::ndarray<V>& items) {
+      const size_t ndim = items.ndim();
+      if (ndim == 0 || ndim > 2) {
+        throw std::invalid_argument("Update input must be 1 or 2 dimensions : " + std::to_string(ndim));
+      }
+      if (items.shape(ndim - 1) != get_d()) {
+        throw std::invalid_argument("input data must have rows with " + std::to_string(get_d())
+          + " elements. Found: " + std::to_string(items.shape(ndim - 1)));
+      }
+
+      nb::gil_scoped_release release;
+      if (ndim == 1) {
+        auto data = items.template view<V, nb::ndim<1>>();
+        for (uint32_t j = 0; j < get_d(); ++j) update_one(sketches_[j], data(j));
+        return;
+      }
+
+      // as in vector_of_kll_sketches: each thread owns a range of columns, and row-major
+      // input is processed in cache-sized blocks of rows
+      auto data = items.template view<V, nb::ndim<2>>();
+      const size_t num_rows = data.shape(0);
+      const bool column_major = items.stride(0) < items.stride(1);
+      parallel_for_chunks(get_d(), num_threads_, [&](size_t first, size_t last) {
+        const size_t block_rows = column_major ? num_rows : std::max<size_t>(16,
+          vector_of_sketches_constants::UPDATE_BLOCK_BYTES / ((last - first) * sizeof(V)));
+        for (size_t row = 0; row < num_rows; row += block_rows) {
+          const size_t row_end = std::min(num_rows, row + block_rows);
+          for (size_t j = first; j < last; ++j) {
+            for (size_t i = row; i < row_end; ++i) update_one(sketches_[j], data(i, j));
+          }
+        }
+      });
+    }
+
+    void merge(const vector_of_sketches& other) {
+      if (get_d() != other.get_d()) {
+        throw std::invalid_argument("Must have same number of dimensions to merge: " + std::to_string(get_d())
+                                    + " vs " + std::to_string(other.get_d()));
+      }
+      parallel_for(get_d(), num_threads_, [&](size_t i) {
+        Family::merge(sketches_[i], other.sketches_[i], params_);
+      });
+    }
+
+    result_type collapse(const std::vector<uint32_t>& indices) const {
+      std::vector<const sketch_type*> sketches;
+      sketches.reserve(indices.size());
+      for (uint32_t idx: indices) sketches.push_back(&sketches_[idx]);
+      return Family::collapse(params_, sketches);
+    }
+
+    // evaluates f(sketch) for each of the given sketches into a NumPy array, without the GIL
+    template<typename R, typename F>
+    numpy_array<R> query(const std::vector<uint32_t>& indices, F&& f) const {
+      auto result = make_numpy_array<R>(indices.size());
+      R* out = result.data();
+      const unsigned num_threads = get_query_threads(indices);
+      nb::gil_scoped_release release;
+      parallel_for(indices.size(), num_threads, [&](size_t i) { out[i] = f(sketches_[indices[i]]); });
+      return result;
+    }
+
+    // evaluates f(sketch, out) for each of the given sketches, where out is a row of
+    // num_cols values of a 2D NumPy array, without the GIL
+    template<typename R, typename F>
+    numpy_array_2d<R> query_rows(const std::vector<uint32_t>& indices, size_t num_cols, F&& f) const {
+      auto result = make_numpy_array<R>(indices.size(), num_cols);
+      R* out = result.data();
+      const unsigned num_threads = get_query_threads(indices);
+      nb::gil_scoped_release release;
+      parallel_for(indices.size(), num_threads, [&](size_t i) { f(sketches_[indices[i]], out + i * num_cols); });
+      return result;
+    }
+
+    size_t get_memory_usage() const {
+      size_t bytes = sizeof(*this) + (sketches_.capacity() - sketches_.size()) * sizeof(sketch_type);
+      for (const sketch_type& sk: sketches_) bytes += sketch_memory_usage(sk);
+      return bytes;
+    }
+
+    std::string to_string() const {
+      std::ostringstream ss;
+      for (uint32_t i = 0; i < get_d(); ++i) {
+        if (i > 0) ss << "\n";
+        ss << Family::to_string(sketches_[i], params_);
+      }
+      return ss.str();
+    }
+
+    nb::bytes serialize_batch(const std::vector<uint32_t>& indices) const {
+      using image_type = decltype(Family::serialize(std::declval<const sketch_type&>(), params_));
+      std::vector<image_type> images(indices.size());
+      {
+        nb::gil_scoped_release release;
+        parallel_for(indices.size(), num_threads_, [&](size_t i) {
+          images[i] = Family::serialize(sketches_[indices[i]], params_);
+        });
+      }
+      return make_batch(images);
+    }
+
+    void deserialize_batch(nb::handle bytes, const std::vector<uint32_t>& indices) {
+      py_byte_range range(bytes);
+      batch_reader reader(range.data(), range.size());
+      if (reader.num_images() != indices.size()) {
+        throw std::invalid_argument("batch holds " + std::to_string(reader.num_images()) + " sketches but "
+          + std::to_string(indices.size()) + " indices were requested");
+      }
+
+      nb::gil_scoped_release release;
+      // deserialize everything before replacing anything, so a bad image leaves the vector unchanged
+      std::vector<std::optional<sketch_type>> sketches(reader.num_images());
+      parallel_for(sketches.size(), num_threads_, [&](size_t i) {
+        sketches[i].emplace(Family::deserialize(reader.image(i), reader.image_size(i), params_));
+      });
+      for (size_t i = 0; i < sketches.size(); ++i) sketches_[indices[i]] = std::move(*sketches[i]);
+    }
+
+  private:
+    params_type params_;
+    unsigned num_threads_;
+    std::vector<sketch_type> sketches_;
+
+    template<typename V>
+    static void update_one(sketch_type& sk, V value) {
+      if constexpr (std::is_floating_point<V>::value) {
+        if (std::isnan(value)) return;
+      }
+      Family::update(sk, value);
+    }
+
+    void check_index(uint32_t idx) const {
+      if (idx >= get_d()) {
+        throw std::invalid_argument("request for invalid dimensions >= d ("
+                 + std::to_string(get_d()) +"): "+ std::to_string(idx));
+      }
+    }
+
+    uint32_t checked_index(int idx) const {
+      if (idx < 0) throw std::invalid_argument("sketch indices must be non-negative: " + std::to_string(idx));
+      check_index(static_cast<uint32_t>(idx));
+      return static_cast<uint32_t>(idx);
+    }
+
+    // sketches may update internal state on queries, so repeated indices are processed serially
+    unsigned get_query_threads(const std::vector<uint32_t>& indices) const {
+      if (num_threads_ == 1) return 1;
+      std::vector<bool> seen(get_d(), false);
+      for (uint32_t idx: indices) {
+        if (seen[idx]) return 1;
+        seen[idx] = true;
+      }
+      return num_threads_;
+    }
+};
+
+/**
+ * @brief Binds the members shared by every vector_of_sketches family.
+ * The caller adds the constructor, update overloads and queries.
+ */
+template<typename Family>
+nb::class_<vector_of_sketches<Family>> bind_vector_of_sketches(nb::module_& m, const char* name, const char* doc) {
+  using VS = vector_of_sketches<Family>;
+  auto clazz = nb::class_<VS>(m, name, doc);
+  clazz
+    .def("__copy__", [](const VS& vs) { return VS(vs); })
+    .def_prop_ro("d", &VS::get_d,
+         "The number of sketches")
+    .def_prop_rw("num_threads", &VS::get_num_threads, &VS::set_num_threads,
+         "The number of native threads used for updates, merges, queries and serialization, "
+         "0 meaning one per hardware thread")
+    .def("__str__", &VS::to_string, release_gil(),
+         "Produces a string summary of all sketches. Users should split the returned string by '\\n\\n'")
+    .def("to_string", &VS::to_string, release_gil(),
+         "Produces a string summary of all sketches. Users should split the returned string by '\\n\\n'")
+    .def("get_memory_usage", &VS::get_memory_usage, release_gil(),
+         "Returns the approximate number of bytes held by the vector and its sketches")
+    .def("merge", &VS::merge, nb::arg("other"), release_gil(),
+         "Merges each sketch of the given vector, which must have the same number of sketches, into the corresponding sketch of this one")
+    .def("collapse",
+         [](const VS& vs, const sketch_indices& isk) {
+           auto indices = vs.get_indices(isk);
+           return call_without_gil([&] { return vs.collapse(indices); });
+         }, nb::arg("isk")=-1,
+         "Returns the result of merging the specified sketches into a single sketch. "
+         "`isk` can be an int or a list of ints (default: all sketches)")
+    .def("serialize_batch",
+         [](const VS& vs, const sketch_indices& isk) { return vs.serialize_batch(vs.get_indices(isk)); },
+         nb::arg("isk")=-1,
+         "Serializes the specified sketch(es) into a single bytes object holding a header, an offset table "
+         "and the concatenated images. `isk` can be an int or a list of ints (default: all sketches)")
+    .def("deserialize_batch",
+         [](VS& vs, nb::handle bytes, const sketch_indices& isk) { vs.deserialize_batch(bytes, vs.get_indices(isk)); },
+         nb::arg("bytes"), nb::arg("isk")=-1,
+         "Replaces the specified sketch(es) with those read from a batch written by serialize_batch(), in order. "
+         "`isk` can be an int or a list of ints (default: all sketches) and must match the number of sketches in the batch");
+  return clazz;
+}
+
+/**
+ * @brief Adds an update method taking a 1D or 2D NumPy array of values of type V.
+ */
+template<typename V, typename Family>
+void add_vector_of_sketches_update(nb::class_<vector_of_sketches<Family>>& clazz, const char* doc) {
+  using VS = vector_of_sketches<Family>;
+  clazz.def("update",
+    [](VS& vs, nb::ndarray<V> items, const std::string& order) {
+      unused(order);
+      vs.update(items);
+    },
+    nb::arg("items"), nb::arg("order")="C", doc);
+}
+
+} // namespace datasketches
+
+#endif // _VECTOR_OF_SKETCHES_HPP_
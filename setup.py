@@ -52,6 +52,9 @@ class CMakeBuild(build_ext):
         # ensure we use a consistent python version
         #cmake_args += ['-DPython3_EXECUTABLE=' + sys.executable]
         cmake_args += ['-DPython_EXECUTABLE=' + sys.executable]
+        # opt-in hot-path counters, see get_stats()
+        if os.environ.get('DATASKETCHES_STATS', '') not in ('', '0'):
+            cmake_args += ['-DDATASKETCHES_STATS=ON']
         cfg = 'Debug' if self.debug else 'Release'
         build_args = ['--config', cfg]
 
@@ -0,0 +1,51 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+
+#include "py_buffer.hpp"
+#include "batch_serde.hpp"
+
+namespace nb = nanobind;
+
+void init_batch(nb::module_& m) {
+  using namespace datasketches;
+
+  m.def("get_batch_offsets",
+    [](nb::handle bytes) {
+      py_byte_range range(bytes);
+      batch_reader reader(range.data(), range.size());
+      const size_t num_offsets = reader.num_images() + 1;
+      uint64_t* offsets = new uint64_t[num_offsets];
+      for (size_t i = 0; i < num_offsets; ++i) offsets[i] = reader.offset(i);
+      nb::capsule owner(offsets, [](void *p) noexcept {
+        delete[] static_cast<uint64_t*>(p);
+      });
+      return nb::ndarray<uint64_t, nb::numpy, nb::ndim<1>>(offsets, {num_offsets}, owner);
+    },
+    nb::arg("bytes"),
+    "Returns the offset table of a sketch batch written by serialize_batch() as a NumPy array of N+1 "
+    "offsets from the start of the batch, where image i occupies [offsets[i], offsets[i+1]). "
+    "The number of sketches in the batch is len(offsets) - 1, and any single image can be read "
+    "with the deserialize() offset and length arguments.\n\n"
+    ":param bytes: A bytes object or any other contiguous buffer holding the batch\n:type bytes: buffer\n"
+    ":return: The image offsets\n:rtype: numpy.ndarray"
+  );
+}
@@ -17,19 +17,150 @@
  * under the License.
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 
 #include "count_min.hpp"
 #include "common_defs.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "numpy_array.hpp"
+#include "arrow_array.hpp"
+#include "pickle_support.hpp"
 
 namespace nb = nanobind;
 
+namespace {
+
+/*
+  Each update of a count-min sketch hashes the key once per row and adds to
+  a counter in every row, which are num_buckets apart in memory. Keys in an
+  array are summed per distinct key first, in blocks small enough for the
+  table to stay in cache, so a key repeated within a block costs one probe
+  instead of num_hashes scattered counter updates. The total weight adds
+  the magnitude of every update, so summing changes it when weights of
+  both signs meet: blocks holding a negative weight are applied one
+  element at a time, exactly as the scalar update would.
+*/
+template<typename W>
+class key_weight_aggregator {
+  public:
+    static constexpr size_t BLOCK_SIZE = 1 << 14;
+
+    key_weight_aggregator(): slots_(2 * BLOCK_SIZE, EMPTY) {
+      entries_.reserve(BLOCK_SIZE);
+    }
+
+    void add(int64_t key, W weight) {
+      size_t slot = hash(key) & (slots_.size() - 1);
+      for (; slots_[slot] != EMPTY; slot = (slot + 1) & (slots_.size() - 1)) {
+        if (entries_[slots_[slot]].first == key) {
+          entries_[slots_[slot]].second += weight;
+          return;
+        }
+      }
+      slots_[slot] = static_cast<uint32_t>(entries_.size());
+      entries_.emplace_back(key, weight);
+    }
+
+    // applies the sums to the sketch in order of first appearance and clears the table
+    template<typename SK>
+    void flush(SK& sk) {
+      for (const auto& entry: entries_) sk.update(entry.first, entry.second);
+      entries_.clear();
+      std::fill(slots_.begin(), slots_.end(), EMPTY);
+    }
+
+  private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    std::vector<uint32_t> slots_;
+    std::vector<std::pair<int64_t, W>> entries_;
+
+    static size_t hash(int64_t key) {
+      uint64_t x = static_cast<uint64_t>(key);
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdULL;
+      x ^= x >> 33;
+      return static_cast<size_t>(x);
+    }
+};
+
+template<typename W>
+void update_from_ndarray(datasketches::count_min_sketch<W>& sk, nb::ndarray<int64_t>& keys,
+                         std::optional<nb::ndarray<W>>& weights) {
+  auto k = datasketches::view_1d(keys);
+  std::optional<decltype(datasketches::view_1d(*weights))> w;
+  if (weights) {
+    w.emplace(datasketches::view_1d(*weights));
+    if (w->shape(0) != k.shape(0)) {
+      throw std::invalid_argument("keys and weights must have the same length: " + std::to_string(k.shape(0))
+        + " vs " + std::to_string(w->shape(0)));
+    }
+  }
+  nb::gil_scoped_release release;
+  key_weight_aggregator<W> aggregator;
+  for (size_t begin = 0; begin < k.shape(0); begin += key_weight_aggregator<W>::BLOCK_SIZE) {
+    const size_t end = std::min(begin + key_weight_aggregator<W>::BLOCK_SIZE, k.shape(0));
+    bool has_negative = false;
+    for (size_t i = begin; w && i < end && !has_negative; ++i) has_negative = (*w)(i) < W(0);
+    if (has_negative) {
+      for (size_t i = begin; i < end; ++i) sk.update(k(i), (*w)(i));
+      continue;
+    }
+    for (size_t i = begin; i < end; ++i) aggregator.add(k(i), w ? (*w)(i) : W(1));
+    aggregator.flush(sk);
+  }
+}
+
+// integer keys are summed per block as in update_from_ndarray(), binary keys go to the sketch directly
+template<typename W>
+void update_from_arrow(datasketches::count_min_sketch<W>& sk, nb::handle array) {
+  using namespace datasketches;
+  for_each_arrow_chunk(array, [&sk](const ArrowSchema& schema, const ArrowArray& chunk) {
+    const arrow_type type = get_arrow_type(schema);
+    if (type.kind == arrow_kind::FLOATING) {
+      throw std::invalid_argument("count-min keys must be integers or strings, not floating point values");
+    }
+    nb::gil_scoped_release release;
+    key_weight_aggregator<W> aggregator;
+    size_t num_pending = 0;
+    for_each_arrow_value(type, chunk, 0, [&](auto key) {
+      using key_type = decltype(key);
+      if constexpr (std::is_same<key_type, arrow_binary>::value) {
+        if (key.size > 0) sk.update(key.data, key.size, W(1));
+      } else if constexpr (std::is_integral<key_type>::value) {
+        // unsigned keys hash as the same 8 bytes when reinterpreted as int64
+        aggregator.add(static_cast<int64_t>(key), W(1));
+        if (++num_pending == key_weight_aggregator<W>::BLOCK_SIZE) {
+          aggregator.flush(sk);
+          num_pending = 0;
+        }
+      }
+    });
+    aggregator.flush(sk);
+  });
+}
+
+} // namespace
+
 template<typename W>
 void bind_count_min_sketch(nb::module_ &m, const char* name) {
   using namespace datasketches;
 
-  nb::class_<count_min_sketch<W>>(m, name)
+  auto clazz = nb::class_<count_min_sketch<W>>(m, name)
     .def(nb::init<uint8_t, uint32_t, uint64_t>(), nb::arg("num_hashes"), nb::arg("num_buckets"), nb::arg("seed")=DEFAULT_SEED,
          "Creates an instance of a CountMin sketch\n\n"
          ":param num_hashes: Number of rows in the sketch\n:type num_hashes: int\n"
@@ -66,6 +197,68 @@ void bind_count_min_sketch(nb::module_ &m, const char* name) {
          "Returns the maximum permissible error for any frequency estimate query")
     .def_prop_ro("total_weight", &count_min_sketch<W>::get_total_weight,
          "The total weight currently inserted into the stream")
+    // the NumPy overloads must come before the scalar ones
+    .def("update",
+         [](count_min_sketch<W>& sk, nb::ndarray<int64_t> keys, std::optional<nb::ndarray<W>> weights) {
+           update_from_ndarray(sk, keys, weights);
+         },
+         nb::arg("keys"), nb::arg("weights")=nb::none(),
+         "Updates the sketch with a NumPy array of 64-bit integer keys and an array of the same length of their "
+         "weights, or a weight of 1 for every key if weights is omitted")
+    .def("update_strings",
+         [](count_min_sketch<W>& sk, nb::handle keys, std::optional<nb::ndarray<W>> weights) {
+           py_buffer buf(keys);
+           std::optional<decltype(view_1d(*weights))> w;
+           if (weights) {
+             w.emplace(view_1d(*weights));
+             if (w->shape(0) != buf.length()) {
+               throw std::invalid_argument("keys and weights must have the same length: " + std::to_string(buf.length())
+                 + " vs " + std::to_string(w->shape(0)));
+             }
+           }
+           nb::gil_scoped_release release;
+           size_t i = 0;
+           for_each_fixed_width_string(buf, [&](const char* data, size_t length) {
+             // empty strings are ignored, as with the scalar update
+             if (length > 0) sk.update(data, length, w ? (*w)(i) : W(1));
+             ++i;
+           });
+         },
+         nb::arg("keys"), nb::arg("weights")=nb::none(),
+         "Updates the sketch with every item of a NumPy fixed-width bytes ('S') or unicode ('U') array and an array "
+         "of the same length of their weights, or a weight of 1 for every item if weights is omitted. "
+         "Unicode items are hashed as UTF-8, matching updates with each str. Empty items are ignored.")
+    .def("update_arrow", &update_from_arrow<W>, nb::arg("keys"),
+         "Updates the sketch with a weight of 1 for every non-null key of an Arrow integer, utf8 or binary array, "
+         "read in place through the Arrow C Data Interface. Chunked arrays are read chunk by chunk. "
+         "Keys hash as with the scalar updates, integers of any width as int. Empty items are ignored.\n\n"
+         ":param keys: Any object implementing __arrow_c_array__ or __arrow_c_stream__, such as a pyarrow Array "
+         "or ChunkedArray\n:type keys: Arrow array")
+    .def("get_estimates",
+         [](const count_min_sketch<W>& sk, nb::ndarray<int64_t> keys) {
+           auto k = view_1d(keys);
+           auto result = make_numpy_array<W>(k.shape(0));
+           W* out = result.data();
+           nb::gil_scoped_release release;
+           for (size_t i = 0; i < k.shape(0); ++i) out[i] = sk.get_estimate(k(i));
+           return result;
+         },
+         nb::arg("keys"),
+         "Returns a NumPy array of the estimated frequency of each of the given 64-bit integer keys")
+    .def("get_estimates_strings",
+         [](const count_min_sketch<W>& sk, nb::handle keys) {
+           py_buffer buf(keys);
+           auto result = make_numpy_array<W>(buf.ndim() == 1 ? buf.length() : 0);
+           W* out = result.data();
+           nb::gil_scoped_release release;
+           for_each_fixed_width_string(buf, [&sk, &out](const char* data, size_t length) {
+             *out++ = length > 0 ? sk.get_estimate(data, length) : W(0);
+           });
+           return result;
+         },
+         nb::arg("keys"),
+         "Returns a NumPy array of the estimated frequency of each item of a NumPy fixed-width bytes ('S') or "
+         "unicode ('U') array, which is 0 for empty items")
     .def("update", static_cast<void (count_min_sketch<W>::*)(int64_t, W)>(&count_min_sketch<W>::update), nb::arg("item"), nb::arg("weight")=1.0,
          "Updates the sketch with the given 64-bit integer value")
     .def("update", static_cast<void (count_min_sketch<W>::*)(const std::string&, W)>(&count_min_sketch<W>::update), nb::arg("item"), nb::arg("weight")=1.0,
@@ -82,24 +275,41 @@ void bind_count_min_sketch(nb::module_ &m, const char* name) {
          "Returns a lower bound on the estimate for the given 64-bit integer value")
     .def("get_lower_bound", static_cast<W (count_min_sketch<W>::*)(const std::string&) const>(&count_min_sketch<W>::get_lower_bound), nb::arg("item"),
          "Returns a lower bound on the estimate for the provided string")
-    .def("merge", &count_min_sketch<W>::merge, nb::arg("other"),
+    .def("merge", &count_min_sketch<W>::merge, nb::arg("other"), release_gil(),
          "Merges the provided other sketch into this one")
     .def("get_serialized_size_bytes", &count_min_sketch<W>::get_serialized_size_bytes,
          "Returns the size in bytes of the serialized image of the sketch")
     .def(
         "serialize",
         [](const count_min_sketch<W>& sk) {
-          auto bytes = sk.serialize();
+          auto bytes = call_without_gil([&sk] { return sk.serialize(); });
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         },
         "Serializes the sketch into a bytes object"
     )
+    .def(
+        "serialize_into",
+        [](const count_min_sketch<W>& sk, nb::handle buffer, size_t offset) {
+          return serialize_into_buffer(buffer, offset, [&](std::ostream& os) { sk.serialize(os); });
+        },
+        nb::arg("buffer"), nb::arg("offset")=0,
+        "Serializes the sketch into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes) { return count_min_sketch<W>::deserialize(bytes.c_str(), bytes.size()); },
-        nb::arg("bytes"),
-        "Reads a bytes object and returns the corresponding count_min_sketch"
+        [](nb::handle bytes, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return call_without_gil([&range] { return count_min_sketch<W>::deserialize(range.data(), range.size()); });
+        },
+        nb::arg("bytes"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding count_min_sketch"
     );
+
+  add_pickle_support(clazz,
+    [](const count_min_sketch<W>& sk) { return sk.serialize(); },
+    [](const char* data, size_t size) { return count_min_sketch<W>::deserialize(data, size); });
 }
 
 void init_count_min(nb::module_ &m) {
@@ -18,19 +18,26 @@
  */
 
 #include <nanobind/nanobind.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 
 #include "cpc_sketch.hpp"
 #include "cpc_union.hpp"
 #include "cpc_common.hpp"
 #include "common_defs.hpp"
+#include "hash_update.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "batch_serde.hpp"
+#include "pickle_support.hpp"
 
 namespace nb = nanobind;
 
 void init_cpc(nb::module_ &m) {
   using namespace datasketches;
 
-  nb::class_<cpc_sketch>(m, "cpc_sketch")
+  auto cpc_class = nb::class_<cpc_sketch>(m, "cpc_sketch")
     .def(nb::init<uint8_t, uint64_t>(), nb::arg("lg_k")=cpc_constants::DEFAULT_LG_K, nb::arg("seed")=DEFAULT_SEED,
          "Creates a new CPC sketch\n\n"
          ":param lg_k: base 2 logarithm of the number of bins in the sketch\n"
@@ -41,19 +48,19 @@ void init_cpc(nb::module_ &m) {
     .def("__copy__", [](const cpc_sketch& sk){ return cpc_sketch(sk); })
     .def("__str__", [](const cpc_sketch& sk) { return sk.to_string(); },
          "Produces a string summary of the sketch")
-    .def("to_string", &cpc_sketch::to_string,
+    .def("to_string", &cpc_sketch::to_string, release_gil(),
          "Produces a string summary of the sketch")
-    .def<void (cpc_sketch::*)(uint64_t)>("update", &cpc_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (cpc_sketch::*)(uint64_t)>(&cpc_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given 64-bit integer value")
-    .def<void (cpc_sketch::*)(double)>("update", &cpc_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (cpc_sketch::*)(double)>(&cpc_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given 64-bit floating point")
-    .def<void (cpc_sketch::*)(const std::string&)>("update", &cpc_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (cpc_sketch::*)(const std::string&)>(&cpc_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given string")
     .def_prop_ro("lg_k", &cpc_sketch::get_lg_k,
          "Configured lg_k of this sketch")
     .def("is_empty", &cpc_sketch::is_empty,
          "Returns True if the sketch is empty, otherwise False")
-    .def("get_estimate", &cpc_sketch::get_estimate,
+    .def("get_estimate", &cpc_sketch::get_estimate, release_gil(),
          "Estimate of the distinct count of the input stream")
     .def("get_lower_bound", &cpc_sketch::get_lower_bound, nb::arg("kappa"),
          "Returns an approximate lower bound on the estimate for kappa values in {1, 2, 3}, roughly corresponding to standard deviations")
@@ -62,23 +69,48 @@ void init_cpc(nb::module_ &m) {
     .def(
         "serialize",
         [](const cpc_sketch& sk) {
-          auto bytes = sk.serialize();
+          auto bytes = call_without_gil([&sk] { return sk.serialize(); });
+          count_serialized(sk, bytes.size());
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         },
         "Serializes the sketch into a bytes object"
     )
+    .def(
+        "serialize_into",
+        [](const cpc_sketch& sk, nb::handle buffer, size_t offset) {
+          const size_t written = serialize_into_buffer(buffer, offset, [&](std::ostream& os) { sk.serialize(os); });
+          count_serialized(sk, written);
+          return written;
+        },
+        nb::arg("buffer"), nb::arg("offset")=0,
+        "Serializes the sketch into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes) { return cpc_sketch::deserialize(bytes.c_str(), bytes.size()); },
-        nb::arg("bytes"),
-        "Reads a bytes object and returns the corresponding cpc_sketch"
+        [](nb::handle bytes, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return call_without_gil([&range] { return cpc_sketch::deserialize(range.data(), range.size()); });
+        },
+        nb::arg("bytes"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding cpc_sketch"
     );
 
+  add_batch_serialization(cpc_class,
+    [](const cpc_sketch& sk) { return sk.serialize(); },
+    [](const char* data, size_t size) { return cpc_sketch::deserialize(data, size); });
+  add_pickle_support(cpc_class,
+    [](const cpc_sketch& sk) { return sk.serialize(); },
+    [](const char* data, size_t size) { return cpc_sketch::deserialize(data, size); });
+  add_hash_vector_update(cpc_class);
+  add_stats(cpc_class);
+
   nb::class_<cpc_union>(m, "cpc_union")
     .def(nb::init<uint8_t, uint64_t>(), nb::arg("lg_k"), nb::arg("seed")=DEFAULT_SEED)
-    .def("update", (void (cpc_union::*)(const cpc_sketch&)) &cpc_union::update, nb::arg("sketch"),
+    .def("update", (void (cpc_union::*)(const cpc_sketch&)) &cpc_union::update, nb::arg("sketch"), release_gil(),
          "Updates the union with the provided CPC sketch")
-    .def("get_result", &cpc_union::get_result,
+    .def("get_result", &cpc_union::get_result, release_gil(),
          "Returns a CPC sketch with the result of the union")
     ;
 }
@@ -17,8 +17,17 @@
  * under the License.
  */
 
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <nanobind/nanobind.h>
 #include <nanobind/intrusive/counter.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/vector.h>
 
 // needed for sketches such as Density and Tuple which rely
 // on a joint C++/Python object
@@ -33,6 +42,7 @@ void init_fi(nb::module_& m);
 void init_cpc(nb::module_& m);
 void init_theta(nb::module_& m);
 void init_tuple(nb::module_& m);
+void init_native_tuple(nb::module_& m);
 void init_vo(nb::module_& m);
 void init_ebpps(nb::module_& m);
 void init_req(nb::module_& m);
@@ -41,10 +51,161 @@ void init_count_min(nb::module_& m);
 void init_density(nb::module_& m);
 void init_tdigest(nb::module_& m);
 void init_vector_of_kll(nb::module_& m);
+void init_vector_of_sketches(nb::module_& m);
+void init_sketch_map(nb::module_& m);
+void init_sketch_ring(nb::module_& m);
+void init_memory(nb::module_& m);
 
 // supporting objects
 void init_kolmogorov_smirnov(nb::module_& m);
 void init_serde(nb::module_& m);
+void init_merge(nb::module_& m);
+void init_batch(nb::module_& m);
+void init_stats(nb::module_& m);
+
+namespace {
+
+/*
+  Most families are registered lazily: creating their types and methods
+  is the bulk of the import time, and a short-lived process rarely uses
+  more than a few of them. Each family lists the module attributes its
+  init function defines, and the module __getattr__ registers a family
+  on first access to one of them, after the families whose types it
+  needs when it is bound (base classes and enum defaults) or returns.
+  Binding can call into Python, which may switch threads, so the GIL
+  alone does not serialize registration: a mutex does, taken without
+  the GIL so that the thread registering can still run.
+*/
+enum class family_state { UNREGISTERED, IN_PROGRESS, REGISTERED, FAILED };
+
+struct lazy_family {
+  const char* name;
+  void (*init)(nb::module_&);
+  std::vector<const char*> depends;
+  std::vector<const char*> attributes;
+  family_state state;
+};
+
+std::vector<lazy_family>& lazy_families() {
+  static std::vector<lazy_family> families = {
+    {"hll", init_hll, {},
+      {"tgt_hll_type", "HLL_4", "HLL_6", "HLL_8", "hll_sketch", "atomic_hll_sketch", "hll_union"}, family_state::UNREGISTERED},
+    {"kll", init_kll, {},
+      {"kll_ints_sketch", "kll_ints_sorted_view", "kll_floats_sketch", "kll_floats_sorted_view",
+       "kll_doubles_sketch", "kll_doubles_sorted_view", "kll_items_sketch", "kll_items_sorted_view"}, family_state::UNREGISTERED},
+    {"fi", init_fi, {},
+      {"frequent_items_error_type", "NO_FALSE_POSITIVES", "NO_FALSE_NEGATIVES", "frequent_strings_sketch",
+       "frequent_items_sketch", "frequent_ints_sketch", "frequent_bytes_sketch"}, family_state::UNREGISTERED},
+    {"cpc", init_cpc, {}, {"cpc_sketch", "cpc_union"}, family_state::UNREGISTERED},
+    {"theta", init_theta, {},
+      {"theta_sketch", "update_theta_sketch", "concurrent_theta_sketch", "compact_theta_sketch",
+       "wrapped_compact_theta_sketch", "theta_union", "theta_intersection", "theta_a_not_b",
+       "theta_jaccard_similarity"}, family_state::UNREGISTERED},
+    {"tuple", init_tuple, {},
+      {"TuplePolicy", "tuple_sketch", "compact_tuple_sketch", "update_tuple_sketch", "tuple_union",
+       "tuple_intersection", "tuple_a_not_b", "tuple_jaccard_similarity"}, family_state::UNREGISTERED},
+    {"native_tuple", init_native_tuple, {},
+      {"tuple_sketch_double", "compact_tuple_sketch_double", "tuple_a_not_b_double",
+       "update_tuple_sketch_double_sum", "tuple_union_double_sum", "tuple_intersection_double_sum",
+       "update_tuple_sketch_double_min", "tuple_union_double_min", "tuple_intersection_double_min",
+       "update_tuple_sketch_double_max", "tuple_union_double_max", "tuple_intersection_double_max",
+       "tuple_sketch_array_of_doubles", "compact_tuple_sketch_array_of_doubles", "tuple_a_not_b_array_of_doubles",
+       "update_tuple_sketch_array_of_doubles", "tuple_union_array_of_doubles",
+       "tuple_intersection_array_of_doubles"}, family_state::UNREGISTERED},
+    {"vo", init_vo, {},
+      {"var_opt_sketch", "var_opt_union", "var_opt_ints_sketch", "var_opt_ints_union", "var_opt_doubles_sketch",
+       "var_opt_doubles_union"}, family_state::UNREGISTERED},
+    {"ebpps", init_ebpps, {}, {"ebpps_sketch", "ebpps_ints_sketch", "ebpps_doubles_sketch"}, family_state::UNREGISTERED},
+    {"req", init_req, {},
+      {"req_ints_sketch", "req_ints_sorted_view", "req_floats_sketch", "req_floats_sorted_view", "req_items_sketch",
+       "req_items_sorted_view"}, family_state::UNREGISTERED},
+    {"quantiles", init_quantiles, {},
+      {"quantiles_ints_sketch", "quantiles_ints_sorted_view", "quantiles_floats_sketch",
+       "quantiles_floats_sorted_view", "quantiles_doubles_sketch", "quantiles_doubles_sorted_view",
+       "quantiles_items_sketch", "quantiles_items_sorted_view"}, family_state::UNREGISTERED},
+    {"count_min", init_count_min, {}, {"count_min_sketch"}, family_state::UNREGISTERED},
+    {"density", init_density, {},
+      {"KernelFunction", "gaussian_kernel", "laplacian_kernel", "polynomial_kernel", "density_sketch"}, family_state::UNREGISTERED},
+    {"tdigest", init_tdigest, {}, {"tdigest_float", "tdigest_double"}, family_state::UNREGISTERED},
+    {"vector_of_kll", init_vector_of_kll, {"kll"},
+      {"vector_of_kll_ints_sketches", "vector_of_kll_floats_sketches"}, family_state::UNREGISTERED},
+    {"vector_of_sketches", init_vector_of_sketches, {"hll", "theta", "tdigest"},
+      {"vector_of_hll_sketches", "vector_of_theta_sketches", "vector_of_tdigests"}, family_state::UNREGISTERED},
+    {"sketch_map", init_sketch_map, {"hll", "kll"}, {"hll_sketch_map", "kll_sketch_map"}, family_state::UNREGISTERED},
+    {"sketch_ring", init_sketch_ring, {"hll", "theta", "kll", "tdigest"},
+      {"hll_sketch_ring", "theta_sketch_ring", "kll_sketch_ring", "tdigest_sketch_ring"}, family_state::UNREGISTERED},
+    {"serde", init_serde, {},
+      {"PyObjectSerDe", "IntsSerDe", "LongsSerDe", "FloatsSerDe", "DoublesSerDe", "StringsSerDe", "BytesSerDe"}, family_state::UNREGISTERED},
+    {"merge", init_merge, {"hll", "theta", "cpc", "kll", "tdigest"},
+      {"merge_hll", "merge_theta", "merge_cpc", "merge_kll_ints", "merge_kll_floats", "merge_kll_doubles",
+       "merge_tdigest_float", "merge_tdigest_double"}, family_state::UNREGISTERED}
+  };
+  return families;
+}
+
+// borrowed, since the module outlives every call into it
+PyObject* module_ptr = nullptr;
+
+nb::dict module_dict() {
+  return nb::borrow<nb::dict>(PyModule_GetDict(module_ptr));
+}
+
+lazy_family& find_family(const std::string& name) {
+  for (lazy_family& family: lazy_families()) {
+    if (name == family.name) return family;
+  }
+  throw std::invalid_argument("unknown family: " + name);
+}
+
+lazy_family* find_family_of(const std::string& attribute) {
+  for (lazy_family& family: lazy_families()) {
+    for (const char* name: family.attributes) {
+      if (attribute == name) return &family;
+    }
+  }
+  return nullptr;
+}
+
+// recursive, as a family registers its dependencies while holding it
+std::recursive_mutex& registration_mutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+void register_family(lazy_family& family) {
+  if (family.state == family_state::REGISTERED) return;
+  std::unique_lock<std::recursive_mutex> lock(registration_mutex(), std::defer_lock);
+  {
+    nb::gil_scoped_release release;
+    lock.lock();
+  }
+  // another thread may have finished it while this one waited, and IN_PROGRESS
+  // here means this thread is registering it already, further up the stack
+  if (family.state == family_state::REGISTERED || family.state == family_state::IN_PROGRESS) return;
+  // a family whose init failed part way cannot define its types again
+  if (family.state == family_state::FAILED) {
+    throw std::runtime_error("family " + std::string(family.name) + " failed to register");
+  }
+  family.state = family_state::IN_PROGRESS;
+  try {
+    for (const char* dependency: family.depends) register_family(find_family(dependency));
+    nb::module_ m = nb::borrow<nb::module_>(module_ptr);
+    family.init(m);
+    // a declared name the family does not define would be published by __dir__ but fail on access
+    nb::dict attributes = module_dict();
+    for (const char* name: family.attributes) {
+      if (!attributes.contains(name)) {
+        throw std::runtime_error("family " + std::string(family.name) + " declares " + name + " but did not define it");
+      }
+    }
+  } catch (...) {
+    family.state = family_state::FAILED;
+    throw;
+  }
+  family.state = family_state::REGISTERED;
+}
+
+} // namespace
 
 NB_MODULE(_datasketches, m) {
   // needed in conjunction with the counter.inl include above
@@ -58,22 +219,70 @@ NB_MODULE(_datasketches, m) {
         Py_DECREF(o);
     }
   );
+  module_ptr = m.ptr();
 
-  init_hll(m);
-  init_kll(m);
-  init_fi(m);
-  init_cpc(m);
-  init_theta(m);
-  init_tuple(m);
-  init_vo(m);
-  init_ebpps(m);
-  init_req(m);
-  init_quantiles(m);
-  init_count_min(m);
-  init_density(m);
-  init_tdigest(m);
-  init_vector_of_kll(m);
-
+  // cheap enough to register eagerly, and only bound to types at call time
+  init_memory(m);
   init_kolmogorov_smirnov(m);
-  init_serde(m);
+  init_batch(m);
+  init_stats(m);
+
+  m.def("__getattr__",
+    [](const std::string& name) -> nb::object {
+      lazy_family* family = find_family_of(name);
+      if (family == nullptr) {
+        throw nb::attribute_error(("module '_datasketches' has no attribute '" + name + "'").c_str());
+      }
+      register_family(*family);
+      // looked up in the dictionary, since a miss through attr() would call back into __getattr__
+      PyObject* value = PyDict_GetItemString(module_dict().ptr(), name.c_str());
+      if (value == nullptr) {
+        throw nb::attribute_error(("module '_datasketches' has no attribute '" + name + "'").c_str());
+      }
+      return nb::borrow<nb::object>(value);
+    },
+    nb::arg("name")
+  );
+
+  m.def("__dir__",
+    []() {
+      nb::dict attributes = module_dict();
+      nb::list names = attributes.keys();
+      for (const lazy_family& family: lazy_families()) {
+        // the names of a failed family would fail on access
+        if (family.state == family_state::REGISTERED || family.state == family_state::FAILED) continue;
+        for (const char* name: family.attributes) {
+          if (!attributes.contains(name)) names.append(nb::str(name));
+        }
+      }
+      return names;
+    }
+  );
+
+  m.def("get_families",
+    []() {
+      nb::dict result;
+      for (const lazy_family& family: lazy_families()) result[family.name] = family.state == family_state::REGISTERED;
+      return result;
+    },
+    "Returns a dict mapping the name of each lazily registered family to whether its classes and functions "
+    "have been registered, which happens on first access to any of them"
+  );
+
+  m.def("register_families",
+    [](const std::optional<std::vector<std::string>>& families) {
+      if (families) {
+        // validated up front so that an unknown name registers nothing
+        for (const std::string& name: *families) find_family(name);
+        for (const std::string& name: *families) register_family(find_family(name));
+      } else {
+        for (lazy_family& family: lazy_families()) register_family(family);
+      }
+    },
+    nb::arg("families")=nb::none(),
+    "Registers the classes and functions of the given families, along with the families they depend on, "
+    "instead of on first access. Useful before timing a hot path, or to fail early in a long-running process.\n\n"
+    ":param families: The names of the families, as returned by get_families(), or None for all of them\n"
+    ":type families: list[str], optional"
+  );
 }
@@ -17,13 +17,20 @@
  * under the License.
  */
 
-#include <vector>
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <nanobind/nanobind.h>
 #include <nanobind/intrusive/counter.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 #include <nanobind/make_iterator.h>
+#include <nanobind/ndarray.h>
 
 #include <nanobind/eval.h>
 
@@ -31,6 +38,11 @@
 
 #include "kernel_function.hpp"
 #include "density_sketch.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "gil_guard.hpp"
+#include "numpy_array.hpp"
+#include "parallel.hpp"
 
 namespace nb = nanobind;
 
@@ -47,13 +59,47 @@ void bind_density_sketch(nb::module_ &m, const char* name) {
         "Creates a new density sketch\n\n"
         ":param k: controls the size and error of the sketch\n:type k: int\n"
         ":param dim: dimension of the input data\n:type dim: int\n"
-        ":param kernel: instance of a kernel\n:type kernel: KernelFunction\n"
+        ":param kernel: instance of a kernel, such as the built-in gaussian_kernel, laplacian_kernel or "
+        "polynomial_kernel evaluated natively, or a KernelFunction implemented in Python\n:type kernel: KernelFunction\n"
         )
     .def("__copy__", [](const density_sketch<T,K>& sk){ return density_sketch<T,K>(sk); })
-    .def("update", static_cast<void (density_sketch<T, K>::*)(const std::vector<T>&)>(&density_sketch<T, K>::update), nb::arg("vector"),
+    // the NumPy overload must come first, or arrays would be converted to std::vector
+    .def(
+        "update",
+        [](density_sketch<T, K>& sk, nb::ndarray<T, nb::c_contig> points) {
+          // a 0-d array has no last dimension to compare
+          if (points.ndim() == 0 || points.ndim() > 2 || points.shape(points.ndim() - 1) != sk.get_dim()) {
+            throw std::invalid_argument("points must be a vector or a 2D array with " + std::to_string(sk.get_dim()) + " columns");
+          }
+          const size_t num_points = points.ndim() == 2 ? points.shape(0) : 1;
+          const T* data = points.data();
+          nb::gil_scoped_release release;
+          // one buffer reused for every row, which the sketch copies into its own storage
+          std::vector<T> point(sk.get_dim());
+          for (size_t i = 0; i < num_points; ++i) {
+            std::copy(data + i * point.size(), data + (i + 1) * point.size(), point.begin());
+            sk.update(point);
+          }
+        },
+        nb::arg("points"),
+        "Updates the sketch with a NumPy vector, or with each row of a 2D array of shape (n, dim). "
+        "Arrays that are not C-contiguous are copied first."
+    )
+    .def("update", static_cast<void (density_sketch<T, K>::*)(const std::vector<T>&)>(&density_sketch<T, K>::update), nb::arg("vector"), release_gil(),
         "Updates the sketch with the given vector")
-    .def("merge", static_cast<void (density_sketch<T, K>::*)(const density_sketch<T, K>&)>(&density_sketch<T, K>::merge), nb::arg("sketch"),
+    .def("merge", static_cast<void (density_sketch<T, K>::*)(const density_sketch<T, K>&)>(&density_sketch<T, K>::merge), nb::arg("sketch"), release_gil(),
         "Merges the provided sketch into this one")
+    .def(
+        "merge",
+        [](density_sketch<T, K>& sk, nb::iterable sketches) {
+          std::vector<const density_sketch<T, K>*> others;
+          for (nb::handle other: sketches) others.push_back(&nb::cast<const density_sketch<T, K>&>(other));
+          nb::gil_scoped_release release;
+          for (const auto* other: others) sk.merge(*other);
+        },
+        nb::arg("sketches"),
+        "Merges each sketch of the given iterable into this one"
+    )
     .def("is_empty", &density_sketch<T, K>::is_empty,
         "Returns True if the sketch is empty, otherwise False")
     .def_prop_ro("k", &density_sketch<T, K>::get_k,
@@ -66,12 +112,53 @@ void bind_density_sketch(nb::module_ &m, const char* name) {
         "The number of retained items (samples) in the sketch")
     .def("is_estimation_mode", &density_sketch<T, K>::is_estimation_mode,
         "Returns True if the sketch is in estimation mode, otherwise False")
-    .def("get_estimate", &density_sketch<T, K>::get_estimate, nb::arg("point"),
+    .def("get_estimate", &density_sketch<T, K>::get_estimate, nb::arg("point"), release_gil(),
         "Returns an approximate density at the given point")
+    .def(
+        "get_estimates",
+        [](const density_sketch<T, K>& sk, nb::ndarray<T> points, unsigned num_threads) {
+          if (points.ndim() != 2 || points.shape(1) != sk.get_dim()) {
+            throw std::invalid_argument("points must be a 2D array with " + std::to_string(sk.get_dim()) + " columns");
+          }
+          auto p = points.template view<T, nb::ndim<2>>();
+          auto result = make_numpy_array<double>(p.shape(0));
+          double* out = result.data();
+          nb::gil_scoped_release release;
+          parallel_for_chunks(p.shape(0), num_threads, [&](size_t begin, size_t end) {
+            std::vector<T> point(sk.get_dim());
+            for (size_t i = begin; i < end; ++i) {
+              for (size_t j = 0; j < point.size(); ++j) point[j] = p(i, j);
+              out[i] = sk.get_estimate(point);
+            }
+          });
+          return result;
+        },
+        nb::arg("points"), nb::arg("num_threads")=1,
+        "Returns a NumPy array of the approximate density at each row of a 2D array of points, "
+        "splitting the rows across num_threads native threads, or one per hardware thread if 0. "
+        "Python kernels hold the GIL for each evaluation, so only built-in kernels benefit from more threads."
+    )
     .def("__str__", [](const density_sketch<T, K>& sk) { return sk.to_string(); },
         "Produces a string summary of the sketch")
     .def("to_string", &density_sketch<T, K>::to_string, nb::arg("print_levels")=false, nb::arg("print_items")=false,
         "Produces a string summary of the sketch")
+    .def(
+        "get_points",
+        [](const density_sketch<T, K>& sk) {
+          auto points = make_numpy_array<T>(sk.get_num_retained(), sk.get_dim());
+          auto weights = make_numpy_array<uint64_t>(sk.get_num_retained());
+          T* out = points.data();
+          size_t i = 0;
+          for (auto it = sk.begin(); it != sk.end(); ++it, ++i) {
+            const auto& entry = *it;
+            std::copy(entry.first.begin(), entry.first.end(), out + i * sk.get_dim());
+            weights.data()[i] = entry.second;
+          }
+          return std::make_pair(std::move(points), std::move(weights));
+        },
+        "Returns a tuple of NumPy arrays (points, weights) of the retained points, where points is a "
+        "C-contiguous 2D array of shape (num_retained, dim)"
+    )
     .def("__iter__", [](const density_sketch<T, K> &sk) {
                         return nb::make_iterator(nb::type<density_sketch<T,K> >(),
                                                  "density_iterator",
@@ -86,14 +173,26 @@ void bind_density_sketch(nb::module_ &m, const char* name) {
         },
         "Serializes the sketch into a bytes object"
     )
+    .def(
+        "serialize_into",
+        [](const density_sketch<T, K>& sk, nb::handle buffer, size_t offset) {
+          return serialize_into_buffer(buffer, offset, [&](std::ostream& os) { sk.serialize(os); });
+        },
+        nb::arg("buffer"), nb::arg("offset")=0,
+        "Serializes the sketch into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-          [](const nb::bytes& bytes, kernel_function* kernel) {
+          [](nb::handle bytes, kernel_function* kernel, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
           K holder(kernel);
-          return density_sketch<T, K>::deserialize(bytes.c_str(), bytes.size(), holder);
+          nb::gil_scoped_release release;
+          return density_sketch<T, K>::deserialize(range.data(), range.size(), holder);
         },
-        nb::arg("bytes"), nb::arg("kernel"),
-        "Reads a bytes object and returns the corresponding density_sketch"
+        nb::arg("bytes"), nb::arg("kernel"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding density_sketch"
     );
 }
 
@@ -121,6 +220,38 @@ void init_density(nb::module_ &m) {
       )
     ;
 
+  // built-in kernels
+  nb::class_<native_gaussian_kernel, kernel_function>(m, "gaussian_kernel",
+     "A built-in Gaussian (RBF) kernel exp(-||a - b||^2 / (2 bandwidth^2)), evaluated natively by the sketch.")
+    .def(nb::init<double>(), nb::arg("bandwidth")=1.0,
+      "Creates a Gaussian kernel\n\n"
+      ":param bandwidth: the kernel bandwidth, default 1.0\n:type bandwidth: float, optional"
+      )
+    .def_prop_ro("bandwidth", &native_gaussian_kernel::get_bandwidth, "The kernel bandwidth")
+    ;
+
+  nb::class_<native_laplacian_kernel, kernel_function>(m, "laplacian_kernel",
+     "A built-in Laplacian kernel exp(-||a - b||_1 / bandwidth), evaluated natively by the sketch.")
+    .def(nb::init<double>(), nb::arg("bandwidth")=1.0,
+      "Creates a Laplacian kernel\n\n"
+      ":param bandwidth: the kernel bandwidth, default 1.0\n:type bandwidth: float, optional"
+      )
+    .def_prop_ro("bandwidth", &native_laplacian_kernel::get_bandwidth, "The kernel bandwidth")
+    ;
+
+  nb::class_<native_polynomial_kernel, kernel_function>(m, "polynomial_kernel",
+     "A built-in polynomial kernel (gamma <a, b> + coef0)^degree, evaluated natively by the sketch.")
+    .def(nb::init<unsigned, double, double>(), nb::arg("degree")=2, nb::arg("gamma")=1.0, nb::arg("coef0")=1.0,
+      "Creates a polynomial kernel\n\n"
+      ":param degree: the degree of the polynomial, default 2\n:type degree: int, optional\n"
+      ":param gamma: the scale of the inner product, default 1.0\n:type gamma: float, optional\n"
+      ":param coef0: the constant term, default 1.0\n:type coef0: float, optional"
+      )
+    .def_prop_ro("degree", &native_polynomial_kernel::get_degree, "The degree of the polynomial")
+    .def_prop_ro("gamma", &native_polynomial_kernel::get_gamma, "The scale of the inner product")
+    .def_prop_ro("coef0", &native_polynomial_kernel::get_coef0, "The constant term")
+    ;
+
   // the old sketch names can almost be defined, but the kernel_function_holder won't work in init()
   //bind_density_sketch<float, gaussian_kernel<float>>(m, "density_floats_sketch");
   //bind_density_sketch<double, gaussian_kernel<double>>(m, "density_doubles_sketch");
@@ -17,13 +17,22 @@
  * under the License.
  */
 
+#include <algorithm>
+#include <type_traits>
+
 #include <nanobind/nanobind.h>
 #include <nanobind/make_iterator.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 
 #include "py_serde.hpp"
 #include "py_object_ostream.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "quantile_conditional.hpp"
+#include "sampling_conditional.hpp"
 
 #include "ebpps_sketch.hpp"
 
@@ -33,7 +42,22 @@ template<typename T>
 void bind_ebpps_sketch(nb::module_ &m, const char* name) {
   using namespace datasketches;
 
-  nb::class_<ebpps_sketch<T>>(m, name)
+  auto clazz = nb::class_<ebpps_sketch<T>>(m, name);
+
+  // the NumPy array update must be registered before the scalar one
+  if constexpr (std::is_arithmetic<T>::value) {
+    add_weighted_vector_update<T>(clazz);
+    clazz.def("get_samples",
+         [](const ebpps_sketch<T>& sk) {
+           const auto result = sk.get_result();
+           auto items = make_numpy_array<T>(result.size());
+           std::copy(result.begin(), result.end(), items.data());
+           return items;
+         },
+         "Returns a NumPy array of a sample drawn from the sketch, as iteration would produce");
+  }
+
+  clazz
     .def(nb::init<uint32_t>(), nb::arg("k"),
          "Creates a new EBPPS sketch instance\n\n"
          ":param k: Maximum number of samples in the sketch\n:type k: int\n"
@@ -65,21 +89,6 @@ void bind_ebpps_sketch(nb::module_ &m, const char* name) {
          "although numerical precision limitations mean it may exceed k by double precision floating point error margins in certain cases.")
     .def("is_empty", &ebpps_sketch<T>::is_empty,
          "Returns True if the sketch is empty, otherwise False")
-    .def("get_serialized_size_bytes",
-         [](const ebpps_sketch<T>& sk, py_object_serde& serde) { return sk.get_serialized_size_bytes(serde); },
-         nb::arg("serde"),
-         "Computes the size in bytes needed to serialize the current sketch")
-    .def("serialize",
-         [](const ebpps_sketch<T>& sk, py_object_serde& serde) {
-           auto bytes = sk.serialize(0, serde);
-           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
-         }, nb::arg("serde"),
-         "Serializes the sketch into a bytes object")
-    .def_static(
-         "deserialize",
-         [](const nb::bytes& bytes, py_object_serde& serde) { return ebpps_sketch<T>::deserialize(bytes.c_str(), bytes.size(), serde); },
-         nb::arg("bytes"), nb::arg("serde"),
-         "Reads a bytes object and returns the corresponding ebpps_sketch")
     .def("__iter__",
           [](const ebpps_sketch<T>& sk) {
                return nb::make_iterator(nb::type<ebpps_sketch<T>>(),
@@ -89,8 +98,13 @@ void bind_ebpps_sketch(nb::module_ &m, const char* name) {
           }, nb::keep_alive<0,1>()
      )
      ;
+
+  add_serialized_size<T>(clazz);
+  add_serialization<T>(clazz);
 }
 
 void init_ebpps(nb::module_ &m) {
   bind_ebpps_sketch<nb::object>(m, "ebpps_sketch");
+  bind_ebpps_sketch<int64_t>(m, "ebpps_ints_sketch");
+  bind_ebpps_sketch<double>(m, "ebpps_doubles_sketch");
 }
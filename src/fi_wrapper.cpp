@@ -20,26 +20,53 @@
 
 #include "py_serde.hpp"
 #include "py_object_ostream.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "byte_string.hpp"
+#include "pickle_support.hpp"
 #include "frequent_items_sketch.hpp"
 
 #include <nanobind/nanobind.h>
 #include <nanobind/operators.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/ndarray.h>
 
 #include <exception>
+#include <optional>
 #include <ostream>
+#include <stdexcept>
+#include <type_traits>
 
 namespace pb = nanobind;
 
+// item types with a built-in C++ serde
+template<typename T>
+struct has_builtin_serde: std::integral_constant<bool, std::is_arithmetic<T>::value
+    || std::is_same<std::string, T>::value || std::is_same<datasketches::byte_string, T>::value> {};
+
 // forward declarations
-// std::string and arithmetic types, where we don't need a separate serde
-template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_arithmetic<T>::value || std::is_same<std::string, T>::value, bool>::type = 0>
+// std::string, bytes and arithmetic types, where we don't need a separate serde
+template<typename T, typename W, typename H, typename E, typename std::enable_if<has_builtin_serde<T>::value, bool>::type = 0>
 void add_serialization(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz);
 
 // nb::object and other types where the caller must provide a serde
-template<typename T, typename W, typename H, typename E, typename std::enable_if<!std::is_arithmetic<T>::value && !std::is_same<std::string, T>::value, bool>::type = 0>
+template<typename T, typename W, typename H, typename E, typename std::enable_if<!has_builtin_serde<T>::value, bool>::type = 0>
 void add_serialization(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz);
 
+// integer items, updated from a NumPy array
+template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_integral<T>::value, bool>::type = 0>
+void add_vector_update(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz);
+
+// string or bytes items, updated from a fixed-width or Arrow-style array
+template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_base_of<std::string, T>::value, bool>::type = 0>
+void add_vector_update(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz);
+
+// nb::object, which has no vectorized update
+template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_same<nb::object, T>::value, bool>::type = 0>
+void add_vector_update(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz);
+
 template<typename T, typename W, typename H, typename E>
 void bind_fi_sketch(nb::module_ &m, const char* name) {
   using namespace datasketches;
@@ -54,11 +81,12 @@ void bind_fi_sketch(nb::module_ &m, const char* name) {
     .def("__copy__", [](const frequent_items_sketch<T, W, H, E>& sk){ return frequent_items_sketch<T,W,H,E>(sk); })
     .def("__str__", [](const frequent_items_sketch<T, W, H, E>& sk) { return sk.to_string(); },
          "Produces a string summary of the sketch")
-    .def("to_string", &frequent_items_sketch<T, W, H, E>::to_string, nb::arg("print_items")=false,
+    .def("to_string", &frequent_items_sketch<T, W, H, E>::to_string, nb::arg("print_items")=false, release_gil_guard<T>(),
          "Produces a string summary of the sketch")
     .def("update", (void (frequent_items_sketch<T, W, H, E>::*)(const T&, uint64_t)) &frequent_items_sketch<T, W, H, E>::update, nb::arg("item"), nb::arg("weight")=1,
          "Updates the sketch with the given string and, optionally, a weight")
     .def("merge", (void (frequent_items_sketch<T, W, H, E>::*)(const frequent_items_sketch<T, W, H, E>&)) &frequent_items_sketch<T, W, H, E>::merge,
+         nb::arg("other"), release_gil_guard<T>(),
          "Merges the given sketch into this one")
     .def("is_empty", &frequent_items_sketch<T, W, H, E>::is_empty,
          "Returns True if the sketch is empty, otherwise False")
@@ -81,7 +109,7 @@ void bind_fi_sketch(nb::module_ &m, const char* name) {
         [](const frequent_items_sketch<T, W, H, E>& sk, frequent_items_error_type err_type, uint64_t threshold) {
           if (threshold == 0) threshold = sk.get_maximum_error();
           nb::list list;
-          auto rows = sk.get_frequent_items(err_type, threshold);
+          auto rows = call_without_gil_for<T>([&sk, err_type, threshold] { return sk.get_frequent_items(err_type, threshold); });
           for (auto row: rows) {
             list.append(nb::make_tuple(
                 row.get_item(),
@@ -110,35 +138,53 @@ void bind_fi_sketch(nb::module_ &m, const char* name) {
     // serialization may need a caller-provided serde depending on the sketch type, so
     // we use a separate method to handle that appropriately based on type T.
     add_serialization(fi_class);
+    add_vector_update(fi_class);
 }
 
-// std::string or arithmetic types, for which we have a built-in serde
-template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_arithmetic<T>::value || std::is_same<std::string, T>::value, bool>::type>
+// std::string, bytes or arithmetic types, for which we have a built-in serde
+template<typename T, typename W, typename H, typename E, typename std::enable_if<has_builtin_serde<T>::value, bool>::type>
 void add_serialization(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz) {
     using namespace datasketches;
     clazz.def(
         "get_serialized_size_bytes",
-        [](const frequent_items_sketch<T, W, H, E>& sk) { return sk.get_serialized_size_bytes(); },
+        [](const frequent_items_sketch<T, W, H, E>& sk) { return sk.get_serialized_size_bytes(); }, release_gil(),
         "Computes the size needed to serialize the current state of the sketch. This can be expensive since every item needs to be looked at."
     )
     .def(
         "serialize",
         [](const frequent_items_sketch<T, W, H, E>& sk) {
-          auto bytes = sk.serialize();
+          auto bytes = call_without_gil([&sk] { return sk.serialize(); });
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         },
         "Serializes the sketch into a bytes object."
     )
+    .def(
+        "serialize_into",
+        [](const frequent_items_sketch<T, W, H, E>& sk, nb::handle buffer, size_t offset) {
+          return serialize_into_buffer(buffer, offset, [&](std::ostream& os) { sk.serialize(os); });
+        },
+        nb::arg("buffer"), nb::arg("offset")=0,
+        "Serializes the sketch into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes) { return frequent_items_sketch<T, W, H, E>::deserialize(bytes.c_str(), bytes.size()); },
-        nb::arg("bytes"),
-        "Reads a bytes object and returns the corresponding frequent_strings_sketch."
+        [](nb::handle bytes, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return call_without_gil([&range] { return frequent_items_sketch<T, W, H, E>::deserialize(range.data(), range.size()); });
+        },
+        nb::arg("bytes"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding sketch"
     );
+
+    add_pickle_support(clazz,
+      [](const frequent_items_sketch<T, W, H, E>& sk) { return sk.serialize(); },
+      [](const char* data, size_t size) { return frequent_items_sketch<T, W, H, E>::deserialize(data, size); });
 }
 
 // nb::object or any other type that requires a provided serde
-template<typename T, typename W, typename H, typename E, typename std::enable_if<!std::is_arithmetic<T>::value && !std::is_same<std::string, T>::value, bool>::type>
+template<typename T, typename W, typename H, typename E, typename std::enable_if<!has_builtin_serde<T>::value, bool>::type>
 void add_serialization(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz) {
     using namespace datasketches;
     clazz.def(
@@ -155,15 +201,132 @@ void add_serialization(nb::class_<datasketches::frequent_items_sketch<T, W, H, E
         }, nb::arg("serde"),
         "Serializes the sketch into a bytes object using the provided serde."
     )
+    .def(
+        "serialize_into",
+        [](const frequent_items_sketch<T, W, H, E>& sk, nb::handle buffer, py_object_serde& serde, size_t offset) {
+          return serialize_into_buffer_for<T>(buffer, offset, [&](std::ostream& os) { sk.serialize(os, serde); });
+        },
+        nb::arg("buffer"), nb::arg("serde"), nb::arg("offset")=0,
+        "Serializes the sketch using the provided serde into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes, py_object_serde& serde) {
-          return frequent_items_sketch<T, W, H, E>::deserialize(bytes.c_str(), bytes.size(), serde);
-        }, nb::arg("bytes"), nb::arg("serde"),
-        "Reads a bytes object using the provided serde and returns the corresponding frequent_strings_sketch."
+        [](nb::handle bytes, py_object_serde& serde, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return frequent_items_sketch<T, W, H, E>::deserialize(range.data(), range.size(), serde);
+        }, nb::arg("bytes"), nb::arg("serde"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "using the provided serde and returns the corresponding frequent_items_sketch."
     );
 }
 
+// per-item weights of an array update, all 1 if no weights are given
+class update_weights {
+  public:
+    update_weights(const std::optional<nb::ndarray<int64_t>>& weights, size_t num_items):
+    data_(nullptr), stride_(0)
+    {
+      if (!weights) return;
+      if (weights->ndim() != 1 || weights->shape(0) != num_items) {
+        throw std::invalid_argument("weights must be a one-dimensional array with one value per item");
+      }
+      data_ = weights->data();
+      stride_ = weights->stride(0);
+      for (size_t i = 0; i < num_items; ++i) {
+        if (data_[i * stride_] < 0) throw std::invalid_argument("weights must be non-negative");
+      }
+    }
+
+    uint64_t operator[](size_t i) const {
+      return data_ == nullptr ? 1 : static_cast<uint64_t>(data_[i * stride_]);
+    }
+
+  private:
+    const int64_t* data_;
+    int64_t stride_;
+};
+
+template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_integral<T>::value, bool>::type>
+void add_vector_update(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz) {
+  using namespace datasketches;
+  clazz.def(
+    "update",
+    [](frequent_items_sketch<T, W, H, E>& sk, nb::ndarray<T> items, std::optional<nb::ndarray<int64_t>> weights) {
+      if (items.ndim() != 1) {
+        throw std::invalid_argument("input data must have only one dimension. Found: "
+          + std::to_string(items.ndim()));
+      }
+      auto v = items.template view<T, nb::ndim<1>>();
+      update_weights w(weights, v.shape(0));
+      nb::gil_scoped_release release;
+      for (size_t i = 0; i < v.shape(0); ++i) sk.update(v(i), w[i]);
+    },
+    nb::arg("items"), nb::arg("weights")=nb::none(),
+    "Updates the sketch with every value of the given array of integers and, optionally, "
+    "an array of non-negative integer weights of the same length"
+  );
+}
+
+template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_base_of<std::string, T>::value, bool>::type>
+void add_vector_update(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz) {
+  using namespace datasketches;
+  clazz.def(
+    "update_strings",
+    [](frequent_items_sketch<T, W, H, E>& sk, nb::handle array, std::optional<nb::ndarray<int64_t>> weights) {
+      py_buffer buf(array);
+      update_weights w(weights, buf.length());
+      nb::gil_scoped_release release;
+      size_t i = 0;
+      for_each_fixed_width_string(buf, [&sk, &w, &i](const char* data, size_t length) {
+        sk.update(T(data, length), w[i++]);
+      });
+    },
+    nb::arg("array"), nb::arg("weights")=nb::none(),
+    "Updates the sketch with every item of a NumPy fixed-width bytes ('S') or unicode ('U') array and, "
+    "optionally, an array of non-negative integer weights of the same length. "
+    "Trailing NUL padding is stripped as in NumPy, and unicode items are stored as UTF-8."
+  )
+  .def(
+    "update_binary",
+    [](frequent_items_sketch<T, W, H, E>& sk, nb::handle offsets, nb::handle data, std::optional<nb::ndarray<int64_t>> weights) {
+      py_buffer offsets_buf(offsets);
+      py_buffer data_buf(data, PyBUF_SIMPLE);
+      update_weights w(weights, offsets_buf.length() > 0 ? offsets_buf.length() - 1 : 0);
+      nb::gil_scoped_release release;
+      size_t i = 0;
+      for_each_offset_string(offsets_buf, data_buf, [&sk, &w, &i](const char* item, size_t length) {
+        sk.update(T(item, length), w[i++]);
+      });
+    },
+    nb::arg("offsets"), nb::arg("data"), nb::arg("weights")=nb::none(),
+    "Updates the sketch with every item of an Arrow-style variable-width binary or string array, "
+    "where item i is data[offsets[i]:offsets[i+1]], and optionally an array of non-negative integer weights.\n\n"
+    ":param offsets: An array of n+1 32- or 64-bit integer offsets into data\n:type offsets: buffer\n"
+    ":param data: A contiguous buffer holding the concatenated items\n:type data: buffer\n"
+    ":param weights: An array of n weights, or None to give each item a weight of 1\n:type weights: numpy.ndarray, optional"
+  );
+}
+
+template<typename T, typename W, typename H, typename E, typename std::enable_if<std::is_same<nb::object, T>::value, bool>::type>
+void add_vector_update(nb::class_<datasketches::frequent_items_sketch<T, W, H, E>>& clazz) {
+  datasketches::unused(clazz);
+}
+
+// mixes the bits of integer items, which are often sequential or share low-order bits,
+// since the sketch places items in its hash map using the low-order bits of the hash
+struct int64_hash {
+  size_t operator()(int64_t item) const {
+    uint64_t x = static_cast<uint64_t>(item);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+};
+
 // calls class __hash__ method
 struct py_hash_caller {
   virtual size_t operator()(const nb::object& a) const {
@@ -192,4 +355,6 @@ void init_fi(nb::module_ &m) {
 
   bind_fi_sketch<std::string, uint64_t, std::hash<std::string>, std::equal_to<std::string>>(m, "frequent_strings_sketch");
   bind_fi_sketch<nb::object, uint64_t, py_hash_caller, py_equal_caller>(m, "frequent_items_sketch"); 
+  bind_fi_sketch<int64_t, uint64_t, int64_hash, std::equal_to<int64_t>>(m, "frequent_ints_sketch");
+  bind_fi_sketch<byte_string, uint64_t, byte_string_hash, std::equal_to<byte_string>>(m, "frequent_bytes_sketch");
 }
@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+
+#include "hll8_registers.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HLL8_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
+
+// SSE2 is part of x86-64, so it needs no run-time check
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLL8_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define HLL8_NEON
+#include <arm_neon.h>
+#endif
+
+namespace datasketches {
+
+namespace {
+
+// 2^-v for every register value
+struct inverse_powers_of_2 {
+  double values[256];
+  inverse_powers_of_2() { for (int v = 0; v < 256; ++v) values[v] = std::ldexp(1.0, -v); }
+};
+
+const inverse_powers_of_2 INVERSE_POWERS;
+
+void max_scalar(uint8_t* dst, const uint8_t* src, size_t n) {
+  for (size_t i = 0; i < n; ++i) dst[i] = std::max(dst[i], src[i]);
+}
+
+// adds registers [begin, n) to the stats
+void accumulate_tail(const uint8_t* registers, size_t begin, size_t n, hll8_register_stats& stats) {
+  for (size_t i = begin; i < n; ++i) {
+    const uint8_t v = registers[i];
+    if (v == 0) ++stats.num_zeros;
+    if (v < 32) stats.kxq0 += INVERSE_POWERS.values[v];
+    else stats.kxq1 += INVERSE_POWERS.values[v];
+  }
+}
+
+hll8_register_stats accumulate_scalar(const uint8_t* registers, size_t n) {
+  hll8_register_stats stats{0, 0, 0};
+  accumulate_tail(registers, 0, n, stats);
+  return stats;
+}
+
+#ifdef HLL8_AVX2_DISPATCH
+
+__attribute__((target("avx2")))
+void max_avx2(uint8_t* dst, const uint8_t* src, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_max_epu8(a, b));
+  }
+  max_scalar(dst + i, src + i, n - i);
+}
+
+// 2^-v is the double of exponent bits 1023 - v, built from the registers widened to 64 bits
+__attribute__((target("avx2")))
+hll8_register_stats accumulate_avx2(const uint8_t* registers, size_t n) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i bias = _mm256_set1_epi64x(1023);
+  const __m256i last_low = _mm256_set1_epi64x(31);
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  uint32_t num_zeros = 0;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(registers + i));
+    num_zeros += __builtin_popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero))));
+    for (size_t j = 0; j < 32; j += 4) {
+      int32_t four;
+      std::memcpy(&four, registers + i + j, sizeof(four));
+      const __m256i w = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(four));
+      const __m256d p = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_sub_epi64(bias, w), 52));
+      const __m256d high = _mm256_castsi256_pd(_mm256_cmpgt_epi64(w, last_low));
+      sum0 = _mm256_add_pd(sum0, _mm256_andnot_pd(high, p));
+      sum1 = _mm256_add_pd(sum1, _mm256_and_pd(high, p));
+    }
+  }
+  double lanes0[4];
+  double lanes1[4];
+  _mm256_storeu_pd(lanes0, sum0);
+  _mm256_storeu_pd(lanes1, sum1);
+  hll8_register_stats stats{(lanes0[0] + lanes0[1]) + (lanes0[2] + lanes0[3]),
+                            (lanes1[0] + lanes1[1]) + (lanes1[2] + lanes1[3]), num_zeros};
+  accumulate_tail(registers, i, n, stats);
+  return stats;
+}
+
+#endif // HLL8_AVX2_DISPATCH
+
+#ifdef HLL8_SSE2
+
+void max_sse2(uint8_t* dst, const uint8_t* src, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_max_epu8(a, b));
+  }
+  max_scalar(dst + i, src + i, n - i);
+}
+
+// two registers widened to 64 bits, with their v >= 32 mask widened alike
+inline void accumulate_sse2_lanes(__m128i w, __m128i high, __m128d& sum0, __m128d& sum1) {
+  const __m128d p = _mm_castsi128_pd(_mm_slli_epi64(_mm_sub_epi64(_mm_set1_epi64x(1023), w), 52));
+  const __m128d mask = _mm_castsi128_pd(high);
+  sum0 = _mm_add_pd(sum0, _mm_andnot_pd(mask, p));
+  sum1 = _mm_add_pd(sum1, _mm_and_pd(mask, p));
+}
+
+// four registers widened to 32 bits, where SSE2 has the comparison that 64 bits lack
+inline void accumulate_sse2_quad(__m128i w, __m128d& sum0, __m128d& sum1) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i high = _mm_cmpgt_epi32(w, _mm_set1_epi32(31));
+  accumulate_sse2_lanes(_mm_unpacklo_epi32(w, zero), _mm_unpacklo_epi32(high, high), sum0, sum1);
+  accumulate_sse2_lanes(_mm_unpackhi_epi32(w, zero), _mm_unpackhi_epi32(high, high), sum0, sum1);
+}
+
+hll8_register_stats accumulate_sse2(const uint8_t* registers, size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  uint32_t num_zeros = 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(registers + i));
+    num_zeros += static_cast<uint32_t>(std::bitset<16>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))).count());
+    const __m128i low = _mm_unpacklo_epi8(v, zero);
+    const __m128i high = _mm_unpackhi_epi8(v, zero);
+    accumulate_sse2_quad(_mm_unpacklo_epi16(low, zero), sum0, sum1);
+    accumulate_sse2_quad(_mm_unpackhi_epi16(low, zero), sum0, sum1);
+    accumulate_sse2_quad(_mm_unpacklo_epi16(high, zero), sum0, sum1);
+    accumulate_sse2_quad(_mm_unpackhi_epi16(high, zero), sum0, sum1);
+  }
+  double lanes0[2];
+  double lanes1[2];
+  _mm_storeu_pd(lanes0, sum0);
+  _mm_storeu_pd(lanes1, sum1);
+  hll8_register_stats stats{lanes0[0] + lanes0[1], lanes1[0] + lanes1[1], num_zeros};
+  accumulate_tail(registers, i, n, stats);
+  return stats;
+}
+
+#endif // HLL8_SSE2
+
+#ifdef HLL8_NEON
+
+void max_neon(uint8_t* dst, const uint8_t* src, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) vst1q_u8(dst + i, vmaxq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+  max_scalar(dst + i, src + i, n - i);
+}
+
+inline void accumulate_neon_lanes(uint64x2_t w, float64x2_t& sum0, float64x2_t& sum1) {
+  const uint64x2_t bits = vshlq_n_u64(vsubq_u64(vdupq_n_u64(1023), w), 52);
+  const uint64x2_t high = vcgtq_u64(w, vdupq_n_u64(31));
+  sum0 = vaddq_f64(sum0, vreinterpretq_f64_u64(vbicq_u64(bits, high)));
+  sum1 = vaddq_f64(sum1, vreinterpretq_f64_u64(vandq_u64(bits, high)));
+}
+
+inline void accumulate_neon_quad(uint32x4_t w, float64x2_t& sum0, float64x2_t& sum1) {
+  accumulate_neon_lanes(vmovl_u32(vget_low_u32(w)), sum0, sum1);
+  accumulate_neon_lanes(vmovl_high_u32(w), sum0, sum1);
+}
+
+hll8_register_stats accumulate_neon(const uint8_t* registers, size_t n) {
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  uint32_t num_zeros = 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16_t v = vld1q_u8(registers + i);
+    num_zeros += vaddvq_u8(vandq_u8(vceqzq_u8(v), vdupq_n_u8(1)));
+    const uint16x8_t low = vmovl_u8(vget_low_u8(v));
+    const uint16x8_t high = vmovl_high_u8(v);
+    accumulate_neon_quad(vmovl_u16(vget_low_u16(low)), sum0, sum1);
+    accumulate_neon_quad(vmovl_high_u16(low), sum0, sum1);
+    accumulate_neon_quad(vmovl_u16(vget_low_u16(high)), sum0, sum1);
+    accumulate_neon_quad(vmovl_high_u16(high), sum0, sum1);
+  }
+  hll8_register_stats stats{vaddvq_f64(sum0), vaddvq_f64(sum1), num_zeros};
+  accumulate_tail(registers, i, n, stats);
+  return stats;
+}
+
+#endif // HLL8_NEON
+
+struct hll8_kernels {
+  void (*max_registers)(uint8_t*, const uint8_t*, size_t);
+  hll8_register_stats (*accumulate)(const uint8_t*, size_t);
+  const char* name;
+};
+
+hll8_kernels select_kernels() {
+#if defined(HLL8_AVX2_DISPATCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return {max_avx2, accumulate_avx2, "avx2"};
+#endif
+#if defined(HLL8_SSE2)
+  return {max_sse2, accumulate_sse2, "sse2"};
+#elif defined(HLL8_NEON)
+  return {max_neon, accumulate_neon, "neon"};
+#endif
+  return {max_scalar, accumulate_scalar, "scalar"};
+}
+
+// selected on first use, by a thread-safe static initialization
+const hll8_kernels& kernels() {
+  static const hll8_kernels selected = select_kernels();
+  return selected;
+}
+
+} // namespace
+
+void hll8_max_registers(uint8_t* dst, const uint8_t* src, size_t n) { kernels().max_registers(dst, src, n); }
+
+hll8_register_stats hll8_accumulate(const uint8_t* registers, size_t n) { return kernels().accumulate(registers, n); }
+
+const char* hll8_kernel_name() { return kernels().name; }
+
+} // namespace datasketches
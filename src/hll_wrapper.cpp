@@ -18,9 +18,18 @@
  */
 
 #include <nanobind/nanobind.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 
 #include "hll.hpp"
+#include "atomic_hll_sketch.hpp"
+#include "hash_update.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "batch_serde.hpp"
+#include "pickle_support.hpp"
+#include "memory_usage.hpp"
 
 namespace nb = nanobind;
 
@@ -33,7 +42,7 @@ void init_hll(nb::module_ &m) {
     .value("HLL_8", HLL_8)
     .export_values();
 
-  nb::class_<hll_sketch>(m, "hll_sketch")
+  auto hll_class = nb::class_<hll_sketch>(m, "hll_sketch")
     .def(nb::init<uint8_t, target_hll_type, bool>(), nb::arg("lg_k"), nb::arg("tgt_type")=HLL_8, nb::arg("start_max_size")=false,
          "Constructs a new HLL sketch\n\n"
          ":param lg_config_k: A full sketch can hold 2^lg_config_k rows. Must be between 7 and 21, inclusive,\n"
@@ -47,7 +56,7 @@ void init_hll(nb::module_ &m) {
     .def("__str__", [](const hll_sketch& sk) { return sk.to_string(); },
          "Produces a string summary of the sketch")
     .def("to_string", (std::string (hll_sketch::*)(bool,bool,bool,bool) const) &hll_sketch::to_string,
-         nb::arg("summary")=true, nb::arg("detail")=false, nb::arg("aux_detail")=false, nb::arg("all")=false,
+         nb::arg("summary")=true, nb::arg("detail")=false, nb::arg("aux_detail")=false, nb::arg("all")=false, release_gil(),
          "Produces a string summary of the sketch")
     .def_prop_ro("lg_config_k", &hll_sketch::get_lg_config_k, "Configured lg_k value for the sketch")
     .def_prop_ro("tgt_type", &hll_sketch::get_target_type, "The HLL type (4, 6, or 8) when in estimation mode")
@@ -65,13 +74,15 @@ void init_hll(nb::module_ &m) {
          "Returns the size of the serialized sketch")
     .def("get_compact_serialization_bytes", &hll_sketch::get_compact_serialization_bytes,
          "Returns the size of the serialized sketch when compressing the exception table if HLL_4")
+    .def("get_memory_usage", [](const hll_sketch& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its heap storage")
     .def("reset", &hll_sketch::reset,
          "Resets the sketch to the empty state in coupon collection mode")
-    .def("update", (void (hll_sketch::*)(int64_t)) &hll_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (hll_sketch::*)(int64_t)>(&hll_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given integral value")
-    .def("update", (void (hll_sketch::*)(double)) &hll_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (hll_sketch::*)(double)>(&hll_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given floating point value")
-    .def("update", (void (hll_sketch::*)(const std::string&)) &hll_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (hll_sketch::*)(const std::string&)>(&hll_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given string value")
     .def_static("get_max_updatable_serialization_bytes", &hll_sketch::get_max_updatable_serialization_bytes,
          nb::arg("lg_k"), nb::arg("tgt_type"),
@@ -82,7 +93,8 @@ void init_hll(nb::module_ &m) {
     .def(
         "serialize_compact",
         [](const hll_sketch& sk) {
-          auto bytes = sk.serialize_compact();
+          auto bytes = call_without_gil([&sk] { return sk.serialize_compact(); });
+          count_serialized(sk, bytes.size());
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         },
         "Serializes the sketch into a bytes object, compressing the exception table if HLL_4"
@@ -90,19 +102,96 @@ void init_hll(nb::module_ &m) {
     .def(
         "serialize_updatable",
         [](const hll_sketch& sk) {
-          auto bytes = sk.serialize_updatable();
+          auto bytes = call_without_gil([&sk] { return sk.serialize_updatable(); });
+          count_serialized(sk, bytes.size());
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         },
         "Serializes the sketch into a bytes object"
     )
+    .def(
+        "serialize_compact_into",
+        [](const hll_sketch& sk, nb::handle buffer, size_t offset) {
+          const size_t written = serialize_into_buffer(buffer, offset, [&](std::ostream& os) { sk.serialize_compact(os); });
+          count_serialized(sk, written);
+          return written;
+        },
+        nb::arg("buffer"), nb::arg("offset")=0,
+        "Serializes the sketch, compressing the exception table if HLL_4, into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
+    .def(
+        "serialize_updatable_into",
+        [](const hll_sketch& sk, nb::handle buffer, size_t offset) {
+          const size_t written = serialize_into_buffer(buffer, offset, [&](std::ostream& os) { sk.serialize_updatable(os); });
+          count_serialized(sk, written);
+          return written;
+        },
+        nb::arg("buffer"), nb::arg("offset")=0,
+        "Serializes the sketch into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes) { return hll_sketch::deserialize(bytes.c_str(), bytes.size()); },
-        nb::arg("bytes"),
-        "Reads a bytes object and returns the corresponding hll_sketch"
+        [](nb::handle bytes, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return call_without_gil([&range] { return hll_sketch::deserialize(range.data(), range.size()); });
+        },
+        nb::arg("bytes"), nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding hll_sketch"
     );
 
-  nb::class_<hll_union>(m, "hll_union")
+  add_batch_serialization(hll_class,
+    [](const hll_sketch& sk) { return sk.serialize_compact(); },
+    [](const char* data, size_t size) { return hll_sketch::deserialize(data, size); });
+  add_pickle_support(hll_class,
+    [](const hll_sketch& sk) { return sk.serialize_compact(); },
+    [](const char* data, size_t size) { return hll_sketch::deserialize(data, size); });
+  add_hash_vector_update(hll_class);
+  add_stats(hll_class);
+
+  auto atomic_hll_class = nb::class_<atomic_hll_sketch>(m, "atomic_hll_sketch",
+    "A dense HLL_8 sketch that many threads may update at once without locks. Each register is raised "
+    "atomically, so the result matches an HLL_8 sketch given the same items in any order.")
+    .def(nb::init<uint8_t>(), nb::arg("lg_k"),
+         "Constructs a new atomic HLL_8 sketch, which keeps 2^lg_k one-byte registers from the start\n\n"
+         ":param lg_k: The base 2 logarithm of the number of registers. Must be between 4 and 21, inclusive\n"
+         ":type lg_k: int"
+    )
+    .def_prop_ro("lg_config_k", &atomic_hll_sketch::get_lg_config_k, "Configured lg_k value for the sketch")
+    .def("update", (void (atomic_hll_sketch::*)(int64_t)) &atomic_hll_sketch::update, nb::arg("datum"),
+         "Updates the sketch with the given integral value")
+    .def("update", (void (atomic_hll_sketch::*)(double)) &atomic_hll_sketch::update, nb::arg("datum"),
+         "Updates the sketch with the given floating point value")
+    .def("update", (void (atomic_hll_sketch::*)(const std::string&)) &atomic_hll_sketch::update, nb::arg("datum"),
+         "Updates the sketch with the given string value")
+    .def("merge", &atomic_hll_sketch::merge, nb::arg("other"), release_gil(),
+         "Raises each register to that of the other sketch, which must have the same lg_k")
+    .def("reset", &atomic_hll_sketch::reset, release_gil(),
+         "Resets every register to zero")
+    .def("is_empty", &atomic_hll_sketch::is_empty, release_gil(),
+         "True if the sketch is empty, otherwise False")
+    .def("get_result", &atomic_hll_sketch::get_result, release_gil(),
+         "Returns an HLL_8 hll_sketch holding a snapshot of the registers, for queries and serialization")
+    .def("get_estimate", [](const atomic_hll_sketch& sk) { return call_without_gil([&sk] { return sk.get_result().get_estimate(); }); },
+         "Estimate of the distinct count of the input stream")
+    .def("get_lower_bound",
+         [](const atomic_hll_sketch& sk, uint8_t num_std_devs) {
+           return call_without_gil([&sk, num_std_devs] { return sk.get_result().get_lower_bound(num_std_devs); });
+         }, nb::arg("num_std_devs"),
+         "Returns the approximate lower error bound given the specified number of standard deviations in {1, 2, 3}")
+    .def("get_upper_bound",
+         [](const atomic_hll_sketch& sk, uint8_t num_std_devs) {
+           return call_without_gil([&sk, num_std_devs] { return sk.get_result().get_upper_bound(num_std_devs); });
+         }, nb::arg("num_std_devs"),
+         "Returns the approximate upper error bound given the specified number of standard deviations in {1, 2, 3}")
+    .def("get_memory_usage", &atomic_hll_sketch::get_memory_usage,
+         "Returns the approximate number of bytes held by the sketch, including its registers")
+  ;
+
+  add_hash_vector_update(atomic_hll_class);
+
+  auto hll_union_class = nb::class_<hll_union>(m, "hll_union")
     .def(nb::init<uint8_t>(), nb::arg("lg_max_k"),
          "Construct an hll_union object if the given size.\n\n"
          ":param lg_max_k: The maximum size, in log2, of k. Must be between 7 and 21, inclusive.\n"
@@ -119,9 +208,9 @@ void init_hll(nb::module_ &m) {
          "True if the union is empty, otherwise False")    
     .def("reset", &hll_union::reset,
          "Resets the union to the empty state")
-    .def("get_result", &hll_union::get_result, nb::arg("tgt_type")=HLL_4,
+    .def("get_result", &hll_union::get_result, nb::arg("tgt_type")=HLL_4, release_gil(),
          "Returns a sketch of the target type representing the current union state")
-    .def<void (hll_union::*)(const hll_sketch&)>("update", &hll_union::update, nb::arg("sketch"),
+    .def<void (hll_union::*)(const hll_sketch&)>("update", &hll_union::update, nb::arg("sketch"), release_gil(),
          "Updates the union with the given HLL sketch")
     .def<void (hll_union::*)(int64_t)>("update", &hll_union::update, nb::arg("datum"),
          "Updates the union with the given integral value")
@@ -133,4 +222,6 @@ void init_hll(nb::module_ &m) {
          nb::arg("upper_bound"), nb::arg("unioned"), nb::arg("lg_k"), nb::arg("num_std_devs"),
          "Returns the a priori relative error bound for the given parameters")
     ;
+
+  add_hash_vector_update(hll_union_class);
 }
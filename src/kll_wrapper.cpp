@@ -27,29 +27,37 @@
 #include "py_object_lt.hpp"
 #include "py_object_ostream.hpp"
 #include "quantile_conditional.hpp"
+#include "sorted_view.hpp"
+#include "memory_usage.hpp"
+#include "sketch_stats.hpp"
 
 #include "kll_sketch.hpp"
 
 namespace nb = nanobind;
 
 template<typename T, typename C>
-void bind_kll_sketch(nb::module_ &m, const char* name) {
+void bind_kll_sketch(nb::module_ &m, const char* name, const char* view_name) {
   using namespace datasketches;
 
-  auto kll_class = nb::class_<kll_sketch<T, C>>(m, name)
+  auto kll_class = nb::class_<kll_sketch<T, C>>(m, name);
+
+  // the NumPy array queries must be registered before the list versions
+  add_vector_queries<T>(kll_class);
+
+  kll_class
     .def(nb::init<uint16_t>(), nb::arg("k")=kll_constants::DEFAULT_K,
          "Creates a KLL sketch instance with the given value of k.\n\n"
          ":param k: Controls the size/accuracy trade-off of the sketch. Default is 200.\n"
          ":type k: int, optional"
          )
     .def("__copy__", [](const kll_sketch<T, C>& sk){ return kll_sketch<T, C>(sk); })
-    .def("update", static_cast<void (kll_sketch<T, C>::*)(const T&)>(&kll_sketch<T, C>::update), nb::arg("item"),
+    .def("update", counted_update(static_cast<void (kll_sketch<T, C>::*)(const T&)>(&kll_sketch<T, C>::update)), nb::arg("item"),
         "Updates the sketch with the given value")
-    .def("merge", (void (kll_sketch<T, C>::*)(const kll_sketch<T, C>&)) &kll_sketch<T, C>::merge, nb::arg("sketch"),
+    .def("merge", (void (kll_sketch<T, C>::*)(const kll_sketch<T, C>&)) &kll_sketch<T, C>::merge, nb::arg("sketch"), release_gil_guard<T>(),
         "Merges the provided sketch into this one")
     .def("__str__", [](const kll_sketch<T, C>& sk) { return sk.to_string(); },
         "Produces a string summary of the sketch")
-    .def("to_string", &kll_sketch<T, C>::to_string, nb::arg("print_levels")=false, nb::arg("print_items")=false,
+    .def("to_string", &kll_sketch<T, C>::to_string, nb::arg("print_levels")=false, nb::arg("print_items")=false, release_gil_guard<T>(),
         "Produces a string summary of the sketch")
     .def("is_empty", &kll_sketch<T, C>::is_empty,
         "Returns True if the sketch is empty, otherwise False")
@@ -59,6 +67,9 @@ void bind_kll_sketch(nb::module_ &m, const char* name) {
         "The length of the input stream")
     .def_prop_ro("num_retained", &kll_sketch<T, C>::get_num_retained,
         "The number of retained items (samples) in the sketch")
+    .def("get_memory_usage", [](const kll_sketch<T, C>& sk) { return get_memory_usage(sk); }, release_gil_guard<T>(),
+        "Returns the approximate number of bytes held by the sketch, including its heap storage. "
+        "Python objects held as items are counted as references only.")
     .def("is_estimation_mode", &kll_sketch<T, C>::is_estimation_mode,
         "Returns True if the sketch is in estimation mode, otherwise False")
     .def("get_min_value", &kll_sketch<T, C>::get_min_item,
@@ -162,12 +173,15 @@ void bind_kll_sketch(nb::module_ &m, const char* name) {
     ;
 
     add_serialization<T>(kll_class);
+    add_serialized_size<T>(kll_class);
     add_vector_update<T>(kll_class);
+    add_stats(kll_class);
+    add_sorted_view<T>(m, kll_class, view_name);
 }
 
 void init_kll(nb::module_ &m) {
-  bind_kll_sketch<int, std::less<int>>(m, "kll_ints_sketch");
-  bind_kll_sketch<float, std::less<float>>(m, "kll_floats_sketch");
-  bind_kll_sketch<double, std::less<double>>(m, "kll_doubles_sketch");
-  bind_kll_sketch<nb::object, py_object_lt>(m, "kll_items_sketch");
+  bind_kll_sketch<int, std::less<int>>(m, "kll_ints_sketch", "kll_ints_sorted_view");
+  bind_kll_sketch<float, std::less<float>>(m, "kll_floats_sketch", "kll_floats_sorted_view");
+  bind_kll_sketch<double, std::less<double>>(m, "kll_doubles_sketch", "kll_doubles_sorted_view");
+  bind_kll_sketch<nb::object, py_object_lt>(m, "kll_items_sketch", "kll_items_sorted_view");
 }
@@ -0,0 +1,306 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/string.h>
+
+#include "tracked_allocator.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+namespace {
+
+enum allocator_mode: int { SYSTEM_ALLOCATOR, POOL_ALLOCATOR, EXTERNAL_ALLOCATOR };
+
+// Free lists of blocks in multiples of 16 bytes up to 1 KiB, carved from 64 KiB chunks.
+// Larger blocks go to malloc. Chunks are returned only when the pool is disabled.
+class size_class_pool {
+  public:
+    static constexpr size_t GRANULE = 16;
+    static constexpr size_t MAX_BLOCK = 1024;
+    static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+    void* allocate(size_t size) {
+      if (size > MAX_BLOCK) return std::malloc(size);
+      size_class& sc = classes_[class_index(size)];
+      std::lock_guard<std::mutex> lock(sc.mutex);
+      if (sc.head == nullptr && !refill(sc, (class_index(size) + 1) * GRANULE)) return nullptr;
+      free_block* block = sc.head;
+      sc.head = block->next;
+      return block;
+    }
+
+    void deallocate(void* ptr, size_t size) {
+      if (size > MAX_BLOCK) {
+        std::free(ptr);
+        return;
+      }
+      size_class& sc = classes_[class_index(size)];
+      std::lock_guard<std::mutex> lock(sc.mutex);
+      free_block* block = static_cast<free_block*>(ptr);
+      block->next = sc.head;
+      sc.head = block;
+    }
+
+    // frees every chunk, which must hold no live blocks
+    void release() {
+      std::lock_guard<std::mutex> lock(chunks_mutex_);
+      for (size_class& sc: classes_) {
+        std::lock_guard<std::mutex> class_lock(sc.mutex);
+        sc.head = nullptr;
+      }
+      for (void* chunk: chunks_) std::free(chunk);
+      chunks_.clear();
+      reserved_bytes_ = 0;
+    }
+
+    uint64_t get_reserved_bytes() const { return reserved_bytes_.load(std::memory_order_relaxed); }
+
+  private:
+    struct free_block { free_block* next; };
+    struct size_class {
+      std::mutex mutex;
+      free_block* head = nullptr;
+    };
+
+    size_class classes_[MAX_BLOCK / GRANULE];
+    std::mutex chunks_mutex_;
+    std::vector<void*> chunks_;
+    std::atomic<uint64_t> reserved_bytes_{0};
+
+    static size_t class_index(size_t size) { return size == 0 ? 0 : (size - 1) / GRANULE; }
+
+    bool refill(size_class& sc, size_t block_size) {
+      char* chunk = static_cast<char*>(std::malloc(CHUNK_SIZE));
+      if (chunk == nullptr) return false;
+      {
+        std::lock_guard<std::mutex> lock(chunks_mutex_);
+        chunks_.push_back(chunk);
+      }
+      reserved_bytes_ += CHUNK_SIZE;
+      for (size_t offset = 0; offset + block_size <= CHUNK_SIZE; offset += block_size) {
+        free_block* block = reinterpret_cast<free_block*>(chunk + offset);
+        block->next = sc.head;
+        sc.head = block;
+      }
+      return true;
+    }
+};
+
+// Every live block is counted in live_blocks, and set_mode switches only once it has swapped a
+// count of 0 for SWITCHING. An allocation counts its block before reading the mode, so either
+// set_mode sees it and refuses, or the allocation sees SWITCHING and waits for the switch. Every
+// block is therefore freed by the allocator that made it, and the pool and external owner are
+// only released once nothing they hold is live, without a lock on allocation or deallocation.
+constexpr uint64_t SWITCHING = uint64_t(1) << 63;
+std::atomic<uint64_t> live_blocks{0};
+std::mutex set_mode_mutex;
+std::atomic<int> mode{SYSTEM_ALLOCATOR};
+allocator_hook external_hook{nullptr, nullptr, nullptr};
+PyObject* external_owner = nullptr; // strong reference to the capsule, held with the GIL
+size_class_pool pool;
+
+// The counters are kept in stripes, each on its own cache line and used by the threads
+// assigned to it in turn, so threads allocating at once keep to their own lines. They are
+// summed when read. A thread adds up its growth in bytes in use and checks the sum against
+// the peak once that growth reaches PEAK_GRANULE, so the peak may lag by that much per thread.
+constexpr size_t NUM_STRIPES = 64;
+constexpr int64_t PEAK_GRANULE = 1 << 14;
+
+struct alignas(64) counter_stripe {
+  std::atomic<uint64_t> num_allocations{0};
+  std::atomic<uint64_t> num_deallocations{0};
+  std::atomic<uint64_t> bytes_allocated{0};
+  std::atomic<uint64_t> bytes_deallocated{0};
+};
+
+counter_stripe stripes[NUM_STRIPES];
+std::atomic<unsigned> next_stripe{0};
+std::atomic<uint64_t> peak_bytes{0};
+thread_local unsigned stripe_index = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+thread_local int64_t unchecked_bytes = 0;
+
+uint64_t sum_bytes_in_use() {
+  uint64_t allocated = 0;
+  uint64_t deallocated = 0;
+  // freed bytes first, so a block freed between the two loads is never counted as freed only
+  for (const counter_stripe& stripe: stripes) deallocated += stripe.bytes_deallocated.load(std::memory_order_acquire);
+  for (const counter_stripe& stripe: stripes) allocated += stripe.bytes_allocated.load(std::memory_order_relaxed);
+  return allocated - deallocated;
+}
+
+void record_peak(uint64_t in_use) {
+  uint64_t peak = peak_bytes.load(std::memory_order_relaxed);
+  while (in_use > peak && !peak_bytes.compare_exchange_weak(peak, in_use, std::memory_order_relaxed)) {}
+}
+
+// only growth can raise the peak, so a thread freeing more than it allocates owes no check
+void count_bytes(int64_t delta) {
+  unchecked_bytes = std::max<int64_t>(unchecked_bytes + delta, 0);
+  if (unchecked_bytes >= PEAK_GRANULE) {
+    unchecked_bytes = 0;
+    record_peak(sum_bytes_in_use());
+  }
+}
+
+const char* ALLOCATOR_CAPSULE_NAME = "datasketches.allocator";
+
+void set_mode(int new_mode, nb::handle owner, const allocator_hook* hook) {
+  std::lock_guard<std::mutex> lock(set_mode_mutex);
+  // live blocks rather than bytes, since a block of size 0 holds no bytes
+  uint64_t expected = 0;
+  if (!live_blocks.compare_exchange_strong(expected, SWITCHING, std::memory_order_acquire)) {
+    throw std::invalid_argument("cannot change the allocator while " + std::to_string(sum_bytes_in_use())
+      + " bytes allocated through it are in use");
+  }
+  if (mode.load() == POOL_ALLOCATOR) pool.release();
+  if (hook != nullptr) external_hook = *hook;
+  Py_XINCREF(owner.ptr());
+  Py_XDECREF(external_owner);
+  external_owner = owner.ptr();
+  mode.store(new_mode, std::memory_order_relaxed);
+  // subtracted rather than stored, keeping the counts of allocations waiting for the switch
+  live_blocks.fetch_sub(SWITCHING, std::memory_order_release);
+}
+
+} // namespace
+
+void* tracked_allocate(size_t size) noexcept {
+  // counted before the mode is read, so that the mode cannot change under the allocation
+  while (live_blocks.fetch_add(1, std::memory_order_acquire) & SWITCHING) {
+    live_blocks.fetch_sub(1, std::memory_order_relaxed);
+    while (live_blocks.load(std::memory_order_acquire) & SWITCHING) std::this_thread::yield();
+  }
+  void* ptr = nullptr;
+  switch (mode.load(std::memory_order_relaxed)) {
+    case POOL_ALLOCATOR: ptr = pool.allocate(size); break;
+    case EXTERNAL_ALLOCATOR: ptr = external_hook.allocate(size, external_hook.context); break;
+    default: ptr = std::malloc(size == 0 ? 1 : size);
+  }
+  if (ptr == nullptr) {
+    live_blocks.fetch_sub(1, std::memory_order_release);
+    return nullptr;
+  }
+  counter_stripe& stripe = stripes[stripe_index];
+  stripe.num_allocations.fetch_add(1, std::memory_order_relaxed);
+  stripe.bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+  count_bytes(static_cast<int64_t>(size));
+  return ptr;
+}
+
+void tracked_deallocate(void* ptr, size_t size) noexcept {
+  if (ptr == nullptr) return;
+  // the block is still counted as live, so the mode cannot change until it is released below
+  switch (mode.load(std::memory_order_relaxed)) {
+    case POOL_ALLOCATOR: pool.deallocate(ptr, size); break;
+    case EXTERNAL_ALLOCATOR: external_hook.deallocate(ptr, size, external_hook.context); break;
+    default: std::free(ptr);
+  }
+  counter_stripe& stripe = stripes[stripe_index];
+  // released, so that a reader seeing the free also sees the allocation, wherever it was counted
+  stripe.num_deallocations.fetch_add(1, std::memory_order_release);
+  stripe.bytes_deallocated.fetch_add(size, std::memory_order_release);
+  count_bytes(-static_cast<int64_t>(size));
+  live_blocks.fetch_sub(1, std::memory_order_release);
+}
+
+allocation_stats get_allocation_stats() noexcept {
+  allocation_stats stats{0, 0, 0, 0, pool.get_reserved_bytes()};
+  for (const counter_stripe& stripe: stripes) {
+    stats.num_deallocations += stripe.num_deallocations.load(std::memory_order_acquire);
+  }
+  for (const counter_stripe& stripe: stripes) {
+    stats.num_allocations += stripe.num_allocations.load(std::memory_order_relaxed);
+  }
+  stats.bytes_in_use = sum_bytes_in_use();
+  record_peak(stats.bytes_in_use);
+  stats.peak_bytes = peak_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace datasketches
+
+void init_memory(nb::module_ &m) {
+  using namespace datasketches;
+
+  m.def("get_allocation_stats",
+    []() {
+      const allocation_stats stats = get_allocation_stats();
+      static const char* names[] = {"system", "pool", "external"};
+      nb::dict result;
+      result["allocator"] = names[mode.load()];
+      result["bytes_in_use"] = stats.bytes_in_use;
+      result["peak_bytes"] = stats.peak_bytes;
+      result["num_allocations"] = stats.num_allocations;
+      result["num_deallocations"] = stats.num_deallocations;
+      result["pool_bytes"] = stats.pool_bytes;
+      return result;
+    },
+    "Returns a dict of the global counters of the allocator hook used by the native sketch containers "
+    "(vectors of sketches and sketch maps): the current allocator, bytes_in_use, peak_bytes, "
+    "num_allocations, num_deallocations, and pool_bytes reserved by the pool allocator. "
+    "The counters are kept per thread and summed here. peak_bytes is checked every 16 KiB of change "
+    "in each thread, so it may miss a short-lived peak by that much per thread."
+  );
+
+  m.def("reset_peak_bytes",
+    []() { peak_bytes.store(sum_bytes_in_use(), std::memory_order_relaxed); },
+    "Resets the peak_bytes counter of get_allocation_stats() to the bytes currently in use"
+  );
+
+  m.def("set_allocator",
+    [](nb::handle allocator) {
+      if (nb::isinstance<nb::str>(allocator)) {
+        const std::string name = nb::cast<std::string>(allocator);
+        if (name == "system") set_mode(SYSTEM_ALLOCATOR, nb::handle(), nullptr);
+        else if (name == "pool") set_mode(POOL_ALLOCATOR, nb::handle(), nullptr);
+        else throw std::invalid_argument("unknown allocator: " + name);
+        return;
+      }
+      if (!PyCapsule_IsValid(allocator.ptr(), ALLOCATOR_CAPSULE_NAME)) {
+        throw std::invalid_argument(std::string("allocator must be 'system', 'pool' or a capsule named ")
+          + ALLOCATOR_CAPSULE_NAME);
+      }
+      const allocator_hook* hook = static_cast<const allocator_hook*>(PyCapsule_GetPointer(allocator.ptr(), ALLOCATOR_CAPSULE_NAME));
+      if (hook->allocate == nullptr || hook->deallocate == nullptr) {
+        throw std::invalid_argument("allocator capsule must provide allocate and deallocate functions");
+      }
+      set_mode(EXTERNAL_ALLOCATOR, allocator, hook);
+    },
+    nb::arg("allocator"),
+    "Sets the allocator used by the native sketch containers (vectors of sketches and sketch maps). "
+    "'system' uses malloc, and 'pool' a pool of size classes carved from 64 KiB chunks, which reduces "
+    "allocation overhead and fragmentation for many small sketches. Native code may also pass a capsule "
+    "named 'datasketches.allocator' pointing to a struct of allocate(size, context) and "
+    "deallocate(ptr, size, context) functions and a context pointer, such as an arena. "
+    "The allocator can only be changed while no memory allocated through it is in use.\n\n"
+    ":param allocator: 'system', 'pool' or an allocator capsule\n:type allocator: str or capsule"
+  );
+}
@@ -0,0 +1,240 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+
+#include "hll.hpp"
+#include "theta_sketch.hpp"
+#include "theta_union.hpp"
+#include "cpc_sketch.hpp"
+#include "cpc_union.hpp"
+#include "kll_sketch.hpp"
+#include "tdigest.hpp"
+#include "common_defs.hpp"
+#include "py_buffer.hpp"
+#include "gil_guard.hpp"
+#include "parallel.hpp"
+#include "hll8_registers.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+// Holds a buffer view on each serialized image for the duration of a
+// reduction, so the images can be read without the GIL and without copying.
+class serialized_images {
+  public:
+    explicit serialized_images(nb::iterable images) {
+      for (nb::handle image: images) {
+        buffers_.emplace_back(new py_buffer(image, PyBUF_SIMPLE));
+      }
+    }
+
+    size_t size() const { return buffers_.size(); }
+    const uint8_t* data(size_t i) const { return buffers_[i]->data(); }
+    size_t size(size_t i) const { return buffers_[i]->size(); }
+
+  private:
+    std::vector<std::unique_ptr<py_buffer>> buffers_;
+};
+
+// Folds every image into an accumulator in native threads with the GIL released.
+template<typename Make, typename Fold, typename Combine>
+auto reduce_images(const serialized_images& images, unsigned num_threads,
+                   Make&& make, Fold&& fold, Combine&& combine) -> decltype(make()) {
+  if (images.size() == 0) return make();
+  return call_without_gil([&] {
+    return parallel_reduce(images.size(), num_threads, make,
+      [&images, &fold](auto& acc, size_t i) { fold(acc, images.data(i), images.size(i)); },
+      combine);
+  });
+}
+
+// The partial union of a thread: the register-wise max of the dense HLL_8 images
+// of lg_max_k, read in place, and a union of every other image.
+struct hll_partial_union {
+  std::vector<uint8_t> registers; // empty until the first dense HLL_8 image
+  hll_union rest;
+  bool has_rest;
+
+  void max_registers(const uint8_t* other, size_t k) {
+    if (registers.empty()) registers.assign(other, other + k);
+    else hll8_max_registers(registers.data(), other, k);
+  }
+};
+
+// Same result as updating an hll_union with every image. To be called without the GIL.
+hll_sketch merge_hll_images(const serialized_images& images, uint8_t lg_max_k, target_hll_type tgt_type, unsigned num_threads) {
+  hll_union empty(lg_max_k);
+  if (images.size() == 0) return empty.get_result(tgt_type);
+  const size_t k = size_t(1) << lg_max_k;
+  hll_partial_union result = parallel_reduce(images.size(), num_threads,
+    [lg_max_k] { return hll_partial_union{{}, hll_union(lg_max_k), false}; },
+    [&images, lg_max_k, k](hll_partial_union& acc, size_t i) {
+      const uint8_t* registers = hll8_image::dense_registers(images.data(i), images.size(i), lg_max_k);
+      if (registers != nullptr) {
+        acc.max_registers(registers, k);
+      } else {
+        acc.rest.update(hll_sketch::deserialize(images.data(i), images.size(i)));
+        acc.has_rest = true;
+      }
+    },
+    [k](hll_partial_union& acc, hll_partial_union& other) {
+      if (!other.registers.empty()) acc.max_registers(other.registers.data(), k);
+      if (other.has_rest) {
+        acc.rest.update(other.rest.get_result(HLL_8));
+        acc.has_rest = true;
+      }
+    });
+  if (result.registers.empty()) return result.rest.get_result(tgt_type);
+
+  // a union result is out of order, so its estimate is computed from these sums alone
+  const hll8_register_stats stats = hll8_accumulate(result.registers.data(), k);
+  const auto image = hll8_image::make(lg_max_k, result.registers.data(), stats);
+  hll_sketch merged = hll_sketch::deserialize(image.data(), image.size());
+  if (!result.has_rest && tgt_type == HLL_8) return merged;
+  result.rest.update(merged);
+  return result.rest.get_result(tgt_type);
+}
+
+template<typename T>
+void bind_kll_merge(nb::module_& m, const char* name) {
+  m.def(name,
+    [](nb::iterable images, uint16_t k, unsigned num_threads) {
+      serialized_images imgs(images);
+      return reduce_images(imgs, num_threads,
+        [k] { return kll_sketch<T>(k); },
+        [](kll_sketch<T>& acc, const uint8_t* data, size_t size) { acc.merge(kll_sketch<T>::deserialize(data, size)); },
+        [](kll_sketch<T>& acc, kll_sketch<T>& other) { acc.merge(std::move(other)); });
+    },
+    nb::arg("images"), nb::arg("k")=kll_constants::DEFAULT_K, nb::arg("num_threads")=0,
+    "Deserializes and merges a list of serialized KLL sketch images of the matching item type "
+    "using native threads, returning the merged sketch.\n\n"
+    ":param images: The serialized sketches, as bytes or any other buffer\n:type images: list\n"
+    ":param k: The parameter k of the resulting sketch. Default is 200.\n:type k: int, optional\n"
+    ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+    ":type num_threads: int, optional\n"
+    ":return: The merged sketch"
+  );
+}
+
+template<typename T>
+void bind_tdigest_merge(nb::module_& m, const char* name) {
+  m.def(name,
+    [](nb::iterable images, uint16_t k, unsigned num_threads) {
+      serialized_images imgs(images);
+      return reduce_images(imgs, num_threads,
+        [k] { return tdigest<T>(k); },
+        [](tdigest<T>& acc, const uint8_t* data, size_t size) {
+          auto sk = tdigest<T>::deserialize(data, size);
+          acc.merge(sk);
+        },
+        [](tdigest<T>& acc, tdigest<T>& other) { acc.merge(other); });
+    },
+    nb::arg("images"), nb::arg("k")=tdigest<T>::DEFAULT_K, nb::arg("num_threads")=0,
+    "Deserializes and merges a list of serialized t-digest images of the matching item type "
+    "using native threads, returning the merged sketch.\n\n"
+    ":param images: The serialized sketches, as bytes or any other buffer\n:type images: list\n"
+    ":param k: The parameter k of the resulting sketch. Default is 200.\n:type k: int, optional\n"
+    ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+    ":type num_threads: int, optional\n"
+    ":return: The merged sketch"
+  );
+}
+
+} // namespace datasketches
+
+void init_merge(nb::module_& m) {
+  using namespace datasketches;
+
+  m.def("merge_hll",
+    [](nb::iterable images, uint8_t lg_max_k, target_hll_type tgt_type, unsigned num_threads) {
+      serialized_images imgs(images);
+      return call_without_gil([&imgs, lg_max_k, tgt_type, num_threads] {
+        return merge_hll_images(imgs, lg_max_k, tgt_type, num_threads);
+      });
+    },
+    nb::arg("images"), nb::arg("lg_max_k"), nb::arg("tgt_type")=HLL_8, nb::arg("num_threads")=0,
+    "Deserializes and merges a list of serialized :class:`hll_sketch` images using native threads, "
+    "with the same result as updating an :class:`hll_union` with each of them. "
+    "Images of HLL_8 sketches in HLL mode with lg_k equal to lg_max_k are read in place and merged "
+    "register-wise with SIMD instructions where the CPU supports them (AVX2 or NEON).\n\n"
+    ":param images: The serialized sketches, as bytes or any other buffer\n:type images: list\n"
+    ":param lg_max_k: The maximum value of log2 K for the union\n:type lg_max_k: int\n"
+    ":param tgt_type: The HLL mode of the resulting sketch. Default is HLL_8.\n:type tgt_type: :class:`tgt_hll_type`, optional\n"
+    ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+    ":type num_threads: int, optional\n"
+    ":return: The merged sketch\n:rtype: :class:`hll_sketch`"
+  );
+
+  m.def("merge_theta",
+    [](nb::iterable images, uint8_t lg_k, uint64_t seed, bool ordered, unsigned num_threads) {
+      serialized_images imgs(images);
+      theta_union u = reduce_images(imgs, num_threads,
+        [lg_k, seed] { return theta_union::builder().set_lg_k(lg_k).set_seed(seed).build(); },
+        [seed](theta_union& acc, const uint8_t* data, size_t size) {
+          acc.update(wrapped_compact_theta_sketch::wrap(data, size, seed));
+        },
+        [](theta_union& acc, theta_union& other) { acc.update(other.get_result(false)); });
+      return call_without_gil([&u, ordered] { return u.get_result(ordered); });
+    },
+    nb::arg("images"), nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("seed")=DEFAULT_SEED,
+    nb::arg("ordered")=true, nb::arg("num_threads")=0,
+    "Merges a list of serialized :class:`compact_theta_sketch` images using native threads, "
+    "with the same result as updating a :class:`theta_union` with each of them. "
+    "Images are read in place without being deserialized.\n\n"
+    ":param images: The serialized sketches, as bytes or any other buffer\n:type images: list\n"
+    ":param lg_k: base 2 logarithm of the maximum size of the union. Default is 12.\n:type lg_k: int, optional\n"
+    ":param seed: The seed used to build the sketches\n:type seed: int, optional\n"
+    ":param ordered: Whether to sort the entries of the result. Default is True.\n:type ordered: bool, optional\n"
+    ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+    ":type num_threads: int, optional\n"
+    ":return: The merged sketch\n:rtype: :class:`compact_theta_sketch`"
+  );
+
+  m.def("merge_cpc",
+    [](nb::iterable images, uint8_t lg_k, uint64_t seed, unsigned num_threads) {
+      serialized_images imgs(images);
+      cpc_union u = reduce_images(imgs, num_threads,
+        [lg_k, seed] { return cpc_union(lg_k, seed); },
+        [seed](cpc_union& acc, const uint8_t* data, size_t size) { acc.update(cpc_sketch::deserialize(data, size, seed)); },
+        [](cpc_union& acc, cpc_union& other) { acc.update(other.get_result()); });
+      return call_without_gil([&u] { return u.get_result(); });
+    },
+    nb::arg("images"), nb::arg("lg_k")=cpc_constants::DEFAULT_LG_K, nb::arg("seed")=DEFAULT_SEED, nb::arg("num_threads")=0,
+    "Deserializes and merges a list of serialized :class:`cpc_sketch` images using native threads, "
+    "with the same result as updating a :class:`cpc_union` with each of them.\n\n"
+    ":param images: The serialized sketches, as bytes or any other buffer\n:type images: list\n"
+    ":param lg_k: base 2 logarithm of the number of bins in the union. Default is 11.\n:type lg_k: int, optional\n"
+    ":param seed: The seed used to build the sketches\n:type seed: int, optional\n"
+    ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+    ":type num_threads: int, optional\n"
+    ":return: The merged sketch\n:rtype: :class:`cpc_sketch`"
+  );
+
+  bind_kll_merge<int>(m, "merge_kll_ints");
+  bind_kll_merge<float>(m, "merge_kll_floats");
+  bind_kll_merge<double>(m, "merge_kll_doubles");
+
+  bind_tdigest_merge<float>(m, "merge_tdigest_float");
+  bind_tdigest_merge<double>(m, "merge_tdigest_double");
+}
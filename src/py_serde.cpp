@@ -18,17 +18,180 @@
  */
 
 #include <cstring>
+#include <stdexcept>
 #include "memory_operations.hpp"
 
+#include "py_buffer.hpp"
 #include "py_serde.hpp"
+#include "sketch_stats.hpp"
 
 #include <nanobind/nanobind.h>
 
 namespace nb = nanobind;
 
+namespace datasketches {
+
+/*
+  Native serdes for common item types. Each processes whole arrays of items
+  in C++, never calling back into Python methods per item. The binary
+  formats match the corresponding Python reference serdes in PySerDe.py and
+  the serdes in the C++ and Java libraries.
+*/
+
+// numeric items written as fixed-width little-endian values
+template<typename V>
+struct fixed_width_serde: public py_object_serde {
+  int64_t get_size(const nb::object&) const override { return sizeof(V); }
+
+  nb::bytes to_bytes(const nb::object& item) const override {
+    char out[sizeof(V)];
+    store_le(out, nb::cast<V>(item));
+    return nb::bytes(out, sizeof(V));
+  }
+
+  nb::tuple from_bytes(nb::bytes& bytes, size_t offset) const override {
+    check_memory_size(offset + sizeof(V), bytes.size());
+    return nb::make_tuple(load_le<V>(bytes.c_str() + offset), sizeof(V));
+  }
+
+  size_t size_of_item(const nb::object&) const override { return sizeof(V); }
+
+  size_t serialize(void* ptr, size_t capacity, const nb::object* items, unsigned num) const override {
+    check_memory_size(static_cast<size_t>(num) * sizeof(V), capacity);
+    nb::gil_scoped_acquire acquire;
+    char* out = static_cast<char*>(ptr);
+    for (unsigned i = 0; i < num; ++i) {
+      store_le(out + i * sizeof(V), nb::cast<V>(items[i]));
+    }
+    return static_cast<size_t>(num) * sizeof(V);
+  }
+
+  void serialize(std::ostream& os, const nb::object* items, unsigned num) const override {
+    nb::gil_scoped_acquire acquire;
+    for (unsigned i = 0; i < num; ++i) {
+      char out[sizeof(V)];
+      store_le(out, nb::cast<V>(items[i]));
+      os.write(out, sizeof(V));
+    }
+  }
+
+  size_t deserialize(const void* ptr, size_t capacity, nb::object* items, unsigned num) const override {
+    check_memory_size(static_cast<size_t>(num) * sizeof(V), capacity);
+    nb::gil_scoped_acquire acquire;
+    const char* in = static_cast<const char*>(ptr);
+    for (unsigned i = 0; i < num; ++i) {
+      new (&items[i]) nb::object(nb::cast(load_le<V>(in + i * sizeof(V))));
+    }
+    return static_cast<size_t>(num) * sizeof(V);
+  }
+};
+
+// str (as UTF-8) or bytes items written as a 4-byte little-endian length followed by the contents
+template<bool IsStr>
+struct length_prefixed_serde: public py_object_serde {
+  static const char* contents(const nb::object& item, size_t& size) {
+    Py_ssize_t length;
+    const char* data;
+    if constexpr (IsStr) {
+      data = PyUnicode_AsUTF8AndSize(item.ptr(), &length);
+      if (data == nullptr) throw nb::python_error();
+    } else {
+      char* buf;
+      if (PyBytes_AsStringAndSize(item.ptr(), &buf, &length) != 0) throw nb::python_error();
+      data = buf;
+    }
+    size = static_cast<size_t>(length);
+    if (size > UINT32_MAX) throw std::length_error("item too large to serialize");
+    return data;
+  }
+
+  static nb::object make_item(const char* data, size_t size) {
+    PyObject* obj = IsStr ? PyUnicode_DecodeUTF8(data, static_cast<Py_ssize_t>(size), nullptr)
+                          : PyBytes_FromStringAndSize(data, static_cast<Py_ssize_t>(size));
+    if (obj == nullptr) throw nb::python_error();
+    return nb::steal(obj);
+  }
+
+  int64_t get_size(const nb::object& item) const override { return size_of_item(item); }
+
+  nb::bytes to_bytes(const nb::object& item) const override {
+    size_t size;
+    const char* data = contents(item, size);
+    std::string out(sizeof(uint32_t) + size, '\0');
+    store_le(&out[0], static_cast<uint32_t>(size));
+    std::memcpy(&out[sizeof(uint32_t)], data, size);
+    return nb::bytes(out.data(), out.size());
+  }
+
+  nb::tuple from_bytes(nb::bytes& bytes, size_t offset) const override {
+    check_memory_size(offset + sizeof(uint32_t), bytes.size());
+    const uint32_t length = load_le<uint32_t>(bytes.c_str() + offset);
+    check_memory_size(offset + sizeof(length) + length, bytes.size());
+    return nb::make_tuple(make_item(bytes.c_str() + offset + sizeof(length), length), sizeof(length) + length);
+  }
+
+  size_t size_of_item(const nb::object& item) const override {
+    nb::gil_scoped_acquire acquire;
+    size_t size;
+    contents(item, size);
+    return sizeof(uint32_t) + size;
+  }
+
+  size_t serialize(void* ptr, size_t capacity, const nb::object* items, unsigned num) const override {
+    nb::gil_scoped_acquire acquire;
+    char* out = static_cast<char*>(ptr);
+    size_t bytes_written = 0;
+    for (unsigned i = 0; i < num; ++i) {
+      size_t size;
+      const char* data = contents(items[i], size);
+      check_memory_size(bytes_written + sizeof(uint32_t) + size, capacity);
+      store_le(out + bytes_written, static_cast<uint32_t>(size));
+      std::memcpy(out + bytes_written + sizeof(uint32_t), data, size);
+      bytes_written += sizeof(uint32_t) + size;
+    }
+    return bytes_written;
+  }
+
+  void serialize(std::ostream& os, const nb::object* items, unsigned num) const override {
+    nb::gil_scoped_acquire acquire;
+    for (unsigned i = 0; i < num; ++i) {
+      size_t size;
+      const char* data = contents(items[i], size);
+      char length[sizeof(uint32_t)];
+      store_le(length, static_cast<uint32_t>(size));
+      os.write(length, sizeof(length));
+      os.write(data, size);
+    }
+  }
+
+  size_t deserialize(const void* ptr, size_t capacity, nb::object* items, unsigned num) const override {
+    nb::gil_scoped_acquire acquire;
+    const char* in = static_cast<const char*>(ptr);
+    size_t bytes_read = 0;
+    unsigned i = 0;
+    try {
+      for (; i < num; ++i) {
+        check_memory_size(bytes_read + sizeof(uint32_t), capacity);
+        const uint32_t length = load_le<uint32_t>(in + bytes_read);
+        bytes_read += sizeof(uint32_t);
+        check_memory_size(bytes_read + length, capacity);
+        new (&items[i]) nb::object(make_item(in + bytes_read, length));
+        bytes_read += length;
+      }
+    } catch (...) {
+      // clean up what we've allocated
+      for (unsigned j = 0; j < i; ++j) items[j].dec_ref();
+      throw;
+    }
+    return bytes_read;
+  }
+};
+
+} // namespace datasketches
+
 void init_serde(nb::module_& m) {
   using namespace datasketches;
-  nb::class_<py_object_serde, PyObjectSerDe /* <--- trampoline*/>(m, "PyObjectSerDe",
+  auto serde_class = nb::class_<py_object_serde, PyObjectSerDe /* <--- trampoline*/>(m, "PyObjectSerDe",
     "An abstract base class for serde objects. All custom serdes must extend this class.")
     .def(nb::init<>())
     .def("get_size", &py_object_serde::get_size, nb::arg("item"),
@@ -50,18 +213,48 @@ void init_serde(nb::module_& m) {
         ":rtype: tuple(object, int)"
         )
     ;
+  add_stats(serde_class);
+
+  nb::class_<fixed_width_serde<int32_t>, py_object_serde>(m, "IntsSerDe",
+    "A native serde writing each integer as a 32-bit little-endian value, compatible with PyIntsSerDe. "
+    "Items are processed in C++ without calling Python methods.")
+    .def(nb::init<>());
+  nb::class_<fixed_width_serde<int64_t>, py_object_serde>(m, "LongsSerDe",
+    "A native serde writing each integer as a 64-bit little-endian value, compatible with PyLongsSerDe. "
+    "Items are processed in C++ without calling Python methods.")
+    .def(nb::init<>());
+  nb::class_<fixed_width_serde<float>, py_object_serde>(m, "FloatsSerDe",
+    "A native serde writing each value as a 32-bit floating point value, compatible with PyFloatsSerDe. "
+    "Items are processed in C++ without calling Python methods.")
+    .def(nb::init<>());
+  nb::class_<fixed_width_serde<double>, py_object_serde>(m, "DoublesSerDe",
+    "A native serde writing each value as a 64-bit floating point value, compatible with PyDoublesSerDe. "
+    "Items are processed in C++ without calling Python methods.")
+    .def(nb::init<>());
+  nb::class_<length_prefixed_serde<true>, py_object_serde>(m, "StringsSerDe",
+    "A native serde writing each str as a 4-byte little-endian length followed by its UTF-8 encoding, "
+    "compatible with PyStringsSerDe and the C++ and Java string serdes. "
+    "Items are processed in C++ without calling Python methods.")
+    .def(nb::init<>());
+  nb::class_<length_prefixed_serde<false>, py_object_serde>(m, "BytesSerDe",
+    "A native serde writing each bytes object as a 4-byte little-endian length followed by its contents. "
+    "Items are processed in C++ without calling Python methods.")
+    .def(nb::init<>());
 }    
 
 namespace datasketches {
   size_t py_object_serde::size_of_item(const nb::object& item) const {
-    return get_size(item);
+    nb::gil_scoped_acquire acquire;
+    serde_stats_probe<py_object_serde> stats(*this);
+    return stats.call([&] { return get_size(item); });
   }
 
   size_t py_object_serde::serialize(void* ptr, size_t capacity, const nb::object* items, unsigned num) const {
     size_t bytes_written = 0;
     nb::gil_scoped_acquire acquire;
+    serde_stats_probe<py_object_serde> stats(*this);
     for (unsigned i = 0; i < num; ++i) {
-      nb::bytes bytes = to_bytes(items[i]); // implicit cast from nb::bytes
+      nb::bytes bytes = stats.call([&] { return to_bytes(items[i]); }); // implicit cast from nb::bytes
       check_memory_size(bytes_written + bytes.size(), capacity);
       memcpy(ptr, bytes.c_str(), bytes.size());
       ptr = static_cast<char*>(ptr) + bytes.size();
@@ -71,6 +264,15 @@ namespace datasketches {
     return bytes_written;
   }
 
+  void py_object_serde::serialize(std::ostream& os, const nb::object* items, unsigned num) const {
+    nb::gil_scoped_acquire acquire;
+    serde_stats_probe<py_object_serde> stats(*this);
+    for (unsigned i = 0; i < num; ++i) {
+      nb::bytes bytes = stats.call([&] { return to_bytes(items[i]); });
+      os.write(bytes.c_str(), bytes.size());
+    }
+  }
+
   size_t py_object_serde::deserialize(const void* ptr, size_t capacity, nb::object* items, unsigned num) const {
     size_t bytes_read = 0;
     unsigned i = 0;
@@ -80,10 +282,11 @@ namespace datasketches {
 
     // copy data into bytes only once
     nb::bytes bytes(static_cast<const char*>(ptr), capacity);
+    serde_stats_probe<py_object_serde> stats(*this);
     for (; i < num && !failure; ++i) {
       nb::tuple bytes_and_len;
       try {
-        bytes_and_len = from_bytes(bytes, bytes_read);
+        bytes_and_len = stats.call([&] { return from_bytes(bytes, bytes_read); });
       } catch (nb::python_error &e) {
         failure = true;
         error_from_python = true;
@@ -28,16 +28,22 @@
 #include "py_object_lt.hpp"
 #include "py_object_ostream.hpp"
 #include "quantile_conditional.hpp"
+#include "sorted_view.hpp"
 #include "quantiles_sketch.hpp"
 
 
 namespace nb = nanobind;
 
 template<typename T, typename C>
-void bind_quantiles_sketch(nb::module_ &m, const char* name) {
+void bind_quantiles_sketch(nb::module_ &m, const char* name, const char* view_name) {
   using namespace datasketches;
 
-  auto quantiles_class = nb::class_<quantiles_sketch<T, C>>(m, name)
+  auto quantiles_class = nb::class_<quantiles_sketch<T, C>>(m, name);
+
+  // the NumPy array queries must be registered before the list versions
+  add_vector_queries<T>(quantiles_class);
+
+  quantiles_class
     .def(nb::init<uint16_t>(), nb::arg("k")=quantiles_constants::DEFAULT_K,
          "Creates a classic quantiles sketch instance with the given value of k.\n\n"
          ":param k: Controls the size/accuracy trade-off of the sketch. Default is 128.\n"
@@ -46,15 +52,15 @@ void bind_quantiles_sketch(nb::module_ &m, const char* name) {
     .def("__copy__", [](const quantiles_sketch<T, C>& sk) { return quantiles_sketch<T,C>(sk); })
     .def(
         "update",
-        static_cast<void (quantiles_sketch<T, C>::*)(const T&)>(&quantiles_sketch<T, C>::update),
+        counted_update(static_cast<void (quantiles_sketch<T, C>::*)(const T&)>(&quantiles_sketch<T, C>::update)),
         nb::arg("item"),
         "Updates the sketch with the given value"
     )
-    .def("merge", (void (quantiles_sketch<T, C>::*)(const quantiles_sketch<T, C>&)) &quantiles_sketch<T, C>::merge, nb::arg("sketch"),
+    .def("merge", (void (quantiles_sketch<T, C>::*)(const quantiles_sketch<T, C>&)) &quantiles_sketch<T, C>::merge, nb::arg("sketch"), release_gil_guard<T>(),
          "Merges the provided sketch into this one")
     .def("__str__", [](const quantiles_sketch<T, C>& sk) { return sk.to_string(); },
          "Produces a string summary of the sketch")
-    .def("to_string", &quantiles_sketch<T, C>::to_string, nb::arg("print_levels")=false, nb::arg("print_items")=false,
+    .def("to_string", &quantiles_sketch<T, C>::to_string, nb::arg("print_levels")=false, nb::arg("print_items")=false, release_gil_guard<T>(),
          "Produces a string summary of the sketch")
     .def("is_empty", &quantiles_sketch<T, C>::is_empty,
          "Returns True if the sketch is empty, otherwise False")
@@ -163,12 +169,15 @@ void bind_quantiles_sketch(nb::module_ &m, const char* name) {
      ;
 
     add_serialization<T>(quantiles_class);
+    add_serialized_size<T>(quantiles_class);
     add_vector_update<T>(quantiles_class);
+    add_stats(quantiles_class);
+    add_sorted_view<T>(m, quantiles_class, view_name);
 }
 
 void init_quantiles(nb::module_ &m) {
-  bind_quantiles_sketch<int, std::less<int>>(m, "quantiles_ints_sketch");
-  bind_quantiles_sketch<float, std::less<float>>(m, "quantiles_floats_sketch");
-  bind_quantiles_sketch<double, std::less<double>>(m, "quantiles_doubles_sketch");
-  bind_quantiles_sketch<nb::object, py_object_lt>(m, "quantiles_items_sketch");
+  bind_quantiles_sketch<int, std::less<int>>(m, "quantiles_ints_sketch", "quantiles_ints_sorted_view");
+  bind_quantiles_sketch<float, std::less<float>>(m, "quantiles_floats_sketch", "quantiles_floats_sorted_view");
+  bind_quantiles_sketch<double, std::less<double>>(m, "quantiles_doubles_sketch", "quantiles_doubles_sorted_view");
+  bind_quantiles_sketch<nb::object, py_object_lt>(m, "quantiles_items_sketch", "quantiles_items_sorted_view");
 }
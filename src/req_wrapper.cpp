@@ -28,15 +28,21 @@
 #include "py_object_lt.hpp"
 #include "py_object_ostream.hpp"
 #include "quantile_conditional.hpp"
+#include "sorted_view.hpp"
 #include "req_sketch.hpp"
 
 namespace nb = nanobind;
 
 template<typename T, typename C>
-void bind_req_sketch(nb::module_ &m, const char* name) {
+void bind_req_sketch(nb::module_ &m, const char* name, const char* view_name) {
   using namespace datasketches;
 
-  auto req_class = nb::class_<req_sketch<T, C>>(m, name)
+  auto req_class = nb::class_<req_sketch<T, C>>(m, name);
+
+  // the NumPy array queries must be registered before the list versions
+  add_vector_queries<T>(req_class);
+
+  req_class
     .def(nb::init<uint16_t, bool>(), nb::arg("k")=12, nb::arg("is_hra")=true,
          "Creates an REQ sketch instance with the given value of k.\n\n"
          ":param k: Controls the size/accuracy trade-off of the sketch. Default is 12.\n"
@@ -45,13 +51,13 @@ void bind_req_sketch(nb::module_ &m, const char* name) {
          ":type is_hra: bool, optional"
     )
     .def("__copy__", [](const req_sketch<T, C>& sk){ return req_sketch<T, C>(sk); })
-    .def("update", (void (req_sketch<T, C>::*)(const T&)) &req_sketch<T, C>::update, nb::arg("item"),
+    .def("update", counted_update(static_cast<void (req_sketch<T, C>::*)(const T&)>(&req_sketch<T, C>::update)), nb::arg("item"),
         "Updates the sketch with the given value")
-    .def("merge", (void (req_sketch<T, C>::*)(const req_sketch<T, C>&)) &req_sketch<T, C>::merge, nb::arg("sketch"),
+    .def("merge", (void (req_sketch<T, C>::*)(const req_sketch<T, C>&)) &req_sketch<T, C>::merge, nb::arg("sketch"), release_gil_guard<T>(),
         "Merges the provided sketch into this one")
     .def("__str__", [](const req_sketch<T, C>& sk) { return sk.to_string(); },
         "Produces a string summary of the sketch")
-    .def("to_string", &req_sketch<T, C>::to_string, nb::arg("print_levels")=false, nb::arg("print_items")=false,
+    .def("to_string", &req_sketch<T, C>::to_string, nb::arg("print_levels")=false, nb::arg("print_items")=false, release_gil_guard<T>(),
         "Produces a string summary of the sketch")
     .def("is_hra", &req_sketch<T, C>::is_HRA,
         "Returns True if the sketch is in High Rank Accuracy mode, otherwise False")
@@ -164,11 +170,14 @@ void bind_req_sketch(nb::module_ &m, const char* name) {
     ;
 
     add_serialization<T>(req_class);
+    add_serialized_size<T>(req_class);
     add_vector_update<T>(req_class);
+    add_stats(req_class);
+    add_sorted_view<T>(m, req_class, view_name);
 }
 
 void init_req(nb::module_ &m) {
-  bind_req_sketch<int, std::less<int>>(m, "req_ints_sketch");
-  bind_req_sketch<float, std::less<float>>(m, "req_floats_sketch");
-  bind_req_sketch<nb::object, py_object_lt>(m, "req_items_sketch");
+  bind_req_sketch<int, std::less<int>>(m, "req_ints_sketch", "req_ints_sorted_view");
+  bind_req_sketch<float, std::less<float>>(m, "req_floats_sketch", "req_floats_sorted_view");
+  bind_req_sketch<nb::object, py_object_lt>(m, "req_items_sketch", "req_items_sorted_view");
 }
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/pair.h>
+
+#include "sketch_families.hpp"
+#include "sketch_map.hpp"
+
+namespace nb = nanobind;
+
+namespace {
+
+using namespace datasketches;
+
+void bind_hll_sketch_map(nb::module_& m) {
+  using SM = sketch_map<hll_family>;
+  auto clazz = bind_sketch_map<hll_family>(m, "hll_sketch_map",
+      "A native map from int64 keys to HLL sketches, for distinct counting grouped by key");
+  clazz
+    .def(
+      "__init__",
+      [](SM* sm, uint8_t lg_k, target_hll_type tgt_type) {
+        new (sm) SM(hll_family::params_type{lg_k, tgt_type});
+      },
+      nb::arg("lg_k"), nb::arg("tgt_type")=HLL_8,
+      "Creates a new empty map of HLL sketches.\n\n"
+      ":param lg_k: The value of lg_k for every sketch in the map, between 7 and 21, inclusive\n:type lg_k: int\n"
+      ":param tgt_type: The HLL mode of every sketch in the map\n:type tgt_type: tgt_hll_type"
+    )
+    .def_prop_ro("lg_k", [](const SM& sm) { return sm.get_params().lg_k; },
+         "The value of `lg_k` of the sketches")
+    .def(
+      "estimates",
+      [](const SM& sm) {
+        return std::make_pair(sm.keys_array(), sm.query<double>([](const hll_family::sketch_type& sk) { return sk.get_estimate(); }));
+      },
+      "Returns a tuple of NumPy arrays (keys, estimates) holding every key and the distinct count estimate of its sketch"
+    )
+    .def(
+      "lower_bounds",
+      [](const SM& sm, uint8_t num_std_devs) {
+        return std::make_pair(sm.keys_array(), sm.query<double>([num_std_devs](const hll_family::sketch_type& sk) { return sk.get_lower_bound(num_std_devs); }));
+      },
+      nb::arg("num_std_devs"),
+      "Returns a tuple of NumPy arrays (keys, bounds) holding every key and the approximate lower error bound of its sketch "
+      "given the number of standard deviations in {1, 2, 3}"
+    )
+    .def(
+      "upper_bounds",
+      [](const SM& sm, uint8_t num_std_devs) {
+        return std::make_pair(sm.keys_array(), sm.query<double>([num_std_devs](const hll_family::sketch_type& sk) { return sk.get_upper_bound(num_std_devs); }));
+      },
+      nb::arg("num_std_devs"),
+      "Returns a tuple of NumPy arrays (keys, bounds) holding every key and the approximate upper error bound of its sketch "
+      "given the number of standard deviations in {1, 2, 3}"
+    );
+
+  const char* update_doc = "Updates the sketch of keys[i] with values[i] for each i, given two NumPy arrays of equal length. "
+    "Sketches are created for new keys. NaN values are skipped.";
+  add_sketch_map_update<int64_t>(clazz, update_doc);
+  add_sketch_map_update<double>(clazz, update_doc);
+}
+
+void bind_kll_sketch_map(nb::module_& m) {
+  using SM = sketch_map<kll_doubles_family>;
+  auto clazz = bind_sketch_map<kll_doubles_family>(m, "kll_sketch_map",
+      "A native map from int64 keys to KLL sketches of doubles, for quantiles grouped by key");
+  clazz
+    .def(
+      "__init__",
+      [](SM* sm, uint16_t k) {
+        new (sm) SM(kll_doubles_family::params_type{k});
+      },
+      nb::arg("k")=kll_constants::DEFAULT_K,
+      "Creates a new empty map of KLL sketches of doubles.\n\n"
+      ":param k: The value of k for every sketch in the map. Default is 200.\n:type k: int, optional"
+    )
+    .def_prop_ro("k", [](const SM& sm) { return sm.get_params().k; },
+         "The value of `k` of the sketches")
+    .def(
+      "counts",
+      [](const SM& sm) {
+        return std::make_pair(sm.keys_array(), sm.query<uint64_t>([](const kll_doubles_family::sketch_type& sk) { return sk.get_n(); }));
+      },
+      "Returns a tuple of NumPy arrays (keys, counts) holding every key and the number of values seen by its sketch"
+    )
+    .def(
+      "quantiles",
+      [](const SM& sm, nb::ndarray<double> ranks, bool inclusive) {
+        auto r = view_1d(ranks);
+        std::vector<double> rank_values(r.shape(0));
+        for (size_t j = 0; j < rank_values.size(); ++j) {
+          if (!(r(j) >= 0.0 && r(j) <= 1.0)) {
+            throw std::invalid_argument("normalized rank cannot be less than zero or greater than 1.0");
+          }
+          rank_values[j] = r(j);
+        }
+        auto quantiles = sm.query_rows<double>(rank_values.size(), [&](const kll_doubles_family::sketch_type& sk, double* out) {
+          for (size_t j = 0; j < rank_values.size(); ++j) {
+            out[j] = sk.is_empty() ? std::numeric_limits<double>::quiet_NaN() : sk.get_quantile(rank_values[j], inclusive);
+          }
+        });
+        return std::make_pair(sm.keys_array(), std::move(quantiles));
+      },
+      nb::arg("ranks"), nb::arg("inclusive")=false,
+      "Returns a tuple (keys, quantiles) of a NumPy array of every key and a 2D NumPy array with a row per key "
+      "of the quantiles of its sketch at the given normalized ranks, or NaN for an empty sketch"
+    )
+    .def(
+      "ranks",
+      [](const SM& sm, nb::ndarray<double> values, bool inclusive) {
+        auto v = view_1d(values);
+        std::vector<double> items(v.shape(0));
+        for (size_t j = 0; j < items.size(); ++j) items[j] = v(j);
+        auto ranks = sm.query_rows<double>(items.size(), [&](const kll_doubles_family::sketch_type& sk, double* out) {
+          for (size_t j = 0; j < items.size(); ++j) {
+            out[j] = sk.is_empty() ? std::numeric_limits<double>::quiet_NaN() : sk.get_rank(items[j], inclusive);
+          }
+        });
+        return std::make_pair(sm.keys_array(), std::move(ranks));
+      },
+      nb::arg("values"), nb::arg("inclusive")=false,
+      "Returns a tuple (keys, ranks) of a NumPy array of every key and a 2D NumPy array with a row per key "
+      "of the normalized rank of each of the given values in its sketch, or NaN for an empty sketch"
+    );
+
+  add_sketch_map_update<double>(clazz,
+    "Updates the sketch of keys[i] with values[i] for each i, given two NumPy arrays of equal length. "
+    "Sketches are created for new keys. NaN values are skipped.");
+}
+
+} // namespace
+
+void init_sketch_map(nb::module_& m) {
+  bind_hll_sketch_map(m);
+  bind_kll_sketch_map(m);
+}
@@ -0,0 +1,210 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+
+#include "sketch_families.hpp"
+#include "sketch_ring.hpp"
+
+namespace nb = nanobind;
+
+namespace {
+
+using namespace datasketches;
+
+template<typename Family, typename E>
+void add_estimate_queries(nb::class_<sketch_ring<Family>>& clazz, E estimate) {
+  using SR = sketch_ring<Family>;
+  clazz
+    .def(
+      "get_estimate",
+      [estimate](SR& sr, std::optional<uint32_t> window) {
+        return estimate(sr.get_params(), sr.window(window)).get_estimate();
+      },
+      nb::arg("window")=nb::none(),
+      "Returns the distinct count estimate over the latest buckets.\n\n"
+      ":param window: The number of latest buckets, the current one included (default: all buckets)\n"
+      ":type window: int, optional"
+    )
+    .def(
+      "get_lower_bound",
+      [estimate](SR& sr, uint8_t num_std_devs, std::optional<uint32_t> window) {
+        return estimate(sr.get_params(), sr.window(window)).get_lower_bound(num_std_devs);
+      },
+      nb::arg("num_std_devs"), nb::arg("window")=nb::none(),
+      "Returns the approximate lower error bound over the latest buckets given the number of standard deviations "
+      "in {1, 2, 3}"
+    )
+    .def(
+      "get_upper_bound",
+      [estimate](SR& sr, uint8_t num_std_devs, std::optional<uint32_t> window) {
+        return estimate(sr.get_params(), sr.window(window)).get_upper_bound(num_std_devs);
+      },
+      nb::arg("num_std_devs"), nb::arg("window")=nb::none(),
+      "Returns the approximate upper error bound over the latest buckets given the number of standard deviations "
+      "in {1, 2, 3}"
+    );
+}
+
+template<typename Family>
+void add_quantile_queries(nb::class_<sketch_ring<Family>>& clazz) {
+  using SR = sketch_ring<Family>;
+  clazz.def(
+    "get_quantiles",
+    [](SR& sr, nb::ndarray<double> ranks, std::optional<uint32_t> window) {
+      auto r = view_1d(ranks);
+      std::vector<double> rank_values(r.shape(0));
+      for (size_t j = 0; j < rank_values.size(); ++j) {
+        if (!(r(j) >= 0.0 && r(j) <= 1.0)) {
+          throw std::invalid_argument("normalized rank cannot be less than zero or greater than 1.0");
+        }
+        rank_values[j] = r(j);
+      }
+      const auto merged = sr.window(window);
+      auto result = make_numpy_array<double>(rank_values.size());
+      for (size_t j = 0; j < rank_values.size(); ++j) {
+        result.data()[j] = merged.is_empty() ? std::numeric_limits<double>::quiet_NaN() : merged.get_quantile(rank_values[j]);
+      }
+      return result;
+    },
+    nb::arg("ranks"), nb::arg("window")=nb::none(),
+    "Returns a NumPy array of the quantiles over the latest buckets at the given normalized ranks, "
+    "or NaN if those buckets are empty.\n\n"
+    ":param ranks: A NumPy array of normalized ranks in [0, 1]\n:type ranks: numpy.ndarray\n"
+    ":param window: The number of latest buckets, the current one included (default: all buckets)\n"
+    ":type window: int, optional"
+  );
+}
+
+void bind_hll_sketch_ring(nb::module_& m) {
+  using SR = sketch_ring<hll_family>;
+  auto clazz = bind_sketch_ring<hll_family>(m, "hll_sketch_ring",
+      "A ring of HLL sketches over time buckets, for distinct counts over sliding windows");
+  clazz
+    .def(
+      "__init__",
+      [](SR* sr, uint32_t num_buckets, uint8_t lg_k, target_hll_type tgt_type) {
+        new (sr) SR(hll_family::params_type{lg_k, tgt_type}, num_buckets);
+      },
+      nb::arg("num_buckets"), nb::arg("lg_k"), nb::arg("tgt_type")=HLL_8,
+      "Creates a new ring of empty HLL sketches.\n\n"
+      ":param num_buckets: The number of buckets in the ring, which is the longest window\n:type num_buckets: int\n"
+      ":param lg_k: The value of lg_k for every sketch in the ring, between 7 and 21, inclusive\n:type lg_k: int\n"
+      ":param tgt_type: The HLL mode of every sketch in the ring\n:type tgt_type: tgt_hll_type"
+    )
+    .def_prop_ro("lg_k", [](const SR& sr) { return sr.get_params().lg_k; },
+         "The value of `lg_k` of the sketches");
+
+  const char* update_doc = "Updates the sketch of the current bucket with each value of a NumPy array. NaN values are skipped.";
+  add_sketch_ring_update<int64_t>(clazz, update_doc);
+  add_sketch_ring_update<double>(clazz, update_doc);
+  add_estimate_queries(clazz, [](const hll_family::params_type&, const hll_family::sketch_type& sk) -> const hll_family::sketch_type& { return sk; });
+}
+
+void bind_theta_sketch_ring(nb::module_& m) {
+  using SR = sketch_ring<theta_family>;
+  auto clazz = bind_sketch_ring<theta_family>(m, "theta_sketch_ring",
+      "A ring of Theta sketches over time buckets, for distinct counts over sliding windows");
+  clazz
+    .def(
+      "__init__",
+      [](SR* sr, uint32_t num_buckets, uint8_t lg_k, double p, uint64_t seed) {
+        new (sr) SR(theta_family::params_type{lg_k, static_cast<float>(p), seed}, num_buckets);
+      },
+      nb::arg("num_buckets"), nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("p")=1.0, nb::arg("seed")=DEFAULT_SEED,
+      "Creates a new ring of empty Theta sketches.\n\n"
+      ":param num_buckets: The number of buckets in the ring, which is the longest window\n:type num_buckets: int\n"
+      ":param lg_k: Configured size of every sketch in the ring. Default is 12.\n:type lg_k: int, optional\n"
+      ":param p: Initial sampling probability. Default is 1.0.\n:type p: float, optional\n"
+      ":param seed: Seed for the hash function. Default is 9001.\n:type seed: int, optional"
+    )
+    .def_prop_ro("lg_k", [](const SR& sr) { return sr.get_params().lg_k; },
+         "The value of `lg_k` of the sketches")
+    .def_prop_ro("seed", [](const SR& sr) { return sr.get_params().seed; },
+         "The seed of the sketches");
+
+  const char* update_doc = "Updates the sketch of the current bucket with each value of a NumPy array. NaN values are skipped.";
+  add_sketch_ring_update<int64_t>(clazz, update_doc);
+  add_sketch_ring_update<double>(clazz, update_doc);
+  add_estimate_queries(clazz, [](const theta_family::params_type& params, const theta_column& column) {
+    return theta_family::compact(column, params);
+  });
+}
+
+void bind_kll_sketch_ring(nb::module_& m) {
+  using SR = sketch_ring<kll_doubles_family>;
+  auto clazz = bind_sketch_ring<kll_doubles_family>(m, "kll_sketch_ring",
+      "A ring of KLL sketches of doubles over time buckets, for quantiles over sliding windows");
+  clazz
+    .def(
+      "__init__",
+      [](SR* sr, uint32_t num_buckets, uint16_t k) {
+        new (sr) SR(kll_doubles_family::params_type{k}, num_buckets);
+      },
+      nb::arg("num_buckets"), nb::arg("k")=kll_constants::DEFAULT_K,
+      "Creates a new ring of empty KLL sketches of doubles.\n\n"
+      ":param num_buckets: The number of buckets in the ring, which is the longest window\n:type num_buckets: int\n"
+      ":param k: The value of k for every sketch in the ring. Default is 200.\n:type k: int, optional"
+    )
+    .def_prop_ro("k", [](const SR& sr) { return sr.get_params().k; },
+         "The value of `k` of the sketches");
+
+  add_sketch_ring_update<double>(clazz,
+    "Updates the sketch of the current bucket with each value of a NumPy array. NaN values are skipped.");
+  add_quantile_queries(clazz);
+}
+
+void bind_tdigest_sketch_ring(nb::module_& m) {
+  using SR = sketch_ring<tdigest_family>;
+  auto clazz = bind_sketch_ring<tdigest_family>(m, "tdigest_sketch_ring",
+      "A ring of t-digests over time buckets, for quantiles over sliding windows");
+  clazz
+    .def(
+      "__init__",
+      [](SR* sr, uint32_t num_buckets, uint16_t k) {
+        new (sr) SR(tdigest_family::params_type{k}, num_buckets);
+      },
+      nb::arg("num_buckets"), nb::arg("k")=tdigest<double>::DEFAULT_K,
+      "Creates a new ring of empty t-digests.\n\n"
+      ":param num_buckets: The number of buckets in the ring, which is the longest window\n:type num_buckets: int\n"
+      ":param k: Controls the size/accuracy trade-off of every digest in the ring. Default is 200.\n:type k: int, optional"
+    )
+    .def_prop_ro("k", [](const SR& sr) { return sr.get_params().k; },
+         "The value of `k` of the digests");
+
+  add_sketch_ring_update<double>(clazz,
+    "Updates the digest of the current bucket with each value of a NumPy array. NaN values are skipped.");
+  add_quantile_queries(clazz);
+}
+
+} // namespace
+
+void init_sketch_ring(nb::module_& m) {
+  bind_hll_sketch_ring(m);
+  bind_theta_sketch_ring(m);
+  bind_kll_sketch_ring(m);
+  bind_tdigest_sketch_ring(m);
+}
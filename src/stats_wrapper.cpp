@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <atomic>
+#include <unordered_map>
+
+#include <nanobind/nanobind.h>
+
+#include "sketch_stats.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+namespace {
+
+const char* const COUNTER_NAMES[NUM_STATS_COUNTERS] = {
+  "updates", "compactions", "rebuilds", "promotions", "serde_calls", "serde_nanos", "bytes_serialized"
+};
+
+#ifdef DATASKETCHES_STATS
+
+struct stats_entry {
+  PyObject* owner;
+  sketch_stats stats;
+};
+
+// guarded by the GIL; an entry is removed when its object is deallocated
+std::unordered_map<PyObject*, stats_entry*> object_table;
+std::atomic<uint64_t> module_counters[NUM_STATS_COUNTERS];
+
+#endif // DATASKETCHES_STATS
+
+} // namespace
+
+nb::dict stats_to_dict(const sketch_stats& stats) {
+  nb::dict result;
+  for (unsigned i = 0; i < NUM_STATS_COUNTERS; ++i) result[COUNTER_NAMES[i]] = stats.counters[i];
+  return result;
+}
+
+#ifdef DATASKETCHES_STATS
+
+sketch_stats* object_stats(PyObject* obj, bool create) {
+  auto it = object_table.find(obj);
+  if (it != object_table.end()) return &it->second->stats;
+  if (!create) return nullptr;
+  stats_entry* entry = new stats_entry{obj, sketch_stats()};
+  object_table.emplace(obj, entry);
+  // frees the entry when the object is deallocated, so a new object at the same address starts from zero
+  nb::detail::keep_alive(obj, entry, [](void* p) noexcept {
+    stats_entry* e = static_cast<stats_entry*>(p);
+    object_table.erase(e->owner);
+    delete e;
+  });
+  return &entry->stats;
+}
+
+void add_module_stats(const sketch_stats& delta) noexcept {
+  for (unsigned i = 0; i < NUM_STATS_COUNTERS; ++i) {
+    if (delta.counters[i] != 0) module_counters[i].fetch_add(delta.counters[i], std::memory_order_relaxed);
+  }
+}
+
+#endif // DATASKETCHES_STATS
+
+} // namespace datasketches
+
+void init_stats(nb::module_& m) {
+  using namespace datasketches;
+
+  m.def("stats",
+    []() {
+      sketch_stats totals;
+#ifdef DATASKETCHES_STATS
+      for (unsigned i = 0; i < NUM_STATS_COUNTERS; ++i) totals.counters[i] = module_counters[i].load(std::memory_order_relaxed);
+#endif
+      nb::dict result = stats_to_dict(totals);
+      result["enabled"] = STATS_ENABLED;
+      return result;
+    },
+    "Returns a dict of the hot-path counters summed over every sketch and serde since the module was loaded "
+    "or reset_stats() was called: updates, compactions, rebuilds, promotions, serde_calls, serde_nanos and "
+    "bytes_serialized, and whether the module was built with DATASKETCHES_STATS, without which they are zero"
+  );
+
+  m.def("reset_stats",
+    []() {
+#ifdef DATASKETCHES_STATS
+      for (auto& counter: module_counters) counter.store(0, std::memory_order_relaxed);
+#endif
+    },
+    "Resets the module-wide counters of stats(), leaving the counters of each object unchanged"
+  );
+}
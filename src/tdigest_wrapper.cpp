@@ -28,6 +28,9 @@
 
 #include "tdigest.hpp"
 #include "quantile_conditional.hpp"
+#include "gil_guard.hpp"
+#include "numpy_array.hpp"
+#include "memory_usage.hpp"
 
 namespace nb = nanobind;
 
@@ -42,21 +45,23 @@ void bind_tdigest(nb::module_ &m, const char* name) {
          ":type k: int, optional"
     )
     .def("__copy__", [](const tdigest<T>& sk) { return tdigest<T>(sk); })
-    .def("update", (void(tdigest<T>::*)(T)) &tdigest<T>::update, nb::arg("item"),
+    .def("update", counted_update(static_cast<void (tdigest<T>::*)(T)>(&tdigest<T>::update)), nb::arg("item"),
         "Updates the sketch with the given value")
     .def("merge", (void(tdigest<T>::*)(tdigest<T>&)) &tdigest<T>::merge, nb::arg("sketch"),
          "Merges the provided sketch into this one")
     .def("__str__", [](const tdigest<T>& sk) { return sk.to_string(); },
          "Produces a string summary of the sketch")
-    .def("to_string", &tdigest<T>::to_string, nb::arg("print_centroids")=false,
+    .def("to_string", &tdigest<T>::to_string, nb::arg("print_centroids")=false, release_gil(),
          "Produces a string summary of the sketch")
     .def("is_empty", &tdigest<T>::is_empty,
          "Returns True if the sketch is empty, otherwise False")
     .def_prop_ro("k", &tdigest<T>::get_k,
          "The configured parameter k")
+    .def("get_memory_usage", [](const tdigest<T>& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its centroids and buffer")
     .def("get_total_weight", &tdigest<T>::get_total_weight,
          "The total weight processed by the sketch")
-    .def("compress", &tdigest<T>::compress,
+    .def("compress", &tdigest<T>::compress, release_gil(),
          "Process buffered values and merge centroids, if necesssary")
     .def("get_min_value", &tdigest<T>::get_min_value,
          "Returns the minimum value from the stream. If empty, throws a RuntimeError")
@@ -68,6 +73,77 @@ void bind_tdigest(nb::module_ &m, const char* name) {
          "Returns an approximation to the data value "
          "associated with the given rank in a hypothetical sorted "
          "version of the input stream so far.\n")
+    .def(
+        "get_quantiles",
+        [](tdigest<T>& sk, nb::ndarray<double> ranks) {
+          auto r = view_1d(ranks);
+          auto quantiles = make_numpy_array<T>(sk.is_empty() ? 0 : r.shape(0));
+          if (!sk.is_empty()) {
+            T* out = quantiles.data();
+            // queries merge the buffer lazily, so it is merged here with the GIL held
+            sk.compress();
+            nb::gil_scoped_release release;
+            for (size_t i = 0; i < r.shape(0); ++i) out[i] = sk.get_quantile(r(i));
+          }
+          return quantiles;
+        },
+        nb::arg("ranks"),
+        "Returns a NumPy array of the quantiles at each normalized rank of the given array.\n"
+        "If the sketch is empty this returns an empty array.")
+    .def(
+        "get_ranks",
+        [](tdigest<T>& sk, nb::ndarray<T> values) {
+          auto v = view_1d(values);
+          auto ranks = make_numpy_array<double>(sk.is_empty() ? 0 : v.shape(0));
+          if (!sk.is_empty()) {
+            double* out = ranks.data();
+            sk.compress();
+            nb::gil_scoped_release release;
+            for (size_t i = 0; i < v.shape(0); ++i) out[i] = sk.get_rank(v(i));
+          }
+          return ranks;
+        },
+        nb::arg("values"),
+        "Returns a NumPy array of the approximate normalized rank of each value of the given array.\n"
+        "If the sketch is empty this returns an empty array.")
+    .def(
+        "get_pmf",
+        [](tdigest<T>& sk, nb::ndarray<T> split_points) {
+          auto v = view_1d(split_points);
+          if (sk.is_empty()) return make_numpy_array<double>(0);
+          std::vector<T> points(v.shape(0));
+          for (size_t i = 0; i < points.size(); ++i) points[i] = v(i);
+          sk.compress();
+          auto pmf = call_without_gil([&] { return sk.get_PMF(points.data(), static_cast<uint32_t>(points.size())); });
+          auto result = make_numpy_array<double>(pmf.size());
+          std::copy(pmf.begin(), pmf.end(), result.data());
+          return result;
+        },
+        nb::arg("split_points"),
+        "Returns an approximation to the Probability Mass Function (PMF) of the input stream "
+        "given a NumPy array of m unique, monotonically increasing split points, as a NumPy array of m+1 values.\n"
+        "The definition of an 'interval' is inclusive of the left split point (or minimum value) and "
+        "exclusive of the right split point, with the exception that the last interval will include "
+        "the maximum value.\n"
+        "If the sketch is empty this returns an empty array.")
+    .def(
+        "get_cdf",
+        [](tdigest<T>& sk, nb::ndarray<T> split_points) {
+          auto v = view_1d(split_points);
+          if (sk.is_empty()) return make_numpy_array<double>(0);
+          std::vector<T> points(v.shape(0));
+          for (size_t i = 0; i < points.size(); ++i) points[i] = v(i);
+          sk.compress();
+          auto cdf = call_without_gil([&] { return sk.get_CDF(points.data(), static_cast<uint32_t>(points.size())); });
+          auto result = make_numpy_array<double>(cdf.size());
+          std::copy(cdf.begin(), cdf.end(), result.data());
+          return result;
+        },
+        nb::arg("split_points"),
+        "Returns an approximation to the Cumulative Distribution Function (CDF), which is the "
+        "cumulative analog of the PMF, of the input stream given a NumPy array of m unique, "
+        "monotonically increasing split points, as a NumPy array of m+1 values.\n"
+        "If the sketch is empty this returns an empty array.")
     .def("get_serialized_size_bytes", &tdigest<T>::get_serialized_size_bytes,
          nb::arg("with_buffer")=false,
          "Returns the size of the serialized sketch, in bytes")
@@ -75,6 +151,7 @@ void bind_tdigest(nb::module_ &m, const char* name) {
 
     add_serialization<T>(tdigest_class);
     add_vector_update<T>(tdigest_class);
+    add_stats(tdigest_class);
 }
 
 void init_tdigest(nb::module_ &m) {
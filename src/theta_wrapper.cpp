@@ -21,6 +21,7 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/make_iterator.h>
 #include <nanobind/stl/array.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 
 #include "theta_sketch.hpp"
@@ -28,10 +29,62 @@
 #include "theta_intersection.hpp"
 #include "theta_a_not_b.hpp"
 #include "theta_jaccard_similarity.hpp"
+#include "concurrent_theta_sketch.hpp"
 #include "common_defs.hpp"
+#include "hash_update.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "batch_serde.hpp"
+#include "pickle_support.hpp"
+#include "memory_usage.hpp"
+#include "numpy_array.hpp"
+#include "sketch_stats.hpp"
+#include "theta_set_ops.hpp"
 
 namespace nb = nanobind;
 
+namespace datasketches {
+
+// The sketches of a Python iterable, kept referenced while they are read without the GIL.
+class theta_sketch_list {
+  public:
+    explicit theta_sketch_list(nb::iterable sketches) {
+      for (nb::handle sk: sketches) {
+        objects_.push_back(nb::borrow(sk));
+        sketches_.push_back(&nb::cast<const theta_sketch&>(sk));
+      }
+    }
+
+    const std::vector<const theta_sketch*>& get() const { return sketches_; }
+
+  private:
+    std::vector<nb::object> objects_;
+    std::vector<const theta_sketch*> sketches_;
+};
+
+inline compact_theta_sketch to_compact_theta(sorted_theta_hashes&& result, uint64_t seed) {
+  return compact_theta_sketch(result.is_empty, true, compute_seed_hash(seed), result.theta, std::move(result.hashes));
+}
+
+// A read-only view of a serialized compact theta sketch, queried in place.
+// Holds the buffer view for as long as the sketch is alive.
+class py_wrapped_compact_theta {
+  public:
+    py_wrapped_compact_theta(nb::handle bytes, uint64_t seed, size_t offset, std::optional<size_t> length):
+    range_(bytes, offset, length),
+    sketch_(wrapped_compact_theta_sketch::wrap(range_.data(), range_.size(), seed))
+    {}
+
+    const wrapped_compact_theta_sketch& get() const { return sketch_; }
+
+  private:
+    py_byte_range range_;
+    wrapped_compact_theta_sketch sketch_;
+};
+
+} // namespace datasketches
+
 void init_theta(nb::module_ &m) {
   using namespace datasketches;
 
@@ -70,7 +123,7 @@ void init_theta(nb::module_ &m) {
      )
   ;
 
-  nb::class_<update_theta_sketch, theta_sketch>(m, "update_theta_sketch")
+  auto update_theta_class = nb::class_<update_theta_sketch, theta_sketch>(m, "update_theta_sketch")
     .def("__init__",
         [](update_theta_sketch* sk, uint8_t lg_k, double p, uint64_t seed) {
           new (sk) update_theta_sketch(update_theta_sketch::builder().set_lg_k(lg_k).set_p(p).set_seed(seed).build());
@@ -82,43 +135,186 @@ void init_theta(nb::module_ &m) {
         ":param seed: the seed to use when hashing values\n:type seed: int, optional\n"
     )
     .def("__copy__", [](const update_theta_sketch& sk){ return update_theta_sketch(sk); })
-    .def("update", (void (update_theta_sketch::*)(int64_t)) &update_theta_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (update_theta_sketch::*)(int64_t)>(&update_theta_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given integral value")
-    .def("update", (void (update_theta_sketch::*)(double)) &update_theta_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (update_theta_sketch::*)(double)>(&update_theta_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given floating point value")
-    .def("update", (void (update_theta_sketch::*)(const std::string&)) &update_theta_sketch::update, nb::arg("datum"),
+    .def("update", counted_update(static_cast<void (update_theta_sketch::*)(const std::string&)>(&update_theta_sketch::update)), nb::arg("datum"),
          "Updates the sketch with the given string")
-    .def("compact", &update_theta_sketch::compact, nb::arg("ordered")=true,
+    .def("compact", &update_theta_sketch::compact, nb::arg("ordered")=true, release_gil(),
          "Returns a compacted form of the sketch, optionally sorting it")
-    .def("trim", &update_theta_sketch::trim, "Removes retained entries in excess of the nominal size k (if any)")
+    .def("trim", &update_theta_sketch::trim, release_gil(), "Removes retained entries in excess of the nominal size k (if any)")
     .def("reset", &update_theta_sketch::reset, "Resets the sketch to the initial empty state")
+    .def("get_memory_usage", [](const update_theta_sketch& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its hash table")
   ;
 
-  nb::class_<compact_theta_sketch, theta_sketch>(m, "compact_theta_sketch")
-    .def(nb::init<const theta_sketch&, bool>(),
+  add_hash_vector_update(update_theta_class);
+  add_stats(update_theta_class);
+
+  using concurrent_theta = concurrent_theta_sketch;
+  auto concurrent_theta_class = nb::class_<concurrent_theta>(m, "concurrent_theta_sketch",
+    "A theta sketch that many threads may update at once. Each thread screens its items against the theta of "
+    "a shared sketch and buffers the survivors, propagating a full buffer into the shared sketch. Queries read "
+    "the shared sketch, which lags the updates by at most max_pending items; flush() propagates them all.")
+    .def("__init__",
+        [](concurrent_theta* sk, uint8_t lg_k, double p, uint64_t seed, uint32_t buffer_size, unsigned num_buffers) {
+          new (sk) concurrent_theta(lg_k, static_cast<float>(p), seed, buffer_size, num_buffers);
+        },
+        nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("p")=1.0, nb::arg("seed")=DEFAULT_SEED,
+        nb::arg("buffer_size")=concurrent_theta::DEFAULT_BUFFER_SIZE, nb::arg("num_buffers")=0,
+        "Creates a concurrent_theta_sketch using the provided parameters\n\n"
+        ":param lg_k: base 2 logarithm of the maximum size of the shared sketch. Default 12.\n:type lg_k: int, optional\n"
+        ":param p: an initial sampling rate to use. Default 1.0\n:type p: float, optional\n"
+        ":param seed: the seed to use when hashing values\n:type seed: int, optional\n"
+        ":param buffer_size: the number of items a buffer holds before it is propagated. Default 16.\n:type buffer_size: int, optional\n"
+        ":param num_buffers: the number of buffers shared round-robin by the updating threads, "
+        "or 0 for one per hardware thread. Default 0.\n:type num_buffers: int, optional"
+    )
+    .def("update", (void (concurrent_theta::*)(int64_t)) &concurrent_theta::update, nb::arg("datum"),
+         "Updates the sketch with the given integral value")
+    .def("update", (void (concurrent_theta::*)(double)) &concurrent_theta::update, nb::arg("datum"),
+         "Updates the sketch with the given floating point value")
+    .def("update", (void (concurrent_theta::*)(const std::string&)) &concurrent_theta::update, nb::arg("datum"),
+         "Updates the sketch with the given string")
+    .def("flush", &concurrent_theta::flush, release_gil(),
+         "Propagates every buffered item into the shared sketch")
+    .def("compact", &concurrent_theta::compact, nb::arg("ordered")=true, release_gil(),
+         "Flushes the buffers and returns a compacted form of the shared sketch, optionally sorting it")
+    .def("reset", &concurrent_theta::reset, release_gil(), "Resets the sketch and its buffers to the initial empty state")
+    .def("is_empty", [](const concurrent_theta& sk) { return sk.query([](const update_theta_sketch& s) { return s.is_empty(); }); },
+         "Returns True if the shared sketch is empty, otherwise False")
+    .def("get_estimate", [](const concurrent_theta& sk) { return sk.query([](const update_theta_sketch& s) { return s.get_estimate(); }); },
+         "Estimate of the distinct count of the items propagated into the shared sketch")
+    .def("get_upper_bound",
+         [](const concurrent_theta& sk, uint8_t num_std_devs) {
+           return sk.query([=](const update_theta_sketch& s) { return s.get_upper_bound(num_std_devs); });
+         }, nb::arg("num_std_devs"),
+         "Returns an approximate upper bound on the estimate of the shared sketch at standard deviations in {1, 2, 3}")
+    .def("get_lower_bound",
+         [](const concurrent_theta& sk, uint8_t num_std_devs) {
+           return sk.query([=](const update_theta_sketch& s) { return s.get_lower_bound(num_std_devs); });
+         }, nb::arg("num_std_devs"),
+         "Returns an approximate lower bound on the estimate of the shared sketch at standard deviations in {1, 2, 3}")
+    .def("get_theta", [](const concurrent_theta& sk) { return sk.query([](const update_theta_sketch& s) { return s.get_theta(); }); },
+         "Returns theta (effective sampling rate) of the shared sketch as a fraction from 0 to 1")
+    .def_prop_ro("num_retained", [](const concurrent_theta& sk) { return sk.query([](const update_theta_sketch& s) { return s.get_num_retained(); }); },
+         "The number of items retained by the shared sketch")
+    .def_prop_ro("buffer_size", &concurrent_theta::get_buffer_size,
+         "The number of items a buffer holds before it is propagated")
+    .def_prop_ro("num_buffers", &concurrent_theta::get_num_buffers,
+         "The number of buffers shared by the updating threads")
+    .def_prop_ro("max_pending", &concurrent_theta::get_max_pending,
+         "The most items that passed theta but may not yet be in the shared sketch, and so in its estimate")
+  ;
+
+  add_hash_vector_update(concurrent_theta_class);
+
+  auto compact_theta_class = nb::class_<compact_theta_sketch, theta_sketch>(m, "compact_theta_sketch")
+    .def(nb::init<const theta_sketch&, bool>(), nb::arg("other"), nb::arg("ordered")=true, release_gil(),
          "Creates a compact_theta_sketch from an existing theta_sketch.\n\n"
          ":param other: a source theta_sketch\n:type other: theta_sketch\n"
          ":param ordered: whether the incoming sketch entries are sorted. Default True\n"
          ":type ordered: bool"
     )
     .def("__copy__", [](const compact_theta_sketch& sk){ return compact_theta_sketch(sk); })
+    .def("get_memory_usage", [](const compact_theta_sketch& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its entries")
     .def(
         "serialize",
         [](const compact_theta_sketch& sk, bool compress) {
-          auto bytes = compress ? sk.serialize_compressed() : sk.serialize();
+          auto bytes = call_without_gil([&sk, compress] { return compress ? sk.serialize_compressed() : sk.serialize(); });
+          count_serialized(sk, bytes.size());
           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
         }, nb::arg("compress")=false,
         "Serializes the sketch into a bytes object, optionally compressing the data"
     )
+    .def(
+        "serialize_into",
+        [](const compact_theta_sketch& sk, nb::handle buffer, size_t offset, bool compress) {
+          const size_t written = serialize_into_buffer(buffer, offset, [&](std::ostream& os) {
+            if (compress) sk.serialize_compressed(os);
+            else sk.serialize(os);
+          });
+          count_serialized(sk, written);
+          return written;
+        }, nb::arg("buffer"), nb::arg("offset")=0, nb::arg("compress")=false,
+        "Serializes the sketch, optionally compressing the data, into a writable buffer such as a bytearray, "
+        "NumPy uint8 array or mmap, starting at offset and returns the number of bytes written. "
+        "Raises a ValueError if the image does not fit."
+    )
+    .def("get_serialized_size_bytes", &compact_theta_sketch::get_serialized_size_bytes, nb::arg("compressed")=false,
+         "Returns the size of the serialized sketch, in bytes, optionally compressed")
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes, uint64_t seed) {
-          return compact_theta_sketch::deserialize(bytes.c_str(), bytes.size(), seed);
+        [](nb::handle bytes, uint64_t seed, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return call_without_gil([&range, seed] { return compact_theta_sketch::deserialize(range.data(), range.size(), seed); });
         },
-        nb::arg("bytes"), nb::arg("seed")=DEFAULT_SEED,
-        "Reads a bytes object and returns the corresponding compact_theta_sketch"
+        nb::arg("bytes"), nb::arg("seed")=DEFAULT_SEED, nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding compact_theta_sketch"
     );
 
+  add_batch_serialization(compact_theta_class,
+    [](const compact_theta_sketch& sk) { return sk.serialize(); },
+    [](const char* data, size_t size) { return compact_theta_sketch::deserialize(data, size); });
+  add_pickle_support(compact_theta_class,
+    [](const compact_theta_sketch& sk) { return sk.serialize(); },
+    [](const char* data, size_t size) { return compact_theta_sketch::deserialize(data, size); });
+  add_stats(compact_theta_class);
+
+  using wrapped_theta = py_wrapped_compact_theta;
+  nb::class_<wrapped_theta>(m, "wrapped_compact_theta_sketch",
+    "A read-only view of a serialized compact_theta_sketch. Queries read the image in place, "
+    "without deserializing or copying it, and the buffer is kept alive by the view.")
+    .def(nb::init<nb::handle, uint64_t, size_t, std::optional<size_t>>(),
+         nb::arg("bytes"), nb::arg("seed")=DEFAULT_SEED, nb::arg("offset")=0, nb::arg("length")=nb::none(),
+         "Wraps a serialized compact_theta_sketch\n\n"
+         ":param bytes: a bytes object or any other contiguous buffer holding the image\n:type bytes: buffer\n"
+         ":param seed: the seed used to build the sketch\n:type seed: int, optional\n"
+         ":param offset: the position of the image within the buffer. Default 0\n:type offset: int, optional\n"
+         ":param length: the size of the image, or None for the rest of the buffer\n:type length: int, optional"
+    )
+    .def("__str__", [](const wrapped_theta& sk) { return sk.get().to_string(); },
+         "Produces a string summary of the sketch")
+    .def("to_string", [](const wrapped_theta& sk, bool print_items) { return sk.get().to_string(print_items); }, nb::arg("print_items")=false,
+         "Produces a string summary of the sketch")
+    .def("is_empty", [](const wrapped_theta& sk) { return sk.get().is_empty(); },
+         "Returns True if the sketch is empty, otherwise False")
+    .def("get_estimate", [](const wrapped_theta& sk) { return sk.get().get_estimate(); },
+         "Estimate of the distinct count of the input stream")
+    .def("get_upper_bound", [](const wrapped_theta& sk, uint8_t num_std_devs) { return sk.get().get_upper_bound(num_std_devs); },
+         nb::arg("num_std_devs"),
+         "Returns an approximate upper bound on the estimate at standard deviations in {1, 2, 3}")
+    .def("get_lower_bound", [](const wrapped_theta& sk, uint8_t num_std_devs) { return sk.get().get_lower_bound(num_std_devs); },
+         nb::arg("num_std_devs"),
+         "Returns an approximate lower bound on the estimate at standard deviations in {1, 2, 3}")
+    .def("is_estimation_mode", [](const wrapped_theta& sk) { return sk.get().is_estimation_mode(); },
+         "Returns True if sketch is in estimation mode, otherwise False")
+    .def_prop_ro("theta", [](const wrapped_theta& sk) { return sk.get().get_theta(); },
+         "Theta (effective sampling rate) as a fraction from 0 to 1")
+    .def_prop_ro("theta64", [](const wrapped_theta& sk) { return sk.get().get_theta64(); },
+         "Theta as 64-bit value")
+    .def_prop_ro("num_retained", [](const wrapped_theta& sk) { return sk.get().get_num_retained(); },
+         "The number of items currently in the sketch")
+    .def("get_seed_hash", [](const wrapped_theta& sk) { return sk.get().get_seed_hash(); },
+         "Returns a hash of the seed used in the sketch")
+    .def("is_ordered", [](const wrapped_theta& sk) { return sk.get().is_ordered(); },
+         "Returns True if the sketch entries are sorted, otherwise False")
+    .def("compact", [](const wrapped_theta& sk, bool ordered) { return compact_theta_sketch(sk.get(), ordered); },
+         nb::arg("ordered")=true, release_gil(),
+         "Returns a compact_theta_sketch copied from the image, optionally sorting it")
+    .def("__iter__",
+          [](const wrapped_theta& s) {
+               return nb::make_iterator(nb::type<wrapped_theta>(),
+               "wrapped_theta_iterator",
+               s.get().begin(),
+               s.get().end());
+          }, nb::keep_alive<0,1>()
+     )
+  ;
+
   nb::class_<theta_union>(m, "theta_union")
     .def("__init__",
         [](theta_union* u, uint8_t lg_k, double p, uint64_t seed) {
@@ -130,10 +326,32 @@ void init_theta(nb::module_ &m) {
         ":param p: an initial sampling rate to use. Default 1.0\n:type p: float, optional\n"
         ":param seed: the seed to use when hashing values. Must match all sketch seeds.\n:type seed: int, optional"
     )
-    .def("update", &theta_union::update<const theta_sketch&>, nb::arg("sketch"),
+    .def("update", &theta_union::update<const theta_sketch&>, nb::arg("sketch"), release_gil(),
          "Updates the union with the given sketch")
-    .def("get_result", &theta_union::get_result, nb::arg("ordered")=true,
+    .def("update", [](theta_union& u, const wrapped_theta& sk) { u.update(sk.get()); }, nb::arg("sketch"), release_gil(),
+         "Updates the union with the given wrapped sketch")
+    .def("get_result", &theta_union::get_result, nb::arg("ordered")=true, release_gil(),
          "Returns the sketch corresponding to the union result")
+    .def_static(
+        "union_all",
+        [](nb::iterable sketches, uint8_t lg_k, uint64_t seed, unsigned num_threads) {
+          theta_union::builder().set_lg_k(lg_k); // rejects lg_k out of range as theta_union does
+          theta_sketch_list list(sketches);
+          return call_without_gil([&] {
+            auto hashes = collect_sorted_hashes(list.get(), seed, num_threads);
+            return to_compact_theta(union_all(hashes, lg_k, num_threads), seed);
+          });
+        },
+        nb::arg("sketches"), nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("seed")=DEFAULT_SEED,
+        nb::arg("num_threads")=0,
+        "Returns the ordered compact sketch of the union of all given sketches, computed by merging their "
+        "sorted hashes in native threads. Equivalent to updating a theta_union of the same lg_k with each sketch.\n\n"
+        ":param sketches: The sketches to union\n:type sketches: list\n"
+        ":param lg_k: base 2 logarithm of the maximum size of the union. Default 12.\n:type lg_k: int, optional\n"
+        ":param seed: the seed to use when hashing values. Must match all sketch seeds.\n:type seed: int, optional\n"
+        ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+        ":type num_threads: int, optional"
+    )
   ;
 
   nb::class_<theta_intersection>(m, "theta_intersection")
@@ -141,12 +359,31 @@ void init_theta(nb::module_ &m) {
         "Creates a theta_intersection using the provided parameters\n\n"
         ":param seed: the seed to use when hashing values. Must match all sketch seeds\n:type seed: int, optional"         
     )
-    .def("update", &theta_intersection::update<const theta_sketch&>, nb::arg("sketch"),
+    .def("update", &theta_intersection::update<const theta_sketch&>, nb::arg("sketch"), release_gil(),
          "Intersections the provided sketch with the current intersection state")
-    .def("get_result", &theta_intersection::get_result, nb::arg("ordered")=true,
+    .def("update", [](theta_intersection& i, const wrapped_theta& sk) { i.update(sk.get()); }, nb::arg("sketch"), release_gil(),
+         "Intersections the provided wrapped sketch with the current intersection state")
+    .def("get_result", &theta_intersection::get_result, nb::arg("ordered")=true, release_gil(),
          "Returns the sketch corresponding to the intersection result")
     .def("has_result", &theta_intersection::has_result,
          "Returns True if the intersection has a valid result, otherwise False")
+    .def_static(
+        "intersect_all",
+        [](nb::iterable sketches, uint64_t seed, unsigned num_threads) {
+          theta_sketch_list list(sketches);
+          return call_without_gil([&] {
+            auto hashes = collect_sorted_hashes(list.get(), seed, num_threads);
+            return to_compact_theta(intersect_all(hashes, num_threads), seed);
+          });
+        },
+        nb::arg("sketches"), nb::arg("seed")=DEFAULT_SEED, nb::arg("num_threads")=0,
+        "Returns the ordered compact sketch of the intersection of all given sketches, computed by merge-joining "
+        "their sorted hashes in native threads. Equivalent to updating a theta_intersection with each sketch.\n\n"
+        ":param sketches: The sketches to intersect, at least one\n:type sketches: list\n"
+        ":param seed: the seed to use when hashing values. Must match all sketch seeds.\n:type seed: int, optional\n"
+        ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+        ":type num_threads: int, optional"
+    )
   ;
 
   nb::class_<theta_a_not_b>(m, "theta_a_not_b")
@@ -157,7 +394,7 @@ void init_theta(nb::module_ &m) {
     .def(
         "compute",
         &theta_a_not_b::compute<const theta_sketch&, const theta_sketch&>,
-        nb::arg("a"), nb::arg("b"), nb::arg("ordered")=true,
+        nb::arg("a"), nb::arg("b"), nb::arg("ordered")=true, release_gil(),
         "Returns a sketch with the result of applying the A-not-B operation on the given inputs"
     )
   ;
@@ -169,26 +406,47 @@ void init_theta(nb::module_ &m) {
         [](const theta_sketch& sketch_a, const theta_sketch& sketch_b, uint64_t seed) {
           return theta_jaccard_similarity::jaccard(sketch_a, sketch_b, seed);
         },
-        nb::arg("sketch_a"), nb::arg("sketch_b"), nb::arg("seed")=DEFAULT_SEED,
+        nb::arg("sketch_a"), nb::arg("sketch_b"), nb::arg("seed")=DEFAULT_SEED, release_gil(),
         "Returns a list with {lower_bound, estimate, upper_bound} of the Jaccard similarity between sketches"
     )
+    .def_static(
+        "pairwise",
+        [](nb::iterable sketches, uint64_t seed, unsigned num_threads) {
+          theta_sketch_list list(sketches);
+          const size_t n = list.get().size();
+          auto result = make_numpy_array<double>(n, n, 3);
+          double* out = result.data();
+          call_without_gil([&] {
+            pairwise_jaccard(collect_sorted_hashes(list.get(), seed, num_threads), num_threads, out);
+          });
+          return result;
+        },
+        nb::arg("sketches"), nb::arg("seed")=DEFAULT_SEED, nb::arg("num_threads")=0,
+        "Returns a NumPy array of shape (n, n, 3) where [i, j] holds {lower_bound, estimate, upper_bound} of the "
+        "Jaccard similarity between sketches i and j, as returned by jaccard(). Each sketch is sorted once and "
+        "the pairs are computed in native threads.\n\n"
+        ":param sketches: The n sketches to compare\n:type sketches: list\n"
+        ":param seed: the seed to use when hashing values. Must match all sketch seeds.\n:type seed: int, optional\n"
+        ":param num_threads: The number of threads to use, or 0 for one per hardware thread. Default is 0.\n"
+        ":type num_threads: int, optional"
+    )
     .def_static(
         "exactly_equal",
         &theta_jaccard_similarity::exactly_equal<const theta_sketch&, const theta_sketch&>,
-        nb::arg("sketch_a"), nb::arg("sketch_b"), nb::arg("seed")=DEFAULT_SEED,
+        nb::arg("sketch_a"), nb::arg("sketch_b"), nb::arg("seed")=DEFAULT_SEED, release_gil(),
         "Returns True if sketch_a and sketch_b are equivalent, otherwise False"
     )
     .def_static(
         "similarity_test",
         &theta_jaccard_similarity::similarity_test<const theta_sketch&, const theta_sketch&>,
-        nb::arg("actual"), nb::arg("expected"), nb::arg("threshold"), nb::arg("seed")=DEFAULT_SEED,
+        nb::arg("actual"), nb::arg("expected"), nb::arg("threshold"), nb::arg("seed")=DEFAULT_SEED, release_gil(),
         "Tests similarity of an actual sketch against an expected sketch. Computers the lower bound of the Jaccard "
         "index J_{LB} of the actual and expected sketches. If J_{LB} >= threshold, then the sketches are considered "
         "to be similar with a confidence of 97.7% and returns True, otherwise False.")
     .def_static(
         "dissimilarity_test",
         &theta_jaccard_similarity::dissimilarity_test<const theta_sketch&, const theta_sketch&>,
-        nb::arg("actual"), nb::arg("expected"), nb::arg("threshold"), nb::arg("seed")=DEFAULT_SEED,
+        nb::arg("actual"), nb::arg("expected"), nb::arg("threshold"), nb::arg("seed")=DEFAULT_SEED, release_gil(),
         "Tests dissimilarity of an actual sketch against an expected sketch. Computers the lower bound of the Jaccard "
         "index J_{UB} of the actual and expected sketches. If J_{UB} <= threshold, then the sketches are considered "
         "to be dissimilar with a confidence of 97.7% and returns True, otherwise False."
@@ -0,0 +1,649 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/make_iterator.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/detail/nb_list.h>
+
+#include "tuple_sketch.hpp"
+#include "tuple_union.hpp"
+#include "tuple_intersection.hpp"
+#include "tuple_a_not_b.hpp"
+#include "memory_operations.hpp"
+#include "common_defs.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "batch_serde.hpp"
+#include "pickle_support.hpp"
+#include "numpy_array.hpp"
+#include "memory_usage.hpp"
+
+namespace nb = nanobind;
+
+namespace datasketches {
+
+// Native summaries and policies, so tuple sketches of doubles run without Python
+// calls or the GIL. Each policy serves as the update, union and intersection policy.
+
+struct double_sum_policy {
+  double create() const { return 0; }
+  void update(double& summary, double update) const { summary += update; }
+  void operator()(double& summary, double other) const { summary += other; }
+};
+
+struct double_min_policy {
+  double create() const { return std::numeric_limits<double>::infinity(); }
+  void update(double& summary, double update) const { summary = std::min(summary, update); }
+  void operator()(double& summary, double other) const { summary = std::min(summary, other); }
+};
+
+struct double_max_policy {
+  double create() const { return -std::numeric_limits<double>::infinity(); }
+  void update(double& summary, double update) const { summary = std::max(summary, update); }
+  void operator()(double& summary, double other) const { summary = std::max(summary, other); }
+};
+
+// a fixed number of doubles per entry, converted to and from a Python list
+struct double_array: public std::vector<double> {
+  using std::vector<double>::vector;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const double_array& array) {
+  os << "[";
+  for (size_t i = 0; i < array.size(); ++i) os << (i > 0 ? ", " : "") << array[i];
+  return os << "]";
+}
+
+// element-wise sums of arrays of num_values doubles
+struct double_array_sum_policy {
+  explicit double_array_sum_policy(uint32_t num_values = 1): num_values(num_values) {}
+
+  double_array create() const { return double_array(num_values, 0.0); }
+
+  void update(double_array& summary, const double* update) const {
+    for (uint32_t i = 0; i < num_values; ++i) summary[i] += update[i];
+  }
+
+  void operator()(double_array& summary, const double_array& other) const {
+    if (summary.size() != other.size()) {
+      throw std::invalid_argument("summaries must have the same number of values: " + std::to_string(summary.size())
+        + " vs " + std::to_string(other.size()));
+    }
+    for (size_t i = 0; i < summary.size(); ++i) summary[i] += other[i];
+  }
+
+  uint32_t num_values;
+};
+
+// 4-byte count followed by the values
+struct double_array_serde {
+  void serialize(std::ostream& os, const double_array* items, unsigned num) const {
+    for (unsigned i = 0; i < num && os.good(); ++i) {
+      const uint32_t count = static_cast<uint32_t>(items[i].size());
+      os.write(reinterpret_cast<const char*>(&count), sizeof(count));
+      os.write(reinterpret_cast<const char*>(items[i].data()), count * sizeof(double));
+    }
+    if (!os.good()) throw std::runtime_error("error writing to std::ostream");
+  }
+
+  void deserialize(std::istream& is, double_array* items, unsigned num) const {
+    unsigned i = 0;
+    bool failure = false;
+    for (; i < num; ++i) {
+      uint32_t count;
+      is.read(reinterpret_cast<char*>(&count), sizeof(count));
+      if (!is.good()) { failure = true; break; }
+      double_array array(count);
+      if (count > 0) is.read(reinterpret_cast<char*>(array.data()), count * sizeof(double));
+      if (!is.good()) { failure = true; break; }
+      new (&items[i]) double_array(std::move(array));
+    }
+    if (failure) {
+      for (unsigned j = 0; j < i; ++j) items[j].~double_array();
+      throw std::runtime_error("error reading from std::istream");
+    }
+  }
+
+  size_t serialize(void* ptr, size_t capacity, const double_array* items, unsigned num) const {
+    char* out = static_cast<char*>(ptr);
+    size_t bytes_written = 0;
+    for (unsigned i = 0; i < num; ++i) {
+      const uint32_t count = static_cast<uint32_t>(items[i].size());
+      const size_t size = count * sizeof(double);
+      check_memory_size(bytes_written + sizeof(count) + size, capacity);
+      std::memcpy(out + bytes_written, &count, sizeof(count));
+      if (size > 0) std::memcpy(out + bytes_written + sizeof(count), items[i].data(), size);
+      bytes_written += sizeof(count) + size;
+    }
+    return bytes_written;
+  }
+
+  size_t deserialize(const void* ptr, size_t capacity, double_array* items, unsigned num) const {
+    const char* in = static_cast<const char*>(ptr);
+    size_t bytes_read = 0;
+    unsigned i = 0;
+    try {
+      for (; i < num; ++i) {
+        uint32_t count;
+        check_memory_size(bytes_read + sizeof(count), capacity);
+        std::memcpy(&count, in + bytes_read, sizeof(count));
+        bytes_read += sizeof(count);
+        const size_t size = count * sizeof(double);
+        check_memory_size(bytes_read + size, capacity);
+        new (&items[i]) double_array(count);
+        if (size > 0) std::memcpy(items[i].data(), in + bytes_read, size);
+        bytes_read += size;
+      }
+    } catch (...) {
+      for (unsigned j = 0; j < i; ++j) items[j].~double_array();
+      throw;
+    }
+    return bytes_read;
+  }
+
+  size_t size_of_item(const double_array& item) const {
+    return sizeof(uint32_t) + item.size() * sizeof(double);
+  }
+};
+
+} // namespace datasketches
+
+namespace nanobind {
+namespace detail {
+
+template<>
+struct type_caster<datasketches::double_array>: list_caster<datasketches::double_array, double> {};
+
+} // namespace detail
+} // namespace nanobind
+
+namespace {
+
+using namespace datasketches;
+
+// the hashes and summaries of the retained entries as NumPy arrays
+std::pair<numpy_array<uint64_t>, numpy_array<double>> get_entries(const tuple_sketch<double>& sk) {
+  auto hashes = make_numpy_array<uint64_t>(sk.get_num_retained());
+  auto summaries = make_numpy_array<double>(sk.get_num_retained());
+  size_t i = 0;
+  for (const auto& entry: sk) {
+    hashes.data()[i] = entry.first;
+    summaries.data()[i] = entry.second;
+    ++i;
+  }
+  return std::make_pair(std::move(hashes), std::move(summaries));
+}
+
+// throws unless every summary holds num_values doubles, which unions of sketches
+// of different sizes and crafted images would otherwise break
+void check_num_values(const tuple_sketch<double_array>& sk, size_t num_values) {
+  for (const auto& entry: sk) {
+    if (entry.second.size() != num_values) {
+      throw std::invalid_argument("summaries must have the same number of values: " + std::to_string(num_values)
+        + " vs " + std::to_string(entry.second.size()));
+    }
+  }
+}
+
+// summaries of a single double are always consistent
+void check_summaries(const tuple_sketch<double>&) {}
+
+void check_summaries(const tuple_sketch<double_array>& sk) {
+  if (sk.get_num_retained() > 0) check_num_values(sk, (*sk.begin()).second.size());
+}
+
+std::pair<numpy_array<uint64_t>, numpy_array_2d<double>> get_entries(const tuple_sketch<double_array>& sk) {
+  const size_t num_values = sk.get_num_retained() > 0 ? (*sk.begin()).second.size() : 0;
+  // checked before anything is copied into the rows of num_values doubles
+  check_num_values(sk, num_values);
+  auto hashes = make_numpy_array<uint64_t>(sk.get_num_retained());
+  auto summaries = make_numpy_array<double>(sk.get_num_retained(), num_values);
+  size_t i = 0;
+  for (const auto& entry: sk) {
+    hashes.data()[i] = entry.first;
+    std::copy(entry.second.begin(), entry.second.end(), summaries.data() + i * num_values);
+    ++i;
+  }
+  return std::make_pair(std::move(hashes), std::move(summaries));
+}
+
+// base class, compact sketch and A-not-B, which do not depend on the policy
+template<typename Summary, typename SerDe>
+void bind_native_tuple_sketch(nb::module_& m, const std::string& suffix) {
+  using base_type = tuple_sketch<Summary>;
+  using compact_type = compact_tuple_sketch<Summary>;
+  using a_not_b_type = tuple_a_not_b<Summary>;
+
+  const auto deserialize = [](const char* data, size_t size, uint64_t seed) {
+    compact_type sk = compact_type::deserialize(data, size, seed, SerDe());
+    check_summaries(sk);
+    return sk;
+  };
+
+  nb::class_<base_type>(m, ("tuple_sketch_" + suffix).c_str(),
+      "An abstract base class for tuple sketches with native summaries.")
+    .def("__str__", [](const base_type& sk) { return sk.to_string(); },
+         "Produces a string summary of the sketch")
+    .def("to_string", &base_type::to_string, nb::arg("print_items")=false, release_gil(),
+         "Produces a string summary of the sketch")
+    .def("is_empty", &base_type::is_empty,
+         "Returns True if the sketch is empty, otherwise False")
+    .def("get_estimate", &base_type::get_estimate,
+         "Estimate of the distinct count of the input stream")
+    .def("get_upper_bound", static_cast<double (base_type::*)(uint8_t) const>(&base_type::get_upper_bound), nb::arg("num_std_devs"),
+         "Returns an approximate upper bound on the estimate at standard deviations in {1, 2, 3}")
+    .def("get_lower_bound", static_cast<double (base_type::*)(uint8_t) const>(&base_type::get_lower_bound), nb::arg("num_std_devs"),
+         "Returns an approximate lower bound on the estimate at standard deviations in {1, 2, 3}")
+    .def("is_estimation_mode", &base_type::is_estimation_mode,
+         "Returns True if sketch is in estimation mode, otherwise False")
+    .def_prop_ro("theta", &base_type::get_theta,
+         "Theta (effective sampling rate) as a fraction from 0 to 1")
+    .def_prop_ro("theta64", &base_type::get_theta64,
+         "Theta as 64-bit value")
+    .def_prop_ro("num_retained", &base_type::get_num_retained,
+         "The number of items currently in the sketch")
+    .def("get_seed_hash", [](const base_type& sk) { return sk.get_seed_hash(); },
+         "Returns a hash of the seed used in the sketch")
+    .def("is_ordered", &base_type::is_ordered,
+         "Returns True if the sketch entries are sorted, otherwise False")
+    .def("get_entries", [](const base_type& sk) { return get_entries(sk); },
+         "Returns a tuple of NumPy arrays (hashes, summaries) of the retained entries, where summaries "
+         "has a row per entry for array summaries")
+    .def("__iter__",
+          [](const base_type& s) {
+               return nb::make_iterator(nb::type<base_type>(),
+               "tuple_iterator",
+               s.begin(),
+               s.end());
+          }, nb::keep_alive<0,1>()
+     )
+  ;
+
+  auto compact_class = nb::class_<compact_type, base_type>(m, ("compact_tuple_sketch_" + suffix).c_str())
+    .def(nb::init<const base_type&, bool>(), nb::arg("other"), nb::arg("ordered")=true, release_gil(),
+         "Creates a compact tuple sketch from an existing tuple sketch of the same summary type.\n\n"
+         ":param other: a source sketch\n:type other: tuple sketch\n"
+         ":param ordered: whether the incoming sketch entries are sorted. Default True\n"
+         ":type ordered: bool, optional"
+         )
+    .def("__copy__", [](const compact_type& sk){ return compact_type(sk); })
+    .def("get_memory_usage", [](const compact_type& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its entries")
+    .def(
+        "serialize",
+        [](const compact_type& sk) {
+          auto bytes = call_without_gil([&sk] { return sk.serialize(0, SerDe()); });
+          return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        },
+        "Serializes the sketch into a bytes object"
+    )
+    .def_static(
+        "deserialize",
+        [deserialize](nb::handle bytes, uint64_t seed, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return call_without_gil([&range, seed, &deserialize] { return deserialize(range.data(), range.size(), seed); });
+        },
+        nb::arg("bytes"), nb::arg("seed")=DEFAULT_SEED, nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding compact tuple sketch"
+    );
+
+  add_batch_serialization(compact_class,
+    [](const compact_type& sk) { return sk.serialize(0, SerDe()); },
+    [deserialize](const char* data, size_t size) { return deserialize(data, size, DEFAULT_SEED); });
+  add_pickle_support(compact_class,
+    [](const compact_type& sk) { return sk.serialize(0, SerDe()); },
+    [deserialize](const char* data, size_t size) { return deserialize(data, size, DEFAULT_SEED); });
+
+  nb::class_<a_not_b_type>(m, ("tuple_a_not_b_" + suffix).c_str())
+    .def(nb::init<uint64_t>(), nb::arg("seed")=DEFAULT_SEED,
+        "Creates a tuple A-not-B operator\n\n"
+        ":param seed: the seed to use when hashing values. Must match any sketch seeds.\n:type seed: int, optional"
+    )
+    .def(
+        "compute",
+        &a_not_b_type::template compute<const base_type&, const base_type&>,
+        nb::arg("a"), nb::arg("b"), nb::arg("ordered")=true, release_gil(),
+        "Returns a sketch with the result of applying the A-not-B operation on the given inputs"
+    )
+  ;
+}
+
+// the summaries of an operand must match those of the union or intersection, which only
+// the array operations can get wrong, as they only check the entries of matching keys
+template<typename Operation, typename Summary>
+void check_operand(const Operation&, const tuple_sketch<Summary>&) {}
+
+template<typename Operation>
+void check_operand(const Operation& op, const tuple_sketch<double_array>& sk) {
+  check_num_values(sk, op.get_num_values());
+}
+
+// methods of the update sketch, union and intersection of one policy
+template<typename Base, typename UpdateSketch, typename Union, typename Intersection>
+void bind_native_tuple_operations(nb::class_<UpdateSketch, Base>& update_class, nb::class_<Union>& union_class,
+                                  nb::class_<Intersection>& intersection_class) {
+  update_class
+    .def("__copy__", [](const UpdateSketch& sk){ return UpdateSketch(sk); })
+    .def("compact", [](const UpdateSketch& sk, bool ordered) { return sk.compact(ordered); }, nb::arg("ordered")=true, release_gil(),
+         "Returns a compacted form of the sketch, optionally sorting it")
+    .def("trim", [](UpdateSketch& sk) { sk.trim(); }, release_gil(), "Removes retained entries in excess of the nominal size k (if any)")
+    .def("reset", [](UpdateSketch& sk) { sk.reset(); }, "Resets the sketch to the initial empty state")
+    .def("get_memory_usage", [](const UpdateSketch& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its hash table");
+
+  // lambdas rather than member pointers, since the array operations derive from the upstream classes
+  union_class
+    .def("update", [](Union& u, const Base& sk) { check_operand(u, sk); u.update(sk); }, nb::arg("sketch"), release_gil(),
+         "Updates the union with the given sketch")
+    .def("get_result", [](const Union& u, bool ordered) { return u.get_result(ordered); }, nb::arg("ordered")=true, release_gil(),
+         "Returns the sketch corresponding to the union result")
+    .def("reset", [](Union& u) { u.reset(); },
+         "Resets the union to the initial empty state");
+
+  intersection_class
+    .def("update", [](Intersection& i, const Base& sk) { check_operand(i, sk); i.update(sk); }, nb::arg("sketch"), release_gil(),
+         "Intersects the provided sketch with the current intersection state")
+    .def("get_result", [](const Intersection& i, bool ordered) { return i.get_result(ordered); }, nb::arg("ordered")=true, release_gil(),
+         "Returns the sketch corresponding to the intersection result")
+    .def("has_result", [](const Intersection& i) { return i.has_result(); },
+         "Returns True if the intersection has a valid result, otherwise False");
+}
+
+template<typename K>
+bool is_nan_key(K key) {
+  if constexpr (std::is_floating_point<K>::value) return std::isnan(key);
+  else { unused(key); return false; }
+}
+
+// update(keys, values) for double summaries, where values default to 1 for counting
+template<typename K, typename UpdateSketch>
+void add_array_update(nb::class_<UpdateSketch, tuple_sketch<double>>& clazz) {
+  clazz.def(
+    "update",
+    [](UpdateSketch& sk, nb::ndarray<K> keys, std::optional<nb::ndarray<double>> values) {
+      auto k = view_1d(keys);
+      if (!values) {
+        nb::gil_scoped_release release;
+        for (size_t i = 0; i < k.shape(0); ++i) {
+          if (!is_nan_key(k(i))) sk.update(k(i), 1.0);
+        }
+        return;
+      }
+      auto v = view_1d(*values);
+      if (k.shape(0) != v.shape(0)) {
+        throw std::invalid_argument("keys and values must have the same length: " + std::to_string(k.shape(0))
+          + " vs " + std::to_string(v.shape(0)));
+      }
+      nb::gil_scoped_release release;
+      for (size_t i = 0; i < k.shape(0); ++i) {
+        const double value = v(i);
+        if (!is_nan_key(k(i)) && !std::isnan(value)) sk.update(k(i), value);
+      }
+    },
+    nb::arg("keys"), nb::arg("values")=nb::none(),
+    "Updates the sketch with a NumPy array of keys and an array of the same length of summary values, "
+    "or 1 for every key if values is omitted. Entries with a NaN key or value are skipped."
+  );
+}
+
+template<typename Policy>
+void bind_double_tuple(nb::module_& m, const std::string& suffix, const char* description) {
+  using base_type = tuple_sketch<double>;
+  using update_type = update_tuple_sketch<double, double, Policy>;
+  using union_type = tuple_union<double, Policy>;
+  using intersection_type = tuple_intersection<double, Policy>;
+
+  auto update_class = nb::class_<update_type, base_type>(m, ("update_tuple_sketch_" + suffix).c_str())
+    .def("__init__",
+        [](update_type* sk, uint8_t lg_k, double p, uint64_t seed) {
+          new (sk) update_type(typename update_type::builder(Policy()).set_lg_k(lg_k).set_p(p).set_seed(seed).build());
+        },
+        nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("p")=1.0, nb::arg("seed")=DEFAULT_SEED,
+        (std::string("Creates a tuple sketch whose double summaries hold the ") + description + " of the values of each key\n\n"
+        ":param lg_k: base 2 logarithm of the maximum size of the sketch. Default 12.\n:type lg_k: int, optional\n"
+        ":param p: an initial sampling rate to use. Default 1.0\n:type p: float, optional\n"
+        ":param seed: the seed to use when hashing values\n:type seed: int, optional").c_str()
+    );
+
+  // NumPy overloads first, so arrays are not converted to scalars
+  add_array_update<int64_t>(update_class);
+  add_array_update<double>(update_class);
+
+  update_class
+    .def("update", [](update_type& sk, int64_t datum, double value) { sk.update(datum, value); },
+         nb::arg("datum"), nb::arg("value"),
+         "Updates the sketch with the given integral item and summary value")
+    .def("update", [](update_type& sk, double datum, double value) { sk.update(datum, value); },
+         nb::arg("datum"), nb::arg("value"),
+         "Updates the sketch with the given floating point item and summary value")
+    .def("update", [](update_type& sk, const std::string& datum, double value) { sk.update(datum, value); },
+         nb::arg("datum"), nb::arg("value"),
+         "Updates the sketch with the given string item and summary value");
+
+  auto union_class = nb::class_<union_type>(m, ("tuple_union_" + suffix).c_str())
+    .def("__init__",
+        [](union_type* u, uint8_t lg_k, double p, uint64_t seed) {
+          new (u) union_type(typename union_type::builder(Policy()).set_lg_k(lg_k).set_p(p).set_seed(seed).build());
+        },
+        nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("p")=1.0, nb::arg("seed")=DEFAULT_SEED,
+        (std::string("Creates a tuple union combining the summaries of matching keys by their ") + description + "\n\n"
+        ":param lg_k: base 2 logarithm of the maximum size of the union. Default 12.\n:type lg_k: int, optional\n"
+        ":param p: an initial sampling rate to use. Default 1.0\n:type p: float, optional\n"
+        ":param seed: the seed to use when hashing values. Must match any sketch seeds.\n:type seed: int, optional").c_str()
+    );
+
+  auto intersection_class = nb::class_<intersection_type>(m, ("tuple_intersection_" + suffix).c_str())
+    .def("__init__",
+        [](intersection_type* sk, uint64_t seed) { new (sk) intersection_type(seed, Policy()); },
+        nb::arg("seed")=DEFAULT_SEED,
+        (std::string("Creates a tuple intersection combining the summaries of matching keys by their ") + description + "\n\n"
+        ":param seed: the seed to use when hashing values. Must match any sketch seeds\n:type seed: int, optional").c_str()
+    );
+
+  bind_native_tuple_operations(update_class, union_class, intersection_class);
+}
+
+// the update policy does not expose its number of values, which array updates must check
+class array_of_doubles_update_sketch: public update_tuple_sketch<double_array, const double*, double_array_sum_policy> {
+  public:
+    using base = update_tuple_sketch<double_array, const double*, double_array_sum_policy>;
+
+    array_of_doubles_update_sketch(uint32_t num_values, uint8_t lg_k, double p, uint64_t seed):
+    base(make(num_values, lg_k, p, seed)),
+    num_values_(num_values)
+    {}
+
+    uint32_t get_num_values() const { return num_values_; }
+
+  private:
+    uint32_t num_values_;
+
+    static base make(uint32_t num_values, uint8_t lg_k, double p, uint64_t seed) {
+      if (num_values == 0) throw std::invalid_argument("num_values must be at least 1");
+      return base::builder(double_array_sum_policy(num_values)).set_lg_k(lg_k).set_p(p).set_seed(seed).build();
+    }
+};
+
+// the union and intersection keep their number of values to check the sketches they are given
+class array_of_doubles_union: public tuple_union<double_array, double_array_sum_policy> {
+  public:
+    using base = tuple_union<double_array, double_array_sum_policy>;
+
+    array_of_doubles_union(uint32_t num_values, uint8_t lg_k, double p, uint64_t seed):
+    base(make(num_values, lg_k, p, seed)),
+    num_values_(num_values)
+    {}
+
+    uint32_t get_num_values() const { return num_values_; }
+
+  private:
+    uint32_t num_values_;
+
+    static base make(uint32_t num_values, uint8_t lg_k, double p, uint64_t seed) {
+      if (num_values == 0) throw std::invalid_argument("num_values must be at least 1");
+      return base::builder(double_array_sum_policy(num_values)).set_lg_k(lg_k).set_p(p).set_seed(seed).build();
+    }
+};
+
+class array_of_doubles_intersection: public tuple_intersection<double_array, double_array_sum_policy> {
+  public:
+    using base = tuple_intersection<double_array, double_array_sum_policy>;
+
+    array_of_doubles_intersection(uint32_t num_values, uint64_t seed):
+    base(seed, make_policy(num_values)),
+    num_values_(num_values)
+    {}
+
+    uint32_t get_num_values() const { return num_values_; }
+
+  private:
+    uint32_t num_values_;
+
+    static double_array_sum_policy make_policy(uint32_t num_values) {
+      if (num_values == 0) throw std::invalid_argument("num_values must be at least 1");
+      return double_array_sum_policy(num_values);
+    }
+};
+
+void bind_array_of_doubles_tuple(nb::module_& m) {
+  using base_type = tuple_sketch<double_array>;
+  using update_type = array_of_doubles_update_sketch;
+  using union_type = array_of_doubles_union;
+  using intersection_type = array_of_doubles_intersection;
+
+  auto update_class = nb::class_<update_type, base_type>(m, "update_tuple_sketch_array_of_doubles")
+    .def("__init__",
+        [](update_type* sk, uint32_t num_values, uint8_t lg_k, double p, uint64_t seed) {
+          new (sk) update_type(num_values, lg_k, p, seed);
+        },
+        nb::arg("num_values"), nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("p")=1.0, nb::arg("seed")=DEFAULT_SEED,
+        "Creates a tuple sketch whose summaries are arrays of num_values doubles, summed element-wise\n\n"
+        ":param num_values: the number of values in each summary\n:type num_values: int\n"
+        ":param lg_k: base 2 logarithm of the maximum size of the sketch. Default 12.\n:type lg_k: int, optional\n"
+        ":param p: an initial sampling rate to use. Default 1.0\n:type p: float, optional\n"
+        ":param seed: the seed to use when hashing values\n:type seed: int, optional"
+    )
+    .def_prop_ro("num_values", [](const update_type& sk) { return sk.get_num_values(); },
+         "The number of values in each summary");
+
+  const auto add_array_update = [&update_class](auto key_tag) {
+    using K = decltype(key_tag);
+    update_class.def(
+      "update",
+      [](update_type& sk, nb::ndarray<K> keys, nb::ndarray<double> values) {
+        auto k = view_1d(keys);
+        const uint32_t num_values = sk.get_num_values();
+        if (values.ndim() != 2 || values.shape(0) != k.shape(0) || values.shape(1) != num_values) {
+          throw std::invalid_argument("values must be a 2D array of shape (" + std::to_string(k.shape(0))
+            + ", " + std::to_string(num_values) + ")");
+        }
+        auto v = values.template view<double, nb::ndim<2>>();
+        nb::gil_scoped_release release;
+        std::vector<double> row(num_values);
+        for (size_t i = 0; i < k.shape(0); ++i) {
+          if (is_nan_key(k(i))) continue;
+          bool has_nan = false;
+          for (uint32_t j = 0; j < num_values; ++j) {
+            row[j] = v(i, j);
+            has_nan |= std::isnan(row[j]);
+          }
+          if (!has_nan) sk.update(k(i), static_cast<const double*>(row.data()));
+        }
+      },
+      nb::arg("keys"), nb::arg("values"),
+      "Updates the sketch with a NumPy array of n keys and a 2D array of shape (n, num_values) of summary values. "
+      "Rows with a NaN key or value are skipped."
+    );
+  };
+  add_array_update(int64_t());
+  add_array_update(double());
+
+  const auto check_values = [](const update_type& sk, const double_array& values) {
+    if (values.size() != sk.get_num_values()) {
+      throw std::invalid_argument("expected " + std::to_string(sk.get_num_values()) + " values, got "
+        + std::to_string(values.size()));
+    }
+    return values.data();
+  };
+  update_class
+    .def("update", [check_values](update_type& sk, int64_t datum, const double_array& values) { sk.update(datum, check_values(sk, values)); },
+         nb::arg("datum"), nb::arg("values"),
+         "Updates the sketch with the given integral item and list of num_values summary values")
+    .def("update", [check_values](update_type& sk, double datum, const double_array& values) { sk.update(datum, check_values(sk, values)); },
+         nb::arg("datum"), nb::arg("values"),
+         "Updates the sketch with the given floating point item and list of num_values summary values")
+    .def("update", [check_values](update_type& sk, const std::string& datum, const double_array& values) { sk.update(datum, check_values(sk, values)); },
+         nb::arg("datum"), nb::arg("values"),
+         "Updates the sketch with the given string item and list of num_values summary values");
+
+  auto union_class = nb::class_<union_type>(m, "tuple_union_array_of_doubles")
+    .def("__init__",
+        [](union_type* u, uint32_t num_values, uint8_t lg_k, double p, uint64_t seed) {
+          new (u) union_type(num_values, lg_k, p, seed);
+        },
+        nb::arg("num_values"), nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("p")=1.0, nb::arg("seed")=DEFAULT_SEED,
+        "Creates a tuple union summing the array summaries of matching keys element-wise\n\n"
+        ":param num_values: the number of values in each summary\n:type num_values: int\n"
+        ":param lg_k: base 2 logarithm of the maximum size of the union. Default 12.\n:type lg_k: int, optional\n"
+        ":param p: an initial sampling rate to use. Default 1.0\n:type p: float, optional\n"
+        ":param seed: the seed to use when hashing values. Must match any sketch seeds.\n:type seed: int, optional"
+    );
+
+  auto intersection_class = nb::class_<intersection_type>(m, "tuple_intersection_array_of_doubles")
+    .def("__init__",
+        [](intersection_type* sk, uint32_t num_values, uint64_t seed) {
+          new (sk) intersection_type(num_values, seed);
+        },
+        nb::arg("num_values"), nb::arg("seed")=DEFAULT_SEED,
+        "Creates a tuple intersection summing the array summaries of matching keys element-wise\n\n"
+        ":param num_values: the number of values in each summary\n:type num_values: int\n"
+        ":param seed: the seed to use when hashing values. Must match any sketch seeds\n:type seed: int, optional"
+    );
+
+  bind_native_tuple_operations(update_class, union_class, intersection_class);
+}
+
+} // namespace
+
+void init_native_tuple(nb::module_ &m) {
+  bind_native_tuple_sketch<double, serde<double>>(m, "double");
+  bind_double_tuple<double_sum_policy>(m, "double_sum", "sum");
+  bind_double_tuple<double_min_policy>(m, "double_min", "minimum");
+  bind_double_tuple<double_max_policy>(m, "double_max", "maximum");
+
+  bind_native_tuple_sketch<double_array, double_array_serde>(m, "array_of_doubles");
+  bind_array_of_doubles_tuple(m);
+}
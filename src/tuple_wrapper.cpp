@@ -24,11 +24,15 @@
 #include <nanobind/intrusive/counter.h>
 #include <nanobind/stl/array.h>
 #include <nanobind/stl/function.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 
 #include "py_serde.hpp"
 #include "py_object_ostream.hpp"
 #include "tuple_policy.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "memory_usage.hpp"
 
 #include "theta_sketch.hpp"
 #include "tuple_sketch.hpp"
@@ -126,6 +130,9 @@ void init_tuple(nb::module_ &m) {
          ":param summary: a summary to use for every sketch entry\n:type summary: object"
          )
     .def("__copy__", [](const py_compact_tuple& sk){ return py_compact_tuple(sk); })
+    .def("get_memory_usage", [](const py_compact_tuple& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its entries. "
+         "Summaries are counted as references only.")
     .def(
         "serialize",
         [](const py_compact_tuple& sk, py_object_serde& serde) {
@@ -134,6 +141,14 @@ void init_tuple(nb::module_ &m) {
         }, nb::arg("serde"),
         "Serializes the sketch into a bytes object"
     )
+    .def(
+        "serialize_into",
+        [](const py_compact_tuple& sk, nb::handle buffer, py_object_serde& serde, size_t offset) {
+          return serialize_into_buffer_for<nb::object>(buffer, offset, [&](std::ostream& os) { sk.serialize(os, serde); });
+        }, nb::arg("buffer"), nb::arg("serde"), nb::arg("offset")=0,
+        "Serializes the sketch using the provided serde into a writable buffer, such as a bytearray, NumPy uint8 array or mmap, "
+        "starting at offset and returns the number of bytes written. Raises a ValueError if the image does not fit."
+    )
     .def("filter",
          [](const py_compact_tuple& sk, const std::function<bool(const nb::object&)> func) {
            return sk.filter(func);
@@ -144,11 +159,13 @@ void init_tuple(nb::module_ &m) {
          ":return: A compact_tuple_sketch with the selected entries\n:rtype: :class:`compact_tuple_sketch`")
     .def_static(
         "deserialize",
-        [](const nb::bytes& bytes, py_object_serde& serde, uint64_t seed) {
-          return py_compact_tuple::deserialize(bytes.c_str(), bytes.size(), seed, serde);
+        [](nb::handle bytes, py_object_serde& serde, uint64_t seed, size_t offset, std::optional<size_t> length) {
+          py_byte_range range(bytes, offset, length);
+          return py_compact_tuple::deserialize(range.data(), range.size(), seed, serde);
         },
-        nb::arg("bytes"), nb::arg("serde"), nb::arg("seed")=DEFAULT_SEED,
-        "Reads a bytes object and returns the corresponding compact_tuple_sketch"
+        nb::arg("bytes"), nb::arg("serde"), nb::arg("seed")=DEFAULT_SEED, nb::arg("offset")=0, nb::arg("length")=nb::none(),
+        "Reads a bytes object, or length bytes starting at offset of any contiguous buffer, "
+        "and returns the corresponding compact_tuple_sketch"
     );
 
   nb::class_<py_update_tuple, py_tuple_sketch>(m, "update_tuple_sketch")
@@ -178,6 +195,9 @@ void init_tuple(nb::module_ &m) {
          "Returns a compacted form of the sketch, optionally sorting it")
     .def("trim", &py_update_tuple::trim, "Removes retained entries in excess of the nominal size k (if any)")
     .def("reset", &py_update_tuple::reset, "Resets the sketch to the initial empty state")
+    .def("get_memory_usage", [](const py_update_tuple& sk) { return get_memory_usage(sk); },
+         "Returns the approximate number of bytes held by the sketch, including its hash table. "
+         "Summaries are counted as references only.")
     .def("filter",
          [](const py_update_tuple& sk, const std::function<bool(const nb::object&)> func) {
            return sk.filter(func);
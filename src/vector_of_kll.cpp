@@ -17,20 +17,36 @@
  * under the License.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <functional>
+#include <map>
+#include <mutex>
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/variant.h>
 #include <nanobind/stl/vector.h>
 #include <nanobind/stl/string.h>
 
 #include "kll_sketch.hpp"
+#include "gil_guard.hpp"
+#include "py_buffer.hpp"
+#include "batch_serde.hpp"
+#include "arrow_array.hpp"
+#include "pickle_support.hpp"
+#include "sorted_view.hpp"
+#include "parallel.hpp"
+#include "memory_usage.hpp"
+#include "merge_tree.hpp"
 
 namespace nb = nanobind;
 
@@ -39,13 +55,17 @@ namespace datasketches {
 namespace vector_of_kll_constants {
   static const uint32_t DEFAULT_K = kll_constants::DEFAULT_K;
   static const uint32_t DEFAULT_D = 1;
+  static const unsigned DEFAULT_NUM_THREADS = 1;
+  // target size of the block of a row-major input updated at once by each thread
+  static const size_t UPDATE_BLOCK_BYTES = 1 << 17;
 }
 
 // Wrapper class for Numpy compatibility
 template <typename T, typename C = std::less<T>>
 class vector_of_kll_sketches {
   public:
-    explicit vector_of_kll_sketches(uint32_t k = vector_of_kll_constants::DEFAULT_K, uint32_t d = vector_of_kll_constants::DEFAULT_D);
+    explicit vector_of_kll_sketches(uint32_t k = vector_of_kll_constants::DEFAULT_K, uint32_t d = vector_of_kll_constants::DEFAULT_D,
+                                    unsigned num_threads = vector_of_kll_constants::DEFAULT_NUM_THREADS);
     vector_of_kll_sketches(const vector_of_kll_sketches& other);
     vector_of_kll_sketches(vector_of_kll_sketches&& other) noexcept;
     vector_of_kll_sketches<T, C>& operator=(const vector_of_kll_sketches& other);
@@ -55,6 +75,10 @@ class vector_of_kll_sketches {
     inline uint32_t get_k() const;
     inline uint32_t get_d() const;
 
+    // number of threads used for updates, merges and queries, 0 meaning one per hardware thread
+    inline unsigned get_num_threads() const;
+    inline void set_num_threads(unsigned num_threads);
+
     template<typename V>
     using Array1D = nb::ndarray<V, nb::numpy, nb::ndim<1>>;
 
@@ -63,14 +87,31 @@ class vector_of_kll_sketches {
 
     // sketch updates/merges
     void update(nb::ndarray<T>& items, char order);
+    // one column per sketch of an Arrow record batch, table or struct array
+    void update_arrow(nb::handle batch);
     void merge(const vector_of_kll_sketches<T>& other);
 
     template<typename V>
     using ArrInputType = std::variant<nb::ndarray<>, nb::list, V>;
 
-    // returns a single sketch combining all data in the array
+    // returns the sketch at the given index
+    const kll_sketch<T, C>& get_sketch(uint32_t idx) const;
+    // the version of the sketch at idx, bumped on every change to it
+    const uint64_t& get_version(uint32_t idx) const { return versions_[idx]; }
+
+    // returns a single sketch combining all data in the array,
+    // taken from the cache when the indices are those of a collapse group
     kll_sketch<T, C> collapse(ArrInputType<int>& isk) const;
 
+    // Collapse groups: sets of indices whose merged sketch is cached and kept up to date
+    // incrementally by a merge_tree, remerging only the paths of the sketches changed since.
+    // Groups are kept by copies, but not serialized.
+    int add_collapse_group(ArrInputType<int>& isk);
+    void remove_collapse_group(int group);
+    std::vector<int> get_collapse_groups() const;
+    kll_sketch<T, C> collapse_group(int group) const;
+    Array2D<T> get_group_quantiles(ArrInputType<double>& ranks, ArrInputType<int>& groups) const;
+
     // sketch queries returning an array of results
     Array1D<bool> is_empty() const;
     Array1D<uint64_t> get_n() const;
@@ -78,6 +119,7 @@ class vector_of_kll_sketches {
     Array1D<T> get_min_values() const;
     Array1D<T> get_max_values() const;
     Array1D<uint32_t> get_num_retained() const;
+    size_t get_memory_usage() const;
     Array2D<T> get_quantiles(ArrInputType<double>& ranks, ArrInputType<int>& isk) const;
     Array2D<double> get_ranks(ArrInputType<T>& values, ArrInputType<int>& isk) const;
     Array2D<double> get_pmf(ArrInputType<T>& split_points, ArrInputType<int>& isk) const;
@@ -90,13 +132,24 @@ class vector_of_kll_sketches {
     nb::list serialize(ArrInputType<int>& isk);
     // note: deserialize() replaces the sketch at the specified
     //       index. Not a static method.
-    void deserialize(const nb::bytes& sk_bytes, uint32_t idx);
+    void deserialize(nb::handle sk_bytes, uint32_t idx, size_t offset, std::optional<size_t> length);
+    // packed batch of images, see batch_serde.hpp
+    nb::bytes serialize_batch(ArrInputType<int>& isk);
+    void deserialize_batch(nb::handle bytes, ArrInputType<int>& isk);
+    // self-contained image of the whole vector, as used for pickling:
+    // uint32 k and num_threads followed by a batch of every sketch
+    std::vector<char> serialize_vector() const;
+    static vector_of_kll_sketches deserialize_vector(const char* data, size_t size);
 
   private:
     template<typename TT>
     Array1D<TT> input_to_vec(ArrInputType<TT>& input) const;
 
     Array1D<uint32_t> get_indices(Array1D<int>& isk) const;
+
+    // threads to use for a query over the given sketches, which must be distinct since
+    // a sketch may build its sorted view on the first query
+    unsigned get_query_threads(const Array1D<uint32_t>& indices) const;
     
     template<typename TT>
     Array1D<TT> make_ndarray(size_t size) const;
@@ -104,15 +157,43 @@ class vector_of_kll_sketches {
     template<typename TT>
     Array2D<TT> make_ndarray(size_t rows, size_t cols) const;
 
+    struct collapse_group_state {
+      std::vector<uint32_t> members;
+      std::vector<uint64_t> seen_versions; // versions of the members when last merged
+      merge_tree<kll_sketch<T, C>> tree;
+    };
+
+    // bumps the version of every sketch, for changes to all of them
+    void mark_all_changed();
+    // bumps the versions of the sketches whose stream length differs from the given one,
+    // for updates, which leave a sketch unchanged when every value for it is skipped
+    std::vector<uint64_t> get_stream_lengths() const;
+    void mark_changed_since(const std::vector<uint64_t>& stream_lengths);
+
+    // the following require groups_mutex_
+    collapse_group_state& find_group(int group) const;
+    const kll_sketch<T, C>& refresh_group(collapse_group_state& group) const;
+
     const uint32_t k_; // kll sketch k parameter
     const uint32_t d_; // number of dimensions (here: sketches) to hold
+    unsigned num_threads_; // threads used for updates, merges and queries across sketches
     std::vector<kll_sketch<T, C>> sketches_;
+    std::vector<uint64_t> versions_; // bumped on every change to the sketch of the same index
+
+    // refreshed by const queries run without the GIL, hence mutable and locked
+    mutable std::mutex groups_mutex_;
+    mutable std::map<int, collapse_group_state> groups_;
+    std::map<std::vector<uint32_t>, int> group_ids_; // by members
+    int next_group_id_;
 };
 
 template<typename T, typename C>
-vector_of_kll_sketches<T, C>::vector_of_kll_sketches(uint32_t k, uint32_t d):
+vector_of_kll_sketches<T, C>::vector_of_kll_sketches(uint32_t k, uint32_t d, unsigned num_threads):
 k_(k), 
-d_(d)
+d_(d),
+num_threads_(num_threads),
+versions_(d, 0),
+next_group_id_(0)
 {
   // check d is valid (k is checked by kll_sketch)
   if (d < 1) {
@@ -130,14 +211,26 @@ template<typename T, typename C>
 vector_of_kll_sketches<T, C>::vector_of_kll_sketches(const vector_of_kll_sketches& other) :
   k_(other.k_),
   d_(other.d_),
-  sketches_(other.sketches_)
-{}
+  num_threads_(other.num_threads_),
+  sketches_(other.sketches_),
+  versions_(other.versions_)
+{
+  std::lock_guard<std::mutex> lock(other.groups_mutex_);
+  groups_ = other.groups_;
+  group_ids_ = other.group_ids_;
+  next_group_id_ = other.next_group_id_;
+}
 
 template<typename T, typename C>
 vector_of_kll_sketches<T, C>::vector_of_kll_sketches(vector_of_kll_sketches&& other) noexcept :
   k_(other.k_),
   d_(other.d_),
-  sketches_(std::move(other.sketches_))
+  num_threads_(other.num_threads_),
+  sketches_(std::move(other.sketches_)),
+  versions_(std::move(other.versions_)),
+  groups_(std::move(other.groups_)),
+  group_ids_(std::move(other.group_ids_)),
+  next_group_id_(other.next_group_id_)
 {}
 
 template<typename T, typename C>
@@ -145,7 +238,13 @@ vector_of_kll_sketches<T, C>& vector_of_kll_sketches<T, C>::operator=(const vect
   vector_of_kll_sketches<T, C> copy(other);
   k_ = copy.k_;
   d_ = copy.d_;
+  num_threads_ = copy.num_threads_;
   std::swap(sketches_, copy.sketches_);
+  std::swap(versions_, copy.versions_);
+  std::lock_guard<std::mutex> lock(groups_mutex_);
+  std::swap(groups_, copy.groups_);
+  std::swap(group_ids_, copy.group_ids_);
+  next_group_id_ = copy.next_group_id_;
   return *this;
 }
 
@@ -153,7 +252,13 @@ template<typename T, typename C>
 vector_of_kll_sketches<T, C>& vector_of_kll_sketches<T, C>::operator=(vector_of_kll_sketches&& other) {
   k_ = other.k_;
   d_ = other.d_;
+  num_threads_ = other.num_threads_;
   std::swap(sketches_, other.sketches_);
+  std::swap(versions_, other.versions_);
+  std::lock_guard<std::mutex> lock(groups_mutex_);
+  std::swap(groups_, other.groups_);
+  std::swap(group_ids_, other.group_ids_);
+  next_group_id_ = other.next_group_id_;
   return *this;
 }
 
@@ -167,6 +272,44 @@ uint32_t vector_of_kll_sketches<T, C>::get_d() const {
   return d_;
 }
 
+template<typename T, typename C>
+unsigned vector_of_kll_sketches<T, C>::get_num_threads() const {
+  return num_threads_;
+}
+
+template<typename T, typename C>
+void vector_of_kll_sketches<T, C>::set_num_threads(unsigned num_threads) {
+  num_threads_ = num_threads;
+}
+
+template<typename T, typename C>
+void vector_of_kll_sketches<T, C>::mark_all_changed() {
+  for (uint64_t& version: versions_) ++version;
+}
+
+template<typename T, typename C>
+std::vector<uint64_t> vector_of_kll_sketches<T, C>::get_stream_lengths() const {
+  std::vector<uint64_t> stream_lengths(d_);
+  for (uint32_t i = 0; i < d_; ++i) stream_lengths[i] = sketches_[i].get_n();
+  return stream_lengths;
+}
+
+template<typename T, typename C>
+void vector_of_kll_sketches<T, C>::mark_changed_since(const std::vector<uint64_t>& stream_lengths) {
+  for (uint32_t i = 0; i < d_; ++i) {
+    if (sketches_[i].get_n() != stream_lengths[i]) ++versions_[i];
+  }
+}
+
+template<typename T, typename C>
+const kll_sketch<T, C>& vector_of_kll_sketches<T, C>::get_sketch(uint32_t idx) const {
+  if (idx >= d_) {
+    throw std::invalid_argument("request for invalid dimensions >= d ("
+             + std::to_string(d_) +"): "+ std::to_string(idx));
+  }
+  return sketches_[idx];
+}
+
 template<typename T, typename C>
 template<typename TT>
 auto vector_of_kll_sketches<T, C>::make_ndarray(size_t size) const -> Array1D<TT> {
@@ -243,6 +386,17 @@ auto vector_of_kll_sketches<T, C>::get_indices(Array1D<int>& isk) const -> Array
   return output;
 }
 
+template<typename T, typename C>
+unsigned vector_of_kll_sketches<T, C>::get_query_threads(const Array1D<uint32_t>& indices) const {
+  if (num_threads_ == 1) return 1;
+  std::vector<bool> seen(d_, false);
+  for (size_t i = 0; i < indices.shape(0); ++i) {
+    if (seen[indices(i)]) return 1;
+    seen[indices(i)] = true;
+  }
+  return num_threads_;
+}
+
 // Checks if each sketch is empty or not
 template<typename T, typename C>
 auto vector_of_kll_sketches<T, C>::is_empty() const -> Array1D<bool> {
@@ -257,63 +411,114 @@ auto vector_of_kll_sketches<T, C>::is_empty() const -> Array1D<bool> {
 // Updates each sketch with values
 // Currently: all values must be present
 // TODO: allow subsets of sketches to be updated
+// Each sketch receives its values in row order, so the result does not depend on the memory
+// layout or on the number of threads. The layout is taken from the array strides, and order
+// is accepted only for compatibility.
 template<typename T, typename C>
 void vector_of_kll_sketches<T, C>::update(nb::ndarray<T>& items, char order) {
+  unused(order);
   size_t ndim = items.ndim();
 
   if (items.shape(ndim-1) != d_) {
     throw std::invalid_argument("input data must have rows with  " + std::to_string(d_)
           + " elements. Found: " + std::to_string(items.shape(ndim-1)));
   }
-  
+  if (ndim > 2) {
+    throw std::invalid_argument("Update input must be 2 or fewer dimensions : " + std::to_string(ndim));
+  }
+
+  const std::vector<uint64_t> stream_lengths = get_stream_lengths();
+  // only raw array data is touched from here on
+  nb::gil_scoped_release release;
   if (ndim == 1) {
-    // 1D case: single value to update per sketch
-    const T* data = items.data();
+    // 1D case: single value to update per sketch, too little work to share across threads
+    auto data = items.template view<T, nb::ndim<1>>();
     for (uint32_t i = 0; i < d_; ++i) {
-      sketches_[i].update(data[i]);
+      sketches_[i].update(data(i));
     }
   }
-  else if (ndim == 2) {
+  else {
     // 2D case: multiple values to update per sketch
-    // We could speedthis up by using raw array access and pre-computing an offset for the
-    // row/column, but if we use the wrong ordering the computation would be incorrect.
-    // By using a view and dereferencing by (row, column) each time we ensure correct
-    // processing at the cost of an extra multiply each derference. Using a mismatched
-    // ordering versus the actual data storage will be potentially slower but will still
-    // produce correct output.
-    auto data = items.template view<nb::ndim<2>>();
-    if (order == 'F' || order == 'f') { // Fortran-style (column-major) order
-      for (uint32_t j = 0; j < d_; ++j) {
-        const size_t offset = j * d_;
-        for (uint32_t i = 0; i < items.shape(0); ++i) { 
-          sketches_[j].update(data(i, j));
+    // Each thread owns a contiguous range of columns (sketches). Column-major input already
+    // gives each sketch a contiguous run of its values. Row-major input is processed in blocks
+    // of rows small enough to stay in cache, so that each sketch takes a run of values from
+    // the block while the cache lines it shares with neighbouring columns are reused.
+    auto data = items.template view<T, nb::ndim<2>>();
+    const size_t num_rows = data.shape(0);
+    const bool column_major = items.stride(0) < items.stride(1);
+    parallel_for_chunks(d_, num_threads_, [&](size_t first, size_t last) {
+      if (column_major) {
+        for (size_t j = first; j < last; ++j) {
+          for (size_t i = 0; i < num_rows; ++i) {
+            sketches_[j].update(data(i, j));
+          }
         }
-      }
-    } else { // nb::c_contig or nb::any_contig
-      for (uint32_t i = 0; i < items.shape(0); ++i) { 
-        const size_t offset = i * items.shape(0);
-        for (uint32_t j = 0; j < d_; ++j) {
-          sketches_[j].update(data(i, j));
+      } else {
+        const size_t block_rows = std::max<size_t>(16,
+          vector_of_kll_constants::UPDATE_BLOCK_BYTES / ((last - first) * sizeof(T)));
+        for (size_t row = 0; row < num_rows; row += block_rows) {
+          const size_t row_end = std::min(num_rows, row + block_rows);
+          for (size_t j = first; j < last; ++j) {
+            for (size_t i = row; i < row_end; ++i) {
+              sketches_[j].update(data(i, j));
+            }
+          }
         }
       }
-    }
-  }
-  else {
-    throw std::invalid_argument("Update input must be 2 or fewer dimensions : " + std::to_string(ndim));
+    });
   }
+  mark_changed_since(stream_lengths);
 }
 
 // Merges two arrays of sketches
 // Currently: all values must be present
+template<typename T, typename C>
+void vector_of_kll_sketches<T, C>::update_arrow(nb::handle batch) {
+  for_each_arrow_chunk(batch, [this](const ArrowSchema& schema, const ArrowArray& chunk) {
+    if (schema.format == nullptr || std::strcmp(schema.format, "+s") != 0) {
+      throw std::invalid_argument("input must be an Arrow record batch, table or struct array with a column per sketch");
+    }
+    if (schema.n_children != d_ || chunk.n_children != d_) {
+      throw std::invalid_argument("input must have " + std::to_string(d_) + " columns. Found: "
+        + std::to_string(schema.n_children));
+    }
+    std::vector<arrow_type> types;
+    types.reserve(d_);
+    for (uint32_t j = 0; j < d_; ++j) {
+      types.push_back(get_arrow_type(*schema.children[j]));
+      if (types.back().kind == arrow_kind::BINARY) {
+        throw std::invalid_argument("column " + std::to_string(j) + " is a utf8 or binary column, not numeric");
+      }
+    }
+
+    const std::vector<uint64_t> stream_lengths = get_stream_lengths();
+    // only Arrow buffers are touched from here on; each thread updates a range of columns
+    nb::gil_scoped_release release;
+    parallel_for(d_, num_threads_, [&](size_t j) {
+      // the rows of a struct array are offset into its columns as well
+      for_each_arrow_value(types[j], *chunk.children[j], chunk.offset, [this, j](auto value) {
+        if constexpr (std::is_arithmetic<decltype(value)>::value) {
+          if constexpr (std::is_floating_point<decltype(value)>::value) {
+            if (std::isnan(value)) return;
+          }
+          sketches_[j].update(static_cast<T>(value));
+        }
+      });
+    });
+    mark_changed_since(stream_lengths);
+  });
+}
+
 template<typename T, typename C>
 void vector_of_kll_sketches<T, C>::merge(const vector_of_kll_sketches<T>& other) {
   if (d_ != other.get_d()) {
     throw std::invalid_argument("Must have same number of dimensions to merge: " + std::to_string(d_)
                                 + " vs " + std::to_string(other.d_));
   } else {
-    for (uint32_t i = 0; i < d_; ++i) {
+    mark_all_changed();
+    parallel_for(d_, num_threads_, [&](size_t i) {
       sketches_[i].merge(other.sketches_[i]);
-    }
+    });
   }
 }
 
@@ -322,14 +527,120 @@ kll_sketch<T, C> vector_of_kll_sketches<T, C>::collapse(ArrInputType<int>& isk)
   Array1D<int> indices = input_to_vec<int>(isk);
   Array1D<uint32_t> index_arr = get_indices(indices);
   auto inds = index_arr.view();
-  
+
+  std::vector<uint32_t> members(inds.data(), inds.data() + inds.shape(0));
+
+  nb::gil_scoped_release release;
+  {
+    std::lock_guard<std::mutex> lock(groups_mutex_);
+    auto it = group_ids_.find(members);
+    if (it != group_ids_.end()) return refresh_group(groups_.at(it->second));
+  }
   kll_sketch<T, C> result(k_);
-  for (size_t idx = 0; idx < inds.shape(0); ++idx) {
-    result.merge(sketches_[inds(idx)]);
+  for (uint32_t idx: members) {
+    result.merge(sketches_[idx]);
   }
   return result;
 }
 
+template<typename T, typename C>
+auto vector_of_kll_sketches<T, C>::find_group(int group) const -> collapse_group_state& {
+  auto it = groups_.find(group);
+  if (it == groups_.end()) throw std::invalid_argument("unknown collapse group: " + std::to_string(group));
+  return it->second;
+}
+
+template<typename T, typename C>
+const kll_sketch<T, C>& vector_of_kll_sketches<T, C>::refresh_group(collapse_group_state& group) const {
+  for (size_t i = 0; i < group.members.size(); ++i) {
+    const uint64_t version = versions_[group.members[i]];
+    if (group.seen_versions[i] != version) {
+      group.tree.invalidate(i);
+      group.seen_versions[i] = version;
+    }
+  }
+  return group.tree.refresh([this, &group](size_t i) -> const kll_sketch<T, C>& {
+    return sketches_[group.members[i]];
+  }, num_threads_);
+}
+
+template<typename T, typename C>
+int vector_of_kll_sketches<T, C>::add_collapse_group(ArrInputType<int>& isk) {
+  Array1D<int> indices = input_to_vec<int>(isk);
+  Array1D<uint32_t> inds = get_indices(indices);
+  if (inds.shape(0) == 0) throw std::invalid_argument("a collapse group needs at least one sketch");
+  std::vector<uint32_t> members(inds.data(), inds.data() + inds.shape(0));
+
+  nb::gil_scoped_release release;
+  std::lock_guard<std::mutex> lock(groups_mutex_);
+  auto it = group_ids_.find(members);
+  if (it != group_ids_.end()) return it->second;
+  std::vector<uint64_t> seen_versions;
+  seen_versions.reserve(members.size());
+  for (uint32_t idx: members) seen_versions.push_back(versions_[idx]);
+  // every node starts dirty, so the first collapse merges all members
+  merge_tree<kll_sketch<T, C>> tree(members.size(), kll_sketch<T, C>(k_));
+  const int group = next_group_id_++;
+  group_ids_.emplace(members, group);
+  groups_.emplace(group, collapse_group_state{std::move(members), std::move(seen_versions), std::move(tree)});
+  return group;
+}
+
+template<typename T, typename C>
+void vector_of_kll_sketches<T, C>::remove_collapse_group(int group) {
+  nb::gil_scoped_release release;
+  std::lock_guard<std::mutex> lock(groups_mutex_);
+  group_ids_.erase(find_group(group).members);
+  groups_.erase(group);
+}
+
+template<typename T, typename C>
+std::vector<int> vector_of_kll_sketches<T, C>::get_collapse_groups() const {
+  std::lock_guard<std::mutex> lock(groups_mutex_);
+  std::vector<int> result;
+  for (const auto& entry: groups_) result.push_back(entry.first);
+  return result;
+}
+
+template<typename T, typename C>
+kll_sketch<T, C> vector_of_kll_sketches<T, C>::collapse_group(int group) const {
+  nb::gil_scoped_release release;
+  std::lock_guard<std::mutex> lock(groups_mutex_);
+  return refresh_group(find_group(group));
+}
+
+// Value of the merged sketch of each group corresponding to some quantile(s)
+template<typename T, typename C>
+auto vector_of_kll_sketches<T, C>::get_group_quantiles(ArrInputType<double>& ranks,
+                                                       ArrInputType<int>& groups) const -> Array2D<T> {
+  Array1D<int> group_arr = input_to_vec<int>(groups);
+  auto group_view = group_arr.view();
+  std::vector<int> ids(group_view.shape(0));
+  for (size_t i = 0; i < ids.size(); ++i) ids[i] = group_view(i);
+  Array1D<double> ranks_arr = input_to_vec<double>(ranks);
+  auto ranks_view = ranks_arr.view();
+  std::vector<double> rank_values(ranks_view.shape(0));
+  for (size_t j = 0; j < rank_values.size(); ++j) rank_values[j] = ranks_view(j);
+
+  std::vector<T> quantiles;
+  {
+    nb::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(groups_mutex_);
+    if (ids.size() == 1 && ids[0] == -1) {
+      ids.clear();
+      for (const auto& entry: groups_) ids.push_back(entry.first);
+    }
+    quantiles.reserve(ids.size() * rank_values.size());
+    for (int id: ids) {
+      const kll_sketch<T, C>& merged = refresh_group(find_group(id));
+      for (double rank: rank_values) quantiles.push_back(merged.get_quantile(rank));
+    }
+  }
+  auto result = make_ndarray<T>(ids.size(), rank_values.size());
+  std::copy(quantiles.begin(), quantiles.end(), result.data());
+  return result;
+}
+
 // Number of updates for each sketch
 template<typename T, typename C>
 auto vector_of_kll_sketches<T, C>::get_n() const -> Array1D<uint64_t> {
@@ -352,6 +663,20 @@ auto vector_of_kll_sketches<T, C>::get_num_retained() const -> Array1D<uint32_t>
   return vals;
 }
 
+template<typename T, typename C>
+size_t vector_of_kll_sketches<T, C>::get_memory_usage() const {
+  size_t bytes = sizeof(*this) + (sketches_.capacity() - sketches_.size()) * sizeof(kll_sketch<T, C>);
+  for (const auto& sk: sketches_) bytes += sketch_memory_usage(sk);
+  bytes += versions_.capacity() * sizeof(uint64_t);
+  std::lock_guard<std::mutex> lock(groups_mutex_);
+  for (const auto& entry: groups_) {
+    const collapse_group_state& group = entry.second;
+    bytes += group.tree.get_memory_usage()
+      + 2 * group.members.capacity() * sizeof(uint32_t) + group.seen_versions.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
 // Gets the minimum value of each sketch
 // TODO: allow subsets of sketches
 template<typename T, typename C>
@@ -416,11 +741,13 @@ auto vector_of_kll_sketches<T, C>::get_quantiles(ArrInputType<double>& ranks,
   auto quants = make_ndarray<T>(num_sketches, num_quantiles);
   auto view = quants.view();
   auto ranks_view = ranks_arr.view();
-  for (uint32_t i = 0; i < num_sketches; ++i) {
+  const unsigned num_threads = get_query_threads(inds);
+  nb::gil_scoped_release release;
+  parallel_for(num_sketches, num_threads, [&](size_t i) {
     for (size_t j = 0; j < num_quantiles; ++j) {
       view(i, j) = sketches_[inds(i)].get_quantile(ranks_view(j));
     }
-  }
+  });
   return quants;
 }
 
@@ -438,12 +765,13 @@ auto vector_of_kll_sketches<T, C>::get_ranks(ArrInputType<T>& values,
 
   auto ranks = make_ndarray<double>(num_sketches, num_ranks);
   auto view = ranks.view();
-  for (uint32_t i = 0; i < num_sketches; ++i) {
-    const size_t offset = i * num_ranks;
+  const unsigned num_threads = get_query_threads(inds);
+  nb::gil_scoped_release release;
+  parallel_for(num_sketches, num_threads, [&](size_t i) {
     for (size_t j = 0; j < num_ranks; ++j) {
       view(i, j) = sketches_[inds(i)].get_rank(vals(j));
     }
-  }
+  });
   return ranks;
 }
 
@@ -460,12 +788,14 @@ auto vector_of_kll_sketches<T, C>::get_pmf(ArrInputType<T>& split_points,
   
   auto pmfs = make_ndarray<double>(num_sketches, num_splits + 1);
   auto view = pmfs.view();
-  for (uint32_t i = 0; i < num_sketches; ++i) {
+  const unsigned num_threads = get_query_threads(inds);
+  nb::gil_scoped_release release;
+  parallel_for(num_sketches, num_threads, [&](size_t i) {
     auto pmf = sketches_[inds(i)].get_PMF(splits_arr.data(), num_splits);
     for (size_t j = 0; j <= num_splits; ++j) {
       view(i, j) = pmf[j];
     }
-  }
+  });
   return pmfs;
 }
 
@@ -482,24 +812,31 @@ auto vector_of_kll_sketches<T, C>::get_cdf(ArrInputType<T>& split_points,
 
   auto cdfs = make_ndarray<double>(num_sketches, num_splits + 1);
   auto view = cdfs.view();
-  for (uint32_t i = 0; i < num_sketches; ++i) {
+  const unsigned num_threads = get_query_threads(inds);
+  nb::gil_scoped_release release;
+  parallel_for(num_sketches, num_threads, [&](size_t i) {
     auto cdf = sketches_[inds(i)].get_CDF(splits_arr.data(), num_splits);
     for (size_t j = 0; j <= num_splits; ++j) {
       view(i, j) = cdf[j];
     }
-  }
+  });
   return cdfs;
 }
 
 template<typename T, typename C>
-void vector_of_kll_sketches<T, C>::deserialize(const nb::bytes& sk_bytes,
-                                               uint32_t idx) {
+void vector_of_kll_sketches<T, C>::deserialize(nb::handle sk_bytes,
+                                               uint32_t idx,
+                                               size_t offset,
+                                               std::optional<size_t> length) {
   if (idx >= d_) {
     throw std::invalid_argument("request for invalid dimensions >= d ("
              + std::to_string(d_) +"): "+ std::to_string(idx));
   }
   // load the sketch into the proper index
-  sketches_[idx] = std::move(kll_sketch<T>::deserialize(sk_bytes.c_str(), sk_bytes.size()));
+  py_byte_range range(sk_bytes, offset, length);
+  nb::gil_scoped_release release;
+  sketches_[idx] = kll_sketch<T, C>::deserialize(range.data(), range.size());
+  ++versions_[idx];
 }
 
 template<typename T, typename C>
@@ -508,27 +845,106 @@ nb::list vector_of_kll_sketches<T, C>::serialize(ArrInputType<int>& isk) {
   Array1D<uint32_t> inds = get_indices(indices);
   const size_t num_sketches = inds.size();
 
+  std::vector<typename kll_sketch<T, C>::vector_bytes> images;
+  images.reserve(num_sketches);
+  {
+    nb::gil_scoped_release release;
+    for (uint32_t i = 0; i < num_sketches; ++i) {
+      images.push_back(sketches_[inds(i)].serialize());
+    }
+  }
+
   nb::list list;
-  for (uint32_t i = 0; i < num_sketches; ++i) {
-    auto serResult = sketches_[inds(i)].serialize();
-    list.append(nb::bytes((char*)serResult.data(), serResult.size()));
+  for (const auto& image: images) {
+    list.append(nb::bytes(reinterpret_cast<const char*>(image.data()), image.size()));
   }
 
   return list;
 }
 
+template<typename T, typename C>
+nb::bytes vector_of_kll_sketches<T, C>::serialize_batch(ArrInputType<int>& isk) {
+  Array1D<int> indices = input_to_vec<int>(isk);
+  Array1D<uint32_t> inds = get_indices(indices);
+  const size_t num_sketches = inds.size();
+
+  std::vector<typename kll_sketch<T, C>::vector_bytes> images;
+  images.reserve(num_sketches);
+  {
+    nb::gil_scoped_release release;
+    for (uint32_t i = 0; i < num_sketches; ++i) {
+      images.push_back(sketches_[inds(i)].serialize());
+    }
+  }
+  return make_batch(images);
+}
+
+template<typename T, typename C>
+void vector_of_kll_sketches<T, C>::deserialize_batch(nb::handle bytes, ArrInputType<int>& isk) {
+  Array1D<int> indices = input_to_vec<int>(isk);
+  Array1D<uint32_t> inds = get_indices(indices);
+  py_byte_range range(bytes);
+  batch_reader reader(range.data(), range.size());
+  if (reader.num_images() != inds.size()) {
+    throw std::invalid_argument("batch holds " + std::to_string(reader.num_images()) + " sketches but "
+      + std::to_string(inds.size()) + " indices were requested");
+  }
+
+  nb::gil_scoped_release release;
+  // deserialize everything before replacing anything, so a bad image leaves the vector unchanged
+  std::vector<kll_sketch<T, C>> sketches;
+  sketches.reserve(reader.num_images());
+  for (size_t i = 0; i < reader.num_images(); ++i) {
+    sketches.push_back(kll_sketch<T, C>::deserialize(reader.image(i), reader.image_size(i)));
+  }
+  for (size_t i = 0; i < sketches.size(); ++i) {
+    sketches_[inds(i)] = std::move(sketches[i]);
+    ++versions_[inds(i)];
+  }
+}
+
+template<typename T, typename C>
+std::vector<char> vector_of_kll_sketches<T, C>::serialize_vector() const {
+  std::vector<typename kll_sketch<T, C>::vector_bytes> images;
+  images.reserve(d_);
+  for (const auto& sk: sketches_) images.push_back(sk.serialize());
+  const uint32_t header[2] = {k_, static_cast<uint32_t>(num_threads_)};
+  std::vector<char> bytes(sizeof(header) + batch_size(images));
+  std::memcpy(bytes.data(), header, sizeof(header));
+  write_batch(images, bytes.data() + sizeof(header));
+  return bytes;
+}
+
+template<typename T, typename C>
+vector_of_kll_sketches<T, C> vector_of_kll_sketches<T, C>::deserialize_vector(const char* data, size_t size) {
+  uint32_t header[2];
+  if (size < sizeof(header)) {
+    throw std::invalid_argument("vector of KLL sketches image of " + std::to_string(size) + " bytes is too small");
+  }
+  std::memcpy(header, data, sizeof(header));
+  batch_reader reader(data + sizeof(header), size - sizeof(header));
+  vector_of_kll_sketches<T, C> result(header[0], static_cast<uint32_t>(reader.num_images()), header[1]);
+  for (size_t i = 0; i < reader.num_images(); ++i) {
+    result.sketches_[i] = kll_sketch<T, C>::deserialize(reader.image(i), reader.image_size(i));
+  }
+  return result;
+}
+
 } // namespace datasketches
 
 template<typename T>
 void bind_vector_of_kll_sketches(nb::module_ &m, const char* name) {
   using namespace datasketches;
 
-  nb::class_<vector_of_kll_sketches<T>>(m, name)
-    .def(nb::init<uint32_t, uint32_t>(), nb::arg("k")=vector_of_kll_constants::DEFAULT_K, 
+  auto clazz = nb::class_<vector_of_kll_sketches<T>>(m, name)
+    .def(nb::init<uint32_t, uint32_t, unsigned>(), nb::arg("k")=vector_of_kll_constants::DEFAULT_K, 
                                          nb::arg("d")=vector_of_kll_constants::DEFAULT_D,
+                                         nb::arg("num_threads")=vector_of_kll_constants::DEFAULT_NUM_THREADS,
          "Creates a new Vector of KLL Sketches instance with the given values of k and d.\n\n"
          ":param k: The value of k for every sketch in the vector\n:type k: int\n"
-         ":param d: The number of sketches in the vector\n:type d: int"
+         ":param d: The number of sketches in the vector\n:type d: int\n"
+         ":param num_threads: The number of native threads across which updates, merges and queries split the sketches, "
+         "or 0 for one per hardware thread. Default is 1.\n:type num_threads: int, optional"
         )
     .def("__copy__", [](const vector_of_kll_sketches<T>& sk){ return vector_of_kll_sketches<T>(sk); })
     // allow user to retrieve k or d, in case it's instantiated w/ defaults
@@ -536,9 +952,15 @@ void bind_vector_of_kll_sketches(nb::module_ &m, const char* name) {
          "The value of `k` of the sketch(es)")
     .def_prop_ro("d", &vector_of_kll_sketches<T>::get_d,
          "The number of sketches")
+    .def_prop_rw("num_threads", &vector_of_kll_sketches<T>::get_num_threads, &vector_of_kll_sketches<T>::set_num_threads,
+         "The number of native threads used for updates, merges and queries, 0 meaning one per hardware thread")
     .def("update", &vector_of_kll_sketches<T>::update, nb::arg("items"), nb::arg("order") = "C",
          "Updates the sketch(es) with value(s).  Must be a 1D array of size equal to the number of sketches.  Can also be 2D array of shape (n_updates, n_sketches).  If a sketch does not have a value to update, use np.nan. "
-         " Order 'F' specifies a column-major (Fortran style) matrix; any other value assumes row-major (C style) matrix.")
+         " The memory layout is taken from the array itself, so `order` is accepted only for compatibility.")
+    .def("update_arrow", &vector_of_kll_sketches<T>::update_arrow, nb::arg("batch"),
+         "Updates sketch j with every non-null value of column j of an Arrow record batch, table or struct array "
+         "of integer or floating point columns, read in place through the Arrow C Data Interface. Tables are read "
+         "batch by batch. NaN values are skipped.")
     .def("__str__", [](const vector_of_kll_sketches<T>& sk) { return sk.to_string(); },
          "Produces a string summary of all sketches. Users should split the returned string by '\\n\\n'")
     .def("to_string", &vector_of_kll_sketches<T>::to_string, nb::arg("print_levels")=false,
@@ -548,6 +970,8 @@ void bind_vector_of_kll_sketches(nb::module_ &m, const char* name) {
          "Returns whether the sketch(es) is(are) empty of not")
     .def("get_n", &vector_of_kll_sketches<T>::get_n, 
          "Returns the number of values seen by the sketch(es)")
+    .def("get_memory_usage", &vector_of_kll_sketches<T>::get_memory_usage, release_gil(),
+         "Returns the approximate number of bytes held by the vector and its sketches")
     .def("get_num_retained", &vector_of_kll_sketches<T>::get_num_retained, 
          "Returns the number of values retained by the sketch(es)")
     .def("is_estimation_mode", &vector_of_kll_sketches<T>::is_estimation_mode, 
@@ -571,13 +995,49 @@ void bind_vector_of_kll_sketches(nb::module_ &m, const char* name) {
          nb::arg("k"), nb::arg("as_pmf"), "Returns the normalized rank error")
     .def("serialize", &vector_of_kll_sketches<T>::serialize, nb::arg("isk")=-1, 
          "Serializes the specified sketch(es). `isk` can be an int or a list/array of ints (default: all sketches)")
-    .def("deserialize", &vector_of_kll_sketches<T>::deserialize, nb::arg("skBytes"), nb::arg("isk"), 
-         "Deserializes the specified sketch.  `isk` must be an int.")
-    .def("merge", &vector_of_kll_sketches<T>::merge, nb::arg("array_of_sketches"),
+    .def("deserialize", &vector_of_kll_sketches<T>::deserialize, nb::arg("skBytes"), nb::arg("isk"),
+         nb::arg("offset")=0, nb::arg("length")=nb::none(),
+         "Deserializes the specified sketch from a bytes object, or from `length` bytes starting at `offset` "
+         "of any contiguous buffer.  `isk` must be an int.")
+    .def("serialize_batch", &vector_of_kll_sketches<T>::serialize_batch, nb::arg("isk")=-1,
+         "Serializes the specified sketch(es) into a single bytes object holding a header, an offset table "
+         "and the concatenated images. `isk` can be an int or a list/array of ints (default: all sketches)")
+    .def("deserialize_batch", &vector_of_kll_sketches<T>::deserialize_batch, nb::arg("bytes"), nb::arg("isk")=-1,
+         "Replaces the specified sketch(es) with those read from a batch written by serialize_batch(), in order. "
+         "`isk` can be an int or a list/array of ints (default: all sketches) and must match the number of sketches in the batch")
+    .def("merge", &vector_of_kll_sketches<T>::merge, nb::arg("array_of_sketches"), release_gil(),
          "Merges the input array of KLL sketches into the existing array.")
     .def("collapse", &vector_of_kll_sketches<T>::collapse, nb::arg("isk")=-1,
-         "Returns the result of collapsing all sketches in the array into a single sketch.  'isk' can be an int or a list/array of ints (default: all sketches)")
+         "Returns the result of collapsing all sketches in the array into a single sketch.  'isk' can be an int or a list/array of ints (default: all sketches). "
+         "When 'isk' lists the sketches of a collapse group, in the same order, the result comes from the cache of that group.")
+    .def("add_collapse_group", &vector_of_kll_sketches<T>::add_collapse_group, nb::arg("isk")=-1,
+         "Registers the specified sketch(es) as a collapse group and returns its id. The merged sketch of a group is "
+         "cached and, when queried, only the sketches changed since the previous query are merged again, along the "
+         "O(log n) path of partial merges above each of them. Registering the same indices again returns the same id. "
+         "'isk' can be an int or a list/array of ints (default: all sketches)")
+    .def("remove_collapse_group", &vector_of_kll_sketches<T>::remove_collapse_group, nb::arg("group"),
+         "Removes the collapse group with the given id and frees its cache")
+    .def("get_collapse_groups", &vector_of_kll_sketches<T>::get_collapse_groups,
+         "Returns the ids of the collapse groups in increasing order")
+    .def("collapse_group", &vector_of_kll_sketches<T>::collapse_group, nb::arg("group"),
+         "Returns the merged sketch of the collapse group with the given id, brought up to date incrementally")
+    .def("get_group_quantiles", &vector_of_kll_sketches<T>::get_group_quantiles, nb::arg("ranks"), nb::arg("groups")=-1,
+         "Returns a 2D array with a row per specified collapse group of the value(s) associated with the specified quantile(s) "
+         "of the merged sketch of the group. `groups` can be a group id or a list/array of ids (default: all groups, in increasing order)")
+    .def("sorted_view",
+         [](const vector_of_kll_sketches<T>& sks, uint32_t isk) {
+           // get_sketch() checks isk, before get_version() reads it
+           const kll_sketch<T>& sk = sks.get_sketch(isk);
+           return py_sorted_view<T, kll_sketch<T>>(sk, &sks.get_version(isk));
+         }, nb::arg("isk"), nb::keep_alive<0, 1>(),
+         "Returns a sorted view of the specified sketch for fast repeated rank and quantile queries. "
+         "The view remains usable until that sketch is next updated, and is of the same type as "
+         "returned by the corresponding kll sketch.  `isk` must be an int.")
     ;
+
+  add_pickle_support(clazz,
+    [](const vector_of_kll_sketches<T>& sks) { return sks.serialize_vector(); },
+    [](const char* data, size_t size) { return vector_of_kll_sketches<T>::deserialize_vector(data, size); });
 }
 
 void init_vector_of_kll(nb::module_ &m) {
@@ -0,0 +1,220 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+
+#include "sketch_families.hpp"
+#include "vector_of_sketches.hpp"
+
+namespace nb = nanobind;
+
+namespace {
+
+using namespace datasketches;
+
+template<typename Family, typename E>
+void add_estimate_queries(nb::class_<vector_of_sketches<Family>>& clazz, E estimate) {
+  using VS = vector_of_sketches<Family>;
+  clazz.def(
+      "get_estimate",
+      [estimate](const VS& vs, const sketch_indices& isk) {
+        return vs.template query<double>(vs.get_indices(isk), [&](const typename Family::sketch_type& sk) {
+          return estimate(vs.get_params(), sk).get_estimate();
+        });
+      },
+      nb::arg("isk")=-1,
+      "Returns a NumPy array of the distinct count estimate of each specified sketch. "
+      "`isk` can be an int or a list of ints (default: all sketches)"
+    )
+    .def(
+      "get_lower_bound",
+      [estimate](const VS& vs, uint8_t num_std_devs, const sketch_indices& isk) {
+        return vs.template query<double>(vs.get_indices(isk), [&](const typename Family::sketch_type& sk) {
+          return estimate(vs.get_params(), sk).get_lower_bound(num_std_devs);
+        });
+      },
+      nb::arg("num_std_devs"), nb::arg("isk")=-1,
+      "Returns a NumPy array of the approximate lower error bound of each specified sketch "
+      "given the number of standard deviations in {1, 2, 3}"
+    )
+    .def(
+      "get_upper_bound",
+      [estimate](const VS& vs, uint8_t num_std_devs, const sketch_indices& isk) {
+        return vs.template query<double>(vs.get_indices(isk), [&](const typename Family::sketch_type& sk) {
+          return estimate(vs.get_params(), sk).get_upper_bound(num_std_devs);
+        });
+      },
+      nb::arg("num_std_devs"), nb::arg("isk")=-1,
+      "Returns a NumPy array of the approximate upper error bound of each specified sketch "
+      "given the number of standard deviations in {1, 2, 3}"
+    );
+}
+
+void bind_vector_of_hll_sketches(nb::module_& m) {
+  using VS = vector_of_sketches<hll_family>;
+  auto clazz = bind_vector_of_sketches<hll_family>(m, "vector_of_hll_sketches",
+      "A vector of d HLL sketches updated together from the columns of 2D arrays");
+  clazz
+    .def(
+      "__init__",
+      [](VS* vs, uint8_t lg_k, target_hll_type tgt_type, uint32_t d, unsigned num_threads) {
+        new (vs) VS(hll_family::params_type{lg_k, tgt_type}, d, num_threads);
+      },
+      nb::arg("lg_k"), nb::arg("tgt_type")=HLL_8, nb::arg("d")=vector_of_sketches_constants::DEFAULT_D,
+      nb::arg("num_threads")=vector_of_sketches_constants::DEFAULT_NUM_THREADS,
+      "Creates a new vector of HLL sketches.\n\n"
+      ":param lg_k: The value of lg_k for every sketch in the vector, between 7 and 21, inclusive\n:type lg_k: int\n"
+      ":param tgt_type: The HLL mode of every sketch in the vector\n:type tgt_type: tgt_hll_type\n"
+      ":param d: The number of sketches in the vector\n:type d: int\n"
+      ":param num_threads: The number of native threads across which updates, merges and queries split the sketches, "
+      "or 0 for one per hardware thread. Default is 1.\n:type num_threads: int, optional"
+    )
+    .def_prop_ro("lg_k", [](const VS& vs) { return vs.get_params().lg_k; },
+         "The value of `lg_k` of the sketches")
+    .def_prop_ro("tgt_type", [](const VS& vs) { return vs.get_params().tgt_type; },
+         "The HLL type of the sketches");
+
+  const char* update_doc = "Updates the sketches with a 1D array of d values or a 2D array of shape (n_updates, d), "
+    "where column j updates sketch j. Use np.nan to skip a value. "
+    "The memory layout is taken from the array itself, so `order` is accepted only for compatibility.";
+  add_vector_of_sketches_update<int64_t>(clazz, update_doc);
+  add_vector_of_sketches_update<double>(clazz, update_doc);
+  add_estimate_queries(clazz, [](const hll_family::params_type&, const hll_family::sketch_type& sk) -> const hll_family::sketch_type& { return sk; });
+}
+
+void bind_vector_of_theta_sketches(nb::module_& m) {
+  using VS = vector_of_sketches<theta_family>;
+  auto clazz = bind_vector_of_sketches<theta_family>(m, "vector_of_theta_sketches",
+      "A vector of d Theta sketches updated together from the columns of 2D arrays");
+  clazz
+    .def(
+      "__init__",
+      [](VS* vs, uint8_t lg_k, double p, uint64_t seed, uint32_t d, unsigned num_threads) {
+        new (vs) VS(theta_family::params_type{lg_k, static_cast<float>(p), seed}, d, num_threads);
+      },
+      nb::arg("lg_k")=theta_constants::DEFAULT_LG_K, nb::arg("p")=1.0, nb::arg("seed")=DEFAULT_SEED,
+      nb::arg("d")=vector_of_sketches_constants::DEFAULT_D,
+      nb::arg("num_threads")=vector_of_sketches_constants::DEFAULT_NUM_THREADS,
+      "Creates a new vector of Theta sketches.\n\n"
+      ":param lg_k: Configured size of every sketch in the vector. Default is 12.\n:type lg_k: int, optional\n"
+      ":param p: Initial sampling probability. Default is 1.0.\n:type p: float, optional\n"
+      ":param seed: Seed for the hash function. Default is 9001.\n:type seed: int, optional\n"
+      ":param d: The number of sketches in the vector\n:type d: int\n"
+      ":param num_threads: The number of native threads across which updates, merges and queries split the sketches, "
+      "or 0 for one per hardware thread. Default is 1.\n:type num_threads: int, optional"
+    )
+    .def_prop_ro("lg_k", [](const VS& vs) { return vs.get_params().lg_k; },
+         "The value of `lg_k` of the sketches")
+    .def_prop_ro("seed", [](const VS& vs) { return vs.get_params().seed; },
+         "The seed of the sketches");
+
+  const char* update_doc = "Updates the sketches with a 1D array of d values or a 2D array of shape (n_updates, d), "
+    "where column j updates sketch j. Use np.nan to skip a value. "
+    "The memory layout is taken from the array itself, so `order` is accepted only for compatibility.";
+  add_vector_of_sketches_update<int64_t>(clazz, update_doc);
+  add_vector_of_sketches_update<double>(clazz, update_doc);
+  add_estimate_queries(clazz, [](const theta_family::params_type& params, const theta_column& column) {
+    return theta_family::compact(column, params);
+  });
+}
+
+void bind_vector_of_tdigests(nb::module_& m) {
+  using VS = vector_of_sketches<tdigest_family>;
+  auto clazz = bind_vector_of_sketches<tdigest_family>(m, "vector_of_tdigests",
+      "A vector of d t-digests updated together from the columns of 2D arrays");
+  clazz
+    .def(
+      "__init__",
+      [](VS* vs, uint16_t k, uint32_t d, unsigned num_threads) {
+        new (vs) VS(tdigest_family::params_type{k}, d, num_threads);
+      },
+      nb::arg("k")=tdigest<double>::DEFAULT_K, nb::arg("d")=vector_of_sketches_constants::DEFAULT_D,
+      nb::arg("num_threads")=vector_of_sketches_constants::DEFAULT_NUM_THREADS,
+      "Creates a new vector of t-digests.\n\n"
+      ":param k: Controls the size/accuracy trade-off of every digest in the vector. Default is 200.\n:type k: int, optional\n"
+      ":param d: The number of digests in the vector\n:type d: int\n"
+      ":param num_threads: The number of native threads across which updates, merges and queries split the digests, "
+      "or 0 for one per hardware thread. Default is 1.\n:type num_threads: int, optional"
+    )
+    .def_prop_ro("k", [](const VS& vs) { return vs.get_params().k; },
+         "The value of `k` of the digests")
+    .def(
+      "get_total_weight",
+      [](const VS& vs, const sketch_indices& isk) {
+        return vs.query<uint64_t>(vs.get_indices(isk), [](const tdigest_family::sketch_type& td) { return td.get_total_weight(); });
+      },
+      nb::arg("isk")=-1,
+      "Returns a NumPy array of the total weight processed by each specified digest"
+    )
+    .def(
+      "get_quantiles",
+      [](const VS& vs, nb::ndarray<double> ranks, const sketch_indices& isk) {
+        auto r = view_1d(ranks);
+        std::vector<double> rank_values(r.shape(0));
+        for (size_t j = 0; j < rank_values.size(); ++j) {
+          if (!(r(j) >= 0.0 && r(j) <= 1.0)) {
+            throw std::invalid_argument("normalized rank cannot be less than zero or greater than 1.0");
+          }
+          rank_values[j] = r(j);
+        }
+        return vs.query_rows<double>(vs.get_indices(isk), rank_values.size(), [&](const tdigest_family::sketch_type& td, double* out) {
+          for (size_t j = 0; j < rank_values.size(); ++j) {
+            out[j] = td.is_empty() ? std::numeric_limits<double>::quiet_NaN() : td.get_quantile(rank_values[j]);
+          }
+        });
+      },
+      nb::arg("ranks"), nb::arg("isk")=-1,
+      "Returns a 2D NumPy array with a row per specified digest of the approximate quantile at each of the "
+      "given normalized ranks, or NaN for an empty digest"
+    )
+    .def(
+      "get_ranks",
+      [](const VS& vs, nb::ndarray<double> values, const sketch_indices& isk) {
+        auto v = view_1d(values);
+        std::vector<double> items(v.shape(0));
+        for (size_t j = 0; j < items.size(); ++j) items[j] = v(j);
+        return vs.query_rows<double>(vs.get_indices(isk), items.size(), [&](const tdigest_family::sketch_type& td, double* out) {
+          for (size_t j = 0; j < items.size(); ++j) {
+            out[j] = td.is_empty() ? std::numeric_limits<double>::quiet_NaN() : td.get_rank(items[j]);
+          }
+        });
+      },
+      nb::arg("values"), nb::arg("isk")=-1,
+      "Returns a 2D NumPy array with a row per specified digest of the approximate normalized rank of each of "
+      "the given values, or NaN for an empty digest"
+    );
+
+  add_vector_of_sketches_update<double>(clazz,
+    "Updates the digests with a 1D array of d values or a 2D array of shape (n_updates, d), "
+    "where column j updates digest j. Use np.nan to skip a value. "
+    "The memory layout is taken from the array itself, so `order` is accepted only for compatibility.");
+}
+
+} // namespace
+
+void init_vector_of_sketches(nb::module_& m) {
+  bind_vector_of_hll_sketches(m);
+  bind_vector_of_theta_sketches(m);
+  bind_vector_of_tdigests(m);
+}
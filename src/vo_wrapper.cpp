@@ -17,24 +17,98 @@
  * under the License.
  */
 
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
 #include <nanobind/nanobind.h>
 #include <nanobind/make_iterator.h>
+#include <nanobind/ndarray.h>
 #include <nanobind/stl/function.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
 
 #include "py_serde.hpp"
 #include "py_object_ostream.hpp"
+#include "py_buffer.hpp"
+#include "buffer_ostream.hpp"
+#include "quantile_conditional.hpp"
+#include "sampling_conditional.hpp"
 
 #include "var_opt_sketch.hpp"
 #include "var_opt_union.hpp"
 
 namespace nb = nanobind;
 
+namespace {
+
+nb::dict to_dict(const datasketches::subset_summary& summary) {
+  nb::dict d;
+  d["estimate"] = summary.estimate;
+  d["lower_bound"] = summary.lower_bound;
+  d["upper_bound"] = summary.upper_bound;
+  d["total_sketch_weight"] = summary.total_sketch_weight;
+  return d;
+}
+
+// NumPy updates, samples and subset sums for numeric items
+template<typename T>
+void add_numeric_methods(nb::class_<datasketches::var_opt_sketch<T>>& clazz) {
+  using namespace datasketches;
+  using SK = var_opt_sketch<T>;
+
+  add_weighted_vector_update<T>(clazz);
+
+  clazz
+    .def("get_samples",
+         [](const SK& sk) {
+           auto items = make_numpy_array<T>(sk.get_num_samples());
+           auto weights = make_numpy_array<double>(sk.get_num_samples());
+           size_t i = 0;
+           for (const auto& sample: sk) {
+             items.data()[i] = sample.first;
+             weights.data()[i] = sample.second;
+             ++i;
+           }
+           return std::make_pair(std::move(items), std::move(weights));
+         },
+         "Returns a tuple of NumPy arrays (items, weights) of the samples, in the order of iteration")
+    .def("estimate_subset_sum",
+         [](const SK& sk, nb::ndarray<bool> mask) {
+           auto m = view_1d(mask);
+           if (m.shape(0) != sk.get_num_samples()) {
+             throw std::invalid_argument("mask must have one entry per sample: expected " + std::to_string(sk.get_num_samples())
+               + ", found " + std::to_string(m.shape(0)));
+           }
+           // the predicate sees the samples once each, in the order of iteration
+           size_t i = 0;
+           return to_dict(sk.estimate_subset_sum([&m, &i](const T&) { return m(i++); }));
+         }, nb::arg("mask"),
+         "Returns the estimated total weight of the samples selected by a boolean NumPy array with one entry per "
+         "sample in the order of iteration (as returned by get_samples()), as well as upper and lower bounds on the "
+         "estimate and the total weight processed by the sketch")
+    .def("estimate_subset_sum_range",
+         [](const SK& sk, T lower, T upper) {
+           return to_dict(sk.estimate_subset_sum([lower, upper](const T& item) { return item >= lower && item <= upper; }));
+         }, nb::arg("lower"), nb::arg("upper"),
+         "Returns the estimated total weight of the items in the closed range [lower, upper], as well as upper and "
+         "lower bounds on the estimate and the total weight processed by the sketch, without calling into Python");
+}
+
+} // namespace
+
 template<typename T>
 void bind_vo_sketch(nb::module_ &m, const char* name) {
   using namespace datasketches;
 
-  nb::class_<var_opt_sketch<T>>(m, name)
+  auto clazz = nb::class_<var_opt_sketch<T>>(m, name);
+
+  // the NumPy array update must be registered before the scalar one
+  if constexpr (std::is_arithmetic<T>::value) add_numeric_methods<T>(clazz);
+
+  clazz
     .def(nb::init<uint32_t>(), nb::arg("k"),
          "Creates a new Var Opt sketch instance\n\n"
          ":param k: Maximum number of samples in the sketch\n:type k: int\n"
@@ -63,31 +137,10 @@ void bind_vo_sketch(nb::module_ &m, const char* name) {
          "Returns True if the sketch is empty, otherwise False")
     .def("estimate_subset_sum",
          [](const var_opt_sketch<T>& sk, const std::function<bool(T)> func) {
-           subset_summary summary = sk.estimate_subset_sum(func);
-           nb::dict d;
-           d["estimate"] = summary.estimate;
-           d["lower_bound"] = summary.lower_bound;
-           d["upper_bound"] = summary.upper_bound;
-           d["total_sketch_weight"] = summary.total_sketch_weight;
-           return d;
+           return to_dict(sk.estimate_subset_sum(func));
          }, nb::arg("predicate"),
          "Applies a provided predicate to the sketch and returns the estimated total weight matching the predicate, as well "
          "as upper and lower bounds on the estimate and the total weight processed by the sketch")
-    .def("get_serialized_size_bytes",
-         [](const var_opt_sketch<T>& sk, py_object_serde& serde) { return sk.get_serialized_size_bytes(serde); },
-         nb::arg("serde"),
-         "Computes the size in bytes needed to serialize the current sketch")
-    .def("serialize",
-         [](const var_opt_sketch<T>& sk, py_object_serde& serde) {
-           auto bytes = sk.serialize(0, serde);
-           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
-         }, nb::arg("serde"),
-         "Serializes the sketch into a bytes object")
-    .def_static(
-         "deserialize",
-         [](const nb::bytes& bytes, py_object_serde& serde) { return var_opt_sketch<T>::deserialize(bytes.c_str(), bytes.size(), serde); },
-         nb::arg("bytes"), nb::arg("serde"),
-         "Reads a bytes object and returns the corresponding var opt sketch")
     .def("__iter__",
           [](const var_opt_sketch<T>& sk) {
                return nb::make_iterator(nb::type<var_opt_sketch<T>>(),
@@ -97,13 +150,16 @@ void bind_vo_sketch(nb::module_ &m, const char* name) {
           }, nb::keep_alive<0,1>()
      )
      ;
+
+  add_serialized_size<T>(clazz);
+  add_serialization<T>(clazz);
 }
 
 template<typename T>
 void bind_vo_union(nb::module_ &m, const char* name) {
   using namespace datasketches;
 
-  nb::class_<var_opt_union<T>>(m, name)
+  auto clazz = nb::class_<var_opt_union<T>>(m, name)
     .def(nb::init<uint32_t>(), nb::arg("max_k"))
     .def("__str__", [](const var_opt_union<T>& sk) { return sk.to_string(); },
          "Produces a string summary of the sketch")
@@ -115,25 +171,17 @@ void bind_vo_union(nb::module_ &m, const char* name) {
          "Returns a sketch corresponding to the union result")
     .def("reset", &var_opt_union<T>::reset,
          "Resets the union to the empty state")
-    .def("get_serialized_size_bytes",
-         [](const var_opt_union<T>& u, py_object_serde& serde) { return u.get_serialized_size_bytes(serde); },
-         nb::arg("serde"),
-         "Computes the size in bytes needed to serialize the current union")
-    .def("serialize",
-         [](const var_opt_union<T>& u, py_object_serde& serde) {
-           auto bytes = u.serialize(0, serde);
-           return nb::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
-         }, nb::arg("serde"),
-         "Serializes the union into a bytes object with the provided serde")
-    .def_static(
-         "deserialize",
-         [](const nb::bytes& bytes, py_object_serde& serde) { return var_opt_union<T>::deserialize(bytes.c_str(), bytes.size(), serde); },
-         nb::arg("bytes"), nb::arg("serde"),
-         "Constructs a var opt union from the given bytes using the provided serde")
     ;
+
+  add_serialized_size<T>(clazz);
+  add_serialization<T>(clazz);
 }
 
 void init_vo(nb::module_ &m) {
   bind_vo_sketch<nb::object>(m, "var_opt_sketch");
   bind_vo_union<nb::object>(m, "var_opt_union");
+  bind_vo_sketch<int64_t>(m, "var_opt_ints_sketch");
+  bind_vo_union<int64_t>(m, "var_opt_ints_union");
+  bind_vo_sketch<double>(m, "var_opt_doubles_sketch");
+  bind_vo_union<double>(m, "var_opt_doubles_union");
 }
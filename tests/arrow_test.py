@@ -0,0 +1,116 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import unittest
+
+import numpy as np
+
+from datasketches import (kll_floats_sketch, kll_ints_sketch, tdigest_double, hll_sketch, cpc_sketch,
+                          update_theta_sketch, count_min_sketch, vector_of_kll_floats_sketches)
+
+try:
+    import pyarrow as pa
+except ImportError:
+    pa = None
+
+class ArrowTest(unittest.TestCase):
+    def test_arrow_rejects_other_objects(self):
+        with self.assertRaises(ValueError):
+            kll_floats_sketch(200).update_arrow(np.arange(10.0))
+        with self.assertRaises(ValueError):
+            hll_sketch(12).update_arrow([1, 2, 3])
+
+    @unittest.skipIf(pa is None, "pyarrow is not installed")
+    def test_arrow_quantiles(self):
+        values = [1.5, None, 3.0, float('nan'), 7.25, None, 2.0]
+        kept = [1.5, 3.0, 7.25, 2.0]
+        kll = kll_floats_sketch(200)
+        kll.update_arrow(pa.array(values, type=pa.float64()))
+        self.assertEqual(kll.n, len(kept))
+        self.assertEqual(kll.get_min_value(), 1.5)
+        self.assertEqual(kll.get_max_value(), 7.25)
+
+        # chunked arrays, slices and narrow integer types
+        chunked = pa.chunked_array([pa.array([1, None, 3], type=pa.int8()), pa.array([4, 5, 6], type=pa.int8())[1:]])
+        ints = kll_ints_sketch(200)
+        ints.update_arrow(chunked)
+        self.assertEqual(ints.n, 4)
+        self.assertEqual(ints.get_min_value(), 1)
+        self.assertEqual(ints.get_max_value(), 6)
+
+        td = tdigest_double(100)
+        td.update_arrow(pa.array(np.arange(1000, dtype=np.float32)))
+        self.assertEqual(td.get_total_weight(), 1000)
+
+        with self.assertRaises(ValueError):
+            kll.update_arrow(pa.array(['a', 'b']))
+
+    @unittest.skipIf(pa is None, "pyarrow is not installed")
+    def test_arrow_distinct_counting(self):
+        n = 10000
+        ints = pa.array(list(range(n)) + [None] * 100, type=pa.int32())
+        strings = pa.chunked_array([pa.array([str(i) for i in range(n // 2)] + [None, '']),
+                                    pa.array([str(i) for i in range(n // 2, n)], type=pa.large_string())])
+        for make in (lambda: hll_sketch(12), lambda: cpc_sketch(11), lambda: update_theta_sketch(12)):
+            # integers of any width hash as int, and strings as str
+            ref = make()
+            ref.update(np.arange(n, dtype=np.int64))
+            sk = make()
+            sk.update_arrow(ints)
+            self.assertEqual(sk.get_estimate(), ref.get_estimate())
+
+            ref = make()
+            ref.update_strings(np.array([str(i) for i in range(n)]))
+            sk = make()
+            sk.update_arrow(strings)
+            self.assertEqual(sk.get_estimate(), ref.get_estimate())
+
+    @unittest.skipIf(pa is None, "pyarrow is not installed")
+    def test_arrow_count_min(self):
+        cm = count_min_sketch(5, 256)
+        cm.update_arrow(pa.array([1, 2, 2, None, 3, 3, 3], type=pa.int16()))
+        cm.update_arrow(pa.array(['x', 'x', None]))
+        self.assertEqual(cm.total_weight, 8)
+        self.assertGreaterEqual(cm.get_estimate(3), 3)
+        self.assertGreaterEqual(cm.get_estimate('x'), 2)
+        with self.assertRaises(ValueError):
+            cm.update_arrow(pa.array([1.0, 2.0]))
+
+    @unittest.skipIf(pa is None, "pyarrow is not installed")
+    def test_arrow_vector_of_kll(self):
+        d = 3
+        data = np.random.rand(1000, d).astype(np.float32)
+        table = pa.table({'c%d' % j: pa.array(data[:, j]) for j in range(d)})
+        vk = vector_of_kll_floats_sketches(k=200, d=d, num_threads=2)
+        vk.update_arrow(table)
+        ref = vector_of_kll_floats_sketches(k=200, d=d)
+        ref.update(data)
+        np.testing.assert_array_equal(vk.get_n(), ref.get_n())
+        np.testing.assert_array_equal(vk.get_min_values(), ref.get_min_values())
+        np.testing.assert_array_equal(vk.get_max_values(), ref.get_max_values())
+
+        batch = pa.record_batch([pa.array([1.0, None]), pa.array([None, 2.0]), pa.array([3.0, 4.0])],
+                                names=['a', 'b', 'c'])
+        vk = vector_of_kll_floats_sketches(k=200, d=d)
+        vk.update_arrow(batch)
+        np.testing.assert_array_equal(vk.get_n(), [1, 1, 2])
+
+        with self.assertRaises(ValueError):
+            vector_of_kll_floats_sketches(k=200, d=2).update_arrow(batch)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -17,6 +17,7 @@
   
 import unittest
 from datasketches import count_min_sketch
+import numpy as np
 
 class CountMinTest(unittest.TestCase):
   def test_count_min_example(self):
@@ -86,5 +87,58 @@ class CountMinTest(unittest.TestCase):
     self.assertGreater(len(cm.to_string()), 0)
     self.assertEqual(len(cm.__str__()), len(cm.to_string()))
 
+  def test_count_min_arrays(self):
+    num_hashes = 5
+    num_buckets = 1000
+    keys = np.random.randint(0, 200, size=50000).astype(np.int64)
+    weights = np.random.randint(1, 10, size=len(keys)).astype(np.float64)
+
+    cm = count_min_sketch(num_hashes, num_buckets)
+    cm.update(keys, weights)
+    expected = count_min_sketch(num_hashes, num_buckets)
+    for key, weight in zip(keys, weights):
+      expected.update(int(key), float(weight))
+    self.assertEqual(cm.total_weight, expected.total_weight)
+
+    queries = np.arange(-10, 250, dtype=np.int64)
+    estimates = cm.get_estimates(queries)
+    self.assertEqual(list(estimates), [expected.get_estimate(int(q)) for q in queries])
+
+    # weights default to 1
+    cm2 = count_min_sketch(num_hashes, num_buckets)
+    cm2.update(np.array([3, 3, 4], dtype=np.int64))
+    self.assertEqual(cm2.total_weight, 3)
+    self.assertGreaterEqual(cm2.get_estimate(3), 2)
+
+    with self.assertRaises(ValueError):
+      cm2.update(keys, weights[:10])
+
+    # weights of both signs are applied as by scalar updates, which add each magnitude to total_weight
+    mixed = count_min_sketch(num_hashes, num_buckets)
+    mixed.update(np.array([7, 7, 8], dtype=np.int64), np.array([5.0, -5.0, 2.0]))
+    expected = count_min_sketch(num_hashes, num_buckets)
+    for key, weight in ((7, 5.0), (7, -5.0), (8, 2.0)):
+      expected.update(key, weight)
+    self.assertEqual(mixed.total_weight, expected.total_weight)
+    self.assertEqual(mixed.get_estimate(7), expected.get_estimate(7))
+    self.assertEqual(mixed.get_estimate(8), expected.get_estimate(8))
+
+  def test_count_min_strings(self):
+    items = np.array(['apple', 'banana', 'apple', '', 'cherry'])
+    cm = count_min_sketch(3, 100)
+    cm.update_strings(items, np.array([1.0, 2.0, 3.0, 4.0, 5.0]))
+    self.assertEqual(cm.total_weight, 11) # the empty item is ignored
+
+    expected = count_min_sketch(3, 100)
+    expected.update('apple', 4.0)
+    expected.update('banana', 2.0)
+    expected.update('cherry', 5.0)
+    estimates = cm.get_estimates_strings(np.array(['apple', 'banana', 'cherry', 'durian', '']))
+    self.assertEqual(list(estimates), [expected.get_estimate(s) for s in ['apple', 'banana', 'cherry', 'durian']] + [0])
+
+    # bytes arrays hash like their unicode equivalents
+    cm.update_strings(np.array([b'apple']))
+    self.assertEqual(cm.get_estimates_strings(np.array(['apple']))[0], cm.get_estimate('apple'))
+
 if __name__ == '__main__':
     unittest.main()
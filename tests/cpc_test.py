@@ -17,6 +17,7 @@
 
 import unittest
 from datasketches import cpc_sketch, cpc_union
+import numpy as np
 
 class CpcTest(unittest.TestCase):
   def test_cpc_example(self):
@@ -69,5 +70,34 @@ class CpcTest(unittest.TestCase):
     cpc = cpc_sketch(lgk)
     self.assertEqual(cpc.lg_k, lgk)
 
+  def test_cpc_vector_update(self):
+    lgk = 10
+    n = 5000
+
+    # array updates hash each value exactly as a scalar update would
+    cpc_scalar = cpc_sketch(lgk)
+    for i in range(n):
+      cpc_scalar.update(i)
+    cpc = cpc_sketch(lgk)
+    cpc.update(np.arange(n, dtype=np.uint64))
+    self.assertEqual(cpc.get_estimate(), cpc_scalar.get_estimate())
+    cpc = cpc_sketch(lgk)
+    cpc.update(np.arange(n, dtype=np.int64))
+    self.assertEqual(cpc.get_estimate(), cpc_scalar.get_estimate())
+
+    strs = [str(i) for i in range(n)]
+    cpc_scalar = cpc_sketch(lgk)
+    for s in strs:
+      cpc_scalar.update(s)
+    cpc = cpc_sketch(lgk)
+    cpc.update_strings(np.array(strs))
+    self.assertEqual(cpc.get_estimate(), cpc_scalar.get_estimate())
+
+    encoded = [s.encode() for s in strs]
+    offsets = np.cumsum([0] + [len(b) for b in encoded], dtype=np.int64)
+    cpc = cpc_sketch(lgk)
+    cpc.update_binary(offsets, np.frombuffer(b''.join(encoded), dtype=np.uint8))
+    self.assertEqual(cpc.get_estimate(), cpc_scalar.get_estimate())
+
 if __name__ == '__main__':
     unittest.main()
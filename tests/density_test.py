@@ -17,6 +17,7 @@
 
 import unittest
 from datasketches import density_sketch, KernelFunction, GaussianKernel
+from datasketches import gaussian_kernel, laplacian_kernel, polynomial_kernel
 import numpy as np
 
 class UnitSphereKernel(KernelFunction):
@@ -93,5 +94,89 @@ class densityTest(unittest.TestCase):
     sphericalRebuilt = density_sketch.deserialize(sk_bytes, UnitSphereKernel())
     self.assertEqual(sphericalSketch.get_estimate([1.001, 1]), sphericalRebuilt.get_estimate([1.001, 1]))
 
+  def test_native_kernels(self):
+    a = np.array([1.0, 2.0, 3.0, 4.0, 5.0])
+    b = np.array([0.5, 2.5, 1.0, 4.0, -1.0])
+
+    # built-in kernels are callable like Python ones
+    self.assertAlmostEqual(gaussian_kernel(2.0)(a, b), GaussianKernel(2.0)(a, b))
+    self.assertAlmostEqual(laplacian_kernel(2.0)(a, b), np.exp(-np.abs(a - b).sum() / 2.0))
+    self.assertAlmostEqual(polynomial_kernel(3, 0.5, 2.0)(a, b), (0.5 * np.dot(a, b) + 2.0) ** 3)
+    self.assertEqual(gaussian_kernel(2.0).bandwidth, 2.0)
+    self.assertEqual(polynomial_kernel().degree, 2)
+
+    with self.assertRaises(ValueError):
+      gaussian_kernel(0.0)
+    with self.assertRaises(ValueError):
+      polynomial_kernel(0)
+
+    # a native Gaussian kernel matches the Python one with the same bandwidth
+    native = density_sketch(10, 2, gaussian_kernel())
+    python = density_sketch(10, 2, GaussianKernel())
+    for p in [[0, 0], [1, 2], [3, 1]]:
+      native.update(p)
+      python.update(p)
+    self.assertAlmostEqual(native.get_estimate([1, 1]), python.get_estimate([1, 1]))
+
+    for i in range(100):
+      native.update([i % 7, i % 11])
+    self.assertGreater(native.get_estimate([3, 5]), 0)
+
+    sk_bytes = native.serialize()
+    rebuilt = density_sketch.deserialize(sk_bytes, gaussian_kernel())
+    self.assertEqual(native.get_estimate([3, 5]), rebuilt.get_estimate([3, 5]))
+
+  def test_get_estimates(self):
+    sketch = density_sketch(10, 3, laplacian_kernel(0.5))
+    for i in range(1000):
+      sketch.update([i % 13, i % 17, i % 19])
+
+    points = np.random.rand(50, 3) * 10
+    expected = [sketch.get_estimate(list(p)) for p in points]
+    self.assertTrue(np.allclose(sketch.get_estimates(points), expected))
+    self.assertTrue(np.allclose(sketch.get_estimates(points, num_threads=4), expected))
+
+    # strided input and Python kernels work too
+    self.assertTrue(np.allclose(sketch.get_estimates(np.asfortranarray(points)), expected))
+    python = density_sketch(10, 3, GaussianKernel())
+    python.update([1, 2, 3])
+    self.assertEqual(len(python.get_estimates(points, num_threads=2)), len(points))
+
+    with self.assertRaises(ValueError):
+      sketch.get_estimates(np.zeros((5, 2)))
+
+  def test_array_update(self):
+    dim = 4
+    points = np.random.rand(500, dim)
+    sketch = density_sketch(10, dim, gaussian_kernel())
+    sketch.update(points)
+    self.assertEqual(sketch.n, 500)
+    sketch.update(points[0])
+    sketch.update(points[::2, :]) # not contiguous
+    self.assertEqual(sketch.n, 751)
+    with self.assertRaises(ValueError):
+      sketch.update(np.zeros((3, dim + 1)))
+    with self.assertRaises(ValueError):
+      sketch.update(np.array(1.0))
+    self.assertEqual(sketch.n, 751)
+
+    retained, weights = sketch.get_points()
+    self.assertEqual(retained.shape, (sketch.num_retained, dim))
+    self.assertTrue(retained.flags['C_CONTIGUOUS'])
+    self.assertEqual(len(weights), sketch.num_retained)
+    for (vector, weight), row, w in zip(sketch, retained, weights):
+      self.assertEqual(list(vector), list(row))
+      self.assertEqual(weight, w)
+
+  def test_merge_many(self):
+    sketches = []
+    for i in range(5):
+      sk = density_sketch(10, 2, gaussian_kernel())
+      sk.update(np.random.rand(20, 2))
+      sketches.append(sk)
+    merged = density_sketch(10, 2, gaussian_kernel())
+    merged.merge(sketches)
+    self.assertEqual(merged.n, 100)
+
 if __name__ == '__main__':
     unittest.main()
@@ -18,6 +18,8 @@
 import unittest
 from math import floor, ceil
 from datasketches import ebpps_sketch, PyIntsSerDe, PyStringsSerDe
+from datasketches import ebpps_ints_sketch, ebpps_doubles_sketch
+import numpy as np
 
 class EbppsTest(unittest.TestCase):
   def test_ebpps_example(self):
@@ -113,5 +115,25 @@ class EbppsTest(unittest.TestCase):
     self.assertGreater(len(sk.to_string(True)), 0)
     self.assertEqual(len(sk.__str__()), len(sk.to_string()))
 
+  def test_ebpps_numeric(self):
+    k = 50
+    n = 5 * k
+    sk = ebpps_ints_sketch(k)
+    sk.update(np.arange(n, dtype=np.int64))
+    self.assertEqual(sk.n, n)
+    self.assertAlmostEqual(sk.c, k, places=12)
+    samples = sk.get_samples()
+    self.assertEqual(len(samples), k)
+    self.assertTrue(np.all((samples >= 0) & (samples < n)))
+
+    sk2 = ebpps_doubles_sketch(5)
+    sk2.update(np.array([1.5, 2.5, 3.5]), np.array([1.0, 2.0, 3.0]))
+    self.assertEqual(sorted(sk2.get_samples()), [1.5, 2.5, 3.5])
+    with self.assertRaises(ValueError):
+      sk2.update(np.array([1.0]), np.array([np.inf]))
+
+    rebuilt = ebpps_ints_sketch.deserialize(sk.serialize())
+    self.assertEqual(rebuilt.n, sk.n)
+
 if __name__ == '__main__':
   unittest.main()
@@ -16,8 +16,10 @@
 # under the License.
  
 import unittest
+import numpy as np
 from datasketches import frequent_strings_sketch, frequent_items_sketch
-from datasketches import frequent_items_error_type, PyIntsSerDe
+from datasketches import frequent_ints_sketch, frequent_bytes_sketch
+from datasketches import frequent_items_error_type, PyIntsSerDe, PyLongsSerDe
 
 class FiTest(unittest.TestCase):
   def test_fi_strings_example(self):
@@ -148,5 +150,65 @@ class FiTest(unittest.TestCase):
     reference_apriori_error = frequent_strings_sketch.get_apriori_error(k, wt)
     self.assertAlmostEqual(sk_apriori_error, reference_apriori_error, delta=1e-6)
 
+  def test_fi_ints_array_update(self):
+    k = 6
+    items = np.arange(-1000, 1000, dtype=np.int64) % 50
+    weights = (items + 100).astype(np.int64)
+
+    fi = frequent_ints_sketch(k)
+    fi.update(items, weights)
+    fi_scalar = frequent_ints_sketch(k)
+    for item, weight in zip(items.tolist(), weights.tolist()):
+      fi_scalar.update(item, weight)
+    self.assertEqual(fi.total_weight, int(weights.sum()))
+    self.assertEqual(fi.serialize(), fi_scalar.serialize())
+
+    # without weights each item counts once, and strided input is fine
+    fi2 = frequent_ints_sketch(k)
+    fi2.update(items[::2])
+    self.assertEqual(fi2.total_weight, 1000)
+    fi.merge(fi2)
+    for row in fi.get_frequent_items(frequent_items_error_type.NO_FALSE_NEGATIVES):
+      self.assertIsInstance(row[0], int)
+      self.assertLessEqual(row[2], row[1])
+
+    # the image uses 64-bit items, so is readable by the generic sketch
+    new_fi = frequent_items_sketch.deserialize(fi.serialize(), PyLongsSerDe())
+    self.assertEqual(new_fi.total_weight, fi.total_weight)
+    self.assertEqual(new_fi.get_estimate(7), fi.get_estimate(7))
+    self.assertEqual(frequent_ints_sketch.deserialize(fi.serialize()).get_estimate(7), fi.get_estimate(7))
+
+    with self.assertRaises(ValueError):
+      fi.update(items, weights[:-1])
+    with self.assertRaises(ValueError):
+      fi.update(items, -weights)
+
+  def test_fi_bytes_array_update(self):
+    k = 5
+    fi = frequent_bytes_sketch(k)
+    fi.update(b'\x00\x01', 3)
+    words = np.array([b'apple', b'kiwi', b'apple', b'fig'])
+    fi.update_strings(words, np.array([1, 2, 3, 4]))
+    self.assertEqual(fi.get_estimate(b'apple'), 4)
+    self.assertEqual(fi.get_estimate(b'\x00\x01'), 3)
+
+    # Arrow-style offsets and data
+    data = b'applefigfig'
+    offsets = np.array([0, 5, 8, 11], dtype=np.int32)
+    fi.update_binary(offsets, data)
+    self.assertEqual(fi.get_estimate(b'fig'), 6)
+    self.assertEqual(fi.total_weight, 16)
+    items = fi.get_frequent_items(frequent_items_error_type.NO_FALSE_POSITIVES)
+    self.assertEqual(items[0][0], b'fig')
+
+    # images match those of the strings sketch for the same items
+    fs = frequent_strings_sketch(k)
+    fs.update_strings(np.array(['apple', 'kiwi', 'fig']), np.array([5, 2, 4]))
+    fb = frequent_bytes_sketch(k)
+    fb.update_strings(np.array([b'apple', b'kiwi', b'fig']), np.array([5, 2, 4]))
+    self.assertEqual(fs.serialize(), fb.serialize())
+    new_fi = frequent_bytes_sketch.deserialize(fi.serialize())
+    self.assertEqual(new_fi.get_estimate(b'fig'), 6)
+
 if __name__ == '__main__':
   unittest.main()
@@ -16,7 +16,9 @@
 # under the License.
 
 import unittest
-from datasketches import hll_sketch, hll_union, tgt_hll_type
+from datasketches import hll_sketch, hll_union, tgt_hll_type, atomic_hll_sketch
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
 
 class HllTest(unittest.TestCase):
     def test_hll_example(self):
@@ -123,6 +125,141 @@ class HllTest(unittest.TestCase):
         self.assertTrue(isinstance(sk, hll_sketch))
         self.assertEqual(sk.tgt_type, tgt_hll_type.HLL_4)
         
+    def test_hll_buffer_deserialize(self):
+        sk = hll_sketch(10, tgt_hll_type.HLL_4)
+        sk.update(np.arange(10000, dtype=np.int64))
+        image = sk.serialize_compact()
+        arena = np.zeros(len(image) + 16, dtype=np.uint8)
+        arena[8:8 + len(image)] = np.frombuffer(image, dtype=np.uint8)
+        new_sk = hll_sketch.deserialize(arena, offset=8, length=len(image))
+        self.assertEqual(new_sk.get_estimate(), sk.get_estimate())
+        new_sk = hll_sketch.deserialize(memoryview(image)[0:len(image)])
+        self.assertEqual(new_sk.get_estimate(), sk.get_estimate())
+        with self.assertRaises(ValueError):
+            hll_sketch.deserialize(image, offset=4, length=len(image))
+        with self.assertRaises(TypeError):
+            hll_sketch.deserialize("not a buffer")
+
+    def test_hll_serialize_into(self):
+        sk = hll_sketch(10, tgt_hll_type.HLL_4)
+        sk.update(np.arange(10000, dtype=np.int64))
+        buf = bytearray(4 + sk.get_compact_serialization_bytes())
+        self.assertEqual(sk.serialize_compact_into(buf, 4), sk.get_compact_serialization_bytes())
+        self.assertEqual(bytes(buf[4:]), sk.serialize_compact())
+        buf = bytearray(sk.get_updatable_serialization_bytes())
+        self.assertEqual(sk.serialize_updatable_into(buf), len(buf))
+        self.assertEqual(hll_sketch.deserialize(buf).get_estimate(), sk.get_estimate())
+        with self.assertRaises(ValueError):
+            sk.serialize_compact_into(bytearray(8))
+
+    def test_hll_batch_serialization(self):
+        sketches = []
+        for i in range(10):
+            sk = hll_sketch(10, tgt_hll_type.HLL_4)
+            sk.update(np.arange(i * 1000, dtype=np.int64))
+            sketches.append(sk)
+        batch = hll_sketch.serialize_batch(sketches)
+        restored = hll_sketch.deserialize_batch(batch)
+        self.assertEqual([sk.get_estimate() for sk in restored], [sk.get_estimate() for sk in sketches])
+        self.assertEqual(len(hll_sketch.deserialize_batch(batch, 3, 5)), 2)
+        self.assertEqual(hll_sketch.deserialize_batch(hll_sketch.serialize_batch([])), [])
+        with self.assertRaises(ValueError):
+            hll_sketch.deserialize_batch(batch, 5, 11)
+        with self.assertRaises(ValueError):
+            hll_sketch.deserialize_batch(batch[:40])
+
+    def test_hll_vector_update(self):
+        lgk = 10
+        n = 5000
+
+        # array updates hash each value exactly as a scalar update would
+        ints = np.arange(n, dtype=np.int64)
+        hll = hll_sketch(lgk, tgt_hll_type.HLL_8)
+        hll.update(ints)
+        self.assertEqual(hll.get_estimate(), self.generate_sketch(n, lgk, tgt_hll_type.HLL_8).get_estimate())
+
+        doubles = np.linspace(0.0, 1.0, n)
+        hll = hll_sketch(lgk)
+        hll.update(doubles)
+        hll_scalar = hll_sketch(lgk)
+        for d in doubles:
+            hll_scalar.update(float(d))
+        self.assertEqual(hll.get_estimate(), hll_scalar.get_estimate())
+
+        # fixed-width strings, bytes and Arrow-style offsets + data all
+        # match updating with the equivalent str values
+        strs = [f'item_{i}' for i in range(n)]
+        hll_scalar = hll_sketch(lgk)
+        for s in strs:
+            hll_scalar.update(s)
+
+        hll = hll_sketch(lgk)
+        hll.update_strings(np.array(strs))
+        self.assertEqual(hll.get_estimate(), hll_scalar.get_estimate())
+
+        hll = hll_sketch(lgk)
+        hll.update_strings(np.array(strs, dtype=np.bytes_))
+        self.assertEqual(hll.get_estimate(), hll_scalar.get_estimate())
+
+        encoded = [s.encode() for s in strs]
+        offsets = np.cumsum([0] + [len(b) for b in encoded], dtype=np.int32)
+        hll = hll_sketch(lgk)
+        hll.update_binary(offsets, b''.join(encoded))
+        self.assertEqual(hll.get_estimate(), hll_scalar.get_estimate())
+
+        # unions accept arrays as well
+        union = hll_union(lgk)
+        union.update(ints)
+        union_scalar = hll_union(lgk)
+        for i in range(n):
+            union_scalar.update(i)
+        self.assertEqual(union.get_estimate(), union_scalar.get_estimate())
+
+        # only 1D arrays are supported
+        with self.assertRaises(ValueError):
+            hll.update(np.zeros((2, 2), dtype=np.int64))
+
+    def test_atomic_hll_sketch(self):
+        lgk = 10
+        n = 100000
+        num_threads = 4
+        sk = atomic_hll_sketch(lgk)
+        self.assertTrue(sk.is_empty())
+        self.assertTrue(sk.get_result().is_empty())
+
+        chunks = np.array_split(np.arange(n, dtype=np.int64), num_threads)
+        with ThreadPoolExecutor(num_threads) as pool:
+            list(pool.map(sk.update, chunks))
+        self.assertFalse(sk.is_empty())
+
+        # the registers match those of a regular HLL_8 sketch, so unions of either agree exactly
+        ref = self.generate_sketch(n, lgk, tgt_hll_type.HLL_8)
+        union_atomic = hll_union(lgk)
+        union_atomic.update(sk.get_result())
+        union_ref = hll_union(lgk)
+        union_ref.update(ref)
+        self.assertEqual(union_atomic.get_estimate(), union_ref.get_estimate())
+        self.assertAlmostEqual(sk.get_estimate(), n, delta=n * 0.1)
+        self.assertLessEqual(sk.get_lower_bound(1), sk.get_estimate())
+        self.assertGreaterEqual(sk.get_upper_bound(1), sk.get_estimate())
+
+        # the result serializes as any hll_sketch
+        restored = hll_sketch.deserialize(sk.get_result().serialize_compact())
+        self.assertEqual(restored.get_estimate(), sk.get_estimate())
+
+        # merging splits of the stream gives the same registers
+        first = atomic_hll_sketch(lgk)
+        first.update(np.arange(n // 2, dtype=np.int64))
+        second = atomic_hll_sketch(lgk)
+        second.update(np.arange(n // 2, n, dtype=np.int64))
+        first.merge(second)
+        self.assertEqual(first.get_estimate(), sk.get_estimate())
+
+        with self.assertRaises(ValueError):
+            first.merge(atomic_hll_sketch(lgk + 1))
+        sk.reset()
+        self.assertTrue(sk.is_empty())
+
     def generate_sketch(self, n, lgk, sk_type=tgt_hll_type.HLL_4, st_idx=0):
         sk = hll_sketch(lgk, sk_type)
         for i in range(st_idx, st_idx + n):
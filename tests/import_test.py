@@ -0,0 +1,126 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+import pickle
+import subprocess
+import sys
+import textwrap
+import unittest
+
+import _datasketches
+import datasketches
+from datasketches import (hll_sketch, AccumulatorPolicy, TuplePolicy, get_families, register_families)
+
+def run_fresh(code):
+  # a new interpreter, since this one has registered most families through other tests
+  result = subprocess.run([sys.executable, '-c', textwrap.dedent(code)], check=True, capture_output=True, text=True)
+  return result.stdout.strip()
+
+class ImportTest(unittest.TestCase):
+    def test_import_registers_nothing(self):
+      out = run_fresh('''
+        import datasketches
+        print(sorted(f for f, registered in datasketches.get_families().items() if registered))
+      ''')
+      self.assertEqual(out, '[]')
+
+    def test_first_access_registers_family(self):
+      out = run_fresh('''
+        import datasketches
+        sk = datasketches.kll_floats_sketch(200)
+        print(sorted(f for f, registered in datasketches.get_families().items() if registered))
+        from datasketches import vector_of_hll_sketches
+        print(sorted(f for f, registered in datasketches.get_families().items() if registered))
+      ''')
+      # vector_of_hll_sketches brings the families of the sketches it holds
+      self.assertEqual(out.splitlines(), ["['kll']", "['hll', 'kll', 'tdigest', 'theta', 'vector_of_sketches']"])
+
+    def test_declared_attributes(self):
+      # every attribute listed for a family is defined by it, and every attribute it defines is listed,
+      # since an unlisted one would only be reachable after something else registered its family
+      out = run_fresh('''
+        import _datasketches
+        eager = set(vars(_datasketches))
+        declared = set(dir(_datasketches)) - eager
+        _datasketches.register_families()
+        defined = set(vars(_datasketches)) - eager
+        print(sorted(declared - defined), sorted(name for name in defined - declared if not name.startswith('_')))
+      ''')
+      self.assertEqual(out, '[] []')
+
+    def test_star_import(self):
+      # every name in __all__ must resolve, and importing them all registers every family
+      out = run_fresh('''
+        from datasketches import *
+        print(all(get_families().values()))
+      ''')
+      self.assertEqual(out, 'True')
+
+    def test_concurrent_first_access(self):
+      # threads racing to register one family all see its attributes once it is done
+      out = run_fresh('''
+        import threading
+        import _datasketches
+        barrier = threading.Barrier(8)
+        found = []
+        def access():
+          barrier.wait()
+          found.append(getattr(_datasketches, 'frequent_strings_sketch', None) is not None)
+        threads = [threading.Thread(target=access) for _ in range(8)]
+        for t in threads:
+          t.start()
+        for t in threads:
+          t.join()
+        print(found.count(True), _datasketches.get_families()['fi'])
+      ''')
+      self.assertEqual(out, '8 True')
+
+    def test_unpickle_in_fresh_process(self):
+      sk = hll_sketch(12)
+      for i in range(1000):
+        sk.update(i)
+      out = run_fresh(f'''
+        import pickle
+        print(round(pickle.loads({pickle.dumps(sk)!r}).get_estimate()))
+      ''')
+      self.assertEqual(int(out), round(sk.get_estimate()))
+
+    def test_register_families(self):
+      families = get_families()
+      self.assertIn('hll', families)
+      self.assertTrue(families['hll'])
+      register_families(['kll', 'theta'])
+      self.assertTrue(get_families()['kll'])
+      with self.assertRaises(ValueError):
+        register_families(['kll', 'no_such_family'])
+      register_families()
+      self.assertTrue(all(get_families().values()))
+
+    def test_package_namespace(self):
+      self.assertIs(datasketches.hll_sketch, _datasketches.hll_sketch)
+      # the Python policies live in a submodule of the same name as their native base class
+      self.assertTrue(issubclass(AccumulatorPolicy, TuplePolicy))
+      self.assertIs(datasketches.TuplePolicy, _datasketches.TuplePolicy)
+      self.assertIn('kll_floats_sketch', dir(datasketches))
+      with self.assertRaises(AttributeError):
+        datasketches.no_such_sketch
+      self.assertFalse(hasattr(_datasketches, 'no_such_sketch'))
+      self.assertIsNone(getattr(_datasketches, 'no_such_sketch', None))
+
+if __name__ == '__main__':
+    unittest.main()
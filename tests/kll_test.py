@@ -20,6 +20,7 @@ from datasketches import kll_ints_sketch, kll_floats_sketch, kll_doubles_sketch
 from datasketches import kll_items_sketch, ks_test, PyStringsSerDe
 import copy
 import numpy as np
+from concurrent.futures import ThreadPoolExecutor
 
 class KllTest(unittest.TestCase):
     def test_kll_floats_example(self):
@@ -171,5 +172,168 @@ class KllTest(unittest.TestCase):
       self.assertGreater(len(kll.to_string(True, True)), 0)
       self.assertEqual(len(kll.__str__()), len(kll.to_string()))
 
+    def test_kll_buffer_deserialize(self):
+      kll = kll_doubles_sketch(200)
+      kll.update(np.random.normal(size=5000))
+      image = kll.serialize()
+      arena = bytearray(3) + image + bytearray(5)
+      new_kll = kll_doubles_sketch.deserialize(memoryview(arena), offset=3, length=len(image))
+      self.assertEqual(new_kll.n, kll.n)
+      self.assertEqual(new_kll.get_quantile(0.5), kll.get_quantile(0.5))
+
+      items = kll_items_sketch(200)
+      for i in range(1000):
+        items.update(str(i))
+      image = items.serialize(PyStringsSerDe())
+      new_items = kll_items_sketch.deserialize(bytearray(image), PyStringsSerDe())
+      self.assertEqual(new_items.n, items.n)
+
+    def test_kll_serialize_into(self):
+      sketches = []
+      for i in range(4):
+        kll = kll_floats_sketch(200)
+        kll.update(np.random.normal(loc=i, size=2000).astype(np.float32))
+        sketches.append(kll)
+
+      # size one arena for the whole batch, then write each image in turn
+      sizes = [sk.get_serialized_size_bytes() for sk in sketches]
+      arena = np.zeros(sum(sizes), dtype=np.uint8)
+      offset = 0
+      for sk, size in zip(sketches, sizes):
+        self.assertEqual(sk.serialize_into(arena, offset), size)
+        offset += size
+      offset = 0
+      for sk, size in zip(sketches, sizes):
+        self.assertEqual(arena[offset:offset + size].tobytes(), sk.serialize())
+        offset += size
+
+      with self.assertRaises(ValueError):
+        sketches[0].serialize_into(arena, len(arena) - 1)
+      with self.assertRaises(TypeError):
+        sketches[0].serialize_into(b'read only buffer')
+
+      items = kll_items_sketch(200)
+      for i in range(1000):
+        items.update(str(i))
+      buf = bytearray(items.get_serialized_size_bytes(PyStringsSerDe()))
+      self.assertEqual(items.serialize_into(buf, PyStringsSerDe()), len(buf))
+      self.assertEqual(bytes(buf), items.serialize(PyStringsSerDe()))
+
+    def test_kll_threaded_merge(self):
+      # array updates and merges release the GIL, so sketches can be built from threads
+      parts = [np.random.normal(size=10000).astype(np.float32) for _ in range(8)]
+      def build(items):
+        sk = kll_floats_sketch(200)
+        sk.update(items)
+        return sk
+      with ThreadPoolExecutor(max_workers=4) as pool:
+        sketches = list(pool.map(build, parts))
+      merged = kll_floats_sketch(200)
+      for sk in sketches:
+        merged.merge(sk)
+      self.assertEqual(merged.n, 80000)
+      # queries keep the GIL, as they may sort the sketch in place, so
+      # threads query only sketches no other thread touches
+      with ThreadPoolExecutor(max_workers=4) as pool:
+        medians = list(pool.map(lambda sk: sk.get_quantile(0.5), sketches))
+      self.assertEqual(medians, [sk.get_quantile(0.5) for sk in sketches])
+
+    def test_kll_array_update(self):
+      values = np.array([1.0, np.nan, 3.0, 4.0, np.nan, 6.0, 7.0, 8.0])
+      # NaN values are skipped
+      sk = kll_doubles_sketch(200)
+      sk.update(values)
+      self.assertEqual(sk.n, 6)
+
+      # a mask selects the values to keep, in the same pass
+      mask = np.array([True, True, False, True, True, False, True, False])
+      sk = kll_doubles_sketch(200)
+      sk.update(values, mask)
+      self.assertEqual(sk.n, 3)
+      self.assertEqual(sk.get_min_value(), 1.0)
+      self.assertEqual(sk.get_max_value(), 7.0)
+
+      # strided input and mask take the general path
+      sk = kll_doubles_sketch(200)
+      sk.update(values[::2], mask=mask[::2])
+      self.assertEqual(sk.n, 2)
+      self.assertEqual(sk.get_max_value(), 7.0)
+
+      ints = kll_ints_sketch(200)
+      ints.update(np.arange(10, dtype=np.int32), mask=np.arange(10) % 2 == 0)
+      self.assertEqual(ints.n, 5)
+
+      with self.assertRaises(ValueError):
+        sk.update(values, np.ones(3, dtype=bool))
+
+    def test_kll_array_queries(self):
+      sk = kll_doubles_sketch(200)
+      sk.update(np.random.normal(size=100000))
+
+      # NumPy input gives NumPy output matching the scalar queries
+      ranks = np.linspace(0, 1, 101)
+      quantiles = sk.get_quantiles(ranks)
+      self.assertIsInstance(quantiles, np.ndarray)
+      self.assertEqual(len(quantiles), len(ranks))
+      for i in range(0, len(ranks), 10):
+        self.assertEqual(quantiles[i], sk.get_quantile(ranks[i]))
+      self.assertEqual(list(quantiles), sk.get_quantiles(ranks.tolist()))
+
+      values = np.array([-2.0, -1.0, 0.0, 1.0, 2.0])
+      np.testing.assert_array_equal(sk.get_ranks(values), [sk.get_rank(v) for v in values])
+      np.testing.assert_array_equal(sk.get_ranks(values, True), sk.get_ranks(values.tolist(), True))
+      np.testing.assert_array_equal(sk.get_cdf(values), sk.get_cdf(values.tolist()))
+      pmf = sk.get_pmf(values)
+      self.assertIsInstance(pmf, np.ndarray)
+      self.assertEqual(len(pmf), len(values) + 1)
+      self.assertAlmostEqual(pmf.sum(), 1.0)
+
+      with self.assertRaises(ValueError):
+        sk.get_quantiles(np.array([0.5, 1.5]))
+      with self.assertRaises(ValueError):
+        sk.get_quantiles(np.zeros((2, 2)))
+
+      # empty sketches return empty arrays
+      empty = kll_doubles_sketch(200)
+      self.assertEqual(len(empty.get_quantiles(ranks)), 0)
+      self.assertEqual(len(empty.get_ranks(values)), 0)
+      self.assertEqual(len(empty.get_pmf(values)), 0)
+
+    def test_kll_sorted_view(self):
+      kll = kll_floats_sketch(200)
+      kll.update(np.random.normal(size=10000).astype(np.float32))
+
+      view = kll.sorted_view()
+      self.assertTrue(view.is_valid)
+      self.assertEqual(view.n, kll.n)
+      self.assertEqual(len(view), kll.num_retained)
+      self.assertEqual(view.cumulative_weights[-1], kll.n)
+      self.assertTrue(np.all(np.diff(view.items) >= 0))
+
+      # queries match those on the sketch
+      self.assertEqual(view.get_quantile(0.5), kll.get_quantile(0.5))
+      self.assertEqual(view.get_rank(0.0, True), kll.get_rank(0.0, True))
+      ranks = np.linspace(0, 1, 11)
+      np.testing.assert_array_equal(view.get_quantiles(ranks), kll.get_quantiles(ranks))
+      values = np.array([-1, 0, 1], dtype=np.float32)
+      np.testing.assert_array_equal(view.get_ranks(values), kll.get_ranks(values))
+      np.testing.assert_array_equal(view.get_cdf(values), kll.get_cdf(values))
+      np.testing.assert_array_equal(view.get_pmf(values), kll.get_pmf(values))
+
+      # updating the sketch invalidates the view
+      kll.update(0.0)
+      self.assertFalse(view.is_valid)
+      with self.assertRaises(RuntimeError):
+        view.get_quantile(0.5)
+      self.assertTrue(kll.sorted_view().is_valid)
+
+      # items sketches use lists
+      items = kll_items_sketch(200)
+      for i in range(100):
+        items.update(str(i))
+      view = items.sorted_view()
+      self.assertEqual(view.get_quantiles([0.0, 1.0]), [items.get_min_value(), items.get_max_value()])
+      self.assertEqual(view.get_ranks(['5']), items.get_ranks(['5']))
+
 if __name__ == '__main__':
     unittest.main()
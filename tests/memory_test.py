@@ -0,0 +1,101 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import unittest
+from datasketches import (hll_sketch, kll_floats_sketch, update_theta_sketch,
+                          update_tuple_sketch, AccumulatorPolicy, tdigest_double,
+                          vector_of_kll_floats_sketches, vector_of_hll_sketches, hll_sketch_map,
+                          get_allocation_stats, reset_peak_bytes, set_allocator)
+import numpy as np
+
+class MemoryTest(unittest.TestCase):
+    def test_sketch_memory_usage(self):
+      # each sketch grows with its input
+      for sk in (hll_sketch(12), kll_floats_sketch(200), update_theta_sketch(12)):
+        empty = sk.get_memory_usage()
+        self.assertGreater(empty, 0)
+        for i in range(20000):
+          sk.update(i)
+        self.assertGreater(sk.get_memory_usage(), empty)
+        self.assertGreater(sk.get_memory_usage(), len(sk.serialize()) // 2)
+
+      # a full HLL_8 sketch holds one byte per bucket
+      hll = hll_sketch(12)
+      for i in range(100000):
+        hll.update(i)
+      self.assertGreaterEqual(hll.get_memory_usage(), 1 << 12)
+
+      tuple_sk = update_tuple_sketch(AccumulatorPolicy(), 10)
+      for i in range(1000):
+        tuple_sk.update(i, 1)
+      self.assertGreater(tuple_sk.get_memory_usage(), tuple_sk.compact().get_memory_usage())
+      self.assertGreater(tdigest_double(200).get_memory_usage(), tdigest_double(50).get_memory_usage())
+
+    def test_container_memory_usage(self):
+      vkll = vector_of_kll_floats_sketches(200, 10)
+      single = kll_floats_sketch(200).get_memory_usage()
+      self.assertGreaterEqual(vkll.get_memory_usage(), 10 * single)
+
+      sm = hll_sketch_map(10)
+      empty = sm.get_memory_usage()
+      sm.update(np.arange(1000, dtype=np.int64), np.arange(1000, dtype=np.int64))
+      self.assertGreater(sm.get_memory_usage(), empty)
+
+    def test_allocation_stats(self):
+      stats = get_allocation_stats()
+      for key in ('allocator', 'bytes_in_use', 'peak_bytes', 'num_allocations', 'num_deallocations', 'pool_bytes'):
+        self.assertIn(key, stats)
+      before = stats['bytes_in_use']
+
+      # container sketches allocate through the hook, and release everything when freed
+      vec = vector_of_hll_sketches(12, d=100)
+      vec.update(np.arange(100000, dtype=np.int64).reshape(-1, 100))
+      stats = get_allocation_stats()
+      self.assertGreater(stats['bytes_in_use'], before)
+      self.assertGreaterEqual(stats['peak_bytes'], stats['bytes_in_use'])
+      del vec
+      self.assertEqual(get_allocation_stats()['bytes_in_use'], before)
+
+      reset_peak_bytes()
+      self.assertEqual(get_allocation_stats()['peak_bytes'], before)
+
+    def test_set_allocator(self):
+      if get_allocation_stats()['bytes_in_use'] != 0:
+        self.skipTest('container sketches are alive')
+      set_allocator('pool')
+      try:
+        self.assertEqual(get_allocation_stats()['allocator'], 'pool')
+        sm = hll_sketch_map(8)
+        sm.update(np.arange(5000, dtype=np.int64) % 500, np.arange(5000, dtype=np.int64))
+        self.assertGreater(get_allocation_stats()['pool_bytes'], 0)
+        np.testing.assert_allclose(sm.estimates()[1], 10, rtol=0.05)
+
+        # cannot switch while memory from the pool is in use
+        with self.assertRaises(ValueError):
+          set_allocator('system')
+        del sm
+      finally:
+        set_allocator('system')
+      self.assertEqual(get_allocation_stats()['pool_bytes'], 0)
+
+      with self.assertRaises(ValueError):
+        set_allocator('arena')
+      with self.assertRaises(ValueError):
+        set_allocator(42)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,189 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import unittest
+from datasketches import (hll_sketch, hll_union, tgt_hll_type,
+                          update_theta_sketch, theta_union,
+                          cpc_sketch, cpc_union,
+                          kll_ints_sketch, kll_floats_sketch, kll_doubles_sketch,
+                          tdigest_float, tdigest_double,
+                          merge_hll, merge_theta, merge_cpc,
+                          merge_kll_ints, merge_kll_floats, merge_kll_doubles,
+                          merge_tdigest_float, merge_tdigest_double)
+import numpy as np
+
+class MergeTest(unittest.TestCase):
+    num_sketches = 37   # deliberately not a multiple of the thread count
+    n = 2000            # items per sketch, with half overlapping the next sketch
+
+    def ranges(self):
+        for i in range(self.num_sketches):
+            yield np.arange(i * self.n // 2, i * self.n // 2 + self.n, dtype=np.int64)
+
+    def test_merge_hll(self):
+        lg_k = 12
+        images = []
+        union = hll_union(lg_k)
+        for items in self.ranges():
+            sk = hll_sketch(lg_k, tgt_hll_type.HLL_4)
+            sk.update(items)
+            union.update(sk)
+            images.append(sk.serialize_compact())
+        expected = union.get_result(tgt_hll_type.HLL_8)
+
+        for num_threads in [1, 4, 0]:
+            result = merge_hll(images, lg_k, tgt_hll_type.HLL_8, num_threads)
+            self.assertIsInstance(result, hll_sketch)
+            self.assertAlmostEqual(result.get_estimate(), expected.get_estimate(), delta=1e-6 * expected.get_estimate())
+
+        # any buffer works, and the requested target type is honored
+        result = merge_hll([bytearray(b) for b in images], lg_k, tgt_hll_type.HLL_6)
+        self.assertEqual(result.tgt_type, tgt_hll_type.HLL_6)
+
+        # merging nothing gives an empty sketch
+        self.assertTrue(merge_hll([], lg_k).is_empty())
+
+    def test_merge_hll8_images(self):
+        # dense HLL_8 images of lg_max_k are merged in place, the others through a union
+        lg_k = 10
+        images = []
+        union = hll_union(lg_k)
+        for i, items in enumerate(self.ranges()):
+            sk = hll_sketch(lg_k, tgt_hll_type.HLL_8)
+            sk.update(items)
+            union.update(sk)
+            images.append(sk.serialize_updatable() if i % 2 else sk.serialize_compact())
+        dense_only = union.get_result(tgt_hll_type.HLL_8)
+
+        for num_threads in [1, 4, 0]:
+            result = merge_hll(images, lg_k, tgt_hll_type.HLL_8, num_threads)
+            self.assertEqual(result.tgt_type, tgt_hll_type.HLL_8)
+            self.assertAlmostEqual(result.get_estimate(), dense_only.get_estimate(), delta=1e-9 * dense_only.get_estimate())
+            self.assertAlmostEqual(result.get_lower_bound(2), dense_only.get_lower_bound(2), delta=1e-6 * dense_only.get_estimate())
+
+        # sketches in list mode, of other types or of other sizes take the general path
+        small = hll_sketch(lg_k, tgt_hll_type.HLL_8)
+        small.update(np.arange(10**6, 10**6 + 20, dtype=np.int64))
+        hll4 = hll_sketch(lg_k, tgt_hll_type.HLL_4)
+        hll4.update(np.arange(-5000, 0, dtype=np.int64))
+        larger = hll_sketch(lg_k + 1, tgt_hll_type.HLL_8)
+        larger.update(np.arange(-10000, -8000, dtype=np.int64))
+        for sk in [small, hll4, larger]:
+            union.update(sk)
+        mixed = images + [small.serialize_compact(), hll4.serialize_compact(), larger.serialize_compact()]
+        expected = union.get_result(tgt_hll_type.HLL_6)
+        for num_threads in [1, 3]:
+            result = merge_hll(mixed, lg_k, tgt_hll_type.HLL_6, num_threads)
+            self.assertEqual(result.tgt_type, tgt_hll_type.HLL_6)
+            self.assertAlmostEqual(result.get_estimate(), expected.get_estimate(), delta=1e-9 * expected.get_estimate())
+
+        # the result is a regular sketch that can be updated and serialized further
+        result = merge_hll(images, lg_k)
+        before = result.get_estimate()
+        result.update(np.arange(10**7, 10**7 + 5000, dtype=np.int64))
+        self.assertGreater(result.get_estimate(), before)
+        self.assertAlmostEqual(hll_sketch.deserialize(result.serialize_compact()).get_estimate(), result.get_estimate())
+
+    def test_merge_theta(self):
+        images = []
+        compressed = []
+        union = theta_union()
+        for items in self.ranges():
+            sk = update_theta_sketch()
+            sk.update(items)
+            union.update(sk)
+            images.append(sk.compact().serialize())
+            compressed.append(sk.compact().serialize(True))
+        expected = union.get_result()
+
+        for num_threads in [1, 4, 0]:
+            result = merge_theta(images, num_threads=num_threads)
+            self.assertEqual(result.get_estimate(), expected.get_estimate())
+            self.assertEqual(result.theta64, expected.theta64)
+            self.assertTrue(result.is_ordered())
+
+        # compressed images can be read too
+        self.assertEqual(merge_theta(compressed).get_estimate(), expected.get_estimate())
+
+        # a mismatched seed is an error
+        with self.assertRaises(ValueError):
+            merge_theta(images, seed=12345)
+
+        self.assertTrue(merge_theta([]).is_empty())
+
+    def test_merge_cpc(self):
+        lg_k = 11
+        images = []
+        union = cpc_union(lg_k)
+        for items in self.ranges():
+            sk = cpc_sketch(lg_k)
+            sk.update(items)
+            union.update(sk)
+            images.append(sk.serialize())
+        expected = union.get_result()
+
+        for num_threads in [1, 4, 0]:
+            result = merge_cpc(images, lg_k, num_threads=num_threads)
+            self.assertAlmostEqual(result.get_estimate(), expected.get_estimate(), delta=0.01 * expected.get_estimate())
+
+        self.assertTrue(merge_cpc([]).is_empty())
+
+    def test_merge_kll(self):
+        for sketch_type, merge, dtype in [(kll_ints_sketch, merge_kll_ints, np.int32),
+                                          (kll_floats_sketch, merge_kll_floats, np.float32),
+                                          (kll_doubles_sketch, merge_kll_doubles, np.float64)]:
+            images = []
+            for items in self.ranges():
+                sk = sketch_type(200)
+                sk.update(items.astype(dtype))
+                images.append(sk.serialize())
+
+            for num_threads in [1, 4, 0]:
+                result = merge(images, 200, num_threads)
+                self.assertIsInstance(result, sketch_type)
+                self.assertEqual(result.n, self.num_sketches * self.n)
+                self.assertEqual(result.get_min_value(), 0)
+                self.assertEqual(result.get_max_value(), (self.num_sketches + 1) * self.n // 2 - 1)
+                median = (self.num_sketches + 1) * self.n / 4
+                self.assertAlmostEqual(result.get_rank(median), 0.5, delta=0.05)
+
+            self.assertTrue(merge([]).is_empty())
+
+    def test_merge_tdigest(self):
+        for sketch_type, merge, dtype in [(tdigest_float, merge_tdigest_float, np.float32),
+                                          (tdigest_double, merge_tdigest_double, np.float64)]:
+            images = []
+            for items in self.ranges():
+                sk = sketch_type(100)
+                sk.update(items.astype(dtype))
+                images.append(sk.serialize())
+
+            for num_threads in [1, 4, 0]:
+                result = merge(images, 100, num_threads)
+                self.assertIsInstance(result, sketch_type)
+                self.assertEqual(result.get_total_weight(), self.num_sketches * self.n)
+                self.assertEqual(result.get_min_value(), 0)
+                self.assertEqual(result.get_max_value(), (self.num_sketches + 1) * self.n // 2 - 1)
+
+    def test_merge_invalid_image(self):
+        with self.assertRaises(Exception):
+            merge_hll([b'not a sketch'], 12, num_threads=2)
+        with self.assertRaises(TypeError):
+            merge_kll_floats(["not a buffer"])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,95 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import copy
+import pickle
+import sys
+import unittest
+
+import numpy as np
+
+from datasketches import (kll_floats_sketch, kll_doubles_sketch, req_ints_sketch, tdigest_double,
+                          hll_sketch, cpc_sketch, update_theta_sketch, compact_theta_sketch,
+                          frequent_strings_sketch, count_min_sketch, vector_of_kll_floats_sketches)
+
+class PickleTest(unittest.TestCase):
+    def make_sketches(self):
+        items = np.arange(10000, dtype=np.float64)
+        kll = kll_floats_sketch(200)
+        kll.update(items.astype(np.float32))
+        kll_d = kll_doubles_sketch(200)
+        kll_d.update(items)
+        req = req_ints_sketch(12)
+        req.update(items.astype(np.int32))
+        td = tdigest_double(100)
+        td.update(items)
+        hll = hll_sketch(12)
+        hll.update(items.astype(np.int64))
+        cpc = cpc_sketch(11)
+        cpc.update(items.astype(np.int64))
+        theta = update_theta_sketch(12)
+        theta.update(items.astype(np.int64))
+        fi = frequent_strings_sketch(6)
+        for i in range(100):
+            fi.update(str(i % 7), i)
+        cm = count_min_sketch(3, 128)
+        for i in range(100):
+            cm.update(i)
+        return [kll, kll_d, req, td, hll, cpc, theta.compact(), fi, cm]
+
+    def test_pickle_round_trip(self):
+        for sk in self.make_sketches():
+            for protocol in range(2, pickle.HIGHEST_PROTOCOL + 1):
+                restored = pickle.loads(pickle.dumps(sk, protocol=protocol))
+                self.assertIs(type(restored), type(sk))
+                self.assertEqual(restored.serialize(), sk.serialize())
+            self.assertEqual(copy.deepcopy(sk).serialize(), sk.serialize())
+
+    def test_pickle_out_of_band(self):
+        for sk in self.make_sketches():
+            buffers = []
+            data = pickle.dumps(sk, protocol=5, buffer_callback=buffers.append)
+            self.assertEqual(len(buffers), 1)
+            # the image travels outside the pickle stream
+            self.assertNotIn(sk.serialize(), data)
+            restored = pickle.loads(data, buffers=[memoryview(b) for b in buffers])
+            self.assertEqual(restored.serialize(), sk.serialize())
+
+            # without the buffers the stream cannot be loaded
+            with self.assertRaises(pickle.UnpicklingError):
+                pickle.loads(data)
+
+    def test_pickle_vector_of_kll(self):
+        vk = vector_of_kll_floats_sketches(k=100, d=3, num_threads=2)
+        vk.update(np.random.rand(1000, 3).astype(np.float32))
+        for protocol in (4, 5):
+            restored = pickle.loads(pickle.dumps(vk, protocol=protocol))
+            self.assertEqual((restored.k, restored.d, restored.num_threads), (vk.k, vk.d, vk.num_threads))
+            self.assertEqual(restored.serialize(), vk.serialize())
+
+    @unittest.skipIf(sys.version_info < (3, 12), "Python buffer protocol for classes requires 3.12")
+    def test_buffer_protocol(self):
+        theta = update_theta_sketch(12)
+        theta.update(np.arange(1000, dtype=np.int64))
+        compact = theta.compact()
+        view = memoryview(compact)
+        self.assertTrue(view.readonly)
+        self.assertEqual(view.tobytes(), compact.serialize())
+        self.assertEqual(compact_theta_sketch.deserialize(view).get_estimate(), compact.get_estimate())
+
+if __name__ == '__main__':
+    unittest.main()
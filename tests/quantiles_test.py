@@ -171,5 +171,38 @@ class QuantilesTest(unittest.TestCase):
       self.assertGreater(len(quantiles.to_string(True, True)), 0)
       self.assertEqual(len(quantiles.__str__()), len(quantiles.to_string()))
 
+    def test_quantiles_array_queries(self):
+      sk = quantiles_doubles_sketch(128)
+      sk.update(np.random.normal(size=100000))
+
+      # NumPy input gives NumPy output matching the scalar queries
+      ranks = np.linspace(0, 1, 101)
+      quantiles = sk.get_quantiles(ranks)
+      self.assertIsInstance(quantiles, np.ndarray)
+      self.assertEqual(len(quantiles), len(ranks))
+      for i in range(0, len(ranks), 10):
+        self.assertEqual(quantiles[i], sk.get_quantile(ranks[i]))
+      self.assertEqual(list(quantiles), sk.get_quantiles(ranks.tolist()))
+
+      values = np.array([-2.0, -1.0, 0.0, 1.0, 2.0])
+      np.testing.assert_array_equal(sk.get_ranks(values), [sk.get_rank(v) for v in values])
+      np.testing.assert_array_equal(sk.get_ranks(values, True), sk.get_ranks(values.tolist(), True))
+      np.testing.assert_array_equal(sk.get_cdf(values), sk.get_cdf(values.tolist()))
+      pmf = sk.get_pmf(values)
+      self.assertIsInstance(pmf, np.ndarray)
+      self.assertEqual(len(pmf), len(values) + 1)
+      self.assertAlmostEqual(pmf.sum(), 1.0)
+
+      with self.assertRaises(ValueError):
+        sk.get_quantiles(np.array([0.5, 1.5]))
+      with self.assertRaises(ValueError):
+        sk.get_quantiles(np.zeros((2, 2)))
+
+      # empty sketches return empty arrays
+      empty = quantiles_doubles_sketch(128)
+      self.assertEqual(len(empty.get_quantiles(ranks)), 0)
+      self.assertEqual(len(empty.get_ranks(values)), 0)
+      self.assertEqual(len(empty.get_pmf(values)), 0)
+
 if __name__ == '__main__':
     unittest.main()
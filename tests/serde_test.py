@@ -0,0 +1,85 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import unittest
+from datasketches import (kll_items_sketch, frequent_items_sketch, var_opt_sketch,
+                          PyObjectSerDe, PyStringsSerDe, PyIntsSerDe, PyLongsSerDe,
+                          PyFloatsSerDe, PyDoublesSerDe,
+                          StringsSerDe, BytesSerDe, IntsSerDe, LongsSerDe,
+                          FloatsSerDe, DoublesSerDe)
+
+class SerDeTest(unittest.TestCase):
+    def test_native_serde_compatibility(self):
+        # native serdes produce the same images as the Python reference serdes
+        for native, reference, items in [(StringsSerDe(), PyStringsSerDe(), [str(i) for i in range(1000)]),
+                                         (IntsSerDe(), PyIntsSerDe(), list(range(-500, 500))),
+                                         (LongsSerDe(), PyLongsSerDe(), [i * 2**40 for i in range(-500, 500)]),
+                                         (FloatsSerDe(), PyFloatsSerDe(), [i / 4 for i in range(1000)]),
+                                         (DoublesSerDe(), PyDoublesSerDe(), [i / 3 for i in range(1000)])]:
+            self.assertIsInstance(native, PyObjectSerDe)
+            kll = kll_items_sketch(200)
+            for item in items:
+                kll.update(item)
+            image = kll.serialize(native)
+            self.assertEqual(image, kll.serialize(reference))
+            self.assertEqual(len(image), kll.get_serialized_size_bytes(native))
+            restored = kll_items_sketch.deserialize(image, native)
+            self.assertEqual(restored.n, kll.n)
+            self.assertEqual(restored.get_quantile(0.5), kll.get_quantile(0.5))
+            self.assertEqual(list(restored), list(kll))
+
+            # the per-item interface matches as well
+            self.assertEqual(native.get_size(items[1]), reference.get_size(items[1]))
+            self.assertEqual(native.to_bytes(items[1]), reference.to_bytes(items[1]))
+            self.assertEqual(native.from_bytes(native.to_bytes(items[1]), 0), reference.from_bytes(native.to_bytes(items[1]), 0))
+
+    def test_native_strings_and_bytes(self):
+        serde = StringsSerDe()
+        fi = frequent_items_sketch(8)
+        words = ['ascii', 'café', '日本', '\U0001f600', '']
+        for i, w in enumerate(words):
+            fi.update(w, i + 1)
+        restored = frequent_items_sketch.deserialize(fi.serialize(serde), serde)
+        self.assertEqual(restored.get_estimate('\U0001f600'), 4)
+        self.assertEqual(restored.get_estimate('café'), 2)
+
+        serde = BytesSerDe()
+        vo = var_opt_sketch(16)
+        for i in range(100):
+            vo.update(bytes([i % 256]) * (i % 7), 1.0)
+        restored = var_opt_sketch.deserialize(vo.serialize(serde), serde)
+        self.assertEqual(restored.n, vo.n)
+        for item, weight in restored:
+            self.assertIsInstance(item, bytes)
+
+    def test_native_serde_errors(self):
+        kll = kll_items_sketch(200)
+        kll.update(1.5)
+        with self.assertRaises(TypeError):
+            kll.serialize(StringsSerDe())
+        with self.assertRaises(TypeError):
+            kll.serialize(IntsSerDe())
+
+        kll = kll_items_sketch(200)
+        for i in range(10):
+            kll.update(str(i))
+        image = kll.serialize(StringsSerDe())
+        with self.assertRaises(Exception):
+            kll_items_sketch.deserialize(image[:-2], StringsSerDe())
+
+if __name__ == '__main__':
+    unittest.main()
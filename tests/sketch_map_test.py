@@ -0,0 +1,123 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import unittest
+from datasketches import hll_sketch_map, kll_sketch_map, hll_sketch, kll_doubles_sketch, tgt_hll_type
+import copy
+import numpy as np
+
+class SketchMapTest(unittest.TestCase):
+    def test_hll_sketch_map(self):
+      num_keys = 1000
+      n = 100000
+      sm = hll_sketch_map(10, tgt_hll_type.HLL_8)
+      self.assertEqual(sm.lg_k, 10)
+      self.assertEqual(len(sm), 0)
+
+      # key i sees the distinct values i, i + num_keys, ...
+      values = np.arange(n, dtype=np.int64)
+      keys = values % num_keys
+      sm.update(keys, values)
+      sm.update(keys[:500], values[:500])
+      self.assertEqual(len(sm), num_keys)
+      self.assertIn(7, sm)
+      self.assertNotIn(num_keys, sm)
+      self.assertIsNone(sm.get(num_keys))
+
+      map_keys, estimates = sm.estimates()
+      np.testing.assert_array_equal(map_keys, np.arange(num_keys))
+      np.testing.assert_allclose(estimates, n // num_keys, rtol=0.1)
+      _, lower = sm.lower_bounds(2)
+      _, upper = sm.upper_bounds(2)
+      self.assertTrue(np.all(lower <= estimates))
+      self.assertTrue(np.all(upper >= estimates))
+
+      # matches a single sketch fed the same values
+      sk = hll_sketch(10, tgt_hll_type.HLL_8)
+      for v in values[keys == 3]:
+        sk.update(int(v))
+      self.assertAlmostEqual(sm.get(3).get_estimate(), sk.get_estimate())
+
+      # merge adds missing keys and unions the others
+      other = hll_sketch_map(10)
+      other.update(np.array([3, 3, num_keys], dtype=np.int64), np.array([-1, -2, 5], dtype=np.int64))
+      sm.merge(other)
+      self.assertEqual(len(sm), num_keys + 1)
+      map_keys, estimates = sm.estimates()
+      self.assertEqual(map_keys[-1], num_keys)
+      self.assertAlmostEqual(estimates[-1], 1, delta=0.01)
+
+      with self.assertRaises(ValueError):
+        sm.update(keys, values[:10])
+
+    def test_hll_sketch_map_nan(self):
+      sm = hll_sketch_map(8)
+      sm.update(np.array([1, 2, 1], dtype=np.int64), np.array([0.5, np.nan, 1.5]))
+      self.assertEqual(len(sm), 1)
+      self.assertAlmostEqual(sm.estimates()[1][0], 2, delta=0.01)
+
+    def test_kll_sketch_map(self):
+      num_keys = 50
+      n = 2 ** 16
+      sm = kll_sketch_map(200)
+      self.assertEqual(sm.k, 200)
+      keys = np.random.randint(0, num_keys, n).astype(np.int64)
+      values = np.random.randn(n)
+      sm.update(keys, values)
+
+      map_keys, counts = sm.counts()
+      self.assertEqual(counts.sum(), n)
+      for key, count in zip(map_keys, counts):
+        self.assertEqual(count, np.count_nonzero(keys == key))
+
+      map_keys, quantiles = sm.quantiles(np.array([0.25, 0.5, 0.75]))
+      self.assertEqual(quantiles.shape, (len(map_keys), 3))
+      np.testing.assert_allclose(quantiles[:, 1], 0, atol=0.2)
+      _, ranks = sm.ranks(np.array([0.0]))
+      np.testing.assert_allclose(ranks, 0.5, atol=0.1)
+
+      sk = kll_doubles_sketch(200)
+      for v in values[keys == map_keys[0]]:
+        sk.update(v)
+      self.assertEqual(sm.get(map_keys[0]).n, sk.n)
+
+      with self.assertRaises(ValueError):
+        sm.quantiles(np.array([-0.5]))
+
+    def test_batch_serialization(self):
+      sm = kll_sketch_map()
+      sm.update(np.array([10, 20, 10, 30], dtype=np.int64), np.array([1.0, 2.0, 3.0, 4.0]))
+      keys = sm.keys()
+      batch = sm.serialize_batch()
+
+      restored = kll_sketch_map()
+      restored.deserialize_batch(keys, batch)
+      np.testing.assert_array_equal(restored.counts()[0], keys)
+      np.testing.assert_array_equal(restored.counts()[1], [2, 1, 1])
+      self.assertEqual(restored.serialize_batch(), batch)
+
+      # existing keys are replaced rather than merged
+      copied = copy.copy(restored)
+      copied.deserialize_batch(keys, batch)
+      np.testing.assert_array_equal(copied.counts()[1], [2, 1, 1])
+      with self.assertRaises(ValueError):
+        restored.deserialize_batch(keys[:1], batch)
+      with self.assertRaises(ValueError):
+        restored.deserialize_batch(keys, b'not a batch')
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,107 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import unittest
+from datasketches import (hll_sketch_ring, theta_sketch_ring, kll_sketch_ring, tdigest_sketch_ring,
+                          kll_doubles_sketch, tgt_hll_type)
+import copy
+import numpy as np
+
+class SketchRingTest(unittest.TestCase):
+    def test_kll_sketch_ring(self):
+      num_buckets = 4
+      ring = kll_sketch_ring(num_buckets, 200)
+      self.assertEqual(len(ring), num_buckets)
+      self.assertEqual(ring.k, 200)
+      ranks = np.array([0.0, 0.25, 0.5, 0.75, 1.0])
+      self.assertTrue(np.all(np.isnan(ring.get_quantiles(ranks))))
+
+      # few enough values per window that every merged sketch is exact
+      buckets = []
+      for t in range(7):
+        values = np.random.randn(20)
+        buckets.append(values)
+        ring.update(values[:10])
+        ring.update(values[10:])
+        for w in range(1, num_buckets + 1):
+          expected = kll_doubles_sketch(200)
+          expected.update(np.concatenate(buckets[max(0, t - w + 1):]))
+          np.testing.assert_array_equal(ring.get_quantiles(ranks, w), expected.get_quantiles(ranks))
+          self.assertEqual(ring.window(w).n, expected.n)
+        self.assertEqual(ring.current().n, 20)
+        self.assertEqual(ring.window().n, ring.window(num_buckets).n)
+        ring.advance()
+      self.assertEqual(ring.num_advances, 7)
+      self.assertTrue(ring.current().is_empty())
+
+      # copies are independent
+      ring_copy = copy.copy(ring)
+      ring_copy.update(np.array([1.0, np.nan]))
+      self.assertEqual(ring_copy.current().n, 1)
+      self.assertTrue(ring.current().is_empty())
+      self.assertGreater(ring.get_memory_usage(), 0)
+
+      # advancing past every bucket clears the ring
+      ring.advance(num_buckets + 3)
+      self.assertTrue(ring.window().is_empty())
+      self.assertEqual(ring.num_advances, 7 + num_buckets + 3)
+
+      with self.assertRaises(ValueError):
+        ring.window(0)
+      with self.assertRaises(ValueError):
+        ring.window(num_buckets + 1)
+      with self.assertRaises(ValueError):
+        kll_sketch_ring(0)
+
+    def test_distinct_count_rings(self):
+      num_buckets = 5
+      per_bucket = 100
+      theta = theta_sketch_ring(num_buckets, lg_k=12)
+      hll = hll_sketch_ring(num_buckets, 12, tgt_hll_type.HLL_4)
+      self.assertEqual(hll.lg_k, 12)
+      for t in range(8):
+        # bucket t sees [t * 50, t * 50 + 100), overlapping the previous one by half
+        values = np.arange(t * 50, t * 50 + per_bucket, dtype=np.int64)
+        theta.update(values)
+        hll.update(values.astype(np.float64))
+        for w in range(1, num_buckets + 1):
+          first = max(0, t - w + 1)
+          exact = t * 50 + per_bucket - first * 50
+          # theta is exact below k, and hll within a few percent at these sizes
+          self.assertEqual(theta.get_estimate(w), exact)
+          self.assertLessEqual(theta.get_lower_bound(1, w), exact)
+          self.assertGreaterEqual(theta.get_upper_bound(1, w), exact)
+          self.assertAlmostEqual(hll.get_estimate(w), exact, delta=0.03 * exact)
+          self.assertAlmostEqual(hll.window(w).get_estimate(), hll.get_estimate(w))
+        theta.advance()
+        hll.advance()
+      self.assertEqual(theta.window(1).get_estimate(), 0)
+
+    def test_tdigest_sketch_ring(self):
+      ring = tdigest_sketch_ring(3, k=100)
+      self.assertEqual(ring.k, 100)
+      for center in [0.0, 10.0, 20.0, 30.0]:
+        ring.update(np.random.uniform(center - 1, center + 1, 10000))
+        ring.advance()
+      ring.update(np.random.uniform(39, 41, 10000))
+      # the window of the latest 3 buckets covers the centers 20, 30 and 40
+      self.assertAlmostEqual(ring.get_quantiles(np.array([0.5]))[0], 30, delta=1)
+      self.assertAlmostEqual(ring.get_quantiles(np.array([0.5]), 1)[0], 40, delta=0.1)
+      self.assertEqual(ring.window(2).get_total_weight(), 20000)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,87 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+import unittest
+from datasketches import (hll_sketch, kll_floats_sketch, kll_items_sketch, update_theta_sketch,
+                          PyStringsSerDe, stats, reset_stats)
+import numpy as np
+
+COUNTERS = ['updates', 'compactions', 'rebuilds', 'promotions', 'serde_calls', 'serde_nanos', 'bytes_serialized']
+
+class StatsTest(unittest.TestCase):
+    def test_stats_surface(self):
+      totals = stats()
+      for key in COUNTERS + ['enabled']:
+        self.assertIn(key, totals)
+      sk = kll_floats_sketch(200)
+      self.assertEqual(sorted(sk.get_stats()), sorted(COUNTERS))
+      if not totals['enabled']:
+        sk.update(np.arange(1000, dtype=np.float32))
+        self.assertEqual(sum(sk.get_stats().values()), 0)
+        self.assertEqual(sum(stats()[key] for key in COUNTERS), 0)
+
+    @unittest.skipUnless(stats()['enabled'], 'the module was built without DATASKETCHES_STATS')
+    def test_sketch_counters(self):
+      reset_stats()
+      kll = kll_floats_sketch(200)
+      kll.update(np.arange(10000, dtype=np.float32))
+      kll.update(1.0)
+      self.assertEqual(kll.get_stats()['updates'], 10001)
+      self.assertGreater(kll.get_stats()['compactions'], 0)
+      self.assertEqual(kll.get_stats()['bytes_serialized'], 0)
+      image = kll.serialize()
+      self.assertEqual(kll.get_stats()['bytes_serialized'], len(image))
+
+      theta = update_theta_sketch(10)
+      theta.update(np.arange(100000, dtype=np.int64))
+      self.assertGreater(theta.get_stats()['rebuilds'], 0)
+      self.assertEqual(update_theta_sketch(10).get_stats()['rebuilds'], 0)
+
+      hll = hll_sketch(10)
+      for i in range(5000):
+        hll.update(i)
+      self.assertEqual(hll.get_stats()['promotions'], 2) # list to set to HLL, however often the set resized
+      hll.update(np.arange(5000, 10000, dtype=np.int64))
+      self.assertEqual(hll.get_stats()['promotions'], 2) # already in HLL mode
+
+      totals = stats()
+      self.assertEqual(totals['updates'], 10001 + 100000 + 10000)
+      self.assertGreaterEqual(totals['compactions'], kll.get_stats()['compactions'])
+
+      kll.reset_stats()
+      self.assertEqual(sum(kll.get_stats().values()), 0)
+      self.assertEqual(stats()['updates'], totals['updates'])
+      reset_stats()
+      self.assertEqual(stats()['updates'], 0)
+
+    @unittest.skipUnless(stats()['enabled'], 'the module was built without DATASKETCHES_STATS')
+    def test_serde_counters(self):
+      serde = PyStringsSerDe()
+      sk = kll_items_sketch(200)
+      for i in range(100):
+        sk.update(str(i))
+      image = sk.serialize(serde)
+      counters = serde.get_stats()
+      self.assertGreater(counters['serde_calls'], 0)
+      self.assertGreater(counters['serde_nanos'], 0)
+      self.assertEqual(sk.get_stats()['bytes_serialized'], len(image))
+      kll_items_sketch.deserialize(image, serde)
+      self.assertGreater(serde.get_stats()['serde_calls'], counters['serde_calls'])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -104,3 +104,29 @@ class TdigestTest(unittest.TestCase):
       self.assertEqual(td.get_max_value(), new_td.get_max_value())
       self.assertEqual(td.get_quantile(0.7), new_td.get_quantile(0.7))
       self.assertEqual(td.get_rank(0.0), new_td.get_rank(0.0))
+
+    def test_tdigest_array_queries(self):
+      td = tdigest_double()
+      td.update(np.random.normal(size=100000))
+
+      ranks = np.linspace(0, 1, 101)
+      quantiles = td.get_quantiles(ranks)
+      self.assertIsInstance(quantiles, np.ndarray)
+      for i in range(0, len(ranks), 10):
+        self.assertEqual(quantiles[i], td.get_quantile(ranks[i]))
+
+      values = np.array([-2.0, -1.0, 0.0, 1.0, 2.0])
+      np.testing.assert_array_equal(td.get_ranks(values), [td.get_rank(v) for v in values])
+      cdf = td.get_cdf(values)
+      self.assertEqual(len(cdf), len(values) + 1)
+      self.assertEqual(cdf[-1], 1.0)
+      pmf = td.get_pmf(values)
+      self.assertEqual(len(pmf), len(values) + 1)
+      self.assertAlmostEqual(pmf.sum(), 1.0)
+
+      # float32 sketches take float32 arrays
+      tdf = tdigest_float()
+      tdf.update(np.arange(1000, dtype=np.float32))
+      self.assertEqual(tdf.get_quantiles(np.array([0.0]))[0], 0.0)
+
+      self.assertEqual(len(tdigest_double().get_ranks(values)), 0)
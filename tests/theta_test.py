@@ -18,9 +18,11 @@
 import unittest
 
 from datasketches import update_theta_sketch
-from datasketches import compact_theta_sketch, theta_union
+from datasketches import compact_theta_sketch, wrapped_compact_theta_sketch, theta_union
 from datasketches import theta_intersection, theta_a_not_b
-from datasketches import theta_jaccard_similarity
+from datasketches import theta_jaccard_similarity, concurrent_theta_sketch
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
 
 class ThetaTest(unittest.TestCase):
     def test_theta_basic_example(self):
@@ -160,6 +162,201 @@ class ThetaTest(unittest.TestCase):
         self.assertTrue(theta_jaccard_similarity.similarity_test(sk1, result, 0.7))
 
 
+    def test_theta_vector_update(self):
+        lgk = 10
+        n = 5000
+
+        # array updates hash each value exactly as a scalar update would
+        sk = update_theta_sketch(lgk)
+        sk.update(np.arange(n, dtype=np.int64))
+        self.assertEqual(sk.get_estimate(), self.generate_theta_sketch(n, lgk).get_estimate())
+
+        strs = [f'{i:06d}' for i in range(n)]
+        sk_scalar = update_theta_sketch(lgk)
+        for s in strs:
+            sk_scalar.update(s)
+        sk = update_theta_sketch(lgk)
+        sk.update_strings(np.array(strs, dtype='U6'))
+        self.assertEqual(sk.get_estimate(), sk_scalar.get_estimate())
+
+        # strided views are supported without copying
+        sk = update_theta_sketch(lgk)
+        sk.update_strings(np.array(strs + strs)[::2])
+        sk.update_strings(np.array(strs + strs)[1::2])
+        self.assertEqual(sk.get_estimate(), sk_scalar.get_estimate())
+
+        # invalid offsets are rejected
+        with self.assertRaises(ValueError):
+            sk.update_binary(np.array([0, 10], dtype=np.int32), b'short')
+
+    def test_theta_buffer_deserialize(self):
+        sk1 = self.generate_theta_sketch(5000, 10).compact()
+        sk2 = self.generate_theta_sketch(5000, 10, 2500).compact()
+        image1 = sk1.serialize()
+        image2 = sk2.serialize(True)
+
+        # images can be read from any buffer, at an offset within it
+        arena = bytearray(b'xx' + image1 + image2)
+        view = memoryview(arena)
+        new_sk1 = compact_theta_sketch.deserialize(view, offset=2, length=len(image1))
+        new_sk2 = compact_theta_sketch.deserialize(arena, offset=2 + len(image1))
+        self.assertEqual(new_sk1.get_estimate(), sk1.get_estimate())
+        self.assertEqual(new_sk2.get_estimate(), sk2.get_estimate())
+        self.assertEqual(compact_theta_sketch.deserialize(np.frombuffer(image1, dtype=np.uint8)).get_estimate(),
+                         sk1.get_estimate())
+
+        with self.assertRaises(ValueError):
+            compact_theta_sketch.deserialize(image1, offset=len(image1) + 1)
+        with self.assertRaises(ValueError):
+            compact_theta_sketch.deserialize(image1, offset=1, length=len(image1))
+
+        # wrapped sketches are queried in place
+        wrapped1 = wrapped_compact_theta_sketch(view, offset=2, length=len(image1))
+        wrapped2 = wrapped_compact_theta_sketch(image2)
+        self.assertEqual(wrapped1.get_estimate(), sk1.get_estimate())
+        self.assertEqual(wrapped1.get_upper_bound(2), sk1.get_upper_bound(2))
+        self.assertEqual(wrapped1.theta64, sk1.theta64)
+        self.assertEqual(wrapped1.num_retained, sk1.num_retained)
+        self.assertEqual(wrapped1.is_ordered(), sk1.is_ordered())
+        self.assertEqual(list(wrapped1), list(sk1))
+        self.assertEqual(wrapped2.get_estimate(), sk2.get_estimate())
+        self.assertEqual(wrapped1.compact().get_estimate(), sk1.get_estimate())
+
+        # and can be used directly in set operations
+        union = theta_union(10)
+        union.update(wrapped1)
+        union.update(wrapped2)
+        expected = theta_union(10)
+        expected.update(sk1)
+        expected.update(sk2)
+        self.assertEqual(union.get_result().get_estimate(), expected.get_result().get_estimate())
+
+        intersection = theta_intersection()
+        intersection.update(wrapped1)
+        intersection.update(sk2)
+        self.assertGreater(intersection.get_result().get_estimate(), 0)
+
+        # the view keeps the buffer alive and locked against resizing
+        del view
+        with self.assertRaises(BufferError):
+            arena.extend(b'more')
+        del wrapped1
+        arena.extend(b'more')
+
+    def test_theta_serialize_into(self):
+        sk = self.generate_theta_sketch(5000, 10).compact()
+        for compress in [False, True]:
+            size = sk.get_serialized_size_bytes(compress)
+            buf = bytearray(size + 2)
+            self.assertEqual(sk.serialize_into(buf, 2, compress), size)
+            self.assertEqual(bytes(buf[2:]), sk.serialize(compress))
+        with self.assertRaises(ValueError):
+            sk.serialize_into(bytearray(16))
+
+    def test_theta_batch_serialization(self):
+        sketches = [self.generate_theta_sketch(1000 * (i + 1), 10).compact() for i in range(5)]
+        batch = compact_theta_sketch.serialize_batch(sketches)
+        restored = compact_theta_sketch.deserialize_batch(batch)
+        self.assertEqual([sk.get_estimate() for sk in restored], [sk.get_estimate() for sk in sketches])
+
+    def test_concurrent_theta_sketch(self):
+        lgk = 12
+        num_threads = 4
+        sk = concurrent_theta_sketch(lgk, buffer_size=8, num_buffers=num_threads)
+        self.assertTrue(sk.is_empty())
+        self.assertEqual(sk.max_pending, 8 * num_threads)
+
+        # exact mode: every item reaches the shared sketch once flushed
+        n = 2000
+        chunks = np.array_split(np.arange(n, dtype=np.int64), num_threads)
+        with ThreadPoolExecutor(num_threads) as pool:
+            list(pool.map(sk.update, chunks))
+        self.assertLessEqual(n - sk.get_estimate(), sk.max_pending)
+        sk.flush()
+        self.assertEqual(sk.get_estimate(), n)
+        self.assertEqual(sk.compact().get_estimate(), self.generate_theta_sketch(n, lgk).get_estimate())
+
+        # scalar and string updates hash as with update_theta_sketch
+        sk.reset()
+        ref = update_theta_sketch(lgk)
+        for item in [1, -2.5, 0.0, -0.0, 'a', '']:
+            sk.update(item)
+            ref.update(item)
+        sk.update_strings(np.array(['b', 'c']))
+        ref.update_strings(np.array(['b', 'c']))
+        inter = theta_intersection()
+        inter.update(sk.compact())
+        inter.update(ref)
+        self.assertEqual(inter.get_result().get_estimate(), ref.get_estimate())
+        self.assertEqual(sk.get_estimate(), ref.get_estimate())
+
+        # estimation mode: the result matches a regular sketch within its error bounds
+        sk.reset()
+        n = 1 << 17
+        chunks = np.array_split(np.arange(n, dtype=np.int64), num_threads)
+        with ThreadPoolExecutor(num_threads) as pool:
+            list(pool.map(sk.update, chunks))
+        result = sk.compact()
+        self.assertLess(result.get_theta(), 1.0)
+        self.assertLessEqual(result.get_lower_bound(3), n)
+        self.assertGreaterEqual(result.get_upper_bound(3), n)
+
+        with self.assertRaises(ValueError):
+            concurrent_theta_sketch(lgk, buffer_size=0)
+
+    def test_theta_batched_set_operations(self):
+        lgk = 10
+        # a mix of exact and estimation mode, ordered and unordered, overlapping and disjoint sketches
+        sketches = [self.generate_theta_sketch(n, lgk, offset) for n, offset in
+                    [(500, 0), (800, 300), (5000, 0), (20000, 2000), (3000, 100000)]]
+        sketches[2] = sketches[2].compact()
+        sketches.append(update_theta_sketch(lgk))
+
+        result = theta_jaccard_similarity.pairwise(sketches, num_threads=3)
+        self.assertEqual(result.shape, (len(sketches), len(sketches), 3))
+        for i in range(len(sketches)):
+            for j in range(len(sketches)):
+                expected = theta_jaccard_similarity.jaccard(sketches[i], sketches[j]) if i != j else [1, 1, 1]
+                np.testing.assert_allclose(result[i, j], expected, rtol=1e-12)
+
+        # intersection matches theta_intersection exactly
+        inter_all = theta_intersection.intersect_all(sketches[:4], num_threads=2)
+        inter = theta_intersection()
+        for sk in sketches[:4]:
+            inter.update(sk)
+        expected = inter.get_result()
+        self.assertEqual(inter_all.get_num_retained(), expected.get_num_retained())
+        self.assertEqual(inter_all.get_theta(), expected.get_theta())
+        self.assertEqual(inter_all.get_estimate(), expected.get_estimate())
+        self.assertTrue(theta_intersection.intersect_all(sketches).is_empty())
+        inter = theta_intersection()
+        inter.update(sketches[0])
+        inter.update(sketches[4])
+        disjoint = theta_intersection.intersect_all([sketches[0], sketches[4]])
+        self.assertEqual(disjoint.is_empty(), inter.get_result().is_empty())
+        self.assertEqual(disjoint.get_estimate(), 0)
+
+        # union matches theta_union in exact mode and within its error bounds otherwise
+        exact = theta_union.union_all(sketches[:2], lg_k=lgk + 1)
+        self.assertEqual(exact.get_estimate(), 1100)
+        self.assertTrue(exact.is_ordered())
+        union_all = theta_union.union_all(sketches, lg_k=lgk, num_threads=4)
+        union = theta_union(lgk)
+        for sk in sketches:
+            union.update(sk)
+        expected = union.get_result()
+        self.assertLessEqual(union_all.get_num_retained(), 1 << lgk)
+        self.assertLessEqual(union_all.get_lower_bound(3), expected.get_estimate())
+        self.assertGreaterEqual(union_all.get_upper_bound(3), expected.get_estimate())
+        self.assertTrue(theta_union.union_all([update_theta_sketch(lgk)]).is_empty())
+
+        with self.assertRaises(ValueError):
+            theta_intersection.intersect_all([])
+        other_seed = update_theta_sketch(lgk, seed=1)
+        other_seed.update(1)
+        with self.assertRaises(ValueError):
+            theta_jaccard_similarity.pairwise([sketches[0], other_seed])
+
     def generate_theta_sketch(self, n, lgk, offset=0):
       sk = update_theta_sketch(lgk)
       for i in range(0, n):
@@ -0,0 +1,178 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+import struct
+import unittest
+
+import numpy as np
+
+from datasketches import update_tuple_sketch_double_sum, update_tuple_sketch_double_min
+from datasketches import update_tuple_sketch_double_max, compact_tuple_sketch_double
+from datasketches import tuple_union_double_sum, tuple_intersection_double_sum
+from datasketches import tuple_union_double_max, tuple_a_not_b_double
+from datasketches import update_tuple_sketch_array_of_doubles, compact_tuple_sketch_array_of_doubles
+from datasketches import tuple_union_array_of_doubles, tuple_intersection_array_of_doubles
+from datasketches import tuple_a_not_b_array_of_doubles
+
+class TupleNativeTest(unittest.TestCase):
+    def test_double_sum_array_update(self):
+        keys = np.array([1, 2, 1, 3, 1], dtype=np.int64)
+        values = np.array([1.0, 2.0, 3.0, np.nan, 5.0])
+        sk = update_tuple_sketch_double_sum()
+        sk.update(keys, values)
+        self.assertEqual(sk.get_estimate(), 2) # key 3 only had NaN
+        hashes, sums = sk.get_entries()
+        self.assertEqual(len(hashes), 2)
+        self.assertEqual(sorted(sums), [2.0, 9.0])
+
+        # scalar updates match the array update
+        sk2 = update_tuple_sketch_double_sum()
+        for k, v in zip(keys, values):
+            if not np.isnan(v):
+                sk2.update(int(k), float(v))
+        self.assertEqual(sorted(s for _, s in sk2), [2.0, 9.0])
+
+    def test_count(self):
+        sk = update_tuple_sketch_double_sum()
+        sk.update(np.array([7, 7, 8, 7], dtype=np.int64))
+        self.assertEqual(sorted(sk.get_entries()[1]), [1.0, 3.0])
+
+    def test_min_max(self):
+        keys = np.array([1.5, 1.5, 2.5, np.nan])
+        values = np.array([4.0, -1.0, 3.0, 10.0])
+        sk_min = update_tuple_sketch_double_min()
+        sk_min.update(keys, values)
+        sk_max = update_tuple_sketch_double_max()
+        sk_max.update(keys, values)
+        self.assertEqual(sorted(sk_min.get_entries()[1]), [-1.0, 3.0])
+        self.assertEqual(sorted(sk_max.get_entries()[1]), [3.0, 4.0])
+
+    def test_double_set_operations(self):
+        n = 1000
+        keys = np.arange(n, dtype=np.int64)
+        sk1 = update_tuple_sketch_double_sum(lg_k=12)
+        sk1.update(keys, np.full(n, 1.0))
+        sk2 = update_tuple_sketch_double_sum(lg_k=12)
+        sk2.update(keys + n // 2, np.full(n, 2.0))
+
+        u = tuple_union_double_sum(lg_k=12)
+        u.update(sk1)
+        u.update(sk2)
+        result = u.get_result()
+        self.assertEqual(result.get_estimate(), 1.5 * n)
+        self.assertEqual(result.get_entries()[1].sum(), 3.0 * n)
+
+        intersection = tuple_intersection_double_sum()
+        intersection.update(sk1)
+        intersection.update(sk2)
+        self.assertTrue(intersection.has_result())
+        result = intersection.get_result()
+        self.assertEqual(result.get_estimate(), n // 2)
+        self.assertTrue(np.all(result.get_entries()[1] == 3.0))
+
+        result = tuple_a_not_b_double().compute(sk1, sk2)
+        self.assertEqual(result.get_estimate(), n // 2)
+
+        # max policy on union keeps the larger value
+        u = tuple_union_double_max()
+        u.update(sk1)
+        u.update(sk2)
+        self.assertEqual(u.get_result().get_entries()[1].max(), 2.0)
+
+    def test_double_serialization(self):
+        sk = update_tuple_sketch_double_sum()
+        sk.update(np.arange(100, dtype=np.int64), np.arange(100, dtype=np.float64))
+        compact = sk.compact()
+        new_sk = compact_tuple_sketch_double.deserialize(compact.serialize())
+        self.assertEqual(new_sk.get_estimate(), compact.get_estimate())
+        self.assertEqual(new_sk.get_entries()[1].sum(), compact.get_entries()[1].sum())
+        self.assertGreater(sk.get_memory_usage(), 0)
+
+    def test_array_of_doubles(self):
+        sk = update_tuple_sketch_array_of_doubles(3)
+        self.assertEqual(sk.num_values, 3)
+        keys = np.array([1, 2, 1, 4], dtype=np.int64)
+        values = np.array([[1.0, 2.0, 3.0],
+                           [4.0, 5.0, 6.0],
+                           [1.0, 1.0, 1.0],
+                           [np.nan, 0.0, 0.0]])
+        sk.update(keys, values)
+        sk.update(2, [1.0, 1.0, 1.0])
+        self.assertEqual(sk.get_estimate(), 2)
+        hashes, summaries = sk.get_entries()
+        self.assertEqual(summaries.shape, (2, 3))
+        self.assertEqual(sorted(map(list, summaries)), [[2.0, 3.0, 4.0], [5.0, 6.0, 7.0]])
+
+        with self.assertRaises(ValueError):
+            sk.update(3, [1.0, 2.0])
+        with self.assertRaises(ValueError):
+            sk.update(keys, values[:, :2])
+        with self.assertRaises(ValueError):
+            update_tuple_sketch_array_of_doubles(0)
+
+        # entries iterate as (hash, list) pairs
+        for _, summary in sk.compact():
+            self.assertEqual(len(summary), 3)
+
+        compact = sk.compact()
+        new_sk = compact_tuple_sketch_array_of_doubles.deserialize(compact.serialize())
+        self.assertTrue(np.array_equal(np.sort(new_sk.get_entries()[1], axis=0), np.sort(summaries, axis=0)))
+
+        other = update_tuple_sketch_array_of_doubles(3)
+        other.update(np.array([1, 5], dtype=np.int64), np.ones((2, 3)))
+        u = tuple_union_array_of_doubles(3)
+        u.update(sk)
+        u.update(other)
+        self.assertEqual(u.get_result().get_estimate(), 3)
+
+        intersection = tuple_intersection_array_of_doubles(3)
+        intersection.update(sk)
+        intersection.update(other)
+        result = intersection.get_result()
+        self.assertEqual(result.get_estimate(), 1)
+        self.assertEqual(list(result.get_entries()[1][0]), [3.0, 4.0, 5.0])
+
+        self.assertEqual(tuple_a_not_b_array_of_doubles().compute(sk, other).get_estimate(), 1)
+
+        # summaries of different sizes cannot be combined
+        mismatched = update_tuple_sketch_array_of_doubles(2)
+        mismatched.update(1, [1.0, 1.0])
+        intersection = tuple_intersection_array_of_doubles(3)
+        intersection.update(sk)
+        with self.assertRaises(ValueError):
+            intersection.update(mismatched)
+        u = tuple_union_array_of_doubles(3)
+        u.update(sk)
+        with self.assertRaises(ValueError):
+            u.update(mismatched)
+        with self.assertRaises(ValueError):
+            tuple_union_array_of_doubles(0)
+
+        # an image whose summaries differ in size is rejected rather than read into rows of one size
+        two = update_tuple_sketch_array_of_doubles(3)
+        two.update(1, [1.5, 2.5, 3.5])
+        two.update(2, [4.5, 5.5, 6.5])
+        image = two.compact().serialize()
+        entry = struct.pack('<I3d', 3, 4.5, 5.5, 6.5)
+        self.assertNotEqual(image.find(entry), -1)
+        crafted = image.replace(entry, struct.pack('<I2d', 2, 4.5, 5.5))
+        with self.assertRaises(ValueError):
+            compact_tuple_sketch_array_of_doubles.deserialize(crafted)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -17,7 +17,8 @@
 
 import unittest
 from datasketches import (vector_of_kll_ints_sketches,
-                          vector_of_kll_floats_sketches)
+                          vector_of_kll_floats_sketches,
+                          kll_floats_sketch, get_batch_offsets)
 import copy
 import numpy as np
 
@@ -151,5 +152,154 @@ class VectorOfKllSketchesTest(unittest.TestCase):
       # the sketches should still be empty
       self.assertTrue(np.all(kll.is_empty()))
 
+    def test_kll_batch_serialization(self):
+      k = 200
+      d = 5
+      kll = vector_of_kll_floats_sketches(k, d)
+      kll.update(np.random.randn(1000, d))
+
+      # one blob holds every sketch, and each image can be read on its own
+      batch = kll.serialize_batch()
+      images = kll.serialize()
+      offsets = get_batch_offsets(batch)
+      self.assertEqual(len(offsets), d + 1)
+      self.assertEqual(offsets[-1], len(batch))
+      for i in range(d):
+        self.assertEqual(batch[offsets[i]:offsets[i + 1]], images[i])
+        sk = kll_floats_sketch.deserialize(batch, offset=int(offsets[i]), length=int(offsets[i + 1] - offsets[i]))
+        self.assertEqual(sk.get_quantile(0.5), kll.get_quantiles(0.5, i)[0][0])
+
+      new_kll = vector_of_kll_floats_sketches(k, d)
+      new_kll.deserialize_batch(batch)
+      np.testing.assert_array_equal(new_kll.get_quantiles(0.5), kll.get_quantiles(0.5))
+
+      # a subset can be written and loaded into other positions
+      subset = kll.serialize_batch([1, 3])
+      new_kll = vector_of_kll_floats_sketches(k, d)
+      new_kll.deserialize_batch(subset, [0, 4])
+      self.assertEqual(new_kll.get_n()[0], kll.get_n()[1])
+      self.assertEqual(new_kll.get_n()[4], kll.get_n()[3])
+      self.assertTrue(new_kll.is_empty()[2])
+
+      with self.assertRaises(ValueError):
+        new_kll.deserialize_batch(subset)
+      with self.assertRaises(ValueError):
+        new_kll.deserialize_batch(images[0], 0)
+
+      # batches of individual sketches use the same format
+      sketches = [kll_floats_sketch.deserialize(image) for image in images]
+      batch = kll_floats_sketch.serialize_batch(sketches)
+      self.assertEqual(batch, kll.serialize_batch())
+      restored = kll_floats_sketch.deserialize_batch(memoryview(batch), 2)
+      self.assertEqual(len(restored), d - 2)
+      self.assertEqual(restored[0].n, sketches[2].n)
+
+    def test_kll_sorted_view(self):
+      kll = vector_of_kll_floats_sketches(200, 2)
+      kll.update(np.random.randn(1000, 2))
+
+      view = kll.sorted_view(1)
+      self.assertIsInstance(view, type(kll_floats_sketch().sorted_view()))
+      self.assertEqual(view.n, 1000)
+      self.assertEqual(view.get_quantile(0.5), kll.get_quantiles(0.5, 1)[0][0])
+
+      # only an update to that sketch invalidates the view
+      kll.update(np.array([np.nan, 1.0]))
+      self.assertFalse(view.is_valid)
+      view = kll.sorted_view(1)
+      kll.update(np.array([1.0, np.nan]))
+      self.assertTrue(view.is_valid)
+
+      # so does replacing it, even by a sketch of the same stream length
+      other = kll_floats_sketch(200)
+      for x in np.random.randn(view.n) + 10:
+        other.update(x)
+      kll.deserialize(other.serialize(), 1)
+      self.assertEqual(kll.get_n()[1], view.n)
+      self.assertFalse(view.is_valid)
+      with self.assertRaises(ValueError):
+        kll.sorted_view(2)
+
+    def test_kll_threaded_updates(self):
+      k = 200
+      d = 37
+      # fewer values than k per sketch, so no compactions and results are exact
+      data = np.random.randn(150, d).astype(np.float32)
+
+      serial = vector_of_kll_floats_sketches(k, d)
+      self.assertEqual(serial.num_threads, 1)
+      serial.update(data)
+
+      threaded = vector_of_kll_floats_sketches(k, d, num_threads=4)
+      threaded.update(data)
+      column_major = vector_of_kll_floats_sketches(k, d, num_threads=0)
+      column_major.update(np.asfortranarray(data))
+      strided = vector_of_kll_floats_sketches(k, d, num_threads=3)
+      strided.update(np.repeat(data, 2, axis=1)[:, ::2])
+
+      ranks = [0.1, 0.5, 0.9]
+      expected = serial.get_quantiles(ranks)
+      for sk in [threaded, column_major, strided]:
+        np.testing.assert_array_equal(sk.get_n(), serial.get_n())
+        np.testing.assert_array_equal(sk.get_quantiles(ranks), expected)
+        np.testing.assert_array_equal(sk.get_ranks([0.0]), serial.get_ranks([0.0]))
+        np.testing.assert_array_equal(sk.get_cdf([-1.0, 1.0]), serial.get_cdf([-1.0, 1.0]))
+        np.testing.assert_array_equal(sk.get_pmf([0.0], [3, 3]), serial.get_pmf([0.0], [3, 3]))
+
+      # merging uses threads as well
+      threaded.num_threads = 2
+      threaded.merge(serial)
+      np.testing.assert_array_equal(threaded.get_n(), 2 * serial.get_n())
+      self.assertEqual(copy.copy(threaded).num_threads, 2)
+
+    def test_kll_collapse_groups(self):
+      k = 200
+      d = 16
+      # few enough values that every merged sketch is exact, so cached and fresh results agree
+      data = np.random.randn(4, d).astype(np.float32)
+      kll = vector_of_kll_floats_sketches(k, d, num_threads=2)
+      kll.update(data)
+
+      evens = kll.add_collapse_group(list(range(0, d, 2)))
+      everything = kll.add_collapse_group()
+      self.assertEqual(kll.add_collapse_group(list(range(0, d, 2))), evens)
+      self.assertEqual(kll.get_collapse_groups(), [evens, everything])
+
+      ranks = [0.1, 0.5, 0.9]
+      fresh = [kll_floats_sketch.deserialize(b) for b in kll.serialize()]
+      def check():
+        for group, isk in [(evens, list(range(0, d, 2))), (everything, list(range(d)))]:
+          merged = kll.collapse_group(group)
+          flat = kll_floats_sketch(k)
+          for i in isk:
+            flat.merge(kll_floats_sketch.deserialize(kll.serialize(i)[0]))
+          self.assertEqual(merged.n, flat.n)
+          np.testing.assert_array_equal(merged.get_quantiles(ranks), flat.get_quantiles(ranks))
+          # collapse() over the same indices is served from the cache
+          self.assertEqual(kll.collapse(isk).n, flat.n)
+        np.testing.assert_array_equal(kll.get_group_quantiles(ranks),
+          np.vstack([kll.collapse_group(g).get_quantiles(ranks) for g in [evens, everything]]))
+      check()
+
+      # changes through every path are picked up
+      kll.update(data[0])
+      check()
+      kll.deserialize(fresh[4].serialize(), 4)
+      check()
+      kll.deserialize_batch(kll.serialize_batch([1, 2]), [2, 1])
+      check()
+      kll.merge(copy.copy(kll))
+      check()
+
+      # copies carry their groups, and removed groups are gone
+      kll_copy = copy.copy(kll)
+      kll.remove_collapse_group(evens)
+      self.assertEqual(kll.get_collapse_groups(), [everything])
+      self.assertEqual(kll_copy.get_collapse_groups(), [evens, everything])
+      with self.assertRaises(ValueError):
+        kll.collapse_group(evens)
+      with self.assertRaises(ValueError):
+        kll.add_collapse_group([])
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,149 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import unittest
+from datasketches import (vector_of_hll_sketches, vector_of_theta_sketches,
+                          vector_of_tdigests, hll_sketch, update_theta_sketch, tgt_hll_type)
+import copy
+import numpy as np
+
+class VectorOfSketchesTest(unittest.TestCase):
+    def test_vector_of_hll_sketches(self):
+      d = 4
+      n = 10000
+      vec = vector_of_hll_sketches(12, tgt_hll_type.HLL_8, d, num_threads=2)
+      self.assertEqual(vec.d, d)
+      self.assertEqual(vec.lg_k, 12)
+
+      # column j holds n distinct values offset by j * n, plus repeats
+      data = np.arange(n, dtype=np.int64).reshape(-1, 1) + np.arange(d, dtype=np.int64) * n
+      vec.update(data)
+      vec.update(data[:100])
+      estimates = vec.get_estimate()
+      self.assertEqual(estimates.shape, (d,))
+      np.testing.assert_allclose(estimates, n, rtol=0.05)
+      self.assertTrue(np.all(vec.get_lower_bound(2) <= estimates))
+      self.assertTrue(np.all(vec.get_upper_bound(2) >= estimates))
+      self.assertEqual(len(vec.get_estimate([1, 3])), 2)
+
+      # matches a single sketch fed the same column, in either memory layout
+      sk = hll_sketch(12, tgt_hll_type.HLL_8)
+      for v in data[:, 2]:
+        sk.update(int(v))
+      self.assertAlmostEqual(vec.get_estimate(2)[0], sk.get_estimate())
+      fortran = vector_of_hll_sketches(12, tgt_hll_type.HLL_8, d)
+      fortran.update(np.asfortranarray(data), order="F")
+      np.testing.assert_array_equal(fortran.get_estimate(), estimates)
+
+      # columns are disjoint, so the collapsed sketch counts them all
+      self.assertAlmostEqual(vec.collapse().get_estimate(), d * n, delta=0.05 * d * n)
+
+      other = vector_of_hll_sketches(12, tgt_hll_type.HLL_8, d)
+      other.update(data + d * n)
+      vec.merge(other)
+      np.testing.assert_allclose(vec.get_estimate(), 2 * n, rtol=0.05)
+
+      with self.assertRaises(ValueError):
+        vec.merge(vector_of_hll_sketches(12, tgt_hll_type.HLL_8, d + 1))
+      with self.assertRaises(ValueError):
+        vec.update(np.zeros((3, d + 1), dtype=np.int64))
+      with self.assertRaises(ValueError):
+        vec.get_estimate(d)
+
+    def test_vector_of_hll_sketches_nan(self):
+      vec = vector_of_hll_sketches(10, d=2)
+      data = np.array([[1.0, np.nan], [2.0, np.nan], [3.0, 4.0]])
+      vec.update(data)
+      np.testing.assert_allclose(vec.get_estimate(), [3, 1], rtol=1e-6)
+
+    def test_vector_of_theta_sketches(self):
+      d = 3
+      n = 5000
+      vec = vector_of_theta_sketches(lg_k=12, d=d)
+      self.assertEqual(vec.lg_k, 12)
+      data = np.arange(n * d, dtype=np.int64).reshape(n, d)
+      vec.update(data)
+      np.testing.assert_allclose(vec.get_estimate(), n, rtol=0.05)
+
+      sk = update_theta_sketch(12)
+      for v in data[:, 1]:
+        sk.update(int(v))
+      self.assertAlmostEqual(vec.get_estimate(1)[0], sk.get_estimate())
+
+      # merged data is kept apart from later updates, and both are counted
+      other = vector_of_theta_sketches(lg_k=12, d=d)
+      other.update(data + n * d)
+      vec.merge(other)
+      vec.update(data[:10])
+      np.testing.assert_allclose(vec.get_estimate(), 2 * n, rtol=0.05)
+      self.assertTrue(np.all(vec.get_lower_bound(2) <= vec.get_estimate()))
+
+      result = vec.collapse([0, 2])
+      self.assertAlmostEqual(result.get_estimate(), 4 * n, delta=0.05 * 4 * n)
+
+    def test_vector_of_tdigests(self):
+      d = 3
+      n = 2 ** 14
+      vec = vector_of_tdigests(100, d)
+      self.assertEqual(vec.k, 100)
+      data = np.random.randn(n, d)
+      vec.update(data)
+      np.testing.assert_array_equal(vec.get_total_weight(), n)
+
+      quantiles = vec.get_quantiles(np.array([0.1, 0.5, 0.9]))
+      self.assertEqual(quantiles.shape, (d, 3))
+      np.testing.assert_allclose(quantiles[:, 1], 0, atol=0.05)
+      ranks = vec.get_ranks(np.array([0.0]), [0, 2])
+      self.assertEqual(ranks.shape, (2, 1))
+      np.testing.assert_allclose(ranks, 0.5, atol=0.02)
+
+      other = vector_of_tdigests(100, d)
+      vec.merge(other)
+      np.testing.assert_array_equal(vec.get_total_weight(), n)
+      self.assertEqual(vec.collapse().get_total_weight(), n * d)
+
+      empty = vector_of_tdigests(100, 2)
+      self.assertTrue(np.all(np.isnan(empty.get_quantiles(np.array([0.5])))))
+      with self.assertRaises(ValueError):
+        vec.get_quantiles(np.array([1.5]))
+
+    def test_batch_serialization(self):
+      d = 4
+      data = np.arange(4000, dtype=np.int64).reshape(-1, d)
+      factories = [(lambda: vector_of_hll_sketches(11, d=d), lambda v: v.get_estimate()),
+                   (lambda: vector_of_theta_sketches(d=d), lambda v: v.get_estimate()),
+                   (lambda: vector_of_tdigests(d=d), lambda v: v.get_total_weight())]
+      for make, summary in factories:
+        vec = make()
+        vec.update(data if not isinstance(vec, vector_of_tdigests) else data.astype(np.float64))
+        batch = vec.serialize_batch()
+        restored = make()
+        restored.deserialize_batch(batch)
+        np.testing.assert_array_equal(summary(restored), summary(copy.copy(vec)))
+
+        # replace only two of the sketches
+        partial = vec.serialize_batch([0, 1])
+        restored = make()
+        restored.deserialize_batch(partial, [2, 3])
+        np.testing.assert_array_equal(summary(restored)[2:], summary(vec)[:2])
+        with self.assertRaises(ValueError):
+          restored.deserialize_batch(partial, [0])
+        with self.assertRaises(ValueError):
+          restored.deserialize_batch(b'not a batch')
+
+if __name__ == '__main__':
+    unittest.main()
@@ -17,6 +17,8 @@
  
 import unittest
 from datasketches import var_opt_sketch, var_opt_union, PyIntsSerDe, PyStringsSerDe
+from datasketches import var_opt_ints_sketch, var_opt_doubles_sketch, var_opt_doubles_union
+import numpy as np
 
 class VoTest(unittest.TestCase):
   def test_vo_example(self):
@@ -137,5 +139,52 @@ class VoTest(unittest.TestCase):
 
 
 
+  def test_vo_numeric(self):
+    k = 50
+    n = 5 * k
+    vo = var_opt_ints_sketch(k)
+    vo.update(np.arange(n, dtype=np.int64))
+    vo.update(np.array([-1], dtype=np.int64), np.array([1000.0 * n]))
+    self.assertEqual(vo.n, n + 1)
+    self.assertEqual(vo.num_samples, k)
+
+    items, weights = vo.get_samples()
+    self.assertEqual(len(items), k)
+    self.assertEqual(list(items), [item for item, _ in vo])
+
+    # a mask over get_samples() matches the equivalent predicate
+    expected = vo.estimate_subset_sum(lambda x: x < 0)
+    summary = vo.estimate_subset_sum(items < 0)
+    self.assertEqual(summary, expected)
+    self.assertEqual(summary['estimate'], 1000 * n)
+    summary = vo.estimate_subset_sum_range(0, n)
+    self.assertEqual(summary, vo.estimate_subset_sum(lambda x: 0 <= x <= n))
+    self.assertEqual(summary['total_sketch_weight'], 1001 * n)
+
+    with self.assertRaises(ValueError):
+      vo.estimate_subset_sum(np.array([True]))
+    with self.assertRaises(ValueError):
+      vo.update(np.array([1, 2], dtype=np.int64), np.array([1.0, -1.0]))
+    self.assertEqual(vo.n, n + 1) # the invalid batch was not applied
+
+    # numeric sketches serialize without a serde
+    vo2 = var_opt_ints_sketch.deserialize(vo.serialize())
+    self.assertEqual(vo2.n, vo.n)
+    self.assertEqual(len(vo.serialize()), vo.get_serialized_size_bytes())
+
+  def test_vo_doubles_union(self):
+    sk1 = var_opt_doubles_sketch(10)
+    sk1.update(np.linspace(0, 1, 100), np.full(100, 2.0))
+    sk2 = var_opt_doubles_sketch(10)
+    sk2.update(np.linspace(1, 2, 100))
+    union = var_opt_doubles_union(10)
+    union.update(sk1)
+    union.update(sk2)
+    result = union.get_result()
+    self.assertEqual(result.n, 200)
+    self.assertAlmostEqual(result.estimate_subset_sum_range(-1.0, 3.0)['estimate'], 300.0)
+    union2 = var_opt_doubles_union.deserialize(union.serialize())
+    self.assertEqual(union2.get_result().n, 200)
+
 if __name__ == '__main__':
   unittest.main()